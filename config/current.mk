@@ -33,8 +33,13 @@ SYSTEM := POSIX
 
 OS     := LINUX
 ARCH   := x86
-LDFLAGS += -z defs -lX11 -lXext -lasound -lavformat -lavcodec -lavutil -lswscale -lavresample
+LDFLAGS += -z defs -lX11 -lXext -lXv -lasound -lavformat -lavcodec -lavutil -lswscale -lavresample -lm
 SOURCE_FILE := 1
+# Uncomment to serve small allocations from the size-class pool (slabs are
+# kept for the life of the process, not returned to the OS)
+#MEMORY_POOL := 1
+# Uncomment to enable per-module memory accounting (eos_mem_stats_get)
+#MEMORY_ACCOUNTING := 1
 CRONPLYR := 1
 JAVA_BIND := 1
 JAVA_DIR := /usr/lib/jvm/java-8-oracle/
@@ -36,18 +36,31 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "eos_macro.h"
 #include "osi_mutex.h"
 #include "osi_memory.h"
+#include "osi_executor.h"
 #include "eos_types.h"
 #include "util_log.h"
 #include "chain_manager.h"
+#include "zap_stats.h"
 #include "set_reg.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define MODULE_NAME "api"
 #define EOS_API_LOG_NAME "eos"
 #define EOS_VER_MAX (32)
 #define EOS_VER_FMT "%u.%u.%u.%x"
+#define EOS_OUT_CNT (EOS_OUT_AUX_AV + 1)
+
+typedef struct eos_req
+{
+	uint32_t id;
+	eos_req_type_t type;
+	eos_out_t out;
+	char *url;
+	char *extras;
+} eos_req_t;
 
 static osi_mutex_t *eos_lock = NULL;
 static util_log_t *eos_log = NULL;
@@ -56,6 +69,20 @@ static void *eos_cbk_cookie = NULL;
 static eos_data_cbk_t eos_data_cbk = NULL;
 static void *eos_data_cbk_cookie = NULL;
 static char eos_ver_str[EOS_VER_MAX] = "";
+/* Async requests block for the whole play/stop, so they get workers of
+ * their own (one per output) instead of the shared pool that delivers the
+ * chain events they wait for */
+static osi_executor_t *eos_req_exec = NULL;
+/* Async requests run one by one per output */
+static osi_executor_serial_t *eos_req_queue[EOS_OUT_CNT];
+/* Guards latest/running, so a request cannot finish between the check
+ * and the interrupt */
+static osi_mutex_t *eos_req_lock = NULL;
+/* ID of the newest request per output, older ones are cancelled */
+static uint32_t eos_req_latest[EOS_OUT_CNT];
+/* ID of the request in progress per output (0 if none) */
+static uint32_t eos_req_running[EOS_OUT_CNT];
+static uint32_t eos_req_cnt = 0;
 
 static eos_error_t eos_check_lock(void);
 static eos_error_t eos_check_unlock(void);
@@ -64,11 +91,16 @@ static eos_error_t eos_chain_cbk(chain_t* chain, eos_event_t event,
 static eos_error_t eos_chain_data_cbk(uint32_t id,
 		engine_type_t engine_type, engine_data_t data_type,
 		uint8_t* data, uint32_t size, void* cookie);
+static eos_error_t eos_req_submit(eos_req_t* req, uint32_t* req_id);
+static void eos_req_process(void* arg);
+static void eos_req_free(void* arg);
+static char* eos_req_strdup(const char* str);
 
 
 eos_error_t eos_init(void)
 {
 	eos_error_t err = EOS_ERROR_OK;
+	uint8_t i = 0;
 
 	UTIL_GLOGI("Staring EOS...");
 	if(eos_lock != NULL)
@@ -95,6 +127,28 @@ eos_error_t eos_init(void)
 		goto done;
 	}
 	chain_manager_module_init();
+	err = osi_mutex_create(&eos_req_lock);
+	if(err != EOS_ERROR_OK)
+	{
+		UTIL_LOGE(eos_log, "Request lock cannot be created");
+		goto done;
+	}
+	err = osi_executor_create(&eos_req_exec, EOS_OUT_CNT);
+	if(err != EOS_ERROR_OK)
+	{
+		UTIL_LOGE(eos_log, "Request executor cannot be created");
+		goto done;
+	}
+	for(i = 0; i < EOS_OUT_CNT; i++)
+	{
+		err = osi_executor_serial_create(&eos_req_queue[i], eos_req_exec,
+				eos_req_free, i);
+		if(err != EOS_ERROR_OK)
+		{
+			UTIL_LOGE(eos_log, "Request queue cannot be created");
+			goto done;
+		}
+	}
 	osi_memset(eos_ver_str, 0, EOS_VER_MAX);
 #ifdef EOS_VERSION_COMMIT
 	snprintf(eos_ver_str, EOS_VER_MAX - 1, EOS_VER_FMT, EOS_VERSION_MAJOR,
@@ -115,7 +169,26 @@ done:
 
 eos_error_t eos_deinit(void)
 {
+	uint8_t i = 0;
+
 	UTIL_GLOGI("Stopping EOS...");
+	for(i = 0; i < EOS_OUT_CNT; i++)
+	{
+		if(eos_req_queue[i] != NULL)
+		{
+			/* Waits for the request in progress, drops the queued ones */
+			osi_executor_serial_destroy(&eos_req_queue[i]);
+		}
+	}
+	if(eos_req_exec != NULL)
+	{
+		osi_executor_destroy(&eos_req_exec);
+	}
+	if(eos_req_lock != NULL)
+	{
+		osi_mutex_destroy(&eos_req_lock);
+	}
+	chain_manager_module_deinit();
 	if(eos_log != NULL)
 	{
 		util_log_destroy(&eos_log);
@@ -149,6 +222,35 @@ eos_error_t eos_set_event_cbk(eos_cbk_t cbk, void* cookie)
 	return eos_check_unlock();
 }
 
+eos_error_t eos_mem_stats_get(eos_mem_stats_t* stats, uint32_t* count)
+{
+	osi_memory_stats_t tmp[OSI_MEMORY_MODULES_MAX];
+	eos_error_t err = EOS_ERROR_OK;
+	uint32_t i, cnt = OSI_MEMORY_MODULES_MAX;
+
+	if(stats == NULL || count == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	err = osi_memory_get_stats(tmp, &cnt);
+	if(err != EOS_ERROR_OK)
+	{
+		return err;
+	}
+	for(i=0; i<cnt && i<*count; i++)
+	{
+		stats[i].module = tmp[i].module;
+		stats[i].live = tmp[i].live;
+		stats[i].peak = tmp[i].peak;
+		stats[i].allocs = tmp[i].allocs;
+		stats[i].frees = tmp[i].frees;
+		stats[i].rate = tmp[i].rate;
+	}
+	*count = cnt;
+
+	return EOS_ERROR_OK;
+}
+
 uint64_t eos_get_ver(void)
 {
 	uint64_t ver = 0LL;
@@ -186,6 +288,7 @@ eos_error_t eos_player_play(char* in_url, char* in_extras, eos_out_t out)
 	{
 		return err;
 	}
+	zap_stats_mark(out, EOS_ZAP_MS_PLAY_REQ);
 	err = chain_manager_create(in_url, in_extras, out, &handler);
 
 	if(err == EOS_ERROR_OK)
@@ -232,6 +335,51 @@ eos_error_t eos_player_stop(eos_out_t out)
 	return chain_manager_destroy(out);
 }
 
+eos_error_t eos_player_play_async(char* in_url, char* in_extras,
+		eos_out_t out, uint32_t* req_id)
+{
+	eos_req_t *req = NULL;
+
+	if(in_url == NULL || req_id == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	req = (eos_req_t*)osi_calloc(sizeof(eos_req_t));
+	if(req == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	req->type = EOS_REQ_PLAY;
+	req->out = out;
+	req->url = eos_req_strdup(in_url);
+	req->extras = eos_req_strdup(in_extras);
+	if(req->url == NULL || (in_extras != NULL && req->extras == NULL))
+	{
+		eos_req_free(req);
+		return EOS_ERROR_NOMEM;
+	}
+	return eos_req_submit(req, req_id);
+}
+
+eos_error_t eos_player_stop_async(eos_out_t out, uint32_t* req_id)
+{
+	eos_req_t *req = NULL;
+
+	if(req_id == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	req = (eos_req_t*)osi_calloc(sizeof(eos_req_t));
+	if(req == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	req->type = EOS_REQ_STOP;
+	req->out = out;
+
+	return eos_req_submit(req, req_id);
+}
+
 eos_error_t eos_player_buffer(eos_out_t out, bool start)
 {
 	eos_error_t err = EOS_ERROR_OK;
@@ -284,6 +432,25 @@ eos_error_t eos_player_trickplay(eos_out_t out, int64_t position,
 	return err;
 }
 
+eos_error_t eos_player_get_zap_stats(eos_out_t out, eos_zap_info_t* last,
+		eos_zap_hist_t* hist)
+{
+	eos_error_t err = EOS_ERROR_OK;
+
+	err = eos_check_lock();
+	if(err != EOS_ERROR_OK)
+	{
+		return err;
+	}
+	eos_check_unlock();
+	if((last == NULL) && (hist == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	return zap_stats_get(out, last, hist);
+}
+
 eos_error_t eos_player_get_media_desc(eos_out_t out, eos_media_desc_t* desc)
 {
 	eos_error_t err = EOS_ERROR_OK;
@@ -424,6 +591,17 @@ eos_error_t eos_out_vol_leveling(eos_out_t out, bool enable,
 	return set_reg_apply(out, SET_REG_OPT_VOL_LVL, &val);
 }
 
+eos_error_t eos_out_dec_threads(eos_out_t out, eos_out_dec_thr_t mode,
+		uint8_t count)
+{
+	set_reg_val_t val;
+
+	val.dec_thr.mode = mode;
+	val.dec_thr.count = count;
+
+	return set_reg_apply(out, SET_REG_OPT_DEC_THR, &val);
+}
+
 eos_error_t eos_data_cbk_set(eos_data_cbk_t cbk, void* cookie)
 {
 	eos_error_t err = EOS_ERROR_OK;
@@ -1000,3 +1178,136 @@ static eos_error_t eos_chain_data_cbk(uint32_t id,
 
 	return err;
 }
+
+static eos_error_t eos_req_submit(eos_req_t* req, uint32_t* req_id)
+{
+	eos_error_t err = EOS_ERROR_OK;
+	uint32_t id = 0;
+
+	if(req->out >= EOS_OUT_CNT || eos_req_queue[req->out] == NULL)
+	{
+		eos_req_free(req);
+		return EOS_ERROR_INVAL;
+	}
+	/* Java gets it as jint: 1..INT32_MAX, never 0 nor -1 (no request) */
+	do
+	{
+		id = eos_req_cnt;
+		req->id = (id >= INT32_MAX) ? 1 : id + 1;
+	} while(!__sync_bool_compare_and_swap(&eos_req_cnt, id, req->id));
+	/* Queued ones are skipped when they are reached, the one in progress
+	 * may be waiting for the source lock, do not let the new one wait.
+	 * The interrupt hits whatever assembles on the output, so a
+	 * synchronous play that overlaps the running request is interrupted
+	 * too, just as it would be by any newer play on that output. */
+	osi_mutex_lock(eos_req_lock);
+	eos_req_latest[req->out] = req->id;
+	if(eos_req_running[req->out] != 0)
+	{
+		UTIL_LOGI(eos_log, "Request %u interrupts %u", req->id,
+				eos_req_running[req->out]);
+		chain_manager_interrupt(req->out);
+	}
+	osi_mutex_unlock(eos_req_lock);
+	*req_id = req->id;
+	err = osi_executor_serial_run(eos_req_queue[req->out], eos_req_process,
+			req);
+	if(err != EOS_ERROR_OK)
+	{
+		UTIL_LOGE(eos_log, "Request %u cannot be queued", *req_id);
+		eos_req_free(req);
+	}
+
+	return err;
+}
+
+static void eos_req_process(void* arg)
+{
+	eos_req_t *req = (eos_req_t*)arg;
+	eos_event_data_t data;
+	eos_cbk_t cbk = eos_cbk;
+	uint32_t latest = 0;
+
+	osi_memset(&data, 0, sizeof(eos_event_data_t));
+	data.req.id = req->id;
+	data.req.type = req->type;
+	data.req.err = EOS_ERROR_OK;
+	osi_mutex_lock(eos_req_lock);
+	latest = eos_req_latest[req->out];
+	if(req->id == latest)
+	{
+		eos_req_running[req->out] = req->id;
+	}
+	osi_mutex_unlock(eos_req_lock);
+	if(req->id != latest)
+	{
+		data.req.state = EOS_REQ_CANCELLED;
+	}
+	else
+	{
+		if(req->type == EOS_REQ_PLAY)
+		{
+			data.req.err = eos_player_play(req->url, req->extras, req->out);
+		}
+		else
+		{
+			data.req.err = eos_player_stop(req->out);
+		}
+		osi_mutex_lock(eos_req_lock);
+		eos_req_running[req->out] = 0;
+		latest = eos_req_latest[req->out];
+		osi_mutex_unlock(eos_req_lock);
+		data.req.state = (data.req.err == EOS_ERROR_OK) ?
+				EOS_REQ_DONE : EOS_REQ_FAILED;
+		/* Failure caused by the interrupt of a newer request */
+		if(data.req.err != EOS_ERROR_OK && req->id != latest)
+		{
+			data.req.state = EOS_REQ_CANCELLED;
+		}
+	}
+	UTIL_LOGI(eos_log, "Request %u on %d: state %d, err %d", req->id,
+			req->out, data.req.state, data.req.err);
+	if(cbk != NULL)
+	{
+		cbk(req->out, EOS_EVENT_REQUEST, &data, eos_cbk_cookie);
+	}
+	eos_req_free(req);
+}
+
+static void eos_req_free(void* arg)
+{
+	eos_req_t *req = (eos_req_t*)arg;
+
+	if(req == NULL)
+	{
+		return;
+	}
+	if(req->url != NULL)
+	{
+		osi_free((void**)&req->url);
+	}
+	if(req->extras != NULL)
+	{
+		osi_free((void**)&req->extras);
+	}
+	osi_free((void**)&req);
+}
+
+static char* eos_req_strdup(const char* str)
+{
+	char *dup = NULL;
+	size_t len = 0;
+
+	if(str == NULL)
+	{
+		return NULL;
+	}
+	len = strlen(str) + 1;
+	dup = (char*)osi_malloc(len);
+	if(dup != NULL)
+	{
+		osi_memcpy(dup, (void*)str, len);
+	}
+
+	return dup;
+}
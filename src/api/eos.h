@@ -49,12 +49,22 @@ eos_error_t eos_deinit(void);
 uint64_t eos_get_ver(void);
 const char* eos_get_ver_str(void);
 eos_error_t eos_set_event_cbk(eos_cbk_t cbk, void* cookie);
+eos_error_t eos_mem_stats_get(eos_mem_stats_t* stats, uint32_t* count);
 
 eos_error_t eos_player_play(char* in_url, char* in_extras, eos_out_t out);
 eos_error_t eos_player_stop(eos_out_t out);
+/* Non-blocking variants: the request is queued per output and its outcome
+ * is reported by EOS_EVENT_REQUEST carrying the returned request ID. A newer
+ * request on the same output cancels the older ones still in flight.
+ * IDs are in 1..INT32_MAX (they go to Java as int) and wrap around. */
+eos_error_t eos_player_play_async(char* in_url, char* in_extras,
+		eos_out_t out, uint32_t* req_id);
+eos_error_t eos_player_stop_async(eos_out_t out, uint32_t* req_id);
 eos_error_t eos_player_trickplay(eos_out_t out, int64_t position,
 		int16_t speed);
 eos_error_t eos_player_buffer(eos_out_t out, bool start);
+eos_error_t eos_player_get_zap_stats(eos_out_t out, eos_zap_info_t* last,
+		eos_zap_hist_t* hist);
 
 eos_error_t eos_player_get_media_desc(eos_out_t out, eos_media_desc_t* desc);
 eos_error_t eos_player_set_track(eos_out_t out, uint32_t id, bool on);
@@ -66,6 +76,8 @@ eos_error_t eos_out_vid_move(eos_out_t out, uint32_t x, uint32_t y);
 eos_error_t eos_out_aud_mode(eos_out_t out, eos_out_amode_t amode);
 eos_error_t eos_out_vol_leveling(eos_out_t out, bool enable,
 		eos_out_vol_lvl_t lvl);
+eos_error_t eos_out_dec_threads(eos_out_t out, eos_out_dec_thr_t mode,
+		uint8_t count);
 eos_error_t eos_out_blank(eos_out_t out);
 eos_error_t eos_out_release(eos_out_t out);
 
@@ -96,6 +96,28 @@ typedef struct eos_conn_state_event
 	eos_conn_reason_t reason;
 } eos_conn_state_event_t;
 
+typedef enum eos_req_type
+{
+	EOS_REQ_PLAY = 1,
+	EOS_REQ_STOP
+} eos_req_type_t;
+
+typedef enum eos_req_state
+{
+	EOS_REQ_DONE = 1,
+	EOS_REQ_FAILED,
+	/* Superseded by a newer request on the same output */
+	EOS_REQ_CANCELLED
+} eos_req_state_t;
+
+typedef struct eos_req_event
+{
+	uint32_t id;
+	eos_req_type_t type;
+	eos_req_state_t state;
+	eos_error_t err;
+} eos_req_event_t;
+
 typedef enum eos_event
 {
 	EOS_EVENT_STATE = 1,
@@ -103,6 +125,8 @@ typedef enum eos_event
 	EOS_EVENT_PBK_STATUS,
 	EOS_EVENT_CONN_STATE,
 	EOS_EVENT_ERR,
+	EOS_EVENT_ZAP,
+	EOS_EVENT_REQUEST,
 	EOS_EVENT_LAST
 } eos_event_t;
 
@@ -113,6 +137,8 @@ typedef union eos_event_data
 	eos_err_event_t err;
 	eos_pbk_status_event_t pbk_status;
 	eos_conn_state_event_t conn;
+	eos_zap_info_t zap;
+	eos_req_event_t req;
 } eos_event_data_t;
 
 typedef eos_error_t (*eos_cbk_t)(eos_out_t out, eos_event_t event,
@@ -128,6 +128,12 @@ typedef union eos_media_es_attr
 			uint16_t width;
 			uint16_t height;
 		} resolution;
+		/* Exact frame rate num/den (fps is it rounded), 0/0 if unknown */
+		struct
+		{
+			uint32_t num;
+			uint32_t den;
+		} rate;
 	} video;
 	struct
 	{
@@ -36,6 +36,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include "eos_error.h"
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,11 +64,63 @@ typedef enum eos_out_vol_lvl
 	EOS_OUT_VOL_LVL_HEAVY
 } eos_out_vol_lvl_t;
 
+typedef enum eos_out_dec_thr
+{
+	EOS_OUT_DEC_THR_AUTO = 0, /* Slices when latency matters, frames otherwise */
+	EOS_OUT_DEC_THR_FRAME,    /* Throughput, output is delayed one frame per thread */
+	EOS_OUT_DEC_THR_SLICE,    /* Low latency, gain depends on how the stream is sliced */
+	EOS_OUT_DEC_THR_OFF
+} eos_out_dec_thr_t;
+
+typedef struct eos_mem_stats
+{
+	const char *module;
+	uint64_t live;
+	uint64_t peak;
+	uint64_t allocs;
+	uint64_t frees;
+	uint32_t rate;
+} eos_mem_stats_t;
+
+/* Milestone was not reached (yet) */
+#define EOS_ZAP_NONE (0xFFFFFFFF)
+/* Histogram bucket N holds zaps below 2^N ms, the last one everything above */
+#define EOS_ZAP_HIST_BUCKETS (16)
+
+typedef enum eos_zap_ms
+{
+	EOS_ZAP_MS_PLAY_REQ = 0,
+	EOS_ZAP_MS_CHAIN_CREATE,
+	EOS_ZAP_MS_SRC_LOCK,
+	EOS_ZAP_MS_PAT,
+	EOS_ZAP_MS_PMT,
+	EOS_ZAP_MS_SINK_SETUP,
+	EOS_ZAP_MS_FIRST_PKT,
+	EOS_ZAP_MS_FIRST_IFRM,
+	EOS_ZAP_MS_FIRST_DISP,
+	EOS_ZAP_MS_LAST
+} eos_zap_ms_t;
+
+typedef struct eos_zap_info
+{
+	/* Sequence number of the zap on the output */
+	uint32_t id;
+	/* Milliseconds since the play request, or EOS_ZAP_NONE */
+	uint32_t at[EOS_ZAP_MS_LAST];
+} eos_zap_info_t;
+
+typedef struct eos_zap_hist
+{
+	/* Number of completed zaps in the window */
+	uint32_t zaps;
+	uint32_t p50[EOS_ZAP_MS_LAST];
+	uint32_t p90[EOS_ZAP_MS_LAST];
+	uint32_t p99[EOS_ZAP_MS_LAST];
+	uint32_t buckets[EOS_ZAP_MS_LAST][EOS_ZAP_HIST_BUCKETS];
+} eos_zap_hist_t;
+
 #ifdef __cplusplus
 }
 #endif
 
-#include <stdint.h>
-#include <stdbool.h>
-
 #endif // EOS_TYPES_H_
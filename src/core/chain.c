@@ -36,35 +36,59 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "chain.h"
 #include "osi_sem.h"
 #include "osi_mutex.h"
-#include "osi_thread.h"
-#include "util_msgq.h"
+#include "osi_executor.h"
 #include "source.h"
 #include "sink.h"
 #include "osi_memory.h"
 #include "playback_ctrl_factory.h"
 #include "data_mgr.h"
+#include "zap_stats.h"
 #include "eos_macro.h"
 #include "util_log.h"
 
 #include <stdbool.h>
 
-#define CHAIN_EVENT_QUEUE_LEN (20)
-
 typedef struct chain_msg
 {
+	chain_t *chain;
 	link_ev_t event;
 	link_ev_data_t data;
 } chain_msg_t;
 
+/* Stream state as seen by readers. Published snapshot is never modified,
+ * writers (serialized by the control lock) publish a modified copy */
+typedef struct chain_snap
+{
+	int32_t refs;
+	util_mdesc_t *media;
+	eos_media_desc_t streams;
+	bool connected;
+	bool playing;
+} chain_snap_t;
+
+/* Data manager is released by whoever drops the last reference, so
+ * dispatching to it needs no lock */
+typedef struct chain_dmgr
+{
+	int32_t refs;
+	data_mgr_t *mgr;
+} chain_dmgr_t;
+
 struct chain
 {
 	uint32_t id;
 	osi_sem_t *sem;
+	/* Control lock, never held while events are dispatched */
 	osi_mutex_t *lock;
+	/* Only guards taking a reference of the current snapshot */
+	osi_mutex_t *snap_lock;
+	chain_snap_t *snap;
+	/* Only guards taking a reference of the current data manager */
+	osi_mutex_t *dispatch_lock;
 	source_t *source;
 	sink_t *sink;
 	playback_ctrl_t playback;
-	data_mgr_t *data_mgr;
+	chain_dmgr_t *dmgr;
 	int64_t pts;
 	uint32_t position;
 	chain_event_cbk_t cbk;
@@ -72,17 +96,30 @@ struct chain
 	chain_data_cbk_t data_cbk;
 	void* data_cookie;
 	eos_state_t state;
-	util_msgq_t *event_queue;
-	osi_thread_t *event_thread;
+	/* Events are handled in order on the shared executor */
+	osi_executor_serial_t *events;
 	util_log_t *log;
-	eos_media_desc_t streams;
-	bool connected;
-	bool playing;
+	/* Source lock is in progress (chain_lock waits for the connection) */
+	bool locking;
+	/* Lock in progress was interrupted (e.g. user zapped again) */
+	bool cancelled;
 };
 
 static void chain_event_hnd(link_ev_t event, link_ev_data_t* data,
 		void* cookie, uint64_t link_id);
-static void* chain_event_thread(void* arg);
+static void chain_event_process(void* arg);
+static void chain_msg_free(void* msg_data);
+static chain_snap_t* chain_snap_get(chain_t* chain);
+static void chain_snap_put(chain_snap_t** snap);
+static chain_snap_t* chain_snap_clone(chain_snap_t* snap);
+static void chain_snap_publish(chain_t* chain, chain_snap_t* snap);
+static eos_error_t chain_state_set(chain_t* chain, bool connected,
+		bool playing);
+static eos_error_t chain_data_mgr_load(chain_t* chain,
+		eos_media_desc_t* streams);
+static void chain_data_mgr_detach(chain_t* chain);
+static chain_dmgr_t* chain_dmgr_get(chain_t* chain);
+static void chain_dmgr_put(chain_dmgr_t** dmgr);
 static eos_error_t chain_process_data (void* cookie, engine_type_t engine_type,
                            engine_data_t data_type, uint8_t* data,
 						   uint32_t size);
@@ -91,7 +128,6 @@ eos_error_t chain_create(chain_t** chain, uint32_t id,
 		chain_handler_t* handler)
 {
 	eos_error_t error = EOS_ERROR_OK;
-	osi_thread_attr_t attr = {OSI_THREAD_JOINABLE};
 
 	if (chain == NULL)
 	{
@@ -117,15 +153,24 @@ eos_error_t chain_create(chain_t** chain, uint32_t id,
 	{
 		goto done;
 	}
-	/* TODO: add free message callback... */
-	error = util_msgq_create(&(*chain)->event_queue, CHAIN_EVENT_QUEUE_LEN,
-			NULL);
+	error = osi_mutex_create(&(*chain)->snap_lock);
 	if (error != EOS_ERROR_OK)
 	{
 		goto done;
 	}
-	error = osi_thread_create(&(*chain)->event_thread, &attr,
-			chain_event_thread, *chain);
+	error = osi_mutex_create(&(*chain)->dispatch_lock);
+	if (error != EOS_ERROR_OK)
+	{
+		goto done;
+	}
+	(*chain)->snap = chain_snap_clone(NULL);
+	if ((*chain)->snap == NULL)
+	{
+		error = EOS_ERROR_NOMEM;
+		goto done;
+	}
+	error = osi_executor_serial_create(&(*chain)->events,
+			osi_executor_shared(), chain_msg_free, OSI_EXECUTOR_ANY);
 	if (error != EOS_ERROR_OK)
 	{
 		goto done;
@@ -143,14 +188,23 @@ done:
 		{
 			util_log_destroy(&(*chain)->log);
 		}
-		if((*chain)->event_queue)
-		{
-			util_msgq_destroy(&(*chain)->event_queue);
-		}
 		if((*chain)->sem != NULL)
 		{
 			osi_sem_destroy(&(*chain)->sem);
 		}
+		if((*chain)->lock != NULL)
+		{
+			osi_mutex_destroy(&(*chain)->lock);
+		}
+		if((*chain)->snap_lock != NULL)
+		{
+			osi_mutex_destroy(&(*chain)->snap_lock);
+		}
+		if((*chain)->dispatch_lock != NULL)
+		{
+			osi_mutex_destroy(&(*chain)->dispatch_lock);
+		}
+		chain_snap_put(&(*chain)->snap);
 		osi_free((void**)chain);
 	}
 	return error;
@@ -172,32 +226,25 @@ eos_error_t chain_destroy(chain_t** chain)
 	}
 
 
-	if ((*chain)->event_queue)
+	if ((*chain)->events)
 	{
-		util_msgq_pause((*chain)->event_queue);
-
-		if (osi_thread_join((*chain)->event_thread, NULL) != EOS_ERROR_OK)
-		{
-
-		}
-		if (osi_thread_release(&(*chain)->event_thread) != EOS_ERROR_OK)
-		{
-
-		}
-		if (util_msgq_destroy(&(*chain)->event_queue) != EOS_ERROR_OK)
+		if (osi_executor_serial_destroy(&(*chain)->events) != EOS_ERROR_OK)
 		{
-			UTIL_GLOGW("Unable to destroy queue");
+			UTIL_GLOGW("Unable to destroy event queue");
 		}
 		else
 		{
-			UTIL_GLOGI("Destroyed queue");
+			UTIL_GLOGI("Destroyed event queue");
 		}
 	}
 
+	chain_snap_put(&(*chain)->snap);
 	if (osi_mutex_destroy(&(*chain)->lock) != EOS_ERROR_OK)
 	{
 
 	}
+	osi_mutex_destroy(&(*chain)->snap_lock);
+	osi_mutex_destroy(&(*chain)->dispatch_lock);
 
 	if (osi_sem_destroy(&(*chain)->sem) != EOS_ERROR_OK)
 	{
@@ -213,6 +260,47 @@ eos_error_t chain_destroy(chain_t** chain)
 	return EOS_ERROR_OK;
 }
 
+eos_error_t chain_reset(chain_t* chain, chain_handler_t* handler)
+{
+	chain_snap_t *snap = NULL;
+
+	if ((chain == NULL) || (handler == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if ((chain->source != NULL) || (chain->sink != NULL))
+	{
+		UTIL_LOGE(chain->log, "Chain is still assembled");
+		return EOS_ERROR_PERM;
+	}
+	snap = chain_snap_clone(NULL);
+	if (snap == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	chain_data_mgr_detach(chain);
+	/* Whatever is still queued belongs to the previous zap, and the event
+	 * in flight must not see the new handler */
+	osi_executor_serial_flush(chain->events);
+	osi_executor_serial_sync(chain->events);
+
+	osi_mutex_lock(chain->lock);
+	chain_snap_publish(chain, snap);
+	osi_memset(&chain->playback, 0, sizeof(playback_ctrl_t));
+	chain->pts = 0;
+	chain->position = 0;
+	chain->state = EOS_STATE_STOPPED;
+	chain->locking = false;
+	chain->cancelled = false;
+	chain->cbk = handler->event_cbk;
+	chain->cookie = handler->event_cookie;
+	chain->data_cbk = handler->data_cbk;
+	chain->data_cookie = handler->data_cookie;
+	osi_mutex_unlock(chain->lock);
+
+	return EOS_ERROR_OK;
+}
+
 eos_error_t chain_set_event_cbk(chain_t* chain, chain_event_cbk_t cbk, void* cookie)
 {
 	eos_error_t err = EOS_ERROR_OK;
@@ -282,7 +370,7 @@ eos_error_t chain_set_source(chain_t* chain, source_t* source)
 	{
 		return error;
 	}
-	if ((source == NULL) && (chain->connected == true))
+	if ((source == NULL) && (chain->snap->connected == true))
 	{
 		osi_mutex_unlock(chain->lock);
 		return EOS_ERROR_GENERAL;
@@ -314,6 +402,12 @@ eos_error_t chain_interrupt(chain_t* chain)
 	}
 
 	source = chain->source;
+	if (chain->locking)
+	{
+		/* Do not wait for the source to give up, wake up the pending lock right away */
+		chain->cancelled = true;
+		osi_sem_post(chain->sem);
+	}
 
 	osi_mutex_unlock(chain->lock);
 	return source->suspend(source);
@@ -343,7 +437,7 @@ eos_error_t chain_lock(chain_t* chain, char* url, char* extras,
 		return EOS_ERROR_INVAL;
 	}
 
-	if (chain->connected)
+	if (chain->snap->connected)
 	{
 		UTIL_LOGE(chain->log, "Source already connected!");
 		osi_mutex_unlock(chain->lock);
@@ -351,12 +445,24 @@ eos_error_t chain_lock(chain_t* chain, char* url, char* extras,
 	}
 
 	source = chain->source;
+	/* Drop the leftover post of a previous (interrupted or timed out) lock */
+	osi_time_get_time(&current_time);
+	while (osi_sem_timedwait(chain->sem, &current_time) == EOS_ERROR_OK);
+	chain->locking = true;
+	chain->cancelled = false;
 
 	osi_mutex_unlock(chain->lock);
 	error = source->lock(source, url, extras, chain_event_hnd, (void*)chain);
+	if (error == EOS_ERROR_OK)
+	{
+		zap_stats_mark(chain->id, EOS_ZAP_MS_SRC_LOCK);
+	}
 
 	if (error != EOS_ERROR_OK)
 	{
+		osi_mutex_lock(chain->lock);
+		chain->locking = false;
+		osi_mutex_unlock(chain->lock);
 		return error;
 	}
 	osi_time_get_time(&current_time);
@@ -366,10 +472,19 @@ eos_error_t chain_lock(chain_t* chain, char* url, char* extras,
 	{
 		return EOS_ERROR_GENERAL;
 	}
+	chain->locking = false;
+	if (chain->cancelled)
+	{
+		UTIL_LOGW(chain->log, "Source lock interrupted");
+		chain->cancelled = false;
+		osi_mutex_unlock(chain->lock);
+		source->unlock(source);
+		return EOS_ERROR_AGAIN;
+	}
 
 	if (error == EOS_ERROR_OK)
 	{
-		if (chain->connected)
+		if (chain->snap->connected)
 		{
 			osi_mutex_unlock(chain->lock);
 			return EOS_ERROR_OK;
@@ -407,8 +522,7 @@ eos_error_t chain_unlock(chain_t* chain)
 		return EOS_ERROR_INVAL;
 	}
 	source = chain->source;
-	chain->connected = false;
-	chain->playing = false;
+	chain_state_set(chain, false, false);
 
 	osi_mutex_unlock(chain->lock);
 	return source->unlock(source);
@@ -417,6 +531,7 @@ eos_error_t chain_unlock(chain_t* chain)
 eos_error_t chain_set_track(chain_t* chain, uint32_t id, bool on)
 {
 	eos_error_t err = EOS_ERROR_OK;
+	chain_snap_t *snap = NULL;
 
 	if (chain == NULL)
 	{
@@ -437,20 +552,23 @@ eos_error_t chain_set_track(chain_t* chain, uint32_t id, bool on)
 
 	if (chain->playback.select == NULL)
 	{
+		osi_mutex_unlock(chain->lock);
 		return EOS_ERROR_GENERAL;
 	}
-	err = chain->playback.select(&chain->playback, chain, &chain->streams, id, on);
-	if (err == EOS_ERROR_OK)
+	snap = chain_snap_clone(chain->snap);
+	if (snap == NULL)
 	{
 		osi_mutex_unlock(chain->lock);
-		return err; 
+		return EOS_ERROR_NOMEM;
 	}
-	err = data_mgr_set(chain->data_mgr, chain, &chain->streams, id, on);
-	if (err == EOS_ERROR_OK)
+	err = chain->playback.select(&chain->playback, chain, &snap->streams,
+			id, on);
+	if (err != EOS_ERROR_OK)
 	{
-		osi_mutex_unlock(chain->lock);
-		return err; 
+		err = data_mgr_set((chain->dmgr != NULL) ? chain->dmgr->mgr : NULL,
+				chain, &snap->streams, id, on);
 	}
+	chain_snap_publish(chain, snap);
 	osi_mutex_unlock(chain->lock);
 
 	return err;
@@ -539,6 +657,7 @@ eos_error_t chain_start(chain_t* chain)
 {
 	// TODO PRINT
 	eos_error_t error = EOS_ERROR_OK;
+	chain_snap_t *snap = NULL;
 
 	if (chain == NULL)
 	{
@@ -548,8 +667,19 @@ eos_error_t chain_start(chain_t* chain)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	chain_load_data_mgr(chain);
-	error = chain->playback.start(&chain->playback, chain, &chain->streams);
+	osi_mutex_lock(chain->lock);
+	/* Track selection is done on a private copy, readers keep seeing the
+	 * previous selection until it is published */
+	snap = chain_snap_clone(chain->snap);
+	if (snap == NULL)
+	{
+		osi_mutex_unlock(chain->lock);
+		return EOS_ERROR_NOMEM;
+	}
+	chain_data_mgr_load(chain, &snap->streams);
+	error = chain->playback.start(&chain->playback, chain, &snap->streams);
+	chain_snap_publish(chain, snap);
+	osi_mutex_unlock(chain->lock);
 	if (error != EOS_ERROR_OK)
 	{
 		//TODO PRINT
@@ -629,8 +759,7 @@ eos_error_t chain_stop(chain_t* chain)
 	}
 	// TODO Error handling
 	osi_mutex_lock(chain->lock);
-	chain->connected = false;
-	chain->playing = false;
+	chain_state_set(chain, false, false);
 	osi_mutex_unlock(chain->lock);
 
 	chain_unload_data_mgr(chain);
@@ -643,7 +772,9 @@ eos_error_t chain_stop(chain_t* chain)
 	{
 		UTIL_LOGI(chain->log, "Stopping chain [Success]");
 	}
-	util_msgq_flush(chain->event_queue);
+	/* Drop queued events and let the one in flight finish */
+	osi_executor_serial_flush(chain->events);
+	osi_executor_serial_sync(chain->events);
 
 	return error;
 }
@@ -661,65 +792,157 @@ eos_error_t chain_get_source(chain_t* chain, source_t** source)
 
 eos_error_t chain_get_streams(chain_t* chain, eos_media_desc_t* streams)
 {
-	eos_error_t err = EOS_ERROR_OK;
+	chain_snap_t *snap = NULL;
 
 	if ((chain == NULL) || (streams == NULL))
 	{
 		return EOS_ERROR_INVAL;
 	}
-	err = osi_mutex_lock(chain->lock);
-	if (err != EOS_ERROR_OK)
+	snap = chain_snap_get(chain);
+	osi_memcpy(streams, &snap->streams, sizeof(eos_media_desc_t));
+	chain_snap_put(&snap);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t chain_get_media(chain_t* chain, util_mdesc_t** media)
+{
+	chain_snap_t *snap = NULL;
+
+	if ((chain == NULL) || (media == NULL))
 	{
-		return err;
+		return EOS_ERROR_INVAL;
 	}
-	osi_memcpy(streams, &chain->streams, sizeof(eos_media_desc_t));
+	snap = chain_snap_get(chain);
+	*media = util_mdesc_ref(snap->media);
+	chain_snap_put(&snap);
 
-	return osi_mutex_unlock(chain->lock);
+	return (*media != NULL) ? EOS_ERROR_OK : EOS_ERROR_NFOUND;
 }
 
 eos_error_t chain_get_stream_data(chain_t* chain, eos_media_codec_t codec,
 		uint32_t id, eos_media_data_t **data)
 {
+	eos_error_t error = EOS_ERROR_OK;
+	chain_dmgr_t *dmgr = NULL;
+
 	if (chain == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	if (chain->data_mgr != NULL)
+	/* Reference keeps it alive even if it is detached meanwhile */
+	dmgr = chain_dmgr_get(chain);
+	if (dmgr != NULL)
 	{
-		return data_mgr_poll(chain->data_mgr, codec, id, data);
+		error = data_mgr_poll(dmgr->mgr, codec, id, data);
+		chain_dmgr_put(&dmgr);
 	}
 	else
 	{
 		UTIL_LOGW(chain->log, "Data manager is NULL?!?");
 	}
 
-	return EOS_ERROR_OK;
+	return error;
 }
 
-eos_error_t chain_load_data_mgr(chain_t* chain)
+static eos_error_t chain_data_mgr_load(chain_t* chain,
+		eos_media_desc_t* streams)
 {
 	eos_error_t error = EOS_ERROR_OK;
 	engine_cb_data_t engine_cb;
+	chain_dmgr_t *dmgr = NULL;
 
-	if (chain == NULL)
-	{
-		return EOS_ERROR_INVAL;
-	}
-	if (chain->data_mgr != NULL)
+	if (chain->dmgr != NULL)
 	{
 		UTIL_LOGW(chain->log, "Data manager is not NULL");
-		data_mgr_stop(chain->data_mgr);
-		data_mgr_destroy(&chain->data_mgr);
+		chain_data_mgr_detach(chain);
 	}
 	engine_cb.cookie = (void*)chain;
 	engine_cb.func = chain_process_data;
-	error = data_mgr_create(&chain->data_mgr, engine_cb);
+	dmgr = (chain_dmgr_t*)osi_calloc(sizeof(chain_dmgr_t));
+	if (dmgr == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	error = data_mgr_create(&dmgr->mgr, engine_cb);
 	if (error != EOS_ERROR_OK)
 	{
 		UTIL_LOGE(chain->log, "Cannot create data manager");
+		osi_free((void**)&dmgr);
 		return error;
 	}
-	return data_mgr_start(chain->data_mgr, chain, &chain->streams);
+	error = data_mgr_start(dmgr->mgr, chain, streams);
+	dmgr->refs = 1;
+	osi_mutex_lock(chain->dispatch_lock);
+	chain->dmgr = dmgr;
+	osi_mutex_unlock(chain->dispatch_lock);
+
+	return error;
+}
+
+static void chain_data_mgr_detach(chain_t* chain)
+{
+	chain_dmgr_t *dmgr = NULL;
+
+	osi_mutex_lock(chain->dispatch_lock);
+	dmgr = chain->dmgr;
+	chain->dmgr = NULL;
+	osi_mutex_unlock(chain->dispatch_lock);
+	/* Engines are stopped here, or by the dispatch still holding it */
+	chain_dmgr_put(&dmgr);
+}
+
+static chain_dmgr_t* chain_dmgr_get(chain_t* chain)
+{
+	chain_dmgr_t *dmgr = NULL;
+
+	osi_mutex_lock(chain->dispatch_lock);
+	dmgr = chain->dmgr;
+	if (dmgr != NULL)
+	{
+		__sync_add_and_fetch(&dmgr->refs, 1);
+	}
+	osi_mutex_unlock(chain->dispatch_lock);
+
+	return dmgr;
+}
+
+static void chain_dmgr_put(chain_dmgr_t** dmgr)
+{
+	if (*dmgr == NULL)
+	{
+		return;
+	}
+	if (__sync_sub_and_fetch(&(*dmgr)->refs, 1) == 0)
+	{
+		data_mgr_stop((*dmgr)->mgr);
+		data_mgr_destroy(&(*dmgr)->mgr);
+		osi_free((void**)dmgr);
+	}
+	*dmgr = NULL;
+}
+
+eos_error_t chain_load_data_mgr(chain_t* chain)
+{
+	eos_error_t error = EOS_ERROR_OK;
+	chain_snap_t *snap = NULL;
+
+	if (chain == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(chain->lock);
+	snap = chain_snap_clone(chain->snap);
+	if (snap == NULL)
+	{
+		osi_mutex_unlock(chain->lock);
+		return EOS_ERROR_NOMEM;
+	}
+	error = chain_data_mgr_load(chain, &snap->streams);
+	chain_snap_publish(chain, snap);
+	osi_mutex_unlock(chain->lock);
+
+	return error;
 }
 
 eos_error_t chain_unload_data_mgr(chain_t* chain)
@@ -728,11 +951,10 @@ eos_error_t chain_unload_data_mgr(chain_t* chain)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	if (chain->data_mgr != NULL)
+	if (chain->dmgr != NULL)
 	{
 		osi_mutex_lock(chain->lock);
-		data_mgr_stop(chain->data_mgr);
-		data_mgr_destroy(&chain->data_mgr);
+		chain_data_mgr_detach(chain);
 		osi_mutex_unlock(chain->lock);
 	}
 	else
@@ -749,7 +971,7 @@ eos_error_t chain_get_data_mgr(chain_t* chain, data_mgr_t** data_mgr)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	*data_mgr = chain->data_mgr;
+	*data_mgr = (chain->dmgr != NULL) ? chain->dmgr->mgr : NULL;
 
 	return EOS_ERROR_OK;
 }
@@ -770,7 +992,6 @@ static void chain_event_hnd(link_ev_t event, link_ev_data_t* data,
 {
 	chain_t *chain = NULL;
 	chain_msg_t *msg = NULL;
-	size_t sz = sizeof(chain_msg_t);
 
 	EOS_UNUSED(link_id);
 	if(cookie == NULL)
@@ -779,215 +1000,268 @@ static void chain_event_hnd(link_ev_t event, link_ev_data_t* data,
 		return;
 	}
 	chain = (chain_t*) cookie;
-	msg = osi_calloc(sz);
+	if (event == LINK_EV_CONNECTED)
+	{
+		zap_stats_mark(chain->id, EOS_ZAP_MS_PMT);
+	}
+	else if ((event == LINK_EV_MILESTONE) && (data != NULL))
+	{
+		/* Only the completed zap goes further (to be reported) */
+		if ((zap_stats_mark(chain->id, data->milestone.id) != EOS_ERROR_OK) ||
+				(data->milestone.id != EOS_ZAP_MS_FIRST_DISP))
+		{
+			return;
+		}
+	}
+	msg = osi_calloc(sizeof(chain_msg_t));
 	if(msg == NULL)
 	{
 		UTIL_LOGE(chain->log, "Ignoring event: OOM on message alloc");
 		return;
 	}
+	msg->chain = chain;
 	msg->event = event;
 	if (data != NULL)
 	{
 		osi_memcpy(&msg->data, data, sizeof(link_ev_data_t));
+		if (event == LINK_EV_CONNECTED)
+		{
+			/* Descriptor has to outlive the emitter's call */
+			util_mdesc_ref(msg->data.conn_info.media);
+		}
 	}
-	if(util_msgq_put(chain->event_queue, (void*)msg, sz, NULL)
+	if(osi_executor_serial_run(chain->events, chain_event_process, msg)
 			!= EOS_ERROR_OK)
 	{
 		UTIL_LOGE(chain->log, "Ignoring event: failed to put message!");
-		osi_free((void**)&msg);
+		chain_msg_free(msg);
 	}
 }
 
-static void* chain_event_thread(void* arg)
+static void chain_msg_free(void* msg_data)
 {
-	chain_t *chain = (chain_t*) arg;
-	chain_msg_t *msg;
-	eos_error_t err = EOS_ERROR_OK;
-	size_t sz = 0;
-	eos_event_t event = EOS_EVENT_LAST;
-	eos_event_data_t event_data;
+	chain_msg_t *msg = (chain_msg_t*)msg_data;
 
-	if(chain == NULL)
+	if (msg == NULL)
 	{
-		return NULL;
+		return;
+	}
+	if (msg->event == LINK_EV_CONNECTED)
+	{
+		util_mdesc_unref(&msg->data.conn_info.media);
 	}
-	UTIL_LOGI(chain->log, "Chain event thread started...");
-	while(util_msgq_get(chain->event_queue, (void**)&msg, &sz, NULL)
-			== EOS_ERROR_OK)
-	{
-//		if(msg->event != LINK_EV_FRAME_DISP)
-//			UTIL_LOGI(chain->log, "Event thread %d", msg->event);
-		/* Invalidate event */
-		event = EOS_EVENT_LAST;
-		osi_memset(&event_data, 0, sizeof(eos_event_data_t));
-		/* Handle internal state... */
-		switch(msg->event)
+	osi_free((void**)&msg);
+}
+
+static void chain_event_process(void* arg)
+{
+	chain_msg_t *msg = (chain_msg_t*) arg;
+	chain_t *chain = msg->chain;
+	eos_error_t err = EOS_ERROR_OK;
+	eos_event_t event = EOS_EVENT_LAST;
+	eos_event_data_t event_data;
+	chain_snap_t *snap = NULL;
+	chain_dmgr_t *dmgr = NULL;
+	bool playing = false;
+
+//	if(msg->event != LINK_EV_FRAME_DISP)
+//		UTIL_LOGI(chain->log, "Event thread %d", msg->event);
+	/* Invalidate event */
+	event = EOS_EVENT_LAST;
+	osi_memset(&event_data, 0, sizeof(eos_event_data_t));
+	/* Handle internal state... */
+	switch(msg->event)
+	{
+	case LINK_EV_CONNECTED:
+		UTIL_LOGI(chain->log, "CONNECTED");
+		osi_mutex_lock(chain->lock);
+		snap = chain_snap_clone(NULL);
+		if (snap != NULL)
 		{
-		case LINK_EV_CONNECTED:
-			UTIL_LOGI(chain->log, "CONNECTED");
-			eos_media_desc_t *streams = &msg->data.conn_info.media;
-			osi_mutex_lock(chain->lock);
-			if (streams != NULL)
-			{
-				osi_memcpy(&chain->streams, streams, sizeof(eos_media_desc_t));
-				chain->connected = true;
-			}
-			else
+			snap->playing = chain->snap->playing;
+			if (msg->data.conn_info.media != NULL)
 			{
-				osi_memset(&chain->streams, 0, sizeof(eos_media_desc_t));
-				chain->connected = false;
+				/* Message reference is handed over to the snapshot */
+				snap->media = msg->data.conn_info.media;
+				msg->data.conn_info.media = NULL;
+				util_mdesc_expand(snap->media, &snap->streams);
+				snap->connected = true;
 			}
-			osi_mutex_unlock(chain->lock);
-			osi_sem_post(chain->sem);
-			event = EOS_EVENT_CONN_STATE;
-			event_data.conn.state = EOS_CONNECTED;
-			event_data.conn.reason = EOS_CONN_USER;
-			break;
-		case LINK_EV_CONN_LOST:
-			UTIL_LOGW(chain->log, "CONN LOST");
-			osi_mutex_lock(chain->lock);
-			osi_memset(&chain->streams, 0, sizeof(eos_media_desc_t));
-			chain->connected = false;
-			chain->playing = false;
-			osi_mutex_unlock(chain->lock);
-			event = EOS_EVENT_CONN_STATE;
-			event_data.conn.state = EOS_DISCONNECTED;
-			/* TODO check msg->data.conn_info.reason */
-			event_data.conn.reason = EOS_CONN_RD_ERR;
-			break;
-		case LINK_EV_DISCONN:
-			UTIL_LOGW(chain->log, "DISCONNECTED");
-			osi_mutex_lock(chain->lock);
-			osi_memset(&chain->streams, 0, sizeof(eos_media_desc_t));
-			chain->connected = false;
-			chain->playing = false;
-			osi_mutex_unlock(chain->lock);
-			event = EOS_EVENT_CONN_STATE;
-			event_data.conn.state = EOS_DISCONNECTED;
-			/* TODO check msg->data.conn_info.reason */
-			event_data.conn.reason = EOS_CONN_USER;
-			break;
-		case LINK_EV_NO_CONNECT:
-			UTIL_LOGW(chain->log, "NO CONNECTION");
-			osi_mutex_lock(chain->lock);
-			osi_memset(&chain->streams, 0, sizeof(eos_media_desc_t));
-			chain->connected = false;
-			osi_mutex_unlock(chain->lock);
-			osi_sem_post(chain->sem);
+			chain_snap_publish(chain, snap);
+		}
+		osi_mutex_unlock(chain->lock);
+		osi_sem_post(chain->sem);
+		event = EOS_EVENT_CONN_STATE;
+		event_data.conn.state = EOS_CONNECTED;
+		event_data.conn.reason = EOS_CONN_USER;
+		break;
+	case LINK_EV_CONN_LOST:
+		UTIL_LOGW(chain->log, "CONN LOST");
+		osi_mutex_lock(chain->lock);
+		chain_snap_publish(chain, chain_snap_clone(NULL));
+		osi_mutex_unlock(chain->lock);
+		event = EOS_EVENT_CONN_STATE;
+		event_data.conn.state = EOS_DISCONNECTED;
+		/* TODO check msg->data.conn_info.reason */
+		event_data.conn.reason = EOS_CONN_RD_ERR;
+		break;
+	case LINK_EV_DISCONN:
+		UTIL_LOGW(chain->log, "DISCONNECTED");
+		osi_mutex_lock(chain->lock);
+		chain_snap_publish(chain, chain_snap_clone(NULL));
+		osi_mutex_unlock(chain->lock);
+		event = EOS_EVENT_CONN_STATE;
+		event_data.conn.state = EOS_DISCONNECTED;
+		/* TODO check msg->data.conn_info.reason */
+		event_data.conn.reason = EOS_CONN_USER;
+		break;
+	case LINK_EV_NO_CONNECT:
+		UTIL_LOGW(chain->log, "NO CONNECTION");
+		osi_mutex_lock(chain->lock);
+		snap = chain_snap_clone(NULL);
+		if (snap != NULL)
+		{
+			snap->playing = chain->snap->playing;
+			chain_snap_publish(chain, snap);
+		}
+		osi_mutex_unlock(chain->lock);
+		osi_sem_post(chain->sem);
+		break;
+	case LINK_EV_FRAME_DISP:
+		/* Every frame: peek at the snapshot, lock only on the transition */
+		snap = chain_snap_get(chain);
+		playing = snap->playing;
+		chain_snap_put(&snap);
+		if (playing)
+		{
 			break;
-		case LINK_EV_FRAME_DISP:
-			osi_mutex_lock(chain->lock);
-			if ((chain->playing != true) && (chain->connected == true))
+		}
+		osi_mutex_lock(chain->lock);
+		if ((chain->snap->playing != true) && (chain->snap->connected == true))
+		{
+			if (chain_state_set(chain, true, true) == EOS_ERROR_OK)
 			{
-				chain->playing = true;
 				event = EOS_EVENT_STATE;
 				event_data.state.state = EOS_STATE_PLAYING;
 				UTIL_LOGI(chain->log, "Playback started");
 			}
-			osi_mutex_unlock(chain->lock);
-			break;
-		default:
-			break;
 		}
+		osi_mutex_unlock(chain->lock);
+		break;
+	default:
+		break;
+	}
 
-		osi_mutex_lock(chain->lock);
-		/* Inform other core modules about this event */
-		if ((chain->playback.handle_event != NULL) && chain->connected && chain->playing)
-		{
-			err = chain->playback.handle_event(&chain->playback, chain,
-					msg->event, &msg->data);
-			if(err != EOS_ERROR_OK)
-			{
-				UTIL_LOGW(chain->log, "Playback controller event handler "
-						"returned error %d", err);
-			}
-		}
-		err = data_mgr_hande_event(chain->data_mgr, msg->event, &msg->data);
+	/* Inform other core modules about this event. Engines can take their
+	 * time, control calls do not wait for them */
+	snap = chain_snap_get(chain);
+	playing = snap->connected && snap->playing;
+	chain_snap_put(&snap);
+	if ((chain->playback.handle_event != NULL) && playing)
+	{
+		err = chain->playback.handle_event(&chain->playback, chain,
+				msg->event, &msg->data);
 		if(err != EOS_ERROR_OK)
 		{
-			UTIL_LOGW(chain->log, "Data manager event handler "
+			UTIL_LOGW(chain->log, "Playback controller event handler "
 					"returned error %d", err);
 		}
-		osi_mutex_unlock(chain->lock);
+	}
+	dmgr = chain_dmgr_get(chain);
+	err = data_mgr_hande_event((dmgr != NULL) ? dmgr->mgr : NULL, msg->event,
+			&msg->data);
+	chain_dmgr_put(&dmgr);
+	if(err != EOS_ERROR_OK)
+	{
+		UTIL_LOGW(chain->log, "Data manager event handler "
+				"returned error %d", err);
+	}
 
-		/* Inform upper layer */
-		if(chain->cbk != NULL)
+	/* Inform upper layer */
+	if(chain->cbk != NULL)
+	{
+		/* Translate event, if is not done before */
+		if(event == EOS_EVENT_LAST)
 		{
-			/* Translate event, if is not done before */
-			if(event == EOS_EVENT_LAST)
+			switch(msg->event)
 			{
-				switch(msg->event)
-				{
-				case LINK_EV_LOW_WM:
-					event = EOS_EVENT_PBK_STATUS;
-					event_data.pbk_status = EOS_PBK_LOW_WM;
-					break;
-				case LINK_EV_HIGH_WM:
+			case LINK_EV_LOW_WM:
+				event = EOS_EVENT_PBK_STATUS;
+				event_data.pbk_status = EOS_PBK_LOW_WM;
+				break;
+			case LINK_EV_HIGH_WM:
 #if 0
-					event = EOS_EVENT_PBK_STATUS;
-					event_data.pbk_status = EOS_PBK_HIGH_WM;
+				event = EOS_EVENT_PBK_STATUS;
+				event_data.pbk_status = EOS_PBK_HIGH_WM;
 #else
-					UTIL_LOGD(chain->log, "Ignoring HIGH WM");
+				UTIL_LOGD(chain->log, "Ignoring HIGH WM");
 #endif
-					break;
-				case LINK_EV_BOS:
-					UTIL_GLOGD("EOS BEGIN received!");
-					event = EOS_EVENT_PBK_STATUS;
-					event_data.pbk_status = EOS_PBK_BOS;
-					break;
-				case LINK_EV_EOS:
-					UTIL_GLOGD("EOS END received!");
-					event = EOS_EVENT_PBK_STATUS;
-					event_data.pbk_status = EOS_PBK_EOS;
-					break;
-				case LINK_EV_PLAY_INFO:
-					//TODO: do we send paused state
+				break;
+			case LINK_EV_BOS:
+				UTIL_GLOGD("EOS BEGIN received!");
+				event = EOS_EVENT_PBK_STATUS;
+				event_data.pbk_status = EOS_PBK_BOS;
+				break;
+			case LINK_EV_EOS:
+				UTIL_GLOGD("EOS END received!");
+				event = EOS_EVENT_PBK_STATUS;
+				event_data.pbk_status = EOS_PBK_EOS;
+				break;
+			case LINK_EV_PLAY_INFO:
+				//TODO: do we send paused state
 #if 0
-					if(msg->data.play_info.speed)
-					{
-						UTIL_LOGW(chain->log, "Detected PAUSE in play info");
-						event = EOS_EVENT_STATE;
-						event_data.state.state = EOS_STATE_PAUSED;
-						break;
-					}
-#endif
-					event = EOS_EVENT_PLAY_INFO;
-					event_data.play_info.position =
-							msg->data.play_info.position;
-					event_data.play_info.begin = msg->data.play_info.begin;
-					event_data.play_info.speed = msg->data.play_info.speed;
-					event_data.play_info.end = msg->data.play_info.end;
-					break;
-				case LINK_EV_FRAME_DISP:
-					/* This one is handled internally */
-					break;
-				default:
-					UTIL_LOGW(chain->log, "Ignoring UNKNOWN event #%d",
-							msg->event);
+				if(msg->data.play_info.speed)
+				{
+					UTIL_LOGW(chain->log, "Detected PAUSE in play info");
+					event = EOS_EVENT_STATE;
+					event_data.state.state = EOS_STATE_PAUSED;
 					break;
 				}
+#endif
+				event = EOS_EVENT_PLAY_INFO;
+				event_data.play_info.position =
+						msg->data.play_info.position;
+				event_data.play_info.begin = msg->data.play_info.begin;
+				event_data.play_info.speed = msg->data.play_info.speed;
+				event_data.play_info.end = msg->data.play_info.end;
+				break;
+			case LINK_EV_FRAME_DISP:
+				/* This one is handled internally */
+				break;
+			case LINK_EV_MILESTONE:
+				if (zap_stats_get(chain->id, &event_data.zap, NULL)
+						== EOS_ERROR_OK)
+				{
+					event = EOS_EVENT_ZAP;
+				}
+				break;
+			default:
+				UTIL_LOGW(chain->log, "Ignoring UNKNOWN event #%d",
+						msg->event);
+				break;
 			}
-			/* Check again weather we have correct translation */
-			if(event == EOS_EVENT_LAST)
-			{
-				osi_free((void**)&msg);
+		}
+		/* Check again weather we have correct translation */
+		if(event == EOS_EVENT_LAST)
+		{
+			chain_msg_free(msg);
 
-				continue;
-			}
-//			UTIL_LOGW(chain->log, "Before callback %d", msg->event);
-			err = chain->cbk(chain, event, &event_data, chain->cookie);
-			if(err != EOS_ERROR_OK)
-			{
-				UTIL_LOGW(chain->log, "Chain message handling failed "
-						"with error code %d", err);
-			}
-//			UTIL_LOGW(chain->log, "After callback %d", msg->event);
-			osi_free((void**)&msg);
+			return;
 		}
+//		UTIL_LOGW(chain->log, "Before callback %d", msg->event);
+		err = chain->cbk(chain, event, &event_data, chain->cookie);
+		if(err != EOS_ERROR_OK)
+		{
+			UTIL_LOGW(chain->log, "Chain message handling failed "
+					"with error code %d", err);
+		}
+//		UTIL_LOGW(chain->log, "After callback %d", msg->event);
+		chain_msg_free(msg);
+	}
+	else
+	{
+		chain_msg_free(msg);
 	}
-	UTIL_LOGI(chain->log, "Chain event thread exited...");
-
-	return NULL;
 }
 
 static eos_error_t chain_process_data (void* cookie, engine_type_t engine_type,
@@ -1006,3 +1280,86 @@ static eos_error_t chain_process_data (void* cookie, engine_type_t engine_type,
 
 	return EOS_ERROR_OK;
 }
+
+static chain_snap_t* chain_snap_get(chain_t* chain)
+{
+	chain_snap_t *snap = NULL;
+
+	osi_mutex_lock(chain->snap_lock);
+	snap = chain->snap;
+	__sync_add_and_fetch(&snap->refs, 1);
+	osi_mutex_unlock(chain->snap_lock);
+
+	return snap;
+}
+
+static void chain_snap_put(chain_snap_t** snap)
+{
+	if (*snap == NULL)
+	{
+		return;
+	}
+	if (__sync_sub_and_fetch(&(*snap)->refs, 1) == 0)
+	{
+		util_mdesc_unref(&(*snap)->media);
+		osi_free((void**)snap);
+	}
+	*snap = NULL;
+}
+
+static chain_snap_t* chain_snap_clone(chain_snap_t* snap)
+{
+	chain_snap_t *tmp = NULL;
+
+	tmp = (chain_snap_t*)osi_calloc(sizeof(chain_snap_t));
+	if (tmp == NULL)
+	{
+		UTIL_GLOGE("Chain state allocation failed");
+		return NULL;
+	}
+	if (snap != NULL)
+	{
+		osi_memcpy(tmp, snap, sizeof(chain_snap_t));
+		util_mdesc_ref(tmp->media);
+	}
+	tmp->refs = 1;
+
+	return tmp;
+}
+
+static void chain_snap_publish(chain_t* chain, chain_snap_t* snap)
+{
+	chain_snap_t *old = NULL;
+
+	if (snap == NULL)
+	{
+		return;
+	}
+	osi_mutex_lock(chain->snap_lock);
+	old = chain->snap;
+	chain->snap = snap;
+	osi_mutex_unlock(chain->snap_lock);
+	chain_snap_put(&old);
+}
+
+static eos_error_t chain_state_set(chain_t* chain, bool connected,
+		bool playing)
+{
+	chain_snap_t *snap = NULL;
+
+	if ((chain->snap->connected == connected) &&
+			(chain->snap->playing == playing))
+	{
+		return EOS_ERROR_OK;
+	}
+	snap = chain_snap_clone(chain->snap);
+	if (snap == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	snap->connected = connected;
+	snap->playing = playing;
+	chain_snap_publish(chain, snap);
+
+	return EOS_ERROR_OK;
+}
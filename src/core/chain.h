@@ -64,6 +64,9 @@ typedef struct chain_handler
 eos_error_t chain_create(chain_t** chain, uint32_t id,
 		chain_handler_t* handler);
 eos_error_t chain_destroy(chain_t** chain);
+/* Brings a disassembled chain (no source nor sink) back to the state it had
+ * right after chain_create so it can serve the next zap */
+eos_error_t chain_reset(chain_t* chain, chain_handler_t* handler);
 eos_error_t chain_get_id(chain_t* chain, uint32_t* id);
 eos_error_t chain_set_source(chain_t* chain, source_t* source);
 eos_error_t chain_interrupt(chain_t* chain);
@@ -74,6 +77,8 @@ eos_error_t chain_set_track(chain_t* chain, uint32_t id, bool on);
 eos_error_t chain_set_sink(chain_t* chain, sink_t* sink);
 eos_error_t chain_get_source(chain_t* chain, source_t** source);
 eos_error_t chain_get_streams(chain_t* chain, eos_media_desc_t* streams);
+/* Returns new reference to the connected media descriptor (release it with util_mdesc_unref) */
+eos_error_t chain_get_media(chain_t* chain, util_mdesc_t** media);
 eos_error_t chain_get_stream_data(chain_t* chain, eos_media_codec_t codec,
 		uint32_t id, eos_media_data_t **data);
 eos_error_t chain_load_data_mgr(chain_t* chain);
@@ -51,9 +51,10 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "osi_sem.h"
 #include "osi_mutex.h"
 #include "osi_memory.h"
-#include "osi_thread.h"
+#include "osi_executor.h"
 
 #include "chain_manager.h"
+#include "zap_stats.h"
 
 #include <string.h>
 
@@ -62,7 +63,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 // *************************************
 
 #define INTERRUPTABLE
-//#define UNSYNC
+/* Outputs that get a ready made chain at module init */
+#define CHAIN_MANAGER_PREWARM_FIRST EOS_OUT_MAIN_AV
+#define CHAIN_MANAGER_PREWARM_LAST EOS_OUT_AUX_AV
 
 // *************************************
 // *              Types                *
@@ -82,6 +85,10 @@ typedef struct chain_element
 	int32_t manipulation_counter;
 	chain_t* chain;
 	chain_protection_t protection;
+	/* Stopped and flushed sink kept from the previous zap */
+	sink_t *spare;
+	/* Chain is disassembled and waits in the pool for the next zap */
+	bool parked;
 } chain_element_t;
 
 typedef struct chain_manager
@@ -91,7 +98,7 @@ typedef struct chain_manager
 	util_slist_t chain;
 } chain_manager_t;
 
-struct thread_data
+struct task_data
 {
 	sink_t *sink;
 	eos_error_t error;
@@ -101,6 +108,16 @@ struct thread_data
 // *            Prototypes             *
 // *************************************
 
+static void chain_manager_sink_stop_join(osi_executor_task_t** sink_stop);
+static void chain_manager_sink_adopt(sink_t** spare, sink_t** sink,
+		uint32_t sink_id, util_mdesc_t* media, link_io_type_t io_type);
+static eos_error_t chain_manager_element_create(uint32_t sink_id,
+		chain_handler_t* handler, chain_element_t** element);
+static void chain_manager_element_destroy(chain_element_t** element);
+static eos_error_t chain_manager_park(chain_element_t* element);
+static eos_error_t chain_manager_release_source(chain_t* chain);
+eos_error_t chain_manager_disassemble(chain_t* chain);
+
 // *************************************
 // *         Global variables          *
 // *************************************
@@ -108,29 +125,191 @@ struct thread_data
 chain_manager_t chain_manager;
 
 // *************************************
-// *             Threads               *
+// *              Tasks                *
 // *************************************
 
-#ifdef UNSYNC
-static void* async_sink_stop(void* arg)
+static void async_sink_stop(void* arg)
 {
 	UTIL_GLOGI("Async sink stop ...");
-	sink_t *sink = ((struct thread_data*)arg)->sink;
+	sink_t *sink = ((struct task_data*)arg)->sink;
 //	UTIL_GLOGWTF("Stop");
-	((struct thread_data*)arg)->error = sink->command.stop(sink);
+	((struct task_data*)arg)->error = sink->command.stop(sink);
 //	UTIL_GLOGWTF("Flush");
-	((struct thread_data*)arg)->error = sink->command.flush_buffs(sink);
-	UTIL_GLOGI("Async sink stop [%s]", (((struct thread_data*)arg)->error == EOS_ERROR_OK)? "Success":"Failure");
-
-	return arg;
+	((struct task_data*)arg)->error = sink->command.flush_buffs(sink);
+	UTIL_GLOGI("Async sink stop [%s]", (((struct task_data*)arg)->error == EOS_ERROR_OK)? "Success":"Failure");
 }
-#endif
 
 // *************************************
 // *         Local functions           *
 // *************************************
+
+static void chain_manager_sink_stop_join(osi_executor_task_t** sink_stop)
+{
+	if (*sink_stop == NULL)
+	{
+		return;
+	}
+	if (osi_executor_join(sink_stop) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGW("Sink stop task join failed");
+	}
+	*sink_stop = NULL;
+}
+
+/*
+ * Spare sink is the one parked by the previous chain_manager_destroy. It is
+ * reused when it can carry the new source output, otherwise it is dismantled
+ * so that a fresh one can be manufactured for the same output.
+ */
+static void chain_manager_sink_adopt(sink_t** spare, sink_t** sink,
+		uint32_t sink_id, util_mdesc_t* media, link_io_type_t io_type)
+{
+	if ((*spare == NULL) || (media == NULL))
+	{
+		return;
+	}
+	if (EOS_MASK_SUBSET((*spare)->plug_type, io_type) &&
+			EOS_MASK_SUBSET((*spare)->caps,
+			(LINK_CAP_STREAM_SEL | LINK_CAP_SINK)) &&
+			((*spare)->command.setup(*spare, sink_id, media) == EOS_ERROR_OK))
+	{
+		UTIL_GLOGI("Reusing pooled sink");
+		*sink = *spare;
+		*spare = NULL;
+		return;
+	}
+	UTIL_GLOGW("Pooled sink does not fit => Dismantle");
+	if (sink_factory_dismantle(spare) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGW("Unable to dismantle sink");
+	}
+	*spare = NULL;
+}
+
+static eos_error_t chain_manager_element_create(uint32_t sink_id,
+		chain_handler_t* handler, chain_element_t** element)
+{
+	eos_error_t error = EOS_ERROR_OK;
+
+	*element = osi_calloc(sizeof(chain_element_t));
+	if (*element == NULL)
+	{
+		UTIL_GLOGE("List element allocation failed");
+		return EOS_ERROR_NOMEM;
+	}
+	(*element)->sink_id = sink_id;
+	error = chain_create(&(*element)->chain, sink_id, handler);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Chain creation failed");
+		goto done;
+	}
+	error = osi_mutex_create(&(*element)->protection.interrupt);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Interrupt mutex creation failed");
+		goto done;
+	}
+	error = osi_mutex_create(&(*element)->protection.tune);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Tune mutex creation failed");
+		goto done;
+	}
+	error = osi_mutex_create(&(*element)->protection.lynk);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Lynk mutex creation failed");
+		goto done;
+	}
+
+done:
+	if (error != EOS_ERROR_OK)
+	{
+		chain_manager_element_destroy(element);
+	}
+	return error;
+}
+
+/* Element has to be out of the list already */
+static void chain_manager_element_destroy(chain_element_t** element)
+{
+	if ((*element)->protection.lynk != NULL &&
+			osi_mutex_destroy(&(*element)->protection.lynk) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGW("Lynk mutex destruction failure");
+	}
+	if ((*element)->protection.tune != NULL &&
+			osi_mutex_destroy(&(*element)->protection.tune) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGW("Tune mutex destruction failure");
+	}
+	if ((*element)->protection.interrupt != NULL &&
+			osi_mutex_destroy(&(*element)->protection.interrupt)
+			!= EOS_ERROR_OK)
+	{
+		UTIL_GLOGW("Interrupt mutex destruction failure");
+	}
+	if (((*element)->spare != NULL) &&
+			(sink_factory_dismantle(&(*element)->spare) != EOS_ERROR_OK))
+	{
+		UTIL_GLOGW("Unable to dismantle pooled sink");
+	}
+	if (((*element)->chain != NULL) &&
+			(chain_destroy(&(*element)->chain) != EOS_ERROR_OK))
+	{
+		UTIL_GLOGW("Chain destroy failure");
+	}
+	osi_free((void**)element);
+}
+
+/*
+ * Stopping a chain keeps it (and its sink) for the next zap on the same
+ * output. The source is released as it is specific to the stopped service.
+ */
+static eos_error_t chain_manager_park(chain_element_t* element)
+{
+	sink_t *sink = NULL;
+	bool keep = false;
+	eos_error_t error = EOS_ERROR_OK;
+
+	chain_get_sink(element->chain, &sink);
+	/* Source goes first, nothing is committed into the sink while it stops.
+	 * Sink can also be detached only from a chain without source. */
+	error = chain_manager_release_source(element->chain);
+	if (error != EOS_ERROR_OK)
+	{
+		return error;
+	}
+	if ((sink != NULL) && (sink->command.stop(sink) == EOS_ERROR_OK) &&
+			(sink->command.flush_buffs(sink) == EOS_ERROR_OK))
+	{
+		keep = true;
+	}
+	if ((keep == true) && (chain_set_sink(element->chain, NULL) == EOS_ERROR_OK))
+	{
+		if ((element->spare != NULL) &&
+				(sink_factory_dismantle(&element->spare) != EOS_ERROR_OK))
+		{
+			UTIL_GLOGW("Unable to dismantle pooled sink");
+		}
+		element->spare = sink;
+	}
+
+	/* Whatever could not be parked is torn down here */
+	return chain_manager_disassemble(element->chain);
+}
+
+/*
+ * Channel change is pipelined: the old source is unlocked, then the old sink
+ * is stopped and flushed (decoder teardown) on the shared executor while the
+ * new source is locked (PSI acquisition). The sink is touched again only when
+ * the new source is connected and the sink has to be set up (or replaced).
+ * Another zap arriving meanwhile interrupts the pending source lock.
+ */
 eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain, 
-				char* source_url, char* source_extras, uint32_t sink_id)
+				char* source_url, char* source_extras, uint32_t sink_id,
+				sink_t** spare)
 {
 	source_t *source = NULL;
 	sink_t *sink = NULL;
@@ -139,11 +318,9 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 	link_io_type_t io_type = 0;
 	bool reuse_source = false;
 	bool restart = false;
-#ifdef UNSYNC
-	osi_thread_t *sink_stop_thread = NULL;
-#endif
-	struct thread_data sink_stop_data;
-	eos_media_desc_t *media = NULL;
+	osi_executor_task_t *sink_stop = NULL;
+	struct task_data sink_stop_data;
+	util_mdesc_t *media = NULL;
 	EOS_UNUSED(sink_id);
 
 	UTIL_GLOGI("Assemble ...");
@@ -192,28 +369,21 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 		{
 			reuse_source = true;
 		}
-		// TODO Create sink stop thread
 		sink_stop_data.sink = sink;
 		sink_stop_data.error = EOS_ERROR_OK;
 		chain_unload_data_mgr(chain);
-#ifdef UNSYNC
-		error = osi_thread_create(&sink_stop_thread, NULL, async_sink_stop,
-				(void*)&sink_stop_data);
-#else
-		//unlock before stop
+		/* Unlock before stop: source must not commit into a stopping sink */
 		chain_unlock(chain);
-
-		UTIL_GLOGWTF("Stop");
-		sink_stop_data.error = sink->command.stop(sink_stop_data.sink);
-		UTIL_GLOGI("Flush sink  [%s]", (sink_stop_data.error == EOS_ERROR_OK)? "Success":"Failure");
-		sink_stop_data.error = sink->command.flush_buffs(sink);
-		UTIL_GLOGI("Sync sink stop [%s]", (sink_stop_data.error == EOS_ERROR_OK)? "Success":"Failure");
-#endif
+		if (osi_executor_run(osi_executor_shared(), async_sink_stop,
+				(void*)&sink_stop_data, OSI_EXECUTOR_ANY, &sink_stop)
+				!= EOS_ERROR_OK)
+		{
+			UTIL_GLOGW("Sink stop task queueing failed => Stop in place");
+			sink_stop = NULL;
+			async_sink_stop((void*)&sink_stop_data);
+		}
 
 #ifdef INTERRUPTABLE
-#ifdef UNSYNC
-		chain_unlock(chain);
-#endif
 		// Lock lynk
 		osi_mutex_lock(protection.lynk);
 #endif
@@ -254,12 +424,9 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 		source->get_output_type(source, &io_type);
 		if (restart == true)
 		{
-			// TODO Wait for sink stop thread
 			restart = false;
-#ifdef UNSYNC
-			osi_thread_join(sink_stop_thread, NULL);
-			osi_thread_release(&sink_stop_thread);
-#endif
+			/* New source is connected, now the sink has to be ready */
+			chain_manager_sink_stop_join(&sink_stop);
 			if (!EOS_MASK_SUBSET(sink->plug_type, io_type) || 
 			!EOS_MASK_SUBSET(sink->caps,(LINK_CAP_STREAM_SEL | LINK_CAP_SINK)))
 			{
@@ -271,13 +438,7 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 			}
 			else
 			{
-				if((media = osi_malloc(sizeof(eos_media_desc_t))) == NULL)
-				{
-					error = EOS_ERROR_NOMEM;
-					UTIL_GLOGE("Cannot allocate media desc");
-					goto done;
-				}
-				error = chain_get_streams(chain, media);
+				error = chain_get_media(chain, &media);
 				if (error != EOS_ERROR_OK)
 				{
 					UTIL_GLOGE("Get streams failed");
@@ -294,13 +455,14 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 
 		if (sink == NULL)
 		{
-			if((media = osi_malloc(sizeof(eos_media_desc_t))) == NULL)
+			if (media == NULL)
 			{
-				error = EOS_ERROR_NOMEM;
-				UTIL_GLOGE("Cannot allocate media desc");
-				goto done;
+				chain_get_media(chain, &media);
 			}
-			chain_get_streams(chain, media);
+			chain_manager_sink_adopt(spare, &sink, sink_id, media, io_type);
+		}
+		if (sink == NULL)
+		{
 			error = sink_factory_manufacture(sink_id, media,
 					LINK_CAP_STREAM_SEL | LINK_CAP_SINK, io_type, &sink);
 			if (error != EOS_ERROR_OK)
@@ -316,6 +478,7 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 			UTIL_GLOGE("Setting sink failed");
 			goto done;
 		}
+		zap_stats_mark(sink_id, EOS_ZAP_MS_SINK_SETUP);
 	}
 	// TODO Add error checking
 	chain_load_playback_controler(chain);
@@ -327,10 +490,9 @@ eos_error_t chain_manager_assemble(chain_protection_t protection, chain_t* chain
 	UTIL_GLOGI("Assemble [Success]");
 
 done:
-	if(media != NULL)
-	{
-		osi_free((void**)&media);
-	}
+	/* Sink stop data lives on this stack */
+	chain_manager_sink_stop_join(&sink_stop);
+	util_mdesc_unref(&media);
 	if (error != EOS_ERROR_OK)
 	{
 #ifdef INTERRUPTABLE
@@ -352,15 +514,6 @@ done:
 		if (sink != NULL)
 		{
 			chain_set_sink(chain, NULL);
-			if (restart == true)
-			{
-				// TODO Wait for sink stop thread
-				restart = false;
-#ifdef UNSYNC
-				osi_thread_join(sink_stop_thread, NULL);
-				osi_thread_release(&sink_stop_thread);
-#endif
-			}
 			if (sink_factory_dismantle(&sink) != EOS_ERROR_OK)
 			{
 				UTIL_GLOGW("Unable to dismantle sink");
@@ -378,9 +531,34 @@ done:
 	return error;
 }
 
-eos_error_t chain_manager_disassemble(chain_t* chain)
+static eos_error_t chain_manager_release_source(chain_t* chain)
 {
 	source_t *source = NULL;
+	eos_error_t error = EOS_ERROR_OK;
+
+	chain_get_source(chain, &source);
+	if (source == NULL)
+	{
+		return EOS_ERROR_OK;
+	}
+	error = chain_unlock(chain);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Source unlock failed");
+		return error;
+	}
+	chain_set_source(chain, NULL);
+	error = source_factory_dismantle(&source);
+	if (error != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Source dismantling failed");
+	}
+
+	return error;
+}
+
+eos_error_t chain_manager_disassemble(chain_t* chain)
+{
 	sink_t *sink = NULL;
 	eos_error_t error = EOS_ERROR_OK;
 
@@ -392,25 +570,11 @@ eos_error_t chain_manager_disassemble(chain_t* chain)
 		return EOS_ERROR_INVAL;
 	}
 
-	chain_get_source(chain, &source);
-	if (source != NULL)
+	error = chain_manager_release_source(chain);
+	if (error != EOS_ERROR_OK)
 	{
-		error = chain_unlock(chain);
-		if (error != EOS_ERROR_OK)
-		{
-			UTIL_GLOGE("Source unlock failed");
-			UTIL_GLOGE("Disassemble [Failure]");
-			return error;
-		}
-
-		chain_set_source(chain, NULL);
-		error = source_factory_dismantle(&source);
-		if (error != EOS_ERROR_OK)
-		{
-			UTIL_GLOGE("Source dismantling failed");
-			UTIL_GLOGE("Disassemble [Failure]");
-			return error;
-		}
+		UTIL_GLOGE("Disassemble [Failure]");
+		return error;
 	}
 
 	chain_get_sink(chain, &sink);
@@ -460,6 +624,10 @@ bool chain_list_comparator(void* sink_id_address, void* chain_element_address)
 eos_error_t chain_manager_module_init()
 {
 	eos_error_t error = EOS_ERROR_OK;
+	chain_element_t *element = NULL;
+	chain_handler_t handler = {NULL, NULL, NULL, NULL};
+	uint32_t sink_id = 0;
+
 	error = osi_mutex_create(&chain_manager.sync);
 	if (error != EOS_ERROR_OK)
 	{
@@ -484,6 +652,74 @@ eos_error_t chain_manager_module_init()
 		}
 		return error;
 	}
+	/* Pre-warm the pool, the first zap then finds its chain ready. Handlers
+	 * are bound by chain_reset once the chain is taken */
+	for (sink_id = CHAIN_MANAGER_PREWARM_FIRST;
+			sink_id <= CHAIN_MANAGER_PREWARM_LAST; sink_id++)
+	{
+		if (chain_manager_element_create(sink_id, &handler, &element)
+				!= EOS_ERROR_OK)
+		{
+			UTIL_GLOGW("Chain pre-warm for output %u failed", sink_id);
+			continue;
+		}
+		element->parked = true;
+		if (chain_manager.chain.add(chain_manager.chain, element)
+				!= EOS_ERROR_OK)
+		{
+			chain_manager_element_destroy(&element);
+		}
+	}
+	return EOS_ERROR_OK;
+}
+
+eos_error_t chain_manager_module_deinit(void)
+{
+	chain_element_t *element = NULL;
+	int32_t count = 0;
+	bool found = false;
+
+	if (chain_manager.list_lock == NULL)
+	{
+		return EOS_ERROR_OK;
+	}
+	osi_mutex_lock(chain_manager.list_lock);
+	do
+	{
+		found = false;
+		if (chain_manager.chain.first(chain_manager.chain,
+				(void**)&element) != EOS_ERROR_OK)
+		{
+			break;
+		}
+		do
+		{
+			if ((element->parked == true) && (element->ref_counter == 0) &&
+					(element->manipulation_counter == 0))
+			{
+				found = true;
+				break;
+			}
+		} while (chain_manager.chain.next(chain_manager.chain,
+				(void**)&element) == EOS_ERROR_OK);
+		if (found == true)
+		{
+			chain_manager.chain.remove(chain_manager.chain,
+					&element->sink_id);
+			chain_manager_element_destroy(&element);
+		}
+	} while (found == true);
+	chain_manager.chain.count(chain_manager.chain, &count);
+	osi_mutex_unlock(chain_manager.list_lock);
+	if (count > 0)
+	{
+		UTIL_GLOGW("%d chain(s) still playing => Keep chain manager", count);
+		return EOS_ERROR_PERM;
+	}
+	util_slist_destroy(&chain_manager.chain);
+	osi_mutex_destroy(&chain_manager.list_lock);
+	osi_mutex_destroy(&chain_manager.sync);
+
 	return EOS_ERROR_OK;
 }
 
@@ -504,7 +740,8 @@ eos_error_t chain_manager_get(uint32_t sink_id, chain_t** chain)
 	}
 	if (chain_manager.chain.get(chain_manager.chain, &sink_id, (void**)&element) == EOS_ERROR_OK)
 	{
-		if ((element->manipulation_counter > 0) || (element->ref_counter > 0))
+		if ((element->manipulation_counter > 0) || (element->ref_counter > 0) ||
+				(element->parked == true))
 		{
 			element = NULL;
 		}
@@ -562,7 +799,9 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 	eos_error_t error = EOS_ERROR_OK;
 	chain_element_t *element = NULL;
 	chain_t *local_chain = NULL;
+	source_t *source = NULL;
 	bool destroy = false;
+	bool reset = false;
 
 	UTIL_GLOGI("Create ...");
 	if ((source_url == NULL) || (handler == NULL))
@@ -571,6 +810,7 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 
 		return EOS_ERROR_INVAL;
 	}
+	zap_stats_mark(sink_id, EOS_ZAP_MS_CHAIN_CREATE);
 
 	error = osi_mutex_lock(chain_manager.list_lock);
 	if (error != EOS_ERROR_OK)
@@ -584,7 +824,6 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 			(void**)&element) == EOS_ERROR_OK)
 	{
 		local_chain = element->chain;
-		UTIL_GLOGI("Recycling chain");
 		if (element->ref_counter > 0)
 		{
 			UTIL_GLOGW("Chain is being used (ref count %d) => Abort",
@@ -597,135 +836,41 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 
 			return EOS_ERROR_PERM;
 		}
-	}
-	else
-	{
-		UTIL_GLOGI("Creating chain");
-		error = chain_create(&local_chain, sink_id, handler);
-		if (error != EOS_ERROR_OK)
-		{
-			
-			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("List mutex unlock failure");
-			}
-			UTIL_GLOGE("Create [Failure]");
-
-			return error;
-		}
-		element = osi_calloc(sizeof(chain_element_t));
-		if (element == NULL)
-		{
-			UTIL_GLOGE("List element allocation failed");
-			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("List mutex unlock failure");
-			}
-			if (chain_destroy(&local_chain) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Chain destroy failure");
-			}
-			UTIL_GLOGE("Create [Failure]");
-
-			return error;
-		}
-		element->sink_id = sink_id;
-		element->chain = local_chain;
-		error = osi_mutex_create(&element->protection.interrupt);
-		if (error != EOS_ERROR_OK)
+		if (element->parked == true)
 		{
-			UTIL_GLOGE("Interrupt mutex creation failed");
-			osi_free((void**)&element);
-			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("List mutex unlock failure");
-			}
-			if (chain_destroy(&local_chain) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Chain destroy failure");
-			}
-			UTIL_GLOGE("Create [Failure]");
-
-			return error;
+			UTIL_GLOGI("Taking chain from the pool");
+			element->parked = false;
+			reset = true;
 		}
-		error = osi_mutex_create(&element->protection.tune);
-		if (error != EOS_ERROR_OK)
+		else
 		{
-			UTIL_GLOGE("Tune mutex creation failed");
-			if (osi_mutex_destroy(&element->protection.interrupt)
-					!= EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Interrupt mutex destruction failure");
-			}
-			osi_free((void**)&element);
-			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("List mutex unlock failure");
-			}
-			if (chain_destroy(&local_chain) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Chain destroy failure");
-			}
-			UTIL_GLOGE("Create [Failure]");
-
-			return error;
+			UTIL_GLOGI("Recycling chain");
 		}
-		error = osi_mutex_create(&element->protection.lynk);
-		if (error != EOS_ERROR_OK)
+	}
+	else
+	{
+		UTIL_GLOGI("Creating chain");
+		error = chain_manager_element_create(sink_id, handler, &element);
+		if (error == EOS_ERROR_OK)
 		{
-			UTIL_GLOGE("Lynk mutex creation failed");
-			if (osi_mutex_destroy(&element->protection.tune) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Tune mutex destruction failure");
-			}
-			if (osi_mutex_destroy(&element->protection.interrupt)
-					!= EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Interrupt mutex destruction failure");
-			}
-			osi_free((void**)&element);
-			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("List mutex unlock failure");
-			}
-			if (chain_destroy(&local_chain) != EOS_ERROR_OK)
+			error = chain_manager.chain.add(chain_manager.chain, element);
+			if (error != EOS_ERROR_OK)
 			{
-				UTIL_GLOGW("Chain destroy failure");
+				UTIL_GLOGE("Storing chain failed");
+				chain_manager_element_destroy(&element);
 			}
-			UTIL_GLOGE("Create [Failure]");
-
-			return error;
 		}
-		error = chain_manager.chain.add(chain_manager.chain, element);
 		if (error != EOS_ERROR_OK)
 		{
-			UTIL_GLOGE("Storing chain failed");
-			if (osi_mutex_destroy(&element->protection.lynk) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Tune mutex destruction failure");
-			}
-			if (osi_mutex_destroy(&element->protection.tune) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Tune mutex destruction failure");
-			}
-			if (osi_mutex_destroy(&element->protection.interrupt)
-					!= EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Interrupt mutex destruction failure");
-			}
-			osi_free((void**)&element);
 			if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
 			{
 				UTIL_GLOGW("List mutex unlock failure");
 			}
-			if (chain_destroy(&local_chain) != EOS_ERROR_OK)
-			{
-				UTIL_GLOGW("Chain destroy failure");
-			}
 			UTIL_GLOGE("Create [Failure]");
 
 			return error;
 		}
+		local_chain = element->chain;
 	}
 	element->manipulation_counter++;
 	error = osi_mutex_unlock(chain_manager.list_lock);
@@ -734,8 +879,18 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 		UTIL_GLOGW("List mutex unlock failure");
 	}
 
-	error = chain_manager_assemble(element->protection, local_chain,
-			source_url, source_extras, sink_id);
+	if (reset == true)
+	{
+		/* Waits for the parking stop to finish */
+		osi_mutex_lock(element->protection.tune);
+		error = chain_reset(local_chain, handler);
+		osi_mutex_unlock(element->protection.tune);
+	}
+	if (error == EOS_ERROR_OK)
+	{
+		error = chain_manager_assemble(element->protection, local_chain,
+				source_url, source_extras, sink_id, &element->spare);
+	}
 
 	if (osi_mutex_lock(chain_manager.list_lock) != EOS_ERROR_OK)
 	{	
@@ -745,12 +900,19 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 	element->manipulation_counter--;
 	if (error != EOS_ERROR_OK)
 	{
+		chain_get_source(local_chain, &source);
 		if ((element->ref_counter > 0) || (element->manipulation_counter > 0))
 		{
 			destroy = false;
 			UTIL_GLOGW("Chain is being used (usage cnt %d) => Skip destroying",
 					element->ref_counter + element->manipulation_counter);
 		}
+		else if (source != NULL)
+		{
+			/* This assemble was interrupted and the later one already succeeded */
+			destroy = false;
+			UTIL_GLOGW("Chain was reassembled meanwhile => Skip destroying");
+		}
 		else
 		{
 			destroy = true;
@@ -763,27 +925,11 @@ eos_error_t chain_manager_create(char* source_url, char* source_extras,
 		{
 			UTIL_GLOGW("Chain removal from the list failure");
 		}
-		if (osi_mutex_destroy(&element->protection.lynk) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Lynk mutex destruction failure");
-		}
-		if (osi_mutex_destroy(&element->protection.tune) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Tune mutex destruction failure");
-		}
-		if (osi_mutex_destroy(&element->protection.interrupt) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Interrupt mutex destruction failure");
-		}
-		osi_free((void**)&element);
 		if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
 		{
 			UTIL_GLOGW("List mutex unlock failure");
 		}
-		if (chain_destroy(&local_chain) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Chain destroy failure");
-		}
+		chain_manager_element_destroy(&element);
 		UTIL_GLOGE("Create [Failure]");
 
 		return error;
@@ -811,7 +957,8 @@ eos_error_t chain_manager_destroy(uint32_t sink_id)
 		UTIL_GLOGE("Destroy [Failure]");
 		return EOS_ERROR_GENERAL;
 	}
-	if (chain_manager.chain.get(chain_manager.chain, &sink_id, (void**)&element) != EOS_ERROR_OK)
+	if ((chain_manager.chain.get(chain_manager.chain, &sink_id,
+			(void**)&element) != EOS_ERROR_OK) || (element->parked == true))
 	{
 		error = osi_mutex_unlock(chain_manager.list_lock);
 		if (error != EOS_ERROR_OK)
@@ -824,35 +971,29 @@ eos_error_t chain_manager_destroy(uint32_t sink_id)
 	}
 	if ((element->ref_counter == 0) && (element->manipulation_counter == 0))
 	{
-		if (chain_manager.chain.remove(chain_manager.chain, &sink_id) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Chain removal from the list failure");
-		}
-		if (osi_mutex_destroy(&element->protection.lynk) != EOS_ERROR_OK)
+		/* Invisible to chain_manager_get from now on, a new zap may take it
+		 * back right away (chain_reset waits for the tune lock) */
+		element->parked = true;
+		element->manipulation_counter++;
+		if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
 		{
-			UTIL_GLOGW("Lynk mutex destruction failure");
+			UTIL_GLOGW("List mutex unlock failure");
 		}
-		if (osi_mutex_destroy(&element->protection.tune) != EOS_ERROR_OK)
+		osi_mutex_lock(element->protection.tune);
+		if (chain_manager_park(element) != EOS_ERROR_OK)
 		{
-			UTIL_GLOGW("Tune mutex destruction failure");
+			UTIL_GLOGW("Chain disassemble failure");
 		}
-		if (osi_mutex_destroy(&element->protection.interrupt) != EOS_ERROR_OK)
+		osi_mutex_unlock(element->protection.tune);
+		if (osi_mutex_lock(chain_manager.list_lock) != EOS_ERROR_OK)
 		{
-			UTIL_GLOGW("Interrupt mutex destruction failure");
+			UTIL_GLOGW("List mutex lock failure");
 		}
+		element->manipulation_counter--;
 		if (osi_mutex_unlock(chain_manager.list_lock) != EOS_ERROR_OK)
 		{
 			UTIL_GLOGW("List mutex unlock failure");
 		}
-		if (chain_manager_disassemble(element->chain) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Chain disassemble failure");
-		}
-		if (chain_destroy(&element->chain) != EOS_ERROR_OK)
-		{
-			UTIL_GLOGW("Chain destroy failure");
-		}
-		osi_free((void**)&element);
 	}
 	else
 	{
@@ -875,3 +1016,38 @@ eos_error_t chain_manager_destroy(uint32_t sink_id)
 	return error;
 }
 
+eos_error_t chain_manager_interrupt(uint32_t sink_id)
+{
+	chain_element_t *element = NULL;
+	source_t *source = NULL;
+	eos_error_t error = EOS_ERROR_OK;
+
+	error = osi_mutex_lock(chain_manager.list_lock);
+	if (error != EOS_ERROR_OK)
+	{
+		return EOS_ERROR_GENERAL;
+	}
+	if ((chain_manager.chain.get(chain_manager.chain, &sink_id,
+			(void**)&element) != EOS_ERROR_OK) ||
+			(element->manipulation_counter == 0))
+	{
+		osi_mutex_unlock(chain_manager.list_lock);
+		return EOS_ERROR_OK;
+	}
+	/* Same protocol as an assemble interrupting the previous one */
+#ifdef INTERRUPTABLE
+	osi_mutex_lock(element->protection.lynk);
+#endif
+	chain_get_source(element->chain, &source);
+	if (source != NULL)
+	{
+		UTIL_GLOGI("Interrupting assemble on %u", sink_id);
+		error = chain_interrupt(element->chain);
+	}
+#ifdef INTERRUPTABLE
+	osi_mutex_unlock(element->protection.lynk);
+#endif
+	osi_mutex_unlock(chain_manager.list_lock);
+
+	return error;
+}
@@ -37,11 +37,15 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "chain.h"
 
 eos_error_t chain_manager_module_init(void);
+eos_error_t chain_manager_module_deinit(void);
 eos_error_t chain_manager_create(char* source_url, char* source_extras,
 		uint32_t sink_id, chain_handler_t* handler);
 eos_error_t chain_manager_get(uint32_t sink_id, chain_t** chain);
 eos_error_t chain_manager_release(uint32_t sink_id, chain_t** chain);
+/* Stopped chain and its sink stay pooled for the next zap on the same output */
 eos_error_t chain_manager_destroy(uint32_t sink_id);
+/* Cuts the source lock of an assemble in progress short (no-op otherwise) */
+eos_error_t chain_manager_interrupt(uint32_t sink_id);
 
 #endif // CHAIN_MANAGER_H_
 
@@ -37,6 +37,7 @@ SRCS += $(COREDIR)/playback_ctrl_factory.c
 SRCS += $(COREDIR)/def_playback_ctrl_provider.c
 SRCS += $(COREDIR)/set_reg.c
 SRCS += $(COREDIR)/data_mgr.c
+SRCS += $(COREDIR)/zap_stats.c
 
 include $(COREDIR)/engine/engine.mk
 
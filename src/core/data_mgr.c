@@ -36,7 +36,6 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "osi_mutex.h"
 #include "osi_memory.h"
 #include "util_log.h"
-#include "util_slist.h"
 #include "sink.h"
 #include "engine_factory.h"
 #define MODULE_NAME ("core:manager:data")
@@ -44,57 +43,80 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include <stdlib.h>
 
+/* One attached engine per type, API cached when the engine is attached */
+typedef struct engine_slot
+{
+	uint32_t id;
+	engine_t *engine;
+	engine_api_t api;
+} engine_slot_t;
+
 struct data_mgr
 {
 	chain_t *chain;
 	bool running;
 	osi_mutex_t *lock;
 	util_log_t *log;
-	util_slist_t engines;
+	engine_slot_t engines[ENGINE_TYPE_INVALID];
 	engine_cb_data_t engine_cb;
 };
 
-typedef struct list_item
-{
-	uint32_t id;
-	engine_t *engine;
-} list_item_t;
-
 static eos_error_t data_prov_start(data_mgr_t* data_mgr, chain_t* chain,
 		eos_media_desc_t* media);
 static eos_error_t data_prov_stop(data_mgr_t* data_mgr);
 static eos_error_t data_prov_select(data_mgr_t* data_mgr,
 		eos_media_desc_t *streams, uint32_t id, bool on);
-static engine_api_t* find_api(data_mgr_t* data_mgr, engine_type_t type,
+static const engine_api_t* find_api(data_mgr_t* data_mgr, engine_type_t type,
 		engine_t **engine);
 
-static bool engine_comparator(void* search_param, void* data_address)
+static engine_slot_t* engine_slot(data_mgr_t* data_mgr, engine_type_t type)
 {
-	list_item_t *item = (list_item_t*)data_address;
-	engine_type_t *type = (engine_type_t*) search_param;
-	engine_api_t *api = NULL;
-	bool found = false;
-	eos_error_t error = EOS_ERROR_OK;
-
-	if(search_param == NULL || data_address == NULL)
+	if (type < ENGINE_TYPE_TTXT || type >= ENGINE_TYPE_INVALID)
+	{
+		return NULL;
+	}
+	if (data_mgr->engines[type].engine == NULL)
 	{
-		return false;
+		return NULL;
 	}
 
-	api = osi_calloc(sizeof(engine_api_t));
-	error = item->engine->get_api(item->engine, api);
-	if (error != EOS_ERROR_OK)
+	return &data_mgr->engines[type];
+}
+
+static eos_error_t engine_store(data_mgr_t* data_mgr, uint32_t id,
+		engine_t* engine, engine_slot_t** slot)
+{
+	engine_api_t api;
+	eos_error_t err = EOS_ERROR_OK;
+
+	osi_memset(&api, 0, sizeof(engine_api_t));
+	err = engine->get_api(engine, &api);
+	if (err != EOS_ERROR_OK)
 	{
-		osi_free((void**)&api);
-		return false;
+		return err;
 	}
-	if(api->type == *type)
+	if (api.type < ENGINE_TYPE_TTXT || api.type >= ENGINE_TYPE_INVALID)
 	{
-		found = true;
+		return EOS_ERROR_INVAL;
+	}
+	if (data_mgr->engines[api.type].engine != NULL)
+	{
+		return EOS_ERROR_PERM;
+	}
+	data_mgr->engines[api.type].id = id;
+	data_mgr->engines[api.type].engine = engine;
+	data_mgr->engines[api.type].api = api;
+	if (slot != NULL)
+	{
+		*slot = &data_mgr->engines[api.type];
 	}
-	osi_free((void**)&api);
 
-	return found;
+	return EOS_ERROR_OK;
+}
+
+static void engine_release(engine_slot_t* slot)
+{
+	osi_memset(slot, 0, sizeof(engine_slot_t));
 }
 
 eos_error_t data_mgr_create(data_mgr_t** data_mgr, engine_cb_data_t cb)
@@ -122,14 +144,6 @@ eos_error_t data_mgr_create(data_mgr_t** data_mgr, engine_cb_data_t cb)
 		osi_free((void**)&tmp);
 		return err;
 	}
-	if ((err = util_slist_create(&tmp->engines, engine_comparator))
-			!= EOS_ERROR_OK)
-	{
-		util_log_destroy(&tmp->log);
-		osi_mutex_destroy(&tmp->lock);
-		osi_free((void**)&tmp);
-		return err;
-	}
 
 	tmp->engine_cb = cb;
 	*data_mgr = tmp;
@@ -144,7 +158,6 @@ eos_error_t data_mgr_destroy(data_mgr_t** data_mgr)
 		return EOS_ERROR_INVAL;
 	}
 	osi_mutex_destroy(&(*data_mgr)->lock);
-	util_slist_destroy(&(*data_mgr)->engines);
 	util_log_destroy(&(*data_mgr)->log);
 	osi_free((void**)data_mgr);
 
@@ -191,7 +204,7 @@ eos_error_t data_mgr_start(data_mgr_t* data_mgr, chain_t* chain, eos_media_desc_
 	sink_t *sink = NULL;
 	engine_params_t params;
 	engine_t *engine = NULL;
-	list_item_t *item = NULL;
+	engine_slot_t *slot = NULL;
 	link_cap_stream_prov_ctrl_t *stream_prov = NULL;
 	engine_in_hook_t hook = NULL;
 
@@ -245,21 +258,18 @@ eos_error_t data_mgr_start(data_mgr_t* data_mgr, chain_t* chain, eos_media_desc_
 				err = engine_factory_manufacture(&params, &engine);
 				if (err == EOS_ERROR_OK)
 				{
-					item = (list_item_t*)osi_calloc(sizeof(list_item_t));
-					if (item == NULL)
+					err = engine->get_hook(engine, &hook);
+					if (err != EOS_ERROR_OK)
 					{
-						UTIL_LOGE(data_mgr->log,
-								"Engine list item mem alloc failed");
+						UTIL_LOGW(data_mgr->log, "Unable to get engine hook");
 						engine_factory_dismantle(&engine);
-						break;
+						continue;
 					}
-					item->id = i;
-					item->engine = engine;
-					err = engine->get_hook(engine, &hook);
+					err = engine_store(data_mgr, i, engine, &slot);
 					if (err != EOS_ERROR_OK)
 					{
-						UTIL_LOGW(data_mgr->log, "Unable to get engine hook");
-						osi_free((void*)&item);
+						UTIL_LOGW(data_mgr->log, "Unable to store engine");
+						engine_factory_dismantle(&engine);
 						continue;
 					}
 					err = stream_prov->attach((link_handle_t)sink, i,
@@ -268,15 +278,8 @@ eos_error_t data_mgr_start(data_mgr_t* data_mgr, chain_t* chain, eos_media_desc_
 					if (err != EOS_ERROR_OK)
 					{
 						UTIL_LOGW(data_mgr->log, "Unable to attach engine");
-						osi_free((void*)&item);
-						continue;
-					}
-					err = data_mgr->engines.add(data_mgr->engines, item);
-					if (err != EOS_ERROR_OK)
-					{
-						UTIL_LOGW(data_mgr->log, "Unable to store engine");
-						stream_prov->detach((link_handle_t)sink, i);
-						osi_free((void*)&item);
+						engine_release(slot);
+						engine_factory_dismantle(&engine);
 						continue;
 					}
 					UTIL_LOGI(data_mgr->log, "Attached \"%s\" engine",
@@ -321,7 +324,7 @@ eos_error_t data_mgr_set(data_mgr_t* data_mgr, chain_t* chain,
 	engine_params_t params;
 	engine_type_t engine_type = ENGINE_TYPE_INVALID;
 	engine_t *engine = NULL;
-	list_item_t *item = NULL;
+	engine_slot_t *slot = NULL;
 	engine_in_hook_t hook = NULL;
 
 	if ((data_mgr == NULL) || (chain == NULL) || (streams == NULL))
@@ -369,65 +372,50 @@ eos_error_t data_mgr_set(data_mgr_t* data_mgr, chain_t* chain,
 				osi_mutex_unlock(data_mgr->lock);
 				return EOS_ERROR_INVAL;
 			}
-			error = data_mgr->engines.get(data_mgr->engines, 
-					(void*)&engine_type, (void**)&item);
+			slot = engine_slot(data_mgr, engine_type);
 			if (!on)
 			{
-					if (error != EOS_ERROR_OK)
+					if (slot == NULL)
 					{
 						osi_mutex_unlock(data_mgr->lock);
 						return EOS_ERROR_INVAL;
 					}
 					UTIL_LOGI(data_mgr->log, "Detach \"%s\" engine", 
-							item->engine->name());
+							slot->engine->name());
 					error = stream_prov->detach((link_handle_t)sink, i);
 					if (error != EOS_ERROR_OK)
 					{
 						osi_mutex_unlock(data_mgr->lock);
 						return EOS_ERROR_INVAL;
 					}
-					error = data_mgr->engines.remove(data_mgr->engines, 
-							(void*)&engine_type);
-					if (error != EOS_ERROR_OK)
-					{
-						osi_mutex_unlock(data_mgr->lock);
-						return EOS_ERROR_INVAL;
-					}
-					
-					error = engine_factory_dismantle(&item->engine);
+					engine = slot->engine;
+					engine_release(slot);
+					error = engine_factory_dismantle(&engine);
 					if (error != EOS_ERROR_OK)
 					{
 						UTIL_LOGW(data_mgr->log, "Unable to dismantle engine");
 					}
-					osi_free((void*)&item);
 					streams->es[i].selected = on;
 					osi_mutex_unlock(data_mgr->lock);
 					return EOS_ERROR_OK;
 			}
-			if (error == EOS_ERROR_OK)
+			if (slot != NULL)
 			{
 				// Engine of the same type already attached
 				UTIL_LOGE(data_mgr->log,
 						"Disconnect currently connected engine");
-				error = stream_prov->detach((link_handle_t)sink, item->id);
+				error = stream_prov->detach((link_handle_t)sink, slot->id);
 				if (error != EOS_ERROR_OK)
 				{
 					osi_mutex_unlock(data_mgr->lock);
 					return EOS_ERROR_INVAL;
 				}
 				//TODO: dismantle?
-				error = data_mgr->engines.remove(data_mgr->engines, 
-						(void*)&engine_type);
-				if (error != EOS_ERROR_OK)
-				{
-					osi_mutex_unlock(data_mgr->lock);
-					return EOS_ERROR_INVAL;
-				}
-				streams->es[item->id].selected = false;
+				streams->es[slot->id].selected = false;
 				UTIL_LOGE(data_mgr->log,
-						"Engine for stream #%hhu is disconnected",
-						item->id);
-				osi_free((void*)&item);
+						"Engine for stream #%u is disconnected",
+						slot->id);
+				engine_release(slot);
 			}
 			osi_memset(&params, 0, sizeof(engine_params_t));
 			params.cb = data_mgr->engine_cb;
@@ -440,43 +428,29 @@ eos_error_t data_mgr_set(data_mgr_t* data_mgr, chain_t* chain,
 
 				return EOS_ERROR_NFOUND;
 			}
-			item = (list_item_t*)osi_calloc(sizeof(list_item_t));
-			if (item == NULL)
-			{
-				UTIL_LOGE(data_mgr->log,
-						"Engine list item mem alloc failed");
-				engine_factory_dismantle(&engine);
-				osi_mutex_unlock(data_mgr->lock);
-				return EOS_ERROR_NOMEM;
-			}
-			item->id = i;
-			item->engine = engine;
 			error = engine->get_hook(engine, &hook);
 			if (error != EOS_ERROR_OK)
 			{
 				UTIL_LOGW(data_mgr->log, "Unable to get engine hook");
-				osi_free((void*)&item);
 				engine_factory_dismantle(&engine);
 				osi_mutex_unlock(data_mgr->lock);
 				return error;
 			}
-			error = stream_prov->attach((link_handle_t)sink, i,
-						(link_stream_cb_t)hook,
-						(void*)engine);
+			error = engine_store(data_mgr, i, engine, &slot);
 			if (error != EOS_ERROR_OK)
 			{
-				UTIL_LOGW(data_mgr->log, "Unable to attach engine");
-				osi_free((void*)&item);
+				UTIL_LOGW(data_mgr->log, "Unable to store engine");
 				engine_factory_dismantle(&engine);
 				osi_mutex_unlock(data_mgr->lock);
 				return error;
 			}
-			error = data_mgr->engines.add(data_mgr->engines, item);
+			error = stream_prov->attach((link_handle_t)sink, i,
+						(link_stream_cb_t)hook,
+						(void*)engine);
 			if (error != EOS_ERROR_OK)
 			{
-				UTIL_LOGW(data_mgr->log, "Unable to store engine");
-				stream_prov->detach((link_handle_t)sink, i);
-				osi_free((void*)&item);
+				UTIL_LOGW(data_mgr->log, "Unable to attach engine");
+				engine_release(slot);
 				engine_factory_dismantle(&engine);
 				osi_mutex_unlock(data_mgr->lock);
 				return error;
@@ -497,10 +471,10 @@ eos_error_t data_mgr_set(data_mgr_t* data_mgr, chain_t* chain,
 eos_error_t data_mgr_stop(data_mgr_t* data_mgr)
 {
 	eos_error_t error = EOS_ERROR_OK;
-	list_item_t *item = NULL;
 	sink_t *sink = NULL;
 	link_cap_stream_prov_ctrl_t *stream_prov = NULL;
-	engine_api_t api;
+	engine_t *engine = NULL;
+	int type = 0;
 
 	UTIL_GLOGI("Data manager stop ...");
 	/* TODO: Anything smart to do here?*/
@@ -533,36 +507,25 @@ eos_error_t data_mgr_stop(data_mgr_t* data_mgr)
 	}
 	osi_mutex_lock(data_mgr->lock);
 	data_mgr->running = false;
-	data_mgr->engines.first(data_mgr->engines, (void**)&item);
-	while (item != NULL)
+	for (type = ENGINE_TYPE_TTXT; type < ENGINE_TYPE_INVALID; type++)
 	{
-		error = stream_prov->detach((link_handle_t)sink, item->id);
-		if (error != EOS_ERROR_OK)
+		if (data_mgr->engines[type].engine == NULL)
 		{
-			UTIL_LOGW(data_mgr->log, "Unable to detach engine");
+			continue;
 		}
-
-		osi_memset(&api, 0, sizeof(engine_api_t));
-		error = item->engine->get_api(item->engine, &api);
+		error = stream_prov->detach((link_handle_t)sink,
+				data_mgr->engines[type].id);
 		if (error != EOS_ERROR_OK)
 		{
-			UTIL_LOGW(data_mgr->log, "Unable to get engine API");
-		}
-		else
-		{
-			error = data_mgr->engines.remove(data_mgr->engines, (void*)&api.type);
-			if (error != EOS_ERROR_OK)
-			{
-				UTIL_LOGW(data_mgr->log, "Unable to remove engine");
-			}
+			UTIL_LOGW(data_mgr->log, "Unable to detach engine");
 		}
-		error = engine_factory_dismantle(&item->engine);
+		engine = data_mgr->engines[type].engine;
+		engine_release(&data_mgr->engines[type]);
+		error = engine_factory_dismantle(&engine);
 		if (error != EOS_ERROR_OK)
 		{
 			UTIL_LOGW(data_mgr->log, "Unable to dismantle engine");
 		}
-		osi_free((void**)&item);
-		data_mgr->engines.first(data_mgr->engines, (void**)&item);
 	}
 	osi_mutex_unlock(data_mgr->lock);
 
@@ -607,7 +570,8 @@ eos_error_t data_mgr_poll(data_mgr_t* data_mgr, eos_media_codec_t codec,
 eos_error_t data_mgr_hande_event(data_mgr_t* data_mgr, link_ev_t event,
 			link_ev_data_t* data)
 {
-	list_item_t *item = NULL;
+	engine_t *engine = NULL;
+	int type = 0;
 
 	if(data_mgr == NULL)
 	{
@@ -616,17 +580,12 @@ eos_error_t data_mgr_hande_event(data_mgr_t* data_mgr, link_ev_t event,
 		return EOS_ERROR_INVAL;
 	}
 	osi_mutex_lock(data_mgr->lock);
-	data_mgr->engines.first(data_mgr->engines, (void**)&item);
-	while (item != NULL)
+	for (type = ENGINE_TYPE_TTXT; type < ENGINE_TYPE_INVALID; type++)
 	{
-		if(item->engine->event_handler != NULL)
-		{
-			item->engine->event_handler(item->engine, event, data);
-		}
-		if(data_mgr->engines.next(data_mgr->engines, (void**)&item)
-				!= EOS_ERROR_OK)
+		engine = data_mgr->engines[type].engine;
+		if(engine != NULL && engine->event_handler != NULL)
 		{
-			break;
+			engine->event_handler(engine, event, data);
 		}
 	}
 	osi_mutex_unlock(data_mgr->lock);
@@ -636,7 +595,7 @@ eos_error_t data_mgr_hande_event(data_mgr_t* data_mgr, link_ev_t event,
 
 eos_error_t data_mgr_ttxt_enable(data_mgr_t* data_mgr, bool enable)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -652,7 +611,6 @@ eos_error_t data_mgr_ttxt_enable(data_mgr_t* data_mgr, bool enable)
 	else
 	{
 		err = api->func.data_prov.ttxt_enable(engine, enable);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -661,7 +619,7 @@ eos_error_t data_mgr_ttxt_enable(data_mgr_t* data_mgr, bool enable)
 eos_error_t data_mgr_ttxt_page_set(data_mgr_t* data_mgr, uint16_t page,
 		uint16_t subpage)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -677,7 +635,6 @@ eos_error_t data_mgr_ttxt_page_set(data_mgr_t* data_mgr, uint16_t page,
 	else
 	{
 		err = api->func.data_prov.ttxt_page_set(engine, page, subpage);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -686,7 +643,7 @@ eos_error_t data_mgr_ttxt_page_set(data_mgr_t* data_mgr, uint16_t page,
 eos_error_t data_mgr_ttxt_page_get(data_mgr_t* data_mgr, uint16_t* page,
 		uint16_t* subpage)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -702,7 +659,6 @@ eos_error_t data_mgr_ttxt_page_get(data_mgr_t* data_mgr, uint16_t* page,
 	else
 	{
 		err = api->func.data_prov.ttxt_page_get(engine, page, subpage);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -710,7 +666,7 @@ eos_error_t data_mgr_ttxt_page_get(data_mgr_t* data_mgr, uint16_t* page,
 
 eos_error_t data_mgr_ttxt_next_page_get(data_mgr_t* data_mgr, uint16_t* next)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -726,7 +682,6 @@ eos_error_t data_mgr_ttxt_next_page_get(data_mgr_t* data_mgr, uint16_t* next)
 	else
 	{
 		err = api->func.data_prov.ttxt_next_page_get(engine, next);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -735,7 +690,7 @@ eos_error_t data_mgr_ttxt_next_page_get(data_mgr_t* data_mgr, uint16_t* next)
 eos_error_t data_mgr_ttxt_prev_page_get(data_mgr_t* data_mgr,
 		uint16_t* previous)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -751,7 +706,6 @@ eos_error_t data_mgr_ttxt_prev_page_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_prev_page_get(engine, previous);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -760,7 +714,7 @@ eos_error_t data_mgr_ttxt_prev_page_get(data_mgr_t* data_mgr,
 eos_error_t data_mgr_ttxt_red_page_get(data_mgr_t* data_mgr,
 		uint16_t* red)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -777,7 +731,6 @@ eos_error_t data_mgr_ttxt_red_page_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_red_page_get(engine, red);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -786,7 +739,7 @@ eos_error_t data_mgr_ttxt_red_page_get(data_mgr_t* data_mgr,
 eos_error_t data_mgr_ttxt_green_page_get(data_mgr_t* data_mgr,
 		uint16_t* green)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -803,7 +756,6 @@ eos_error_t data_mgr_ttxt_green_page_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_green_page_get(engine, green);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -812,7 +764,7 @@ eos_error_t data_mgr_ttxt_green_page_get(data_mgr_t* data_mgr,
 
 eos_error_t data_mgr_ttxt_next_subpage_get(data_mgr_t* data_mgr, uint16_t* next)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -828,7 +780,6 @@ eos_error_t data_mgr_ttxt_next_subpage_get(data_mgr_t* data_mgr, uint16_t* next)
 	else
 	{
 		err = api->func.data_prov.ttxt_next_subpage_get(engine, next);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -837,7 +788,7 @@ eos_error_t data_mgr_ttxt_next_subpage_get(data_mgr_t* data_mgr, uint16_t* next)
 eos_error_t data_mgr_ttxt_prev_subpage_get(data_mgr_t* data_mgr,
 		uint16_t* previous)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -853,7 +804,6 @@ eos_error_t data_mgr_ttxt_prev_subpage_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_prev_subpage_get(engine, previous);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -862,7 +812,7 @@ eos_error_t data_mgr_ttxt_prev_subpage_get(data_mgr_t* data_mgr,
 eos_error_t data_mgr_ttxt_blue_page_get(data_mgr_t* data_mgr,
 		uint16_t* blue)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -878,7 +828,6 @@ eos_error_t data_mgr_ttxt_blue_page_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_blue_page_get(engine, blue);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -887,7 +836,7 @@ eos_error_t data_mgr_ttxt_blue_page_get(data_mgr_t* data_mgr,
 eos_error_t data_mgr_ttxt_yellow_page_get(data_mgr_t* data_mgr,
 		uint16_t* yellow)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -903,7 +852,6 @@ eos_error_t data_mgr_ttxt_yellow_page_get(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_yellow_page_get(engine, yellow);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -912,7 +860,7 @@ eos_error_t data_mgr_ttxt_yellow_page_get(data_mgr_t* data_mgr,
 eos_error_t data_mgr_ttxt_transparency_set(data_mgr_t* data_mgr,
 		uint8_t alpha)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -929,7 +877,6 @@ eos_error_t data_mgr_ttxt_transparency_set(data_mgr_t* data_mgr,
 	else
 	{
 		err = api->func.data_prov.ttxt_transparency_set(engine, alpha);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -937,7 +884,7 @@ eos_error_t data_mgr_ttxt_transparency_set(data_mgr_t* data_mgr,
 
 eos_error_t data_mgr_hbbtv_uri_get(data_mgr_t* data_mgr, char* uri)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -953,7 +900,6 @@ eos_error_t data_mgr_hbbtv_uri_get(data_mgr_t* data_mgr, char* uri)
 	else
 	{
 		err = api->func.hbbtv.get_red_btn_url(engine, (uint8_t**)&uri);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -961,7 +907,7 @@ eos_error_t data_mgr_hbbtv_uri_get(data_mgr_t* data_mgr, char* uri)
 
 eos_error_t data_mgr_dvbsub_enable(data_mgr_t* data_mgr, bool enable)
 {
-	engine_api_t *api = NULL;
+	const engine_api_t *api = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 	engine_t *engine = NULL;
 
@@ -977,7 +923,6 @@ eos_error_t data_mgr_dvbsub_enable(data_mgr_t* data_mgr, bool enable)
 	else
 	{
 		err = api->func.data_prov.dvbsub_enable(engine, enable);
-		osi_free((void**)&api);
 	}
 
 	return err;
@@ -992,8 +937,7 @@ static eos_error_t data_prov_start(data_mgr_t* data_mgr, chain_t* chain,
 	link_cap_data_prov_t *data_prov = NULL;
 	engine_params_t params;
 	engine_t *engine = NULL;
-	list_item_t *item = NULL;
-	engine_api_t *api = NULL;
+	engine_slot_t *slot = NULL;
 	link_cap_stream_sel_ctrl_t *sel = NULL;
 
 	err = chain_get_sink(chain, &sink);
@@ -1052,24 +996,16 @@ static eos_error_t data_prov_start(data_mgr_t* data_mgr, chain_t* chain,
 	err = engine_factory_manufacture(&params, &engine);
 	if (err == EOS_ERROR_OK)
 	{
-		item = (list_item_t*)osi_calloc(sizeof(list_item_t));
-		if (item == NULL)
+		err = engine_store(data_mgr, media->es_cnt, engine, &slot);
+		if (err != EOS_ERROR_OK)
 		{
-			UTIL_LOGE(data_mgr->log,
-					"Engine list item mem alloc failed");
+			UTIL_LOGE(data_mgr->log, "Unable to store engine");
 			engine_factory_dismantle(&engine);
 			osi_mutex_unlock(data_mgr->lock);
-			return EOS_ERROR_NOMEM;
+			return err;
 		}
-		item->id = media->es_cnt;
-		item->engine = engine;
-		data_mgr->engines.add(data_mgr->engines, item);
-
-		api = osi_calloc(sizeof(engine_api_t));
-		item->engine->get_api(item->engine, api);
 		UTIL_LOGI(data_mgr->log, "Setting data provider");
-		api->func.data_prov.set_data_prov(engine, sink, data_prov);
-		osi_free((void**)&api);
+		slot->api.func.data_prov.set_data_prov(engine, sink, data_prov);
 	}
 	osi_mutex_unlock(data_mgr->lock);
 
@@ -1080,8 +1016,7 @@ static eos_error_t data_prov_stop(data_mgr_t* data_mgr)
 {
 	sink_t *sink = NULL;
 	eos_error_t err = EOS_ERROR_OK;
-	list_item_t *item = NULL;
-	engine_type_t type = ENGINE_TYPE_DATA_PROV;
+	engine_slot_t *slot = NULL;
 
 	err = chain_get_sink(data_mgr->chain, &sink);
 	if(err != EOS_ERROR_OK)
@@ -1094,18 +1029,13 @@ static eos_error_t data_prov_stop(data_mgr_t* data_mgr)
 		return EOS_ERROR_OK;
 	}
 	osi_mutex_lock(data_mgr->lock);
-	err = data_mgr->engines.get(data_mgr->engines, &type, (void**)&item);
-	if(err != EOS_ERROR_OK || item == NULL)
+	slot = engine_slot(data_mgr, ENGINE_TYPE_DATA_PROV);
+	if(slot == NULL)
 	{
 		osi_mutex_unlock(data_mgr->lock);
-		return err;
-	}
-	err = data_mgr->engines.remove(data_mgr->engines, (void*)&type);
-	if(err != EOS_ERROR_OK)
-	{
-		UTIL_LOGW(data_mgr->log, "Remove from list failed?!?");
+		return EOS_ERROR_NFOUND;
 	}
-	osi_free((void**)&item);
+	engine_release(slot);
 	osi_mutex_unlock(data_mgr->lock);
 
 	return EOS_ERROR_OK;
@@ -1204,21 +1134,17 @@ static eos_error_t data_prov_select(data_mgr_t* data_mgr,
 	return EOS_ERROR_OK;
 }
 
-static engine_api_t* find_api(data_mgr_t* data_mgr, engine_type_t type,
+static const engine_api_t* find_api(data_mgr_t* data_mgr, engine_type_t type,
 		engine_t **engine)
 {
-	engine_api_t *api = NULL;
-	list_item_t *item = NULL;
-	eos_error_t err = EOS_ERROR_OK;
+	engine_slot_t *slot = NULL;
 
-	err = data_mgr->engines.get(data_mgr->engines, &type, (void**)&item);
-	if(err != EOS_ERROR_OK || item == NULL)
+	slot = engine_slot(data_mgr, type);
+	if(slot == NULL)
 	{
 		return NULL;
 	}
-	*engine = item->engine;
-	api = osi_calloc(sizeof(engine_api_t));
-	item->engine->get_api(item->engine, api);
+	*engine = slot->engine;
 
-	return api;
+	return &slot->api;
 }
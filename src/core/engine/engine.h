@@ -129,6 +129,9 @@ struct engine
 
 	const char* (*name) (void);
 	eos_error_t (*probe) (eos_media_codec_t codec);
+	/* Handled codecs terminated with EOS_MEDIA_CODEC_UNKNOWN, the factory
+	 * probes the engine only for these. NULL probes every codec. */
+	const eos_media_codec_t* codecs;
 	eos_error_t (*get_api) (engine_t* engine, engine_api_t* api);
 	eos_error_t (*get_hook) (engine_t* engine, engine_in_hook_t* hook);
 	eos_error_t (*flush) (engine_t* engine);
@@ -53,6 +53,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 // *              Macros               *
 // *************************************
 
+#define ENGINE_FACTORY_CODECS_MAX (16)
+
 // *************************************
 // *              Types                *
 // *************************************
@@ -62,6 +64,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 // *************************************
 
 static eos_error_t engine_probe(engine_t* model, engine_params_t* params);
+static void engine_key(engine_params_t* params, uint32_t* key, uint32_t* hint);
 
 // *************************************
 // *         Global variables          *
@@ -92,6 +95,13 @@ static eos_error_t engine_probe(engine_t* model, engine_params_t* params)
 	return EOS_ERROR_NFOUND;
 }
 
+static void engine_key(engine_params_t* params, uint32_t* key, uint32_t* hint)
+{
+	/* EOS_MEDIA_CODEC_UNKNOWN doubles as the match-all key */
+	*key = (params != NULL) ? (uint32_t)params->codec : 0;
+	*hint = *key;
+}
+
 // *************************************
 // *         Global functions          *
 // *************************************
@@ -100,6 +110,8 @@ eos_error_t engine_factory_register(engine_t* model, uint64_t* model_id, engine_
 		engine_dismantle_cb_t dismantle)
 {
 	eos_error_t ret = EOS_ERROR_OK;
+	uint32_t keys[ENGINE_FACTORY_CODECS_MAX];
+	uint8_t key_cnt = 0;
 
 	if ((model == NULL) || (manufacture == NULL))
 	{
@@ -108,13 +120,27 @@ eos_error_t engine_factory_register(engine_t* model, uint64_t* model_id, engine_
 
 	if (factory == NULL)
 	{
-		ret = util_factory_create(&factory, (util_probe_cb_t)engine_probe);
+		ret = util_factory_create(&factory, (util_probe_cb_t)engine_probe,
+				(util_key_cb_t)engine_key);
 		if (ret != EOS_ERROR_OK)
 		{
 			return ret;
 		}
 	}
+	while (model->codecs != NULL &&
+			model->codecs[key_cnt] != EOS_MEDIA_CODEC_UNKNOWN)
+	{
+		if (key_cnt == ENGINE_FACTORY_CODECS_MAX)
+		{
+			/* Too many to index, probe it for everything */
+			key_cnt = 0;
+			break;
+		}
+		keys[key_cnt] = (uint32_t)model->codecs[key_cnt];
+		key_cnt++;
+	}
 	ret = util_factory_register(factory, (void*)model, model_id,
+			keys, key_cnt,
 			(util_manufacture_cb_t)manufacture, (util_dismantle_cb_t)dismantle);
 	if (ret != EOS_ERROR_OK)
 	{
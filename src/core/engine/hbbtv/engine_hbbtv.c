@@ -103,11 +103,18 @@ static eos_error_t engine_hbbtv_get_red_btn_url (engine_t* engine, uint8_t** url
 // *         Global variables          *
 // *************************************
 
+static const eos_media_codec_t engine_hbbtv_codecs[] =
+{
+	ENGINE_CODEC,
+	EOS_MEDIA_CODEC_UNKNOWN
+};
+
 static engine_t engine_hbbtv_model =
 {
 	.handle = NULL,
 	.name = engine_hbbtv_name,
 	.probe = engine_hbbtv_probe,
+	.codecs = engine_hbbtv_codecs,
 	.get_api = engine_hbbtv_get_api,
 	.get_hook = engine_hbbtv_get_hook,
 	.flush = engine_hbbtv_flush,
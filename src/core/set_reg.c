@@ -90,6 +90,7 @@ static set_reg_sys_t sys_reg[] =
 		{SET_REG_OPT_VID_SIZE, 0, NULL, NULL},
 		{SET_REG_OPT_AUD_MODE, 0, NULL, NULL},
 		{SET_REG_OPT_VOL_LVL, 0, NULL, NULL},
+		{SET_REG_OPT_DEC_THR, 0, NULL, NULL},
 		{SET_REG_OPT_LAST, 0, NULL, NULL}
 };
 
@@ -433,6 +434,10 @@ static eos_error_t set_reg_item_store_values(set_reg_item_t* new_value)
 				stored_item->val.vol_lvl.lvl = new_value->val.vol_lvl.lvl;
 				stored_item->val.vol_lvl.enable = new_value->val.vol_lvl.enable;
 				break;
+			case SET_REG_OPT_DEC_THR:
+				stored_item->val.dec_thr.mode = new_value->val.dec_thr.mode;
+				stored_item->val.dec_thr.count = new_value->val.dec_thr.count;
+				break;
 			default:
 				return EOS_ERR_UNKNOWN;
 		}
@@ -458,6 +463,11 @@ static eos_error_t set_reg_item_store_values(set_reg_item_t* new_value)
 				stored_item->val.vol_lvl.enable =
 						new_value->val.vol_lvl.enable;
 				break;
+			case SET_REG_OPT_DEC_THR:
+				stored_item->val.dec_thr.mode = new_value->val.dec_thr.mode;
+				stored_item->val.dec_thr.count =
+						new_value->val.dec_thr.count;
+				break;
 			default:
 				return EOS_ERR_UNKNOWN;
 		}
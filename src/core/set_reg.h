@@ -43,6 +43,7 @@ typedef enum set_reg_opt
 	SET_REG_OPT_VID_SIZE,
 	SET_REG_OPT_AUD_MODE,
 	SET_REG_OPT_VOL_LVL,
+	SET_REG_OPT_DEC_THR,
 	SET_REG_OPT_LAST
 } set_reg_opt_t;
 
@@ -64,6 +65,11 @@ typedef union set_reg_val
 		bool enable;
 		eos_out_vol_lvl_t lvl;
 	} vol_lvl;
+	struct
+	{
+		eos_out_dec_thr_t mode;
+		uint8_t count; /* 0 for one thread per online core */
+	} dec_thr;
 } set_reg_val_t;
 
 typedef eos_error_t (*set_reg_cbk_t) (set_reg_opt_t opt, set_reg_val_t* val,
@@ -0,0 +1,219 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+#include "zap_stats.h"
+
+#include "eos_macro.h"
+#include "osi_memory.h"
+#include "osi_mutex.h"
+#include "osi_time.h"
+
+#define MODULE_NAME ("core:zap")
+#include "util_log.h"
+
+#define ZAP_STATS_OUT_MAX (EOS_OUT_AUX_AV + 1)
+
+typedef struct zap_stats_out
+{
+	uint32_t seq;
+	bool active;
+	osi_time_t start;
+	eos_zap_info_t cur;
+	/* Ring of completed zaps */
+	eos_zap_info_t window[ZAP_STATS_WINDOW];
+	uint32_t completed;
+} zap_stats_out_t;
+
+static osi_mutex_t *zap_lock = NULL;
+static zap_stats_out_t zap_outs[ZAP_STATS_OUT_MAX];
+
+static void zap_stats_sort(uint32_t* vals, uint32_t cnt);
+static uint32_t zap_stats_bucket(uint32_t ms);
+
+CALL_ON_LOAD(zap_stats_init)
+static void zap_stats_init(void)
+{
+	if(osi_mutex_create(&zap_lock) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Lock could not be created");
+	}
+}
+
+CALL_ON_UNLOAD(zap_stats_deinit)
+static void zap_stats_deinit(void)
+{
+	if(zap_lock != NULL)
+	{
+		osi_mutex_destroy(&zap_lock);
+	}
+}
+
+eos_error_t zap_stats_mark(uint32_t id, eos_zap_ms_t ms)
+{
+	zap_stats_out_t *out = NULL;
+	osi_time_t now = {0, 0};
+	osi_time_t diff = {0, 0};
+	uint64_t msec = 0;
+	uint8_t i = 0;
+
+	if(id >= ZAP_STATS_OUT_MAX || ms >= EOS_ZAP_MS_LAST || zap_lock == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_time_get_timestamp(&now);
+	out = &zap_outs[id];
+	osi_mutex_lock(zap_lock);
+	if(ms == EOS_ZAP_MS_PLAY_REQ)
+	{
+		out->seq++;
+		out->active = true;
+		out->start = now;
+		out->cur.id = out->seq;
+		for(i = 0; i < EOS_ZAP_MS_LAST; i++)
+		{
+			out->cur.at[i] = EOS_ZAP_NONE;
+		}
+		out->cur.at[EOS_ZAP_MS_PLAY_REQ] = 0;
+		osi_mutex_unlock(zap_lock);
+
+		return EOS_ERROR_OK;
+	}
+	if(!out->active || out->cur.at[ms] != EOS_ZAP_NONE)
+	{
+		osi_mutex_unlock(zap_lock);
+		return EOS_ERROR_NFOUND;
+	}
+	osi_time_diff(&out->start, &now, &diff);
+	OSI_TIME_CONVERT_TO_MSEC(diff, msec);
+	out->cur.at[ms] = (msec < EOS_ZAP_NONE) ? (uint32_t)msec : EOS_ZAP_NONE - 1;
+	if(ms == EOS_ZAP_MS_FIRST_DISP)
+	{
+		out->window[out->completed % ZAP_STATS_WINDOW] = out->cur;
+		out->completed++;
+		out->active = false;
+		UTIL_GLOGI("Zap #%u on %u: lock %d, PMT %d, sink %d, 1st pkt %d, "
+				"I frame %d, display %u ms", out->cur.id, id,
+				(int32_t)out->cur.at[EOS_ZAP_MS_SRC_LOCK],
+				(int32_t)out->cur.at[EOS_ZAP_MS_PMT],
+				(int32_t)out->cur.at[EOS_ZAP_MS_SINK_SETUP],
+				(int32_t)out->cur.at[EOS_ZAP_MS_FIRST_PKT],
+				(int32_t)out->cur.at[EOS_ZAP_MS_FIRST_IFRM],
+				out->cur.at[EOS_ZAP_MS_FIRST_DISP]);
+	}
+	osi_mutex_unlock(zap_lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t zap_stats_get(uint32_t id, eos_zap_info_t* last, eos_zap_hist_t* hist)
+{
+	zap_stats_out_t *out = NULL;
+	uint32_t vals[ZAP_STATS_WINDOW];
+	uint32_t cnt = 0, zaps = 0, i = 0, ms = 0;
+
+	if(id >= ZAP_STATS_OUT_MAX || zap_lock == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	out = &zap_outs[id];
+	osi_mutex_lock(zap_lock);
+	if(out->seq == 0)
+	{
+		osi_mutex_unlock(zap_lock);
+		return EOS_ERROR_NFOUND;
+	}
+	if(last != NULL)
+	{
+		*last = out->cur;
+	}
+	if(hist != NULL)
+	{
+		osi_memset(hist, 0, sizeof(eos_zap_hist_t));
+		zaps = (out->completed < ZAP_STATS_WINDOW) ?
+				out->completed : ZAP_STATS_WINDOW;
+		hist->zaps = zaps;
+		for(ms = 0; ms < EOS_ZAP_MS_LAST; ms++)
+		{
+			for(i = 0, cnt = 0; i < zaps; i++)
+			{
+				if(out->window[i].at[ms] != EOS_ZAP_NONE)
+				{
+					vals[cnt++] = out->window[i].at[ms];
+					hist->buckets[ms][zap_stats_bucket(out->window[i].at[ms])]++;
+				}
+			}
+			if(cnt == 0)
+			{
+				hist->p50[ms] = hist->p90[ms] = hist->p99[ms] = EOS_ZAP_NONE;
+				continue;
+			}
+			zap_stats_sort(vals, cnt);
+			hist->p50[ms] = vals[((cnt - 1) * 50) / 100];
+			hist->p90[ms] = vals[((cnt - 1) * 90) / 100];
+			hist->p99[ms] = vals[((cnt - 1) * 99) / 100];
+		}
+	}
+	osi_mutex_unlock(zap_lock);
+
+	return EOS_ERROR_OK;
+}
+
+/* Window is small, insertion sort is good enough */
+static void zap_stats_sort(uint32_t* vals, uint32_t cnt)
+{
+	uint32_t i = 0, j = 0, tmp = 0;
+
+	for(i = 1; i < cnt; i++)
+	{
+		tmp = vals[i];
+		for(j = i; j > 0 && vals[j - 1] > tmp; j--)
+		{
+			vals[j] = vals[j - 1];
+		}
+		vals[j] = tmp;
+	}
+}
+
+static uint32_t zap_stats_bucket(uint32_t ms)
+{
+	uint32_t bucket = 0;
+
+	while(ms != 0 && bucket < EOS_ZAP_HIST_BUCKETS - 1)
+	{
+		ms >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
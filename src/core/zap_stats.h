@@ -0,0 +1,65 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+#ifndef ZAP_STATS_H_
+#define ZAP_STATS_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+
+/* Number of the last completed zaps percentiles/histograms are built from */
+#define ZAP_STATS_WINDOW (128)
+
+/**
+ * Records the time the milestone was reached on the output.
+ * EOS_ZAP_MS_PLAY_REQ starts a new zap (an unfinished one is dropped),
+ * EOS_ZAP_MS_FIRST_DISP completes it. Every other milestone is recorded
+ * only the first time it is reached within the zap.
+ * @param id Output (chain) ID.
+ * @param ms Milestone.
+ * @return EOS_ERROR_OK if recorded, EOS_ERROR_NFOUND if there is no zap
+ * in progress or the milestone is already recorded.
+ */
+eos_error_t zap_stats_mark(uint32_t id, eos_zap_ms_t ms);
+/**
+ * Returns the latest zap (finished or not) and statistics of the last
+ * ZAP_STATS_WINDOW completed zaps.
+ * @param id Output (chain) ID.
+ * @param last Latest zap breakdown (can be NULL).
+ * @param hist Percentiles and histograms (can be NULL).
+ * @return EOS_ERROR_OK, or EOS_ERROR_NFOUND if there was no zap on the output.
+ */
+eos_error_t zap_stats_get(uint32_t id, eos_zap_info_t* last, eos_zap_hist_t* hist);
+
+#endif /* ZAP_STATS_H_ */
@@ -42,6 +42,7 @@ import com.swisscom.eos.event.EosException;
 import com.swisscom.eos.event.EosPlayInfo;
 import com.swisscom.eos.event.EosPlaybackStatus;
 import com.swisscom.eos.event.EosPlayerState;
+import com.swisscom.eos.event.EosRequestResult;
 import com.swisscom.eos.log.EosLog;
 import com.swisscom.eos.media.EosMediaDesc;
 import com.swisscom.eos.out.EosOut;
@@ -96,6 +97,11 @@ class EosNativeBridge {
 	
 	public native void stop(EosOut out) throws EosException;
 	
+	public native int startAsync(EosOut out, String inUrl, 
+			String inExtras) throws EosException;
+	
+	public native int stopAsync(EosOut out) throws EosException;
+	
 	public native EosMediaDesc getMediaDesc(EosOut out) throws EosException;
 	
 	public native void selectTrack(EosOut out, int id) throws EosException;
@@ -207,6 +213,16 @@ class EosNativeBridge {
 		}
 	}
 	
+	private void fireRequest(EosOut out, EosRequestResult result) {
+		EosLog.d(LOG_TAG, "fireRequest: ID " + out.getID() + " " + 
+			result.getID() + " " + result.getState().name());
+		for (INativeBridgeListener lsnr : listeners) {
+			if(lsnr.getOut().getID() == out.getID()) {
+				lsnr.onRequestComplete(result);
+			}
+		}
+	}
+	
 	private void fireData(EosOut out, EosDataKind kind, EosDataFormat format,
 			String data) {
 		EosLog.d(LOG_TAG, "fireData: ID " + out.getID() + " " + kind.name());
@@ -52,6 +52,8 @@ import com.swisscom.eos.event.EosPlayInfo;
 import com.swisscom.eos.event.EosPlaybackStatus;
 import com.swisscom.eos.event.EosPlayerStatus;
 import com.swisscom.eos.event.EosPlayerState;
+import com.swisscom.eos.event.EosRequestResult;
+import com.swisscom.eos.event.EosRequestState;
 import com.swisscom.eos.event.IEosPlayerListener;
 import com.swisscom.eos.log.EosLog;
 import com.swisscom.eos.media.EosMediaDesc;
@@ -70,6 +72,7 @@ public class EosPlayer implements INativeBridgeListener {
 	private EosHbbTVFeed hbbtvFeed;
 	private EosDsmccFeed dsmccFeed;
 	private EosMediaDesc mediaDesc;
+	private int stopRequest;
 	
 	private static final long EOS_PLAYER_CURRENT_TIME = -1;
 	private static final short EOS_PLAYER_PAUSE_SPEED = 0;
@@ -78,6 +81,7 @@ public class EosPlayer implements INativeBridgeListener {
 	private static final String EOS_PLAYER_SPEED = "speed=";
 	private static final String EOS_PLAYER_DELIMITER = "&";
 	private static final String LOG_TAG = "EosPlayer";
+	private static final int EOS_PLAYER_NO_REQUEST = -1;
 	
 	public EosPlayer(EosOut out) {
 		if(out == null) {
@@ -104,6 +108,7 @@ public class EosPlayer implements INativeBridgeListener {
 		status.setState(EosPlayerState.STOPPED);
 		status.setError(EosError.OK);
 		mediaDesc = null;
+		stopRequest = EOS_PLAYER_NO_REQUEST;
 	}
 	
 	public EosOut getOut() {
@@ -166,6 +171,42 @@ public class EosPlayer implements INativeBridgeListener {
 		}
 	}
 
+	/**
+	 * Returns right away, the outcome is reported to the listeners by a 
+	 * status carrying the request result with the returned ID. A newer 
+	 * request on the same out cancels this one if it is still in flight.
+	 */
+	public int playAsync(URI inUri, String inExtras) {
+		String uri;
+		int id;
+		
+		if(inUri == null) {
+			return EOS_PLAYER_NO_REQUEST;
+		}
+		EosLog.d("eos", "PLAY ASYNC: " + inUri.toString());
+		uri = inUri.toString();
+		if(uri.startsWith("file:/") && !uri.startsWith("file:///")) {
+			uri = uri.replace("file:/", "file:///");
+		}
+		try {
+			synchronized (status) {
+				status.setPlayInfo(null);
+				mediaDesc = null;
+			}
+			fireStateChanged(EosPlayerState.TRANSITIONING);
+			id = bridge.startAsync(out, uri, inExtras);
+			synchronized (status) {
+				status.setUri(inUri);
+				status.setError(EosError.OK);
+			}
+		} catch (EosException e) {
+			fireError(e.getError());
+			return EOS_PLAYER_NO_REQUEST;
+		}
+		
+		return id;
+	}
+
 	public void play(URI inUri, EosTime offset, short speed) {
 		String extras = null;
 		
@@ -272,6 +313,24 @@ public class EosPlayer implements INativeBridgeListener {
 		}
 	}
 	
+	public int stopAsync() {
+		int id;
+		
+		try {
+			fireStateChanged(EosPlayerState.TRANSITIONING);
+			// completion can come before stopAsync returns
+			synchronized (status) {
+				id = bridge.stopAsync(out);
+				stopRequest = id;
+			}
+		} catch (EosException e) {
+			fireError(e.getError());
+			return EOS_PLAYER_NO_REQUEST;
+		}
+		
+		return id;
+	}
+	
 	public EosMediaDesc getMediaDesc() {	
 		try {
 			synchronized (status) {
@@ -469,6 +528,37 @@ public class EosPlayer implements INativeBridgeListener {
 		}
 	}
 
+	@Override
+	public void onRequestComplete(EosRequestResult result) {
+		boolean stopped = false;
+		
+		synchronized (status) {
+			if(result.getID() == stopRequest) {
+				stopRequest = EOS_PLAYER_NO_REQUEST;
+				stopped = result.getState() == EosRequestState.DONE;
+			}
+			if(stopped) {
+				status.setUri(null);
+			}
+		}
+		// Stop has no native state event to close the transition
+		if(stopped) {
+			fireStateChanged(EosPlayerState.STOPPED);
+		}
+		synchronized (status) {
+			status.setRequest(result);
+			status.setError(result.getError());
+		}
+		for (IEosPlayerListener lnr : listeners) {
+			lnr.onStatusChange(status);
+		}
+		// clear request result after listener is informed
+		synchronized (status) {
+			status.setRequest(null);
+			status.setError(EosError.OK);
+		}
+	}
+
 	private String resolveLalala(String httpUri) {
 		URLConnection urlConn = null;
 		InputStreamReader in = null;
@@ -37,6 +37,7 @@ import com.swisscom.eos.event.EosError;
 import com.swisscom.eos.event.EosPlayInfo;
 import com.swisscom.eos.event.EosPlaybackStatus;
 import com.swisscom.eos.event.EosPlayerState;
+import com.swisscom.eos.event.EosRequestResult;
 import com.swisscom.eos.out.EosOut;
 
 interface INativeBridgeListener {
@@ -46,4 +47,5 @@ interface INativeBridgeListener {
 	public void onError(EosError err);
 	public void onPlaybackStatus(EosPlaybackStatus playbackStatus);
 	public void onConnectionStateChange(EosConnectionStateChange connectionState);
+	public void onRequestComplete(EosRequestResult result);
 }
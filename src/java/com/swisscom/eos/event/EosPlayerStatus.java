@@ -41,6 +41,7 @@ public class EosPlayerStatus {
 	private EosError error;
 	private EosConnectionStateChange connectionState;
 	private EosPlaybackStatus playbackStatus;
+	private EosRequestResult request;
 	
 	public void setState(EosPlayerState state) {
 		this.state = state;
@@ -89,4 +90,12 @@ public class EosPlayerStatus {
 	public void setPlaybackStatus(EosPlaybackStatus playbackStatus) {
 		this.playbackStatus = playbackStatus;
 	}
+
+	public EosRequestResult getRequest() {
+		return request;
+	}
+
+	public void setRequest(EosRequestResult request) {
+		this.request = request;
+	}
 }
@@ -74,6 +74,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define CLASS_CONN_CHNG_REASON (\
 		PACKAGE"/event/EosConnectionChangeReason")
 #define CLASS_ERR_ENUM         (PACKAGE"/event/EosError")
+#define CLASS_REQ_RESULT       (PACKAGE"/event/EosRequestResult")
+#define CLASS_REQ_STATE        (PACKAGE"/event/EosRequestState")
 #define CLASS_DATA_KIND_ENUM   (PACKAGE"/data/EosDataKind")
 #define CLASS_DATA_FORMAT_ENUM (PACKAGE"/data/EosDataFormat")
 
@@ -127,6 +129,11 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 		"L"PACKAGE"/data/EosDataKind;" \
 		"L"PACKAGE"/data/EosDataFormat;Ljava/lang/String;)V")
 #define SIGN_ERR_ENUM             ("L"PACKAGE"/event/EosError;")
+#define SIGN_REQ_STATE_ENUM       ("L"PACKAGE"/event/EosRequestState;")
+#define SIGN_REQ_RESULT_CTOR      ("(IL"PACKAGE"/event/EosRequestState;" \
+		"L"PACKAGE"/event/EosError;)V")
+#define SIGN_FIRE_REQUEST         ("(L"PACKAGE"/out/EosOut;" \
+		"L"PACKAGE"/event/EosRequestResult;)V")
 #define SIGN_EXC_CTOR             ("(L"PACKAGE"/event/EosError;)V")
 #define SIGN_DATA_KIND            ("L"PACKAGE"/data/EosDataKind;")
 #define SIGN_DATA_FORMAT          ("L"PACKAGE"/data/EosDataFormat;")
@@ -145,6 +152,7 @@ static jobject conv_conn_state_to_java(JNIEnv* jEnv,
 		eos_conn_state_event_t* conn_state);
 static jobject conv_secs_to_java(JNIEnv* jEnv, uint64_t secs);
 static jobject conv_err_to_java(JNIEnv* jEnv, eos_error_t err);
+static jobject conv_req_to_java(JNIEnv* jEnv, eos_req_event_t* req);
 static void throw_eos_exception(JNIEnv* jEnv, eos_error_t err);
 static eos_error_t eos_callback(eos_out_t out, eos_event_t event,
 		eos_event_data_t* data, void* cookie);
@@ -166,6 +174,8 @@ static jclass jClazzConnState = NULL;
 static jclass jClazzConnChangeReason = NULL;
 static jclass jClazzState = NULL;
 static jclass jClazzErr = NULL;
+static jclass jClazzReqResult = NULL;
+static jclass jClazzReqState = NULL;
 static jclass jClazzDataKind = NULL;
 static jclass jClazzDataFormat = NULL;
 
@@ -300,6 +310,57 @@ JNIEXPORT void JNICALL NATIVE_BRIDGE_FUNC(stop)(JNIEnv* jEnv,
 	UTIL_LOGI(log, "Done");
 }
 
+JNIEXPORT jint JNICALL NATIVE_BRIDGE_FUNC(startAsync)(JNIEnv* jEnv,
+		jobject jThis, jobject jOut, jstring jInUrl, jstring jInExtras)
+{
+	const char *url = NULL;
+	const char *ext = NULL;
+	eos_error_t err = EOS_ERROR_OK;
+	eos_out_t out = conv_out_from_java(jEnv, jOut);
+	uint32_t id = 0;
+
+	EOS_UNUSED(jThis);
+	url = (*jEnv)->GetStringUTFChars(jEnv, jInUrl, 0);
+	UTIL_LOGI(log, "Start async %s", url);
+	if(jInExtras != NULL)
+	{
+		ext = (*jEnv)->GetStringUTFChars(jEnv, jInExtras, 0);
+	}
+	/* Strings are copied, they can be released right away */
+	err = eos_player_play_async((char*)url, (char*)ext, out, &id);
+	(*jEnv)->ReleaseStringUTFChars(jEnv, jInUrl, url);
+	if(ext != NULL)
+	{
+		(*jEnv)->ReleaseStringUTFChars(jEnv, jInExtras, ext);
+	}
+	if(err != EOS_ERROR_OK)
+	{
+		throw_eos_exception(jEnv, err);
+	}
+	UTIL_LOGI(log, "Done [%u]", id);
+
+	return (jint)id;
+}
+
+JNIEXPORT jint JNICALL NATIVE_BRIDGE_FUNC(stopAsync)(JNIEnv* jEnv,
+		jobject jThis, jobject jOut)
+{
+	eos_out_t out = conv_out_from_java(jEnv, jOut);
+	eos_error_t err = EOS_ERROR_OK;
+	uint32_t id = 0;
+
+	EOS_UNUSED(jThis);
+	UTIL_LOGI(log, "Stop async");
+	err = eos_player_stop_async(out, &id);
+	if(err != EOS_ERROR_OK)
+	{
+		throw_eos_exception(jEnv, err);
+	}
+	UTIL_LOGI(log, "Done [%u]", id);
+
+	return (jint)id;
+}
+
 JNIEXPORT jobject JNICALL NATIVE_BRIDGE_FUNC(getMediaDesc)
 		(JNIEnv* jEnv, jobject jThis, jobject jOut)
 {
@@ -725,6 +786,10 @@ static void cache_classes(JNIEnv* jEnv, jobject jThis)
 	jClazzState = (*jEnv)->NewGlobalRef(jEnv, clazz);
 	clazz = (*jEnv)->FindClass(jEnv, CLASS_ERR_ENUM);
 	jClazzErr = (*jEnv)->NewGlobalRef(jEnv, clazz);
+	clazz = (*jEnv)->FindClass(jEnv, CLASS_REQ_RESULT);
+	jClazzReqResult = (*jEnv)->NewGlobalRef(jEnv, clazz);
+	clazz = (*jEnv)->FindClass(jEnv, CLASS_REQ_STATE);
+	jClazzReqState = (*jEnv)->NewGlobalRef(jEnv, clazz);
 	clazz = (*jEnv)->FindClass(jEnv, CLASS_DATA_KIND_ENUM);
 	jClazzDataKind = (*jEnv)->NewGlobalRef(jEnv, clazz);
 	clazz = (*jEnv)->FindClass(jEnv, CLASS_DATA_FORMAT_ENUM);
@@ -780,6 +845,11 @@ static eos_error_t eos_callback(eos_out_t out, eos_event_t event,
 		jMethodFire = (*jEnv)->GetMethodID(jEnv, jClazzaNativeBridge,
 				"fireError", SIGN_FIRE_ERROR);
 		break;
+	case EOS_EVENT_REQUEST:
+		jEvent = conv_req_to_java(jEnv, &data->req);
+		jMethodFire = (*jEnv)->GetMethodID(jEnv, jClazzaNativeBridge,
+				"fireRequest", SIGN_FIRE_REQUEST);
+		break;
 	default:
 		break;
 	}
@@ -1133,6 +1203,10 @@ static jobject conv_err_to_java(JNIEnv* jEnv, eos_error_t err)
 
 	switch(err)
 	{
+	case EOS_ERROR_OK:
+		jFieldEnum = (*jEnv)->GetStaticFieldID(jEnv, jClazzErr,
+				"OK", SIGN_ERR_ENUM);
+		break;
 	case EOS_ERROR_GENERAL:
 		jFieldEnum = (*jEnv)->GetStaticFieldID(jEnv, jClazzErr,
 				"GENERAL", SIGN_ERR_ENUM);
@@ -1200,6 +1274,46 @@ static jobject conv_err_to_java(JNIEnv* jEnv, eos_error_t err)
 	return (*jEnv)->GetStaticObjectField(jEnv, jClazzErr, jFieldEnum);
 }
 
+static jobject conv_req_to_java(JNIEnv* jEnv, eos_req_event_t* req)
+{
+	jfieldID jFieldEnum = NULL;
+	jobject jState = NULL;
+	jobject jErr = NULL;
+	jmethodID jMethod = NULL;
+
+	switch(req->state)
+	{
+	case EOS_REQ_DONE:
+		jFieldEnum = (*jEnv)->GetStaticFieldID(jEnv, jClazzReqState,
+				"DONE", SIGN_REQ_STATE_ENUM);
+		break;
+	case EOS_REQ_FAILED:
+		jFieldEnum = (*jEnv)->GetStaticFieldID(jEnv, jClazzReqState,
+				"FAILED", SIGN_REQ_STATE_ENUM);
+		break;
+	case EOS_REQ_CANCELLED:
+		jFieldEnum = (*jEnv)->GetStaticFieldID(jEnv, jClazzReqState,
+				"CANCELLED", SIGN_REQ_STATE_ENUM);
+		break;
+	default:
+		UTIL_LOGE(log, "Unsupported request state: %d", req->state);
+		return NULL;
+	}
+	jState = (*jEnv)->GetStaticObjectField(jEnv, jClazzReqState, jFieldEnum);
+	jErr = conv_err_to_java(jEnv, req->err);
+	if(jState == NULL || jErr == NULL)
+	{
+		UTIL_LOGE(log, "Request result conversion failed: %d/%d",
+				req->state, req->err);
+		return NULL;
+	}
+	jMethod = (*jEnv)->GetMethodID(jEnv, jClazzReqResult, "<init>",
+			SIGN_REQ_RESULT_CTOR);
+
+	return (*jEnv)->NewObject(jEnv, jClazzReqResult, jMethod,
+			(jint)req->id, jState, jErr);
+}
+
 static void throw_eos_exception(JNIEnv* jEnv, eos_error_t err)
 {
 	jclass jClazzExc = NULL;
@@ -63,6 +63,22 @@ JNIEXPORT void JNICALL Java_com_swisscom_eos_EosNativeBridge_trickPlay
 JNIEXPORT void JNICALL Java_com_swisscom_eos_EosNativeBridge_stop
   (JNIEnv *, jobject, jobject);
 
+/*
+ * Class:     com_swisscom_eos_EosNativeBridge
+ * Method:    startAsync
+ * Signature: (Lcom/swisscom/eos/out/EosOut;Ljava/lang/String;Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_com_swisscom_eos_EosNativeBridge_startAsync
+  (JNIEnv *, jobject, jobject, jstring, jstring);
+
+/*
+ * Class:     com_swisscom_eos_EosNativeBridge
+ * Method:    stopAsync
+ * Signature: (Lcom/swisscom/eos/out/EosOut;)I
+ */
+JNIEXPORT jint JNICALL Java_com_swisscom_eos_EosNativeBridge_stopAsync
+  (JNIEnv *, jobject, jobject);
+
 /*
  * Class:     com_swisscom_eos_EosNativeBridge
  * Method:    getMediaDesc
@@ -33,6 +33,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include "link_factory.h"
 #include "util_slist.h"
+#include "util_dispatch.h"
 #include "osi_memory.h"
 #include "osi_mutex.h"
 #include "eos_macro.h"
@@ -58,19 +59,29 @@ typedef struct link_factory_product
 	uint64_t id;
 } link_factory_product_t;
 
+typedef struct link_factory_lookup
+{
+	link_factory_t *factory;
+	void *data;
+} link_factory_lookup_t;
+
 struct link_factory
 {
 	util_slist_t specs;
+	util_dispatch_t *index;
 	util_slist_t products;
 	osi_mutex_t *products_mutex;
 	link_identify_cbk_t id_cbk;
+	link_key_cbk_t key_cbk;
 };
 
 static link_factory_spec_t* link_factory_id_and_remove (link_factory_t* factory, link_handle_t* instance);
 static int32_t link_factory_dismantle_all (link_factory_t* factory, link_factory_spec_t* spec);
 static uint64_t link_factory_gen_model_id (void);
+static bool link_factory_match (void* item, void* cookie);
 
-eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id_cbk)
+eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id_cbk,
+		link_key_cbk_t key_cbk)
 {
 	link_factory_t *tmp = NULL;
 
@@ -90,10 +101,18 @@ eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id
 		return EOS_ERROR_GENERAL;
 	}
 	UTIL_GLOGI("Created link manufacturing specs register");
+	if (util_dispatch_create(&tmp->index) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Unable to create link manufacturing specs index");
+		util_slist_destroy(&tmp->specs);
+		osi_free((void**)&tmp);
+		return EOS_ERROR_GENERAL;
+	}
 	UTIL_GLOGD("Creating manufactured links register...");
 	if (util_slist_create(&tmp->products, NULL) != EOS_ERROR_OK)
 	{
 		UTIL_GLOGE("Unable to create manufactured links register");
+		util_dispatch_destroy(&tmp->index);
 		util_slist_destroy(&tmp->specs);
 		osi_free((void**)&tmp);
 		return EOS_ERROR_GENERAL;
@@ -102,11 +121,13 @@ eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id
 	{
 		UTIL_GLOGE("Unable to create manufactured links register");
 		util_slist_destroy(&tmp->products);
+		util_dispatch_destroy(&tmp->index);
 		util_slist_destroy(&tmp->specs);
 		osi_free((void**)&tmp);
 		return EOS_ERROR_GENERAL;
 	}
 	tmp->id_cbk = id_cbk;
+	tmp->key_cbk = key_cbk;
 	*factory = tmp;
 	UTIL_GLOGI("Created manufactured links register");
 
@@ -141,6 +162,7 @@ eos_error_t link_factory_destroy(link_factory_t** factory)
 	{
 		UTIL_GLOGE("Unable to destroy link manufacturing specs register");
 	}
+	util_dispatch_destroy(&tmp->index);
 	UTIL_GLOGD("Destroying manufactured links register...");
 	if (util_slist_destroy(&tmp->products) == EOS_ERROR_OK)
 	{
@@ -160,15 +182,23 @@ eos_error_t link_factory_destroy(link_factory_t** factory)
 }
 
 eos_error_t link_factory_register (link_factory_t* factory, link_handle_t* model, uint64_t* model_id,
+		const uint32_t* keys, uint8_t key_cnt,
 		link_manufacture_func_t manufacture, link_dismantle_func_t dismantle)
 {
 	link_factory_spec_t *product_spec = NULL;
+	eos_error_t error = EOS_ERROR_OK;
+	uint8_t i = 0;
 
-	if (factory == NULL || model == NULL || model_id == NULL)
+	if (factory == NULL || model == NULL || model_id == NULL ||
+			(keys == NULL && key_cnt != 0))
 	{
 		return EOS_ERROR_INVAL;
 	}
 	product_spec = (link_factory_spec_t*)osi_calloc(sizeof(link_factory_spec_t));
+	if (product_spec == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
 	product_spec->model = model;
 	if(*model_id == 0LL)
 	{
@@ -184,6 +214,23 @@ eos_error_t link_factory_register (link_factory_t* factory, link_handle_t* model
 		UTIL_GLOGE("Unable to register link model: %llu", *model_id);
 		return EOS_ERROR_GENERAL;
 	}
+	for (i = 0; i < key_cnt && error == EOS_ERROR_OK; i++)
+	{
+		error = util_dispatch_add(factory->index, keys[i], product_spec);
+	}
+	if (key_cnt == 0)
+	{
+		error = util_dispatch_add(factory->index, UTIL_DISPATCH_ANY,
+				product_spec);
+	}
+	if (error != EOS_ERROR_OK)
+	{
+		util_dispatch_remove(factory->index, product_spec);
+		factory->specs.remove(factory->specs, (void*)product_spec);
+		osi_free((void**)&product_spec);
+		UTIL_GLOGE("Unable to index link model: %llu", *model_id);
+		return error;
+	}
 	UTIL_GLOGD("Registered model id: 0x%llX", *model_id);
 
 	return EOS_ERROR_OK;
@@ -218,6 +265,7 @@ eos_error_t link_factory_unregister (link_factory_t* factory, link_handle_t* mod
 				{
 					UTIL_GLOGW("%d manufactured %s forcefully dismantled", count, ((count % 10 == 1) && (count % 100 != 11))? "link was" : "links were");
 				}
+				util_dispatch_remove(factory->index, product_spec);
 				if (factory->specs.remove(factory->specs, (void*)product_spec) == EOS_ERROR_OK)
 				{
 					osi_free((void**)&product_spec);
@@ -257,87 +305,68 @@ eos_error_t link_factory_manufacture (link_factory_t* factory, link_handle_t** p
 {
 	link_factory_spec_t *product_spec = NULL;
 	link_factory_product_t *product_data = NULL;
-	bool found = false;
+	link_factory_lookup_t lookup = {factory, data};
 	uint64_t product_id = LINK_FACTORY_START_PRODUCT_ID;
+	uint32_t key = UTIL_DISPATCH_ANY;
+	uint32_t hint = UTIL_DISPATCH_ANY;
 	eos_error_t error = EOS_ERROR_OK;
-	eos_error_t spec_error = EOS_ERROR_OK;
 
-	if (product == NULL)
+	if (factory == NULL || product == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 
-	spec_error = factory->specs.first(factory->specs, (void**)&product_spec);
-	while ((spec_error == EOS_ERROR_OK) || (spec_error == EOS_ERROR_EOL))
+	if (factory->key_cbk != NULL)
 	{
-		if (product_spec == NULL)
-		{
-			continue;
-		}
-		if (factory->id_cbk(product_spec->model, data) == EOS_ERROR_OK)
-		{
-			UTIL_GLOGD("Found link model");
-			error = factory->products.last(factory->products, (void**)&product_data);
-			if (error == EOS_ERROR_OK)
-			{
-				product_id = product_data->id + 1;
-			}
-			else
-			{
-				if (error != EOS_ERROR_EMPTY)
-				{
-					UTIL_GLOGD("Source manufacturing failed");
-					break;
-				}
-			}
-			if (product_id == LINK_FACTORY_START_PRODUCT_ID)
-			{
-				// In theory possible but in practice quite impossible to overlap (ever)
-			}
-			if (product_spec->manufacture(product_spec->model, product_spec->model_id, product, product_id) == EOS_ERROR_OK)
-			{
-				product_data = (link_factory_product_t*)osi_calloc(sizeof(link_factory_product_t));
-				if (product_data == NULL)
-				{
-					product_spec->dismantle(product_spec->model_id, product);
-					UTIL_GLOGD("Source manufacturing failed");
-					break;
-				}
-				product_data->instance = *product;
-				product_data->spec = product_spec;
-				product_data->id = product_id;
-				if (factory->products.add(factory->products, (void*)product_data) != EOS_ERROR_OK)
-				{
-					product_spec->dismantle(product_spec->model_id, product);
-					osi_free((void**)&product_data);
-					UTIL_GLOGD("Source manufacturing failed");
-					break;
-				}
-				found = true;
-				break;
-			}
-			else
-			{
-				UTIL_GLOGD("Source manufacturing failed");
-				break;
-			}
-		}
-		if (spec_error == EOS_ERROR_EOL)
+		factory->key_cbk(data, &key, &hint);
+	}
+	if (util_dispatch_find(factory->index, key, hint, link_factory_match,
+			&lookup, (void**)&product_spec) != EOS_ERROR_OK)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	UTIL_GLOGD("Found link model");
+	error = factory->products.last(factory->products, (void**)&product_data);
+	if (error == EOS_ERROR_OK)
+	{
+		product_id = product_data->id + 1;
+	}
+	else
+	{
+		if (error != EOS_ERROR_EMPTY)
 		{
-			break;
+			UTIL_GLOGD("Source manufacturing failed");
+			return EOS_ERROR_NFOUND;
 		}
-
-		spec_error = factory->specs.next(factory->specs, (void**)&product_spec);
 	}
-
-	if (found == true)
+	if (product_id == LINK_FACTORY_START_PRODUCT_ID)
 	{
-		return EOS_ERROR_OK;
+		// In theory possible but in practice quite impossible to overlap (ever)
 	}
-	else
+	if (product_spec->manufacture(product_spec->model, product_spec->model_id, product, product_id) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGD("Source manufacturing failed");
+		return EOS_ERROR_NFOUND;
+	}
+	product_data = (link_factory_product_t*)osi_calloc(sizeof(link_factory_product_t));
+	if (product_data == NULL)
 	{
+		product_spec->dismantle(product_spec->model_id, product);
+		UTIL_GLOGD("Source manufacturing failed");
 		return EOS_ERROR_NFOUND;
 	}
+	product_data->instance = *product;
+	product_data->spec = product_spec;
+	product_data->id = product_id;
+	if (factory->products.add(factory->products, (void*)product_data) != EOS_ERROR_OK)
+	{
+		product_spec->dismantle(product_spec->model_id, product);
+		osi_free((void**)&product_data);
+		UTIL_GLOGD("Source manufacturing failed");
+		return EOS_ERROR_NFOUND;
+	}
+
+	return EOS_ERROR_OK;
 }
 
 eos_error_t link_factory_dismantle (link_factory_t* factory, link_handle_t** product)
@@ -484,3 +513,10 @@ static uint64_t link_factory_gen_model_id (void)
 	return ret;
 }
 
+static bool link_factory_match (void* item, void* cookie)
+{
+	link_factory_spec_t *spec = (link_factory_spec_t*)item;
+	link_factory_lookup_t *lookup = (link_factory_lookup_t*)cookie;
+
+	return lookup->factory->id_cbk(spec->model, lookup->data) == EOS_ERROR_OK;
+}
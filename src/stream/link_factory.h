@@ -41,14 +41,20 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 typedef struct link_factory link_factory_t;
 
+/* Same keyed dispatch as util_factory: models are probed only if
+ * registered under the key of the identification data (or without keys),
+ * model found for the hint is cached and probed first next time. */
 typedef eos_error_t (*link_identify_cbk_t)(link_handle_t* model, void* id_data);
+typedef void (*link_key_cbk_t)(void* id_data, uint32_t* key, uint32_t* hint);
 typedef eos_error_t (*link_manufacture_func_t) (link_handle_t* model, uint64_t model_id,
 		link_handle_t** product, uint64_t product_id);
 typedef eos_error_t (*link_dismantle_func_t) (uint64_t model_id, link_handle_t** product);
 
-eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id_cbk);
+eos_error_t link_factory_create(link_factory_t** factory, link_identify_cbk_t id_cbk,
+		link_key_cbk_t key_cbk);
 eos_error_t link_factory_destroy(link_factory_t** factory);
 eos_error_t link_factory_register (link_factory_t* factory, link_handle_t* model, uint64_t* model_id,
+		const uint32_t* keys, uint8_t key_cnt,
 		link_manufacture_func_t manufacture, link_dismantle_func_t dismantle);
 eos_error_t link_factory_unregister (link_factory_t* factory, link_handle_t* model, uint64_t model_id);
 eos_error_t link_factory_get_count (link_factory_t* factory, uint32_t* count);
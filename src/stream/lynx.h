@@ -40,6 +40,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "eos_error.h"
 #include "osi_time.h"
 #include "eos_media.h"
+#include "util_mdesc.h"
 
 typedef void* link_handle_t;
 
@@ -138,6 +139,7 @@ typedef enum link_ev
 	LINK_EV_EOS,
 	LINK_EV_PBK_ERR,
 	LINK_EV_PLAY_INFO,
+	LINK_EV_MILESTONE,
 	LINK_EV_LAST
 } link_ev_t;
 
@@ -161,9 +163,16 @@ typedef union link_ev_data
 	} play_info;
 	struct
 	{
-		eos_media_desc_t media;
+		/** Valid for LINK_EV_CONNECTED only. Reference it to keep it after the handler returns. */
+		util_mdesc_t *media;
+		uint32_t gen;
 		link_conn_err_t reason;
 	} conn_info;
+	struct
+	{
+		/** Zap milestone reached by the link (time is taken by the receiver) */
+		eos_zap_ms_t id;
+	} milestone;
 } link_ev_data_t;
 
 #define LINK_CAP_SOURCE         (0x1LL)
@@ -75,7 +75,9 @@ typedef enum cron_plyr_ev
 	CRON_PLYR_EV_VDEC_RES,	//!< CRON_PLYR_EV_VDEC_RES
 	CRON_PLYR_EV_VOUT_END,  //!< CRON_PLYR_EV_VOUT_END
 	CRON_PLYR_EV_VOUT_BEGIN,//!< CRON_PLYR_EV_VOUT_BEGIN
-	CRON_PLYR_EV_ERR      	//!< CRON_PLYR_EV_ERR
+	CRON_PLYR_EV_ERR,     	//!< CRON_PLYR_EV_ERR
+	CRON_PLYR_EV_FRM_DISP, 	//!< CRON_PLYR_EV_FRM_DISP (first frame rendered)
+	CRON_PLYR_EV_VDEC_LVL 	//!< CRON_PLYR_EV_VDEC_LVL (decoding quality changed)
 } cron_plyr_ev_t;
 
 /**
@@ -115,6 +117,44 @@ typedef enum cron_vol_lvl
 	CRON_VOL_LVL_HEAVY
 } cron_vol_lvl_t;
 
+/**
+ * \enum cron_dec_thr_t
+ * cron_dec_thr_t Video decoder threading modes.
+ */
+typedef enum cron_dec_thr
+{
+	CRON_DEC_THR_AUTO = 0, /**< Player picks slice or frame threads. */
+	CRON_DEC_THR_FRAME,    /**< Frame threads (throughput). */
+	CRON_DEC_THR_SLICE,    /**< Slice threads (low latency). */
+	CRON_DEC_THR_OFF       /**< Single decoding thread. */
+} cron_dec_thr_t;
+
+/**
+ * \enum cron_clk_t
+ * cron_clk_t Master clock video is presented against.
+ */
+typedef enum cron_clk
+{
+	CRON_CLK_AUTO = 0, /**< Audio if there is audio, video otherwise. */
+	CRON_CLK_AUD,      /**< Audio master. */
+	CRON_CLK_VID,      /**< Video master (free running video). */
+	CRON_CLK_EXT       /**< Input (PCR locked) timing, for live streams. */
+} cron_clk_t;
+
+/**
+ * \enum cron_vdec_lvl_t
+ * cron_vdec_lvl_t Video decoding quality. It is lowered step by step while
+ * frames reach the screen too late to be shown and raised again once none
+ * have been late for a while.
+ */
+typedef enum cron_vdec_lvl
+{
+	CRON_VDEC_LVL_FULL = 0, /**< Everything decoded. */
+	CRON_VDEC_LVL_NO_LPF,   /**< Loop (deblocking) filter skipped. */
+	CRON_VDEC_LVL_NO_NREF,  /**< Non-reference frames skipped as well. */
+	CRON_VDEC_LVL_KEY       /**< Key frames only. */
+} cron_vdec_lvl_t;
+
 /**
  * \union cron_ply_ev_data_t
  * Event data.
@@ -156,6 +196,12 @@ typedef union cron_ply_ev_data
 		uint32_t width;
 		uint32_t height;
 	} vdec_res;
+	struct
+	{
+		cron_vdec_lvl_t level;
+		uint32_t dropped;	/**< Frames dropped late since the last change. */
+		uint32_t queued;	/**< Packets waiting for the decoder. */
+	} vdec_lvl;
 } cron_ply_ev_data_t;
 
 /**
@@ -254,11 +300,11 @@ eos_error_t cron_plyr_destroy(cron_plyr_t** player);
  * <b>NOTE:<\b> Not all fields in the media descriptor will be set.
  * Only those fields which are available at the time will be set.
  * @param[in] player Chronos player handle.
- * @param[in] media Media descriptor. Must not be NULL.
+ * @param[in] media Media descriptor, or NULL if streams are not known yet.
  * @return EOS_ERROR_OK on success or proper error code.
  */
 eos_error_t cron_plyr_set_media_desc(cron_plyr_t* player,
-		eos_media_desc_t* media);
+		util_mdesc_t* media);
 
 /** \brief Enables/disables free run mode.
  *
@@ -610,6 +656,37 @@ eos_error_t cron_plyr_aud_pt(cron_plyr_t* player, bool enable);
  * @return EOS_ERROR_OK on success or proper error code.
  */
 eos_error_t cron_plyr_vol_leveling(cron_plyr_t* player, bool enable, cron_vol_lvl_t lvl);
+/** @brief Sets video decoder threading.
+ * Frame threading gives the best throughput but delays the output by one frame
+ * per extra thread, slice threading adds no delay. The change takes effect on
+ * next video start.
+ * @param[in] player Chronos player handle.
+ * @param[in] mode Threading mode.
+ * @param[in] count Number of decoding threads, 0 for one per online core.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t cron_plyr_dec_threads(cron_plyr_t* player, cron_dec_thr_t mode,
+		uint8_t count);
+/** @brief Sets master clock.
+ * Video frames late to the master clock are dropped, early ones wait
+ * (keeping the previous frame on screen).
+ * In free run mode video does not wait for the master longer than the
+ * sync time allows (see cron_plyr_set_sync_time()).
+ * @param[in] player Chronos player handle.
+ * @param[in] clk Master clock.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t cron_plyr_set_clk(cron_plyr_t* player, cron_clk_t clk);
+/** @brief Gets presentation counters.
+ * Counters are reset when playback starts.
+ * @param[in] player Chronos player handle.
+ * @param[out] dropped Number of video frames dropped for being late.
+ * @param[out] repeated Number of frame periods a frame was kept on screen
+ * longer, waiting for the master clock.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t cron_plyr_get_frm_stats(cron_plyr_t* player, uint32_t* dropped,
+		uint32_t* repeated);
 /** @brief Gives specific features available for this player.
  * As the sink implementation can vary from platform to platform, some specific
  * features may be announced by the player to EOS via <code>>cron_plyr_sys_get_caps<\code>.
@@ -206,6 +206,7 @@ eos_error_t cron_plyr_buff_cons(cron_plyr_t* player, uint8_t* buff, size_t size,
 	{
 		data.first_frm.pts = 0;
 		cron_plyr_fire_ev(player, CRON_PLYR_EV_FRM, &data);
+		cron_plyr_fire_ev(player, CRON_PLYR_EV_FRM_DISP, NULL);
 		player->frm_ev = true;
 	}
 	if(extended_info)
@@ -220,17 +221,22 @@ eos_error_t cron_plyr_buff_cons(cron_plyr_t* player, uint8_t* buff, size_t size,
 }
 
 eos_error_t cron_plyr_set_media_desc(cron_plyr_t* player,
-		eos_media_desc_t* media)
+		util_mdesc_t* media)
 {
 	uint8_t i = 0;
 
-	if(player == NULL || media == NULL)
+	if(player == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 	UTIL_GLOGD("%s", __func__);
 	CRON_PLYR_LOCK(player);
-	osi_memcpy(&(player->media), media, sizeof(eos_media_desc_t));
+	/* Only used ES entries are copied, selection is tracked in the player's copy */
+	player->media.es_cnt = 0;
+	if(media != NULL)
+	{
+		util_mdesc_expand(media, &(player->media));
+	}
 	for(i=0; i<player->media.es_cnt; i++)
 	{
 		player->media.es[i].selected = false;
@@ -632,6 +638,42 @@ eos_error_t cron_plyr_vol_leveling(cron_plyr_t* player, bool enable, cron_vol_lv
 	return EOS_ERROR_OK;
 }
 
+eos_error_t cron_plyr_dec_threads(cron_plyr_t* player, cron_dec_thr_t mode,
+		uint8_t count)
+{
+	if(player == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	UTIL_GLOGD("%s: %d, %u", __func__, mode, count);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t cron_plyr_set_clk(cron_plyr_t* player, cron_clk_t clk)
+{
+	if(player == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	UTIL_GLOGD("%s: %d", __func__, clk);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t cron_plyr_get_frm_stats(cron_plyr_t* player, uint32_t* dropped,
+		uint32_t* repeated)
+{
+	if(player == NULL || dropped == NULL || repeated == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	*dropped = 0;
+	*repeated = 0;
+
+	return EOS_ERROR_OK;
+}
+
 eos_error_t cron_plyr_get_ext(cron_plyr_t* player, link_cap_t cap,
 		void** ctrl_funcs)
 {
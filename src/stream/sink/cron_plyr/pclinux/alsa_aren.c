@@ -31,6 +31,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+
 #include "alsa_aren.h"
 #include "osi_memory.h"
 #define MODULE_NAME "alsa_aren"
@@ -38,30 +39,87 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "osi_time.h"
 
 #include <libavutil/opt.h>
+#include <math.h>
 
-#define ALSA_AREN_SAMPLE_RATE (44100)
 #define ALSA_AREN_CHANNEL_NUM (2)
-#define ALSA_AREN_AVFORMAT (AV_SAMPLE_FMT_S16)
-#define ALSA_AREN_PCMFORMAT (SND_PCM_FORMAT_S16)
-#define ALSA_AREN_CH_LAYOUT (AV_CH_LAYOUT_STEREO)
-
-static eos_error_t alsa_aren_open_ar(alsa_aren_t* aren, AVFrame *a_frame);
+/* Used when the stream does not tell (opened without probing) */
+#define ALSA_AREN_DFLT_RATE (48000)
+/* The player accounts for the delay, the ring size is only underrun margin */
+#define ALSA_AREN_BUFF_USEC (200000)
+#define ALSA_AREN_PERIOD_USEC (20000)
+/* Largest decoded frame expected, codecs we play stay well below */
+#define ALSA_AREN_MAX_FRM (8192)
+/* Resampler may give out a bit more than the input frame (filter delay) */
+#define ALSA_AREN_AR_MARGIN (256)
+#define ALSA_AREN_WAIT_MS (100)
+/* Leveling: loudness follows rises in 0.5s and drops in 4s, nothing below
+ * -60dBFS (mean square) counts, block peaks stay under full scale */
+#define ALSA_AREN_LVL_ATTACK (0.5f)
+#define ALSA_AREN_LVL_RELEASE (4.0f)
+#define ALSA_AREN_LVL_GATE (1e-6f)
+#define ALSA_AREN_LVL_PEAK (0.98f)
+/* Downmix: -3dB and -6dB */
+#define ALSA_AREN_M3DB (0.7071068f)
+#define ALSA_AREN_M6DB (0.5f)
+
+typedef struct alsa_aren_lvl_prm
+{
+	/* Mean square target and largest boost (attenuation is its inverse) */
+	float target;
+	float max;
+} alsa_aren_lvl_prm_t;
 
-eos_error_t alsa_aren_init(alsa_aren_t* aren)
+/* -23dBFS +-6dB, -20dBFS +-12dB, -18dBFS +-18dB */
+static const alsa_aren_lvl_prm_t alsa_aren_lvl_prm[] =
+{
+	{0.0f, 1.0f},
+	{0.0050119f, 1.9952623f},
+	{0.0100000f, 3.9810717f},
+	{0.0158489f, 7.9432823f}
+};
+
+static eos_error_t alsa_aren_open_ar(alsa_aren_t* aren, AVFrame *a_frame,
+		bool dsp);
+static eos_error_t alsa_aren_play_dsp(alsa_aren_t* aren, AVFrame *a_frame);
+static eos_error_t alsa_aren_dsp(alsa_aren_t* aren, const float* const* src,
+		uint32_t ch, uint64_t layout, uint32_t n);
+static void alsa_aren_mtx(alsa_aren_t* aren, uint64_t layout, uint32_t ch);
+static float alsa_aren_level(alsa_aren_t* aren, util_audio_dsp_meter_t* meter,
+		uint32_t n);
+static eos_error_t alsa_aren_alloc_buf(alsa_aren_t* aren, uint32_t frames);
+static eos_error_t alsa_aren_write(alsa_aren_t* aren, uint8_t* data,
+		uint32_t frames);
+static snd_pcm_sframes_t alsa_aren_mmap_write(alsa_aren_t* aren,
+		uint8_t* data, snd_pcm_uframes_t frames);
+static snd_pcm_format_t alsa_aren_pcm_fmt(enum AVSampleFormat fmt);
+static enum AVSampleFormat alsa_aren_av_fmt(snd_pcm_format_t fmt);
+
+eos_error_t alsa_aren_init(alsa_aren_t* aren, uint32_t rate,
+		enum AVSampleFormat fmt)
 {
 	snd_pcm_stream_t stream = SND_PCM_STREAM_PLAYBACK;
 	const char *pcm_name = "default";
 	snd_pcm_sw_params_t *swparams = NULL;
 	snd_pcm_hw_params_t *hwparams = NULL;
-	unsigned int periods = 16;
-	snd_pcm_uframes_t boundary, chunksz;
-	unsigned int supported_sample_rate = ALSA_AREN_SAMPLE_RATE;
+	unsigned int buff_time = ALSA_AREN_BUFF_USEC;
+	unsigned int period_time = ALSA_AREN_PERIOD_USEC;
+	snd_pcm_uframes_t boundary, period;
 	unsigned int channels = ALSA_AREN_CHANNEL_NUM;
+	/* Source format first, so that it can go out unconverted */
+	snd_pcm_format_t formats[] = {alsa_aren_pcm_fmt(fmt), SND_PCM_FORMAT_S16,
+			SND_PCM_FORMAT_S32, SND_PCM_FORMAT_FLOAT};
+	uint32_t fmt_cnt = sizeof(formats) / sizeof(formats[0]);
+	uint32_t i = 0, c = 0;
 	int err = 0;
 	snd_pcm_format_t format;
 	uint64_t msk;
 
+	if(aren == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
 	osi_memset(aren, 0, sizeof(alsa_aren_t));
+	aren->rate = rate != 0 ? rate : ALSA_AREN_DFLT_RATE;
 	snd_pcm_hw_params_alloca(&hwparams);
 	snd_pcm_sw_params_alloca(&swparams);
 	if(snd_pcm_open(&aren->pcm_handle, pcm_name, stream, 0) < 0)
@@ -72,17 +130,18 @@ eos_error_t alsa_aren_init(alsa_aren_t* aren)
 	{
 		return EOS_ERROR_GENERAL;
 	}
-	if(snd_pcm_hw_params_set_access(aren->pcm_handle, hwparams,
+	/* Write straight into the ring where the device allows it */
+	aren->mmap = snd_pcm_hw_params_set_access(aren->pcm_handle, hwparams,
+			SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+	if(!aren->mmap && snd_pcm_hw_params_set_access(aren->pcm_handle, hwparams,
 			SND_PCM_ACCESS_RW_INTERLEAVED) < 0)
 	{
 		return EOS_ERROR_GENERAL;
 	}
-	if(snd_pcm_hw_params_set_periods_near(aren->pcm_handle, hwparams, &periods, 0) < 0)
-	{
-		return EOS_ERROR_GENERAL;
-	}
+	/* Device rate: if anything has to resample, it is done once, here */
+	snd_pcm_hw_params_set_rate_resample(aren->pcm_handle, hwparams, 0);
 	if(snd_pcm_hw_params_set_rate_near(aren->pcm_handle, hwparams,
-			&supported_sample_rate, 0) < 0)
+			&aren->rate, 0) < 0)
 	{
 		return EOS_ERROR_GENERAL;
 	}
@@ -90,8 +149,17 @@ eos_error_t alsa_aren_init(alsa_aren_t* aren)
 	{
 		return EOS_ERROR_GENERAL;
 	}
-	if((err = snd_pcm_hw_params_set_format(aren->pcm_handle, hwparams,
-			ALSA_AREN_PCMFORMAT)) < 0)
+	for(i = 0; i < fmt_cnt; i++)
+	{
+		if(formats[i] != SND_PCM_FORMAT_UNKNOWN &&
+				snd_pcm_hw_params_test_format(aren->pcm_handle, hwparams,
+						formats[i]) == 0)
+		{
+			break;
+		}
+	}
+	if(i == fmt_cnt || (err = snd_pcm_hw_params_set_format(aren->pcm_handle,
+			hwparams, formats[i])) < 0)
 	{
 		UTIL_GLOGE("Could not set sample format:%s",snd_strerror(err));
 		snd_pcm_hw_params_get_format_mask(hwparams, (snd_pcm_format_mask_t*)&msk);
@@ -105,14 +173,26 @@ eos_error_t alsa_aren_init(alsa_aren_t* aren)
 		}
 		return EOS_ERROR_GENERAL;
 	}
+	if(snd_pcm_hw_params_set_buffer_time_near(aren->pcm_handle, hwparams,
+			&buff_time, NULL) < 0)
+	{
+		return EOS_ERROR_GENERAL;
+	}
+	if(snd_pcm_hw_params_set_period_time_near(aren->pcm_handle, hwparams,
+			&period_time, NULL) < 0)
+	{
+		return EOS_ERROR_GENERAL;
+	}
 	if(snd_pcm_hw_params(aren->pcm_handle, hwparams) < 0)
 	{
 		return EOS_ERROR_GENERAL;
 	}
-	if(snd_pcm_hw_params_get_period_size_min(hwparams, &chunksz, NULL) < 0)
+	if(snd_pcm_hw_params_get_period_size(hwparams, &period, NULL) < 0 ||
+			snd_pcm_hw_params_get_buffer_size(hwparams, &aren->ring) < 0)
 	{
 		return EOS_ERROR_GENERAL;
 	}
+	aren->period = period;
 	if(snd_pcm_sw_params_current(aren->pcm_handle, swparams) < 0)
 	{
 		return EOS_ERROR_GENERAL;
@@ -122,7 +202,7 @@ eos_error_t alsa_aren_init(alsa_aren_t* aren)
 		return EOS_ERROR_GENERAL;
 	}
 	if(snd_pcm_sw_params_set_start_threshold(aren->pcm_handle, swparams,
-			chunksz / 4) < 0)
+			period) < 0)
 	{
 		return EOS_ERROR_GENERAL;
 	}
@@ -138,6 +218,39 @@ eos_error_t alsa_aren_init(alsa_aren_t* aren)
 	{
 		return EOS_ERROR_GENERAL;
 	}
+	aren->pcm_fmt = formats[i];
+	aren->av_fmt = alsa_aren_av_fmt(formats[i]);
+	aren->channels = channels;
+	aren->frm_bytes = channels * snd_pcm_format_physical_width(formats[i]) / 8;
+	if(alsa_aren_alloc_buf(aren, ALSA_AREN_MAX_FRM + ALSA_AREN_AR_MARGIN)
+			!= EOS_ERROR_OK)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	aren->gain = 1.0f;
+	/* Float path scratch, one block for planar input, mix and interleave */
+	if(aren->channels == 2 && (aren->pcm_fmt == SND_PCM_FORMAT_S16 ||
+			aren->pcm_fmt == SND_PCM_FORMAT_FLOAT))
+	{
+		aren->dsp = av_malloc((2 * ALSA_AREN_MAX_CH + 2) * ALSA_AREN_DSP_FRM
+				* sizeof(float));
+		if(aren->dsp == NULL)
+		{
+			return EOS_ERROR_NOMEM;
+		}
+		for(c = 0; c < ALSA_AREN_MAX_CH; c++)
+		{
+			aren->pln[c] = aren->dsp + c * ALSA_AREN_DSP_FRM;
+		}
+		aren->mix[0] = aren->dsp + ALSA_AREN_MAX_CH * ALSA_AREN_DSP_FRM;
+		aren->mix[1] = aren->mix[0] + ALSA_AREN_DSP_FRM;
+		aren->ibuf = aren->mix[1] + ALSA_AREN_DSP_FRM;
+		util_audio_dsp_dither_init(&aren->dither, 1);
+	}
+	UTIL_GLOGI("Output: %s %uHz %uch (%s, %ums ring, %lu frame periods%s)",
+			snd_pcm_format_name(aren->pcm_fmt), aren->rate, aren->channels,
+			aren->mmap ? "mmap" : "rw", buff_time / 1000, period,
+			aren->dsp != NULL ? ", float path" : "");
 
 	return osi_mutex_create(&aren->lock);
 }
@@ -154,93 +267,373 @@ eos_error_t alsa_aren_setup(alsa_aren_t* aren)
 	return EOS_ERROR_OK;
 }
 
-eos_error_t alsa_aren_open_ar(alsa_aren_t* aren, AVFrame *a_frame)
+/* dsp: resample only, to planar float in the source layout */
+static eos_error_t alsa_aren_open_ar(alsa_aren_t* aren, AVFrame *a_frame,
+		bool dsp)
 {
 	AVAudioResampleContext *avr = aren->ar_ctx;
+	uint64_t layout = a_frame->channel_layout;
 	int err;
 
-	av_opt_set_int(avr, "in_channel_layout",  a_frame->channel_layout,  0);
-	av_opt_set_int(avr, "out_channel_layout", ALSA_AREN_CH_LAYOUT,      0);
-	av_opt_set_int(avr, "in_sample_rate",     a_frame->sample_rate,     0);
-	av_opt_set_int(avr, "out_sample_rate",    ALSA_AREN_SAMPLE_RATE,    0);
-	av_opt_set_int(avr, "in_sample_fmt",      a_frame->format,          0);
-	av_opt_set_int(avr, "out_sample_fmt",     ALSA_AREN_AVFORMAT,       0);
+	if(aren->ar_opened)
+	{
+		avresample_close(avr);
+		aren->ar_opened = 0;
+	}
+	if(layout == 0)
+	{
+		layout = (uint64_t)av_get_default_channel_layout(a_frame->channels);
+	}
+	av_opt_set_int(avr, "in_channel_layout",  (int64_t)layout,        0);
+	av_opt_set_int(avr, "out_channel_layout", dsp ? (int64_t)layout :
+			av_get_default_channel_layout((int)aren->channels),       0);
+	av_opt_set_int(avr, "in_sample_rate",     a_frame->sample_rate,   0);
+	av_opt_set_int(avr, "out_sample_rate",    aren->rate,             0);
+	av_opt_set_int(avr, "in_sample_fmt",      a_frame->format,        0);
+	av_opt_set_int(avr, "out_sample_fmt",     dsp ? AV_SAMPLE_FMT_FLTP :
+			aren->av_fmt,                                             0);
 	if((err = avresample_open(avr)) < 0)
 	{
 		UTIL_GLOGE("Could not open AVResample context %d", err);
 		return EOS_ERROR_GENERAL;
 	}
+	/* Grows once per stream (if at all), never per frame */
+	if(!dsp && a_frame->sample_rate > 0 && alsa_aren_alloc_buf(aren,
+			(uint32_t)av_rescale_rnd(ALSA_AREN_MAX_FRM, aren->rate,
+					a_frame->sample_rate, AV_ROUND_UP) + ALSA_AREN_AR_MARGIN)
+			!= EOS_ERROR_OK)
+	{
+		avresample_close(avr);
+		return EOS_ERROR_NOMEM;
+	}
+	aren->ar_fmt = (enum AVSampleFormat)a_frame->format;
+	aren->ar_rate = a_frame->sample_rate;
+	aren->ar_layout = a_frame->channel_layout;
+	aren->ar_dsp = dsp;
+	aren->ar_opened = 1;
+	UTIL_GLOGI("Converting %s %dHz %dch%s",
+			av_get_sample_fmt_name(aren->ar_fmt), aren->ar_rate,
+			a_frame->channels, dsp ? " (float path)" : "");
 
 	return EOS_ERROR_OK;
 }
 
-void alsa_aren_recover(alsa_aren_t* aren, void* output, unsigned int out_linesize)
+eos_error_t alsa_aren_play(alsa_aren_t* aren, AVFrame *a_frame)
 {
-	int err = 0;
+	uint8_t *output = NULL;
+	int out_size = 0;
+	eos_error_t err = EOS_ERROR_OK;
 
-	if((err = snd_pcm_prepare(aren->pcm_handle)) < 0)
+	if(aren == NULL || aren->pcm_handle == NULL || a_frame == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	/* Already what the device takes, nothing to convert (unless leveling,
+	 * or still ramping back to unity after it was switched off) */
+	if(a_frame->format == aren->av_fmt && a_frame->sample_rate == (int)aren->rate
+			&& a_frame->channels == (int)aren->channels &&
+			aren->lvl == ALSA_AREN_LVL_OFF && aren->gain == 1.0f)
+	{
+		return alsa_aren_write(aren, a_frame->data[0],
+				(uint32_t)a_frame->nb_samples);
+	}
+	if(aren->dsp != NULL && a_frame->channels > 0 &&
+			a_frame->channels <= ALSA_AREN_MAX_CH)
+	{
+		return alsa_aren_play_dsp(aren, a_frame);
+	}
+	if(!aren->ar_opened || aren->ar_dsp || a_frame->format != aren->ar_fmt ||
+			a_frame->sample_rate != aren->ar_rate ||
+			a_frame->channel_layout != aren->ar_layout)
+	{
+		if((err = alsa_aren_open_ar(aren, a_frame, false)) != EOS_ERROR_OK)
+		{
+			return err;
+		}
+	}
+	output = aren->buf;
+	out_size = avresample_convert(aren->ar_ctx, &output,
+			(int)(aren->buf_frm * aren->frm_bytes), (int)aren->buf_frm,
+			a_frame->extended_data, a_frame->linesize[0], a_frame->nb_samples);
+	if(out_size < 0)
 	{
-		UTIL_GLOGE("ALSA prepare failed (%s)", snd_strerror(err));
+		UTIL_GLOGE("Skipping wrong AVR data");
+		alsa_aren_open_ar(aren, a_frame, false);
+
+		return EOS_ERROR_OK;
 	}
-	if((err = snd_pcm_writei(aren->pcm_handle, output, out_linesize)) < 0)
+	while(out_size > 0)
 	{
-		if(err == -EPIPE)
+		if((err = alsa_aren_write(aren, output, (uint32_t)out_size))
+				!= EOS_ERROR_OK)
 		{
-			alsa_aren_recover(aren, output, out_linesize);
+			return err;
 		}
-		UTIL_GLOGE("Cannot recover ALSA (%s)", snd_strerror(err));
+		/* Whatever did not fit in the buffer waits in the AVR FIFO */
+		out_size = avresample_available(aren->ar_ctx) > 0 ?
+				avresample_read(aren->ar_ctx, &output, (int)aren->buf_frm) : 0;
 	}
+
+	return EOS_ERROR_OK;
 }
 
-eos_error_t alsa_aren_play(alsa_aren_t* aren, AVFrame *a_frame)
+static eos_error_t alsa_aren_play_dsp(alsa_aren_t* aren, AVFrame *a_frame)
 {
-	uint8_t *output = NULL;
-	int out_size;
-	int out_size_1;
-	int err = 0;
-
-	if(!aren->ar_opened)
+	uint32_t ch = (uint32_t)a_frame->channels;
+	uint32_t n = (uint32_t)a_frame->nb_samples;
+	uint64_t layout = a_frame->channel_layout;
+	uint32_t off = 0, cnt = 0;
+	uint8_t **output = (uint8_t**)aren->pln;
+	int out_size = 0;
+	eos_error_t err = EOS_ERROR_OK;
+
+	if(a_frame->sample_rate == (int)aren->rate)
 	{
-		alsa_aren_open_ar(aren, a_frame);
-		aren->ar_opened = 1;
-		if((err = snd_pcm_prepare(aren->pcm_handle)) < 0)
+		switch(a_frame->format)
 		{
-			UTIL_GLOGE("ALSA prepare failed (%s)", snd_strerror(err));
-			return EOS_ERROR_GENERAL;
+		case AV_SAMPLE_FMT_FLTP:
+			return alsa_aren_dsp(aren,
+					(const float* const*)a_frame->extended_data, ch, layout, n);
+		case AV_SAMPLE_FMT_FLT:
+		case AV_SAMPLE_FMT_S16:
+			for(off = 0; off < n && err == EOS_ERROR_OK; off += cnt)
+			{
+				cnt = n - off < ALSA_AREN_DSP_FRM ? n - off : ALSA_AREN_DSP_FRM;
+				if(a_frame->format == AV_SAMPLE_FMT_S16)
+				{
+					util_audio_dsp_s16_to_f32(aren->ibuf,
+							(const int16_t*)a_frame->data[0] + off * ch,
+							cnt * ch);
+					util_audio_dsp_deinterleave(aren->pln, aren->ibuf, ch, cnt);
+				}
+				else
+				{
+					util_audio_dsp_deinterleave(aren->pln,
+							(const float*)a_frame->data[0] + off * ch, ch, cnt);
+				}
+				err = alsa_aren_dsp(aren, (const float* const*)aren->pln, ch,
+						layout, cnt);
+			}
+			return err;
+		default:
+			break;
 		}
 	}
-	if(av_samples_alloc(&output, &out_size_1, ALSA_AREN_CHANNEL_NUM, a_frame->nb_samples,
-			ALSA_AREN_AVFORMAT, 0) < 0)
+	/* Other formats and rates: AVR only resamples, the rest is done here */
+	if(!aren->ar_opened || !aren->ar_dsp || a_frame->format != aren->ar_fmt ||
+			a_frame->sample_rate != aren->ar_rate ||
+			a_frame->channel_layout != aren->ar_layout)
 	{
-		return EOS_ERROR_GENERAL;
+		if((err = alsa_aren_open_ar(aren, a_frame, true)) != EOS_ERROR_OK)
+		{
+			return err;
+		}
 	}
-	out_size = avresample_convert(aren->ar_ctx, &output, out_size_1, a_frame->nb_samples,
+	out_size = avresample_convert(aren->ar_ctx, output,
+			(int)(ALSA_AREN_DSP_FRM * sizeof(float)), ALSA_AREN_DSP_FRM,
 			a_frame->extended_data, a_frame->linesize[0], a_frame->nb_samples);
 	if(out_size < 0)
 	{
 		UTIL_GLOGE("Skipping wrong AVR data");
-		avresample_close(aren->ar_ctx);
-		alsa_aren_open_ar(aren, a_frame);
-		av_freep(&output);
+		alsa_aren_open_ar(aren, a_frame, true);
 
 		return EOS_ERROR_OK;
 	}
-	if((err = snd_pcm_writei(aren->pcm_handle, output, out_size)) < 0)
+	while(out_size > 0)
+	{
+		if((err = alsa_aren_dsp(aren, (const float* const*)aren->pln, ch,
+				layout, (uint32_t)out_size)) != EOS_ERROR_OK)
+		{
+			return err;
+		}
+		out_size = avresample_available(aren->ar_ctx) > 0 ?
+				avresample_read(aren->ar_ctx, output, ALSA_AREN_DSP_FRM) : 0;
+	}
+
+	return EOS_ERROR_OK;
+}
+
+/* Planar float in, downmixed, leveled and converted for the device */
+static eos_error_t alsa_aren_dsp(alsa_aren_t* aren, const float* const* src,
+		uint32_t ch, uint64_t layout, uint32_t n)
+{
+	const float *in[ALSA_AREN_MAX_CH];
+	const float *out[2];
+	util_audio_dsp_meter_t meter;
+	uint32_t off = 0, cnt = 0, i = 0;
+	float gain = 1.0f, from = 1.0f, lim = 0.0f;
+	eos_error_t err = EOS_ERROR_OK;
+
+	for(off = 0; off < n && err == EOS_ERROR_OK; off += cnt)
 	{
-		if(err == -EPIPE)
+		cnt = n - off < ALSA_AREN_DSP_FRM ? n - off : ALSA_AREN_DSP_FRM;
+		for(i = 0; i < ch; i++)
+		{
+			in[i] = src[i] + off;
+		}
+		out[0] = in[0];
+		out[1] = in[ch > 1 ? 1 : 0];
+		if(ch > 2)
+		{
+			if(layout != aren->mtx_layout || ch != aren->mtx_ch)
+			{
+				alsa_aren_mtx(aren, layout, ch);
+			}
+			util_audio_dsp_downmix(aren->mix, in, ch, aren->mtx, cnt);
+			out[0] = aren->mix[0];
+			out[1] = aren->mix[1];
+		}
+		util_audio_dsp_meter_rst(&meter);
+		util_audio_dsp_meter(&meter, out[0], cnt);
+		util_audio_dsp_meter(&meter, out[1], cnt);
+		gain = alsa_aren_level(aren, &meter, cnt);
+		from = aren->gain;
+		/* Ramp goes through both ends, so both keep the block peak under
+		 * full scale (never cut below unity when leveling is off) */
+		if(meter.peak > 0.0f)
+		{
+			lim = ALSA_AREN_LVL_PEAK / meter.peak;
+			if(aren->lvl == ALSA_AREN_LVL_OFF && lim < 1.0f)
+			{
+				lim = 1.0f;
+			}
+			from = from > lim ? lim : from;
+			gain = gain > lim ? lim : gain;
+		}
+		/* Ramps from the previous block's gain, no zipper noise */
+		util_audio_dsp_gain(aren->mix[0], out[0], cnt, from, gain);
+		util_audio_dsp_gain(aren->mix[1], out[1], cnt, from, gain);
+		aren->gain = gain;
+		out[0] = aren->mix[0];
+		out[1] = aren->mix[1];
+		util_audio_dsp_interleave(aren->ibuf, out, 2, cnt);
+		if(aren->pcm_fmt == SND_PCM_FORMAT_FLOAT)
 		{
-			alsa_aren_recover(aren, output, out_size);
+			err = alsa_aren_write(aren, (uint8_t*)aren->ibuf, cnt);
 		}
 		else
 		{
-			UTIL_GLOGE("Cannot write to ALSA (%s)", snd_strerror(err));
-			av_freep(&output);
-			return EOS_ERROR_GENERAL;
+			util_audio_dsp_f32_to_s16((int16_t*)aren->buf, aren->ibuf, 2 * cnt,
+					&aren->dither);
+			err = alsa_aren_write(aren, aren->buf, cnt);
 		}
 	}
-	av_freep(&output);
 
-	return EOS_ERROR_OK;
+	return err;
+}
+
+/* Stereo downmix coefficients for a layout: centre and surrounds at -3dB,
+ * LFE dropped, scaled so that full scale in every channel does not clip */
+static void alsa_aren_mtx(alsa_aren_t* aren, uint64_t layout, uint32_t ch)
+{
+	uint64_t msk = layout;
+	uint64_t bit = 0;
+	uint32_t c = 0;
+	float l = 0.0f, r = 0.0f, sum_l = 0.0f, sum_r = 0.0f, norm = 1.0f;
+
+	if(msk == 0 || av_get_channel_layout_nb_channels(msk) != (int)ch)
+	{
+		msk = (uint64_t)av_get_default_channel_layout((int)ch);
+	}
+	osi_memset(aren->mtx, 0, sizeof(aren->mtx));
+	for(bit = 1; bit != 0 && c < ch; bit <<= 1)
+	{
+		if(msk != 0 && !(msk & bit))
+		{
+			continue;
+		}
+		switch(msk != 0 ? bit : 0)
+		{
+		case AV_CH_FRONT_LEFT:
+		case AV_CH_FRONT_LEFT_OF_CENTER:
+		case AV_CH_WIDE_LEFT:
+			l = 1.0f;
+			r = 0.0f;
+			break;
+		case AV_CH_FRONT_RIGHT:
+		case AV_CH_FRONT_RIGHT_OF_CENTER:
+		case AV_CH_WIDE_RIGHT:
+			l = 0.0f;
+			r = 1.0f;
+			break;
+		case AV_CH_BACK_LEFT:
+		case AV_CH_SIDE_LEFT:
+		case AV_CH_SURROUND_DIRECT_LEFT:
+			l = ALSA_AREN_M3DB;
+			r = 0.0f;
+			break;
+		case AV_CH_BACK_RIGHT:
+		case AV_CH_SIDE_RIGHT:
+		case AV_CH_SURROUND_DIRECT_RIGHT:
+			l = 0.0f;
+			r = ALSA_AREN_M3DB;
+			break;
+		case AV_CH_FRONT_CENTER:
+			l = r = ALSA_AREN_M3DB;
+			break;
+		case AV_CH_LOW_FREQUENCY:
+		case AV_CH_LOW_FREQUENCY_2:
+			l = r = 0.0f;
+			break;
+		default:
+			/* Back centre, height and unknown channels */
+			l = r = ALSA_AREN_M6DB;
+			break;
+		}
+		aren->mtx[c] = l;
+		aren->mtx[ch + c] = r;
+		sum_l += l;
+		sum_r += r;
+		c++;
+	}
+	norm = sum_l > sum_r ? sum_l : sum_r;
+	if(norm > 1.0f)
+	{
+		for(c = 0; c < 2 * ch; c++)
+		{
+			aren->mtx[c] /= norm;
+		}
+	}
+	aren->mtx_layout = layout;
+	aren->mtx_ch = ch;
+}
+
+static float alsa_aren_level(alsa_aren_t* aren, util_audio_dsp_meter_t* meter,
+		uint32_t n)
+{
+	const alsa_aren_lvl_prm_t *prm = NULL;
+	alsa_aren_lvl_t lvl = aren->lvl;
+	float ms = util_audio_dsp_meter_ms(meter);
+	float a = 0.0f, gain = 1.0f;
+
+	if(lvl == ALSA_AREN_LVL_OFF || lvl > ALSA_AREN_LVL_HEAVY)
+	{
+		return 1.0f;
+	}
+	prm = &alsa_aren_lvl_prm[lvl];
+	/* Pauses and fades do not pull the gain up */
+	if(ms > ALSA_AREN_LVL_GATE)
+	{
+		a = (float)n / ((ms > aren->loud ? ALSA_AREN_LVL_ATTACK :
+				ALSA_AREN_LVL_RELEASE) * (float)aren->rate);
+		aren->loud = aren->loud == 0.0f || a > 1.0f ? ms :
+				aren->loud + a * (ms - aren->loud);
+	}
+	if(aren->loud == 0.0f)
+	{
+		return aren->gain;
+	}
+	gain = sqrtf(prm->target / aren->loud);
+	if(gain > prm->max)
+	{
+		gain = prm->max;
+	}
+	else if(gain < 1.0f / prm->max)
+	{
+		gain = 1.0f / prm->max;
+	}
+
+	return gain;
 }
 
 eos_error_t alsa_aren_pause(alsa_aren_t* aren)
@@ -269,29 +662,48 @@ eos_error_t alsa_aren_flush(alsa_aren_t* aren)
 
 eos_error_t alsa_aren_silence(alsa_aren_t* aren, uint32_t milis)
 {
-	uint32_t len = milis * 176; /*44100 * 2 * 2 / 1000 ~= 176 */
-	uint8_t *buff = osi_calloc(len);
+	if(aren == NULL || aren->pcm_handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
 
-	snd_pcm_writei(aren->pcm_handle, buff, len/2);
-	osi_free((void**)&buff);
+	return alsa_aren_write(aren, NULL, aren->rate * milis / 1000);
+}
+
+eos_error_t alsa_aren_set_lvl(alsa_aren_t* aren, alsa_aren_lvl_t lvl)
+{
+	if(aren == NULL || lvl > ALSA_AREN_LVL_HEAVY)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(lvl != ALSA_AREN_LVL_OFF && aren->dsp == NULL)
+	{
+		return EOS_ERROR_NIMPLEMENTED;
+	}
+	/* Gain ramps towards the new target (or unity) from the next block */
+	aren->lvl = lvl;
 
 	return EOS_ERROR_OK;
 }
 
-eos_error_t alsa_aren_get_buff_dur(alsa_aren_t* aren, double* buffered)
+eos_error_t alsa_aren_get_delay(alsa_aren_t* aren, uint32_t* frames,
+		uint32_t* rate)
 {
-	snd_pcm_sframes_t frames = 0;
+	snd_pcm_sframes_t delay = 0;
 
-	if(aren == NULL || buffered == NULL || aren->pcm_handle == NULL)
+	if(aren == NULL || frames == NULL || rate == NULL ||
+			aren->pcm_handle == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 	snd_pcm_avail_update(aren->pcm_handle);
-	if(snd_pcm_delay(aren->pcm_handle, &frames) < 0)
+	if(snd_pcm_delay(aren->pcm_handle, &delay) < 0 || delay < 0)
 	{
-		frames = 0;
+		delay = 0;
 	}
-	*buffered = frames / (double)ALSA_AREN_SAMPLE_RATE;
+	/* Frames (at the negotiated rate) written but not heard yet */
+	*frames = (uint32_t)delay;
+	*rate = aren->rate;
 
 	return EOS_ERROR_OK;
 }
@@ -308,9 +720,173 @@ eos_error_t alsa_aren_deinit(alsa_aren_t* aren)
 	snd_pcm_close(aren->pcm_handle);
 	aren->pcm_handle = NULL;
 	aren->ar_opened = 0;
+	av_freep(&aren->buf);
+	aren->buf_frm = 0;
+	av_freep(&aren->dsp);
 	osi_mutex_unlock(aren->lock);
 	osi_mutex_destroy(&aren->lock);
 
 	return EOS_ERROR_OK;
 }
 
+static eos_error_t alsa_aren_alloc_buf(alsa_aren_t* aren, uint32_t frames)
+{
+	int linesize = 0;
+
+	if(frames <= aren->buf_frm)
+	{
+		return EOS_ERROR_OK;
+	}
+	av_freep(&aren->buf);
+	aren->buf_frm = 0;
+	if(av_samples_alloc(&aren->buf, &linesize, (int)aren->channels,
+			(int)frames, aren->av_fmt, 0) < 0)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	aren->buf_frm = frames;
+
+	return EOS_ERROR_OK;
+}
+
+/* data == NULL writes silence */
+static eos_error_t alsa_aren_write(alsa_aren_t* aren, uint8_t* data,
+		uint32_t frames)
+{
+	snd_pcm_sframes_t ret = 0;
+	uint32_t chunk = 0;
+
+	while(frames > 0)
+	{
+		if(aren->mmap)
+		{
+			ret = alsa_aren_mmap_write(aren, data, frames);
+		}
+		else
+		{
+			chunk = frames;
+			if(data == NULL)
+			{
+				chunk = frames < aren->buf_frm ? frames : aren->buf_frm;
+				snd_pcm_format_set_silence(aren->pcm_fmt, aren->buf,
+						chunk * aren->channels);
+			}
+			ret = snd_pcm_writei(aren->pcm_handle,
+					data != NULL ? data : aren->buf, chunk);
+		}
+		if(ret < 0)
+		{
+			/* Underrun or suspend: the player resyncs on the delay */
+			if((ret = snd_pcm_recover(aren->pcm_handle, (int)ret, 1)) < 0)
+			{
+				UTIL_GLOGE("Cannot write to ALSA (%s)", snd_strerror((int)ret));
+				return EOS_ERROR_GENERAL;
+			}
+			continue;
+		}
+		frames -= (uint32_t)ret;
+		if(data != NULL)
+		{
+			data += ret * aren->frm_bytes;
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static snd_pcm_sframes_t alsa_aren_mmap_write(alsa_aren_t* aren,
+		uint8_t* data, snd_pcm_uframes_t frames)
+{
+	const snd_pcm_channel_area_t *areas = NULL;
+	snd_pcm_uframes_t offset = 0;
+	snd_pcm_sframes_t avail = 0, ret = 0;
+	uint8_t *dst = NULL;
+	int err = 0;
+
+	if((avail = snd_pcm_avail_update(aren->pcm_handle)) < 0)
+	{
+		return avail;
+	}
+	if(avail == 0)
+	{
+		/* Ring full, block the way writei would until a period is played */
+		err = snd_pcm_wait(aren->pcm_handle, ALSA_AREN_WAIT_MS);
+		return err < 0 ? err : 0;
+	}
+	if(frames > (snd_pcm_uframes_t)avail)
+	{
+		frames = (snd_pcm_uframes_t)avail;
+	}
+	/* May be less than asked for when the free space wraps around */
+	if((err = snd_pcm_mmap_begin(aren->pcm_handle, &areas, &offset,
+			&frames)) < 0)
+	{
+		return err;
+	}
+	if(data != NULL)
+	{
+		/* Interleaved: one area, frames back to back */
+		dst = (uint8_t*)areas[0].addr + areas[0].first / 8 +
+				offset * (areas[0].step / 8);
+		osi_memcpy(dst, data, frames * aren->frm_bytes);
+	}
+	else
+	{
+		snd_pcm_areas_silence(areas, offset, aren->channels, frames,
+				aren->pcm_fmt);
+	}
+
+	if((ret = snd_pcm_mmap_commit(aren->pcm_handle, offset, frames)) < 0)
+	{
+		return ret;
+	}
+	/*
+	 * Unlike writei, commit does not look at the start threshold: start the
+	 * device once a period is in (also after flush and underrun recovery).
+	 */
+	if(snd_pcm_state(aren->pcm_handle) == SND_PCM_STATE_PREPARED &&
+			(avail = snd_pcm_avail_update(aren->pcm_handle)) >= 0 &&
+			aren->ring - (snd_pcm_uframes_t)avail >= aren->period)
+	{
+		/* Frames are in either way, a failed start shows on the next write */
+		snd_pcm_start(aren->pcm_handle);
+	}
+
+	return ret;
+}
+
+static snd_pcm_format_t alsa_aren_pcm_fmt(enum AVSampleFormat fmt)
+{
+	switch(av_get_packed_sample_fmt(fmt))
+	{
+	case AV_SAMPLE_FMT_U8:
+		return SND_PCM_FORMAT_U8;
+	case AV_SAMPLE_FMT_S16:
+		return SND_PCM_FORMAT_S16;
+	case AV_SAMPLE_FMT_S32:
+		return SND_PCM_FORMAT_S32;
+	case AV_SAMPLE_FMT_FLT:
+		return SND_PCM_FORMAT_FLOAT;
+	case AV_SAMPLE_FMT_DBL:
+		return SND_PCM_FORMAT_FLOAT64;
+	default:
+		return SND_PCM_FORMAT_UNKNOWN;
+	}
+}
+
+static enum AVSampleFormat alsa_aren_av_fmt(snd_pcm_format_t fmt)
+{
+	switch(fmt)
+	{
+	case SND_PCM_FORMAT_U8:
+		return AV_SAMPLE_FMT_U8;
+	case SND_PCM_FORMAT_S32:
+		return AV_SAMPLE_FMT_S32;
+	case SND_PCM_FORMAT_FLOAT:
+		return AV_SAMPLE_FMT_FLT;
+	case SND_PCM_FORMAT_FLOAT64:
+		return AV_SAMPLE_FMT_DBL;
+	default:
+		return AV_SAMPLE_FMT_S16;
+	}
+}
@@ -35,28 +35,75 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define ALSA_AREN_H_
 
 #include "eos_error.h"
+#include "eos_types.h"
 #include "osi_mutex.h"
+#include "util_audio_dsp.h"
 
 #include <alsa/asoundlib.h>
 #include <libavformat/avformat.h>
 #include <libavresample/avresample.h>
 
+/* Most channels the float path mixes down */
+#define ALSA_AREN_MAX_CH (8)
+/* Float path block (frames) */
+#define ALSA_AREN_DSP_FRM (2048)
+
+typedef enum alsa_aren_lvl
+{
+	ALSA_AREN_LVL_OFF = 0,
+	ALSA_AREN_LVL_LIGHT,
+	ALSA_AREN_LVL_NORMAL,
+	ALSA_AREN_LVL_HEAVY
+} alsa_aren_lvl_t;
+
 typedef struct alsa_aren
 {
 	snd_pcm_t *pcm_handle;
 	AVAudioResampleContext *ar_ctx;
 	uint8_t ar_opened;
+	bool ar_dsp;
+	/* What AVR was opened for, reopened when the decoder output changes */
+	enum AVSampleFormat ar_fmt;
+	int ar_rate;
+	uint64_t ar_layout;
+	/* Negotiated with the device */
+	bool mmap;
+	snd_pcm_uframes_t ring;
+	snd_pcm_uframes_t period;
+	snd_pcm_format_t pcm_fmt;
+	enum AVSampleFormat av_fmt;
+	uint32_t rate;
+	uint32_t channels;
+	uint32_t frm_bytes;
+	/* Conversion output, allocated up front for the largest frame */
+	uint8_t *buf;
+	uint32_t buf_frm;
+	/* Float path (stereo S16/FLOAT devices): downmix, leveling, dither */
+	float *dsp;
+	float *pln[ALSA_AREN_MAX_CH];
+	float *mix[2];
+	float *ibuf;
+	float mtx[2 * ALSA_AREN_MAX_CH];
+	uint64_t mtx_layout;
+	uint32_t mtx_ch;
+	util_audio_dsp_dither_t dither;
+	volatile alsa_aren_lvl_t lvl;
+	float gain;
+	float loud;
 	osi_mutex_t *lock;
 } alsa_aren_t;
 
-eos_error_t alsa_aren_init(alsa_aren_t* aren);
+eos_error_t alsa_aren_init(alsa_aren_t* aren, uint32_t rate,
+		enum AVSampleFormat fmt);
 eos_error_t alsa_aren_setup(alsa_aren_t* aren);
 eos_error_t alsa_aren_play(alsa_aren_t* aren, AVFrame* a_frame);
 eos_error_t alsa_aren_pause(alsa_aren_t* aren);
 eos_error_t alsa_aren_resume(alsa_aren_t* aren);
 eos_error_t alsa_aren_flush(alsa_aren_t* aren);
 eos_error_t alsa_aren_silence(alsa_aren_t* aren, uint32_t milis);
-eos_error_t alsa_aren_get_buff_dur(alsa_aren_t* aren, double* buffered);
+eos_error_t alsa_aren_set_lvl(alsa_aren_t* aren, alsa_aren_lvl_t lvl);
+eos_error_t alsa_aren_get_delay(alsa_aren_t* aren, uint32_t* frames,
+		uint32_t* rate);
 eos_error_t alsa_aren_deinit(alsa_aren_t* aren);
 
 #endif /* ALSA_AREN_H_ */
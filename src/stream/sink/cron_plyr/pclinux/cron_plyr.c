@@ -31,14 +31,18 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+/* MODULE_NAME ("core") is shared with other modules */
+#define OSI_MEMORY_TAG "cron_plyr"
+
 #include "cron_plyr.h"
 
 #include "eos_macro.h"
 #include "osi_memory.h"
 #include "osi_mutex.h"
-#include "osi_thread.h"
+#include "osi_executor.h"
 #include "util_rbuff.h"
 #include "util_msgq.h"
+#include "util_clk.h"
 
 #define MODULE_NAME "core"
 #include "util_log.h"
@@ -61,13 +65,32 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 //#define CRON_PLYR_PROBE_SZ (188 * 800)
 #define CRON_PLYR_PROBE_SZ (188 * 10000)
 
-/* about 2M rounded to TS packet size */
+/* about 2M rounded to TS packet size, used until the input bitrate is known */
 #define CRON_PLYR_INBUFF_SZ (188 * 11000)
-/* about 4k rounded to TS packet size */
-#define CRON_PLYR_IOCTX_SZ (188 * 22)
+/* input buffer is resized to hold this many seconds of the stream */
+#define CRON_PLYR_INBUFF_SEC (3)
+/* input bitrate is measured over the first seconds of the stream */
+#define CRON_PLYR_INBUFF_MEASURE_MS (3000)
+/* about 512k and 8M rounded to TS packet size */
+#define CRON_PLYR_INBUFF_MIN_SZ (188 * 2800)
+#define CRON_PLYR_INBUFF_MAX_SZ (188 * 44000)
+/* resize attempts held off by a writer reservation, then the size is kept */
+#define CRON_PLYR_INBUFF_TRIES (32)
+/* about 16k rounded to TS packet size */
+#define CRON_PLYR_IOCTX_SZ (188 * 88)
+/* Largest rbuff span lent to the demuxer (must not exceed the AVIO buffer size) */
+#define CRON_PLYR_LEND_SZ CRON_PLYR_IOCTX_SZ
+/* Lend waits for one TS packet at least, not for a full span */
+#define CRON_PLYR_LEND_MIN_SZ (188)
+/* Copied at a span boundary, just enough to let the demuxer finish its frame */
+#define CRON_PLYR_LEND_COPY_SZ (188)
 
 #define CRON_PLYR_AUD_QUEUE_SZ (10)
 #define CRON_PLYR_VID_QUEUE_SZ (50)
+/* Frame duration (UTIL_CLK_HZ) when frame rate is not known, 25 fps */
+#define CRON_PLYR_DFLT_FRM_DUR (3600)
+/* Longest video waits for the master clock before it is taken as discontinuity */
+#define CRON_PLYR_MAX_WAIT (2 * UTIL_CLK_HZ)
 
 #define CRON_PLYR_LOCK(player) osi_mutex_lock(player->lock)
 #define CRON_PLYR_UNLOCK(player) osi_mutex_unlock(player->lock)
@@ -77,9 +100,12 @@ typedef struct cron_plyr_sync
 	double t_base;
 	double a_start;
 	double v_start;
-	double a_pts;
-	double v_pts;
-	uint32_t v_clk_tmt;
+	/* Stream time bases, time stamps are rescaled to UTIL_CLK_HZ */
+	AVRational a_tb;
+	AVRational v_tb;
+	/* Video frame duration (UTIL_CLK_HZ) */
+	uint32_t v_dur;
+	/* Longest video wait in free run (usec) */
 	uint32_t threshold;
 	osi_mutex_t *lock;
 } cron_plyr_sync_t;
@@ -94,12 +120,25 @@ struct cron_plyr
 	osi_mutex_t *lock;
 	util_rbuff_t *in_rb;
 	uint8_t *in_buff;
+	uint32_t in_size;
+	uint32_t in_target;
+	/* new block waiting for the resize (reader side) */
+	uint8_t *in_spare;
+	uint8_t in_tries;
+	uint64_t in_bytes;
+	osi_time_t in_start;
 	bool freerun;
 	uint8_t slowdown;
 	uint32_t dec_trshld;
+	cron_dec_thr_t dec_thr;
+	uint8_t dec_thr_cnt;
+	alsa_aren_lvl_t vol_lvl;
+	util_clk_t *clk;
+	cron_clk_t clk_master;
 	bool keep_frm;
+	bool frm_disp_ev;
 
-	osi_thread_t *probe_thread;
+	osi_executor_task_t *probe_task;
 	uint8_t *probe_buff;
 	uint32_t probe_len;
 	uint32_t probe_off;
@@ -111,6 +150,12 @@ struct cron_plyr
 	AVCodecContext *v_codec;
 #endif
 	void *io_ctx_buff;
+	/* AVIO buffer owned by libav, parked while an rbuff span is lent */
+	uint8_t *io_own;
+	int io_own_size;
+	/* Last rbuff span handed out, released once the demuxer consumed it */
+	uint8_t *lent;
+	uint32_t lent_len;
 	util_msgq_t *aud_queue;
 	util_msgq_t *vid_queue;
 	bool stopped;
@@ -132,15 +177,25 @@ struct cron_plyr
 static const char *cron_plyr_name = "pclinux";
 
 static int cron_plyr_read_pkt(void* opaque, uint8_t* buf, int buf_size);
+static void cron_plyr_lend_io(void* opaque, AVIOContext* io_ctx);
+static void cron_plyr_return_io(cron_plyr_t* player);
+static void cron_plyr_inbuff_adapt(cron_plyr_t* player, size_t size);
+static void cron_plyr_inbuff_resize(cron_plyr_t* player);
 static void cron_plyr_free_pkt(void* msg_data, size_t msg_size);
-static void* cron_plyr_probe(void* arg);
+static void cron_plyr_probe(void* arg);
+static eos_error_t cron_plyr_fast_open(cron_plyr_t* player);
 static eos_error_t cron_plyr_dmx_aud(void* opaque, AVPacket* pkt);
 static eos_error_t cron_plyr_dmx_vid(void* opaque, AVPacket* pkt);
 static eos_error_t cron_plyr_dec_aud(void* opaque, AVFrame* frame);
 static eos_error_t cron_plyr_dec_vid(void* opaque, AVFrame* frame);
 static void cron_plyr_i_frm(void* opaque, uint64_t pts);
+static void cron_plyr_vdec_lvl(void* opaque, libav_dec_lvl_t lvl,
+		uint32_t dropped, uint32_t queued);
+static uint32_t cron_plyr_vdec_late(void* opaque);
+static libav_dec_thr_t cron_plyr_dec_thr(cron_plyr_t* player, double frm_dur);
 static eos_error_t cron_plyr_clk_vid(void* opaque, x11_frame_t* frame,
-		uint32_t* micros, osi_time_t* offset);
+		osi_time_t* deadline, bool* drop);
+static util_clk_src_t cron_plyr_clk_src(cron_plyr_t* player);
 static void cron_plyr_libav_log(void*, int, const char*, va_list);
 static eos_error_t cron_plyr_fire_ev(cron_plyr_t* player,
 		cron_plyr_ev_t event, cron_ply_ev_data_t* data);
@@ -230,6 +285,7 @@ eos_error_t cron_plyr_create(cron_plyr_t** player, cron_plyr_disp_t disp)
 		goto done;
 	}
 	tmp->in_buff = attr.buff;
+	tmp->in_size = CRON_PLYR_INBUFF_SZ;
 
 	if((tmp->io_ctx_buff = av_malloc(CRON_PLYR_IOCTX_SZ)) == NULL)
 	{
@@ -259,6 +315,10 @@ eos_error_t cron_plyr_create(cron_plyr_t** player, cron_plyr_disp_t disp)
 	{
 		goto done;
 	}
+	if((err = util_clk_create(&tmp->clk)) != EOS_ERROR_OK)
+	{
+		goto done;
+	}
 	tmp->aud_started = false;
 	tmp->vid_started = false;
 	osi_memset(&(tmp->media), 0, sizeof(eos_media_desc_t));
@@ -299,6 +359,10 @@ done:
 		{
 			util_log_destroy(&tmp->log);
 		}
+		if(tmp->clk != NULL)
+		{
+			util_clk_destroy(&tmp->clk);
+		}
 	}
 	return EOS_ERROR_OK;
 }
@@ -312,14 +376,20 @@ eos_error_t cron_plyr_destroy(cron_plyr_t** player)
 		return EOS_ERROR_INVAL;
 	}
 	tmp = *player;
+	cron_plyr_return_io(tmp);
 	osi_mutex_lock(tmp->lock);
 	osi_free((void**)&tmp->in_buff);
+	if(tmp->in_spare != NULL)
+	{
+		osi_free((void**)&tmp->in_spare);
+	}
 	util_rbuff_destroy(&tmp->in_rb);
 	util_msgq_destroy(&tmp->aud_queue);
 	util_msgq_destroy(&tmp->vid_queue);
 	osi_mutex_unlock(tmp->lock);
 	osi_mutex_destroy(&tmp->lock);
 	util_log_destroy(&tmp->log);
+	util_clk_destroy(&tmp->clk);
 
 	av_free(tmp->io_ctx->buffer);
 	avio_context_free(&tmp->io_ctx);
@@ -354,6 +424,8 @@ eos_error_t cron_plyr_buff_get(cron_plyr_t* player, uint8_t** buff, size_t* size
 eos_error_t cron_plyr_buff_cons(cron_plyr_t* player, uint8_t* buff, size_t size,
 		link_data_ext_info_t* extended_info, int32_t milis, uint16_t id)
 {
+	eos_error_t err = EOS_ERROR_OK;
+
 	if(player == NULL || buff == NULL)
 	{
 		return EOS_ERROR_INVAL;
@@ -362,20 +434,31 @@ eos_error_t cron_plyr_buff_cons(cron_plyr_t* player, uint8_t* buff, size_t size,
 	EOS_UNUSED(id);
 	EOS_UNUSED(extended_info);
 
-	return util_rbuff_commit(player->in_rb, buff, size);
+	if((err = util_rbuff_commit(player->in_rb, buff, size)) != EOS_ERROR_OK)
+	{
+		return err;
+	}
+	cron_plyr_inbuff_adapt(player, size);
+
+	return EOS_ERROR_OK;
 }
 
 eos_error_t cron_plyr_set_media_desc(cron_plyr_t* player,
-		eos_media_desc_t* media)
+		util_mdesc_t* media)
 {
 	uint8_t i = 0;
 
-	if(player == NULL || media == NULL)
+	if(player == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 	CRON_PLYR_LOCK(player);
-	osi_memcpy(&(player->media), media, sizeof(eos_media_desc_t));
+	/* Only used ES entries are copied, selection is tracked in the player's copy */
+	player->media.es_cnt = 0;
+	if(media != NULL)
+	{
+		util_mdesc_expand(media, &(player->media));
+	}
 	for(i=0; i<player->media.es_cnt; i++)
 	{
 		player->media.es[i].selected = false;
@@ -633,6 +716,7 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 	eos_error_t err = EOS_ERROR_OK;
 	int idx = -1;
 	double rate = 0.0;
+	enum AVFieldOrder field = AV_FIELD_UNKNOWN;
 	uint16_t x = 0, y = 0, w = 0, h = 0;
 	eos_media_es_t *sel = NULL;
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
@@ -670,8 +754,12 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 			return EOS_ERROR_NFOUND;
 		}
 		libav_dmx_set_vid(&player->dmx, idx);
-		player->sync.v_start = player->sync.t_base *
-				player->avf_ctx->streams[idx]->start_time;
+		/* Not known when opened without probing */
+		if(player->avf_ctx->streams[idx]->start_time != AV_NOPTS_VALUE)
+		{
+			player->sync.v_start = player->sync.t_base *
+					player->avf_ctx->streams[idx]->start_time;
+		}
 #if FF_API_R_FRAME_RATE
 		rate = player->avf_ctx->streams[idx]->r_frame_rate.den /
 				(double)player->avf_ctx->streams[idx]->r_frame_rate.num;
@@ -680,17 +768,23 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 						(double)player->avf_ctx->streams[idx]->avg_frame_rate.num;
 #endif
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
-		if(player->avf_ctx->streams[idx]->codecpar->field_order !=
-				AV_FIELD_PROGRESSIVE)
+		field = player->avf_ctx->streams[idx]->codecpar->field_order;
 #else
-		if(player->avf_ctx->streams[idx]->codec->field_order !=
-				AV_FIELD_PROGRESSIVE)
+		field = player->avf_ctx->streams[idx]->codec->field_order;
 #endif
+		/* Only when known to be interlaced, the fast path (no probing)
+		 * leaves it unknown */
+		if(field == AV_FIELD_TT || field == AV_FIELD_BB ||
+				field == AV_FIELD_TB || field == AV_FIELD_BT)
 		{
 			rate *= 2;
 		}
-		player->sync.v_clk_tmt = (uint32_t)OSI_TIME_SEC_TO_USEC(rate);
-		player->sync.threshold = (uint32_t)OSI_TIME_SEC_TO_USEC(rate);
+		player->sync.v_tb = player->avf_ctx->streams[idx]->time_base;
+		/* Frame rate may be unknown when opened without probing */
+		player->sync.v_dur = (rate > 0.0 && rate < 1.0) ?
+				(uint32_t)UTIL_CLK_USEC_TO_TICKS(OSI_TIME_SEC_TO_USEC(rate)) :
+				CRON_PLYR_DFLT_FRM_DUR;
+		player->sync.threshold = (uint32_t)UTIL_CLK_TICKS_TO_USEC(player->sync.v_dur);
 		UTIL_GLOGD("%f (rate: %f) ", player->sync.v_start -
 				player->sync.a_start, rate);
 		x = player->x != 0 ? player->x : 0;
@@ -723,6 +817,9 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 		{
 			return EOS_ERROR_GENERAL;
 		}
+		libav_dec_set_thr(&player->dec, cron_plyr_dec_thr(player, rate),
+				player->dec_thr_cnt);
+		libav_dec_set_adapt(&player->dec, true);
 		libav_dec_start_vid(&player->dec, player->v_codec);
 #else
 		h = player->h != 0 ? player->h : (uint16_t)player->avf_ctx->streams[idx]->codec->height;
@@ -734,6 +831,9 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 				(uint16_t)player->avf_ctx->streams[idx]->codec->width);
 		x11_vren_set_clk_cb(&player->vren, cron_plyr_clk_vid, player);
 
+		libav_dec_set_thr(&player->dec, cron_plyr_dec_thr(player, rate),
+				player->dec_thr_cnt);
+		libav_dec_set_adapt(&player->dec, true);
 		libav_dec_start_vid(&player->dec,
 				player->avf_ctx->streams[idx]->codec);
 #endif
@@ -762,11 +862,25 @@ eos_error_t cron_plyr_es_start(cron_plyr_t* player, cron_plyr_es_t es)
 		}
 		libav_dmx_set_aud(&player->dmx, idx);
 		player->sync.t_base = av_q2d(player->avf_ctx->streams[idx]->time_base);
-		player->sync.a_start = player->sync.t_base *
-				player->avf_ctx->streams[idx]->start_time;
+		player->sync.a_tb = player->avf_ctx->streams[idx]->time_base;
+		if(player->avf_ctx->streams[idx]->start_time != AV_NOPTS_VALUE)
+		{
+			player->sync.a_start = player->sync.t_base *
+					player->avf_ctx->streams[idx]->start_time;
+		}
 
-		alsa_aren_init(&player->aren);
+		/* Device is opened as close to the source as it goes */
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
+		alsa_aren_init(&player->aren,
+				(uint32_t)player->avf_ctx->streams[idx]->codecpar->sample_rate,
+				(enum AVSampleFormat)player->avf_ctx->streams[idx]->codecpar->format);
+#else
+		alsa_aren_init(&player->aren,
+				(uint32_t)player->avf_ctx->streams[idx]->codec->sample_rate,
+				player->avf_ctx->streams[idx]->codec->sample_fmt);
+#endif
 		alsa_aren_setup(&player->aren);
+		alsa_aren_set_lvl(&player->aren, player->vol_lvl);
 
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
 		if(av_find_best_stream(player->avf_ctx, AVMEDIA_TYPE_AUDIO, idx, -1, &dec, 0) < 0)
@@ -883,8 +997,6 @@ eos_error_t cron_plyr_reg_ev_hnd(cron_plyr_t* player, cron_plyr_ev_cbk_t cbk,
 
 eos_error_t cron_plyr_start(cron_plyr_t* player)
 {
-	osi_thread_attr_t attr = {OSI_THREAD_JOINABLE};
-
 	if(player == NULL)
 	{
 		return EOS_ERROR_INVAL;
@@ -893,27 +1005,40 @@ eos_error_t cron_plyr_start(cron_plyr_t* player)
 	player->probe_len = 0;
 	player->probe_off = 0;
 	player->probe_done = false;
+	player->frm_disp_ev = false;
+	util_clk_stats_rst(player->clk);
+	/* new stream, measure its bitrate again */
+	player->in_bytes = 0;
+	player->in_target = 0;
+	player->in_tries = 0;
+	if(player->in_spare != NULL)
+	{
+		osi_free((void**)&player->in_spare);
+	}
 
-	return osi_thread_create(&player->probe_thread, &attr,
-			cron_plyr_probe, player);
+	return osi_executor_run(osi_executor_shared(), cron_plyr_probe, player,
+			OSI_EXECUTOR_ANY, &player->probe_task);
 }
 
 eos_error_t cron_plyr_stop(cron_plyr_t* player)
 {
 	eos_error_t err = EOS_ERROR_OK;
+	uint32_t dropped = 0, repeated = 0;
 
 	if(player == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	util_rbuff_stop(player->in_rb);
-	if((err = osi_thread_join(player->probe_thread, NULL)) != EOS_ERROR_OK)
+	if(util_clk_stats(player->clk, &dropped, &repeated) == EOS_ERROR_OK)
 	{
-		// TODO: warning?
+		UTIL_LOGI(player->log, "Frames dropped: %u repeated: %u", dropped,
+				repeated);
 	}
-	if((err = osi_thread_release(&player->probe_thread)) != EOS_ERROR_OK)
+	util_rbuff_stop(player->in_rb);
+	/* Input is stopped, probing (even if not started yet) ends quickly */
+	if(player->probe_task != NULL)
 	{
-
+		osi_executor_join(&player->probe_task);
 	}
 	osi_free((void**)&player->probe_buff);
 	cron_plyr_es_stop(player, CRON_PLYR_ES_AUD);
@@ -922,6 +1047,7 @@ eos_error_t cron_plyr_stop(cron_plyr_t* player)
 	util_msgq_pause(player->vid_queue);
 	libav_dmx_stop(&player->dmx);
 	libav_dmx_deinit(&player->dmx);
+	cron_plyr_return_io(player);
 	util_msgq_flush(player->aud_queue);
 	util_msgq_flush(player->vid_queue);
 	CRON_PLYR_LOCK(player);
@@ -968,6 +1094,8 @@ eos_error_t cron_plyr_resume(cron_plyr_t* player)
 	libav_dmx_resume(&player->dmx);
 	libav_dec_resume_aud(&player->dec);
 	libav_dec_resume_vid(&player->dec);
+	/* Clock did not move while paused */
+	util_clk_reset(player->clk);
 	alsa_aren_resume(&player->aren);
 	x11_vren_resume(&player->vren);
 
@@ -988,6 +1116,7 @@ eos_error_t cron_plyr_pause_resume(cron_plyr_t* player, uint32_t milis)
 
 	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(milis));
 
+	util_clk_reset(player->clk);
 	alsa_aren_resume(&player->aren);
 	x11_vren_resume(&player->vren);
 
@@ -1005,6 +1134,7 @@ eos_error_t cron_plyr_flush(cron_plyr_t* player)
 		return EOS_ERROR_INVAL;
 	}
 	UTIL_GLOGD("Flushing...");
+	cron_plyr_return_io(player);
 	util_rbuff_rst(player->in_rb);
 	avio_flush(player->io_ctx);
 	player->io_ctx->pos = 0LL;
@@ -1014,6 +1144,7 @@ eos_error_t cron_plyr_flush(cron_plyr_t* player)
 	libav_dec_flush_vid(&player->dec);
 	util_msgq_flush(player->vren.queue);
 	alsa_aren_flush(&player->aren);
+	util_clk_reset(player->clk);
 	UTIL_GLOGD("Flushed");
 
 	return err;
@@ -1103,14 +1234,75 @@ eos_error_t cron_plyr_aud_pt(cron_plyr_t* player, bool enable)
 
 eos_error_t cron_plyr_vol_leveling(cron_plyr_t* player, bool enable, cron_vol_lvl_t lvl)
 {
+	alsa_aren_lvl_t aren_lvl = ALSA_AREN_LVL_OFF;
+	eos_error_t err = EOS_ERROR_OK;
+
 	if(player == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	EOS_UNUSED(enable);
-	EOS_UNUSED(lvl);
+	switch(lvl)
+	{
+	case CRON_VOL_LVL_LIGHT:
+		aren_lvl = ALSA_AREN_LVL_LIGHT;
+		break;
+	case CRON_VOL_LVL_NORMAL:
+		aren_lvl = ALSA_AREN_LVL_NORMAL;
+		break;
+	case CRON_VOL_LVL_HEAVY:
+		aren_lvl = ALSA_AREN_LVL_HEAVY;
+		break;
+	default:
+		return EOS_ERROR_INVAL;
+	}
+	/* Kept for the next audio stream, applied right away if one is playing */
+	osi_mutex_lock(player->lock);
+	player->vol_lvl = enable ? aren_lvl : ALSA_AREN_LVL_OFF;
+	if(player->aren.pcm_handle != NULL)
+	{
+		err = alsa_aren_set_lvl(&player->aren, player->vol_lvl);
+	}
+	osi_mutex_unlock(player->lock);
 
-	return EOS_ERROR_NIMPLEMENTED;
+	return err;
+}
+
+eos_error_t cron_plyr_dec_threads(cron_plyr_t* player, cron_dec_thr_t mode,
+		uint8_t count)
+{
+	if(player == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(player->lock);
+	player->dec_thr = mode;
+	player->dec_thr_cnt = count;
+	osi_mutex_unlock(player->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t cron_plyr_set_clk(cron_plyr_t* player, cron_clk_t clk)
+{
+	if(player == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	/* Read by renderer on every frame, a plain store is enough */
+	player->clk_master = clk;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t cron_plyr_get_frm_stats(cron_plyr_t* player, uint32_t* dropped,
+		uint32_t* repeated)
+{
+	if(player == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	return util_clk_stats(player->clk, dropped, repeated);
 }
 
 eos_error_t cron_plyr_get_ext(cron_plyr_t* player, link_cap_t cap,
@@ -1126,6 +1318,30 @@ eos_error_t cron_plyr_get_ext(cron_plyr_t* player, link_cap_t cap,
 int cron_plyr_read_pkt(void *opaque, uint8_t *buf, int buf_size)
 {
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
+	uint8_t *data = NULL;
+	uint32_t size = 0, read = 0;
+
+	if(player->io_own != NULL)
+	{
+		/*
+		 * Demuxer ran out of the lent span in the middle of a frame and
+		 * wants the rest in place of it. The span is still held, so it is
+		 * safe to copy over, but only copy what is needed to finish the
+		 * frame: the next span is lent again before the next read.
+		 */
+		size = buf_size < CRON_PLYR_LEND_COPY_SZ ?
+				(uint32_t)buf_size : CRON_PLYR_LEND_COPY_SZ;
+		if(util_rbuff_read(player->in_rb, (void**)&data, size, &read,
+				UTIL_RBUFF_FOREVER) != EOS_ERROR_OK)
+		{
+			return -1;
+		}
+		osi_memcpy(buf, data, read);
+		player->lent = data;
+		player->lent_len = read;
+
+		return (int)read;
+	}
 
 	//UTIL_LOGWTF(player->log, "RD PKT len %d", buf_size);
 	if(player->probe_off < player->probe_len && player->probe_done)
@@ -1168,6 +1384,87 @@ int cron_plyr_read_pkt(void *opaque, uint8_t *buf, int buf_size)
 	return -1;
 }
 
+static void cron_plyr_lend_io(void* opaque, AVIOContext* io_ctx)
+{
+	cron_plyr_t* player = (cron_plyr_t*)opaque;
+	uint8_t *data = NULL;
+	uint32_t read = 0, size = 0;
+
+	/* Demuxer has not consumed the current span yet */
+	if(io_ctx->buf_ptr < io_ctx->buf_end)
+	{
+		return;
+	}
+	if(player->io_own == NULL)
+	{
+		player->io_own = io_ctx->buffer;
+		player->io_own_size = io_ctx->buffer_size;
+	}
+	/* Spans are taken in order, so releasing the last one frees all before it */
+	if(player->lent != NULL)
+	{
+		util_rbuff_free(player->in_rb, player->lent, player->lent_len);
+		player->lent = NULL;
+		player->lent_len = 0;
+		/* Consumed, but must not point into the ring once it is released */
+		io_ctx->buffer = player->io_own;
+		io_ctx->buffer_size = player->io_own_size;
+		io_ctx->buf_ptr = player->io_own;
+		io_ctx->buf_end = player->io_own;
+	}
+	/* Nothing is lent now, the only moment the ring can be swapped */
+	cron_plyr_inbuff_resize(player);
+	/* Lend whole packets that are already there; we are the only reader,
+	 * so they are still there when we read */
+	if(util_rbuff_get_fullness(player->in_rb, &size) != EOS_ERROR_OK)
+	{
+		size = 0;
+	}
+	size -= size % CRON_PLYR_LEND_MIN_SZ;
+	if(size < CRON_PLYR_LEND_MIN_SZ)
+	{
+		size = CRON_PLYR_LEND_MIN_SZ;
+	}
+	if(size > CRON_PLYR_LEND_SZ)
+	{
+		size = CRON_PLYR_LEND_SZ;
+	}
+	if(util_rbuff_read(player->in_rb, (void**)&data, size,
+			&read, UTIL_RBUFF_FOREVER) != EOS_ERROR_OK)
+	{
+		/* Leave the consumed buffer, read_pkt will report the error */
+		return;
+	}
+	player->lent = data;
+	player->lent_len = read;
+	/* Same bookkeeping as libav does when it fills the buffer itself */
+	io_ctx->buffer = data;
+	io_ctx->buffer_size = read;
+	io_ctx->buf_ptr = data;
+	io_ctx->buf_end = data + read;
+	io_ctx->pos += read;
+}
+
+static void cron_plyr_return_io(cron_plyr_t* player)
+{
+	if(player->lent != NULL)
+	{
+		util_rbuff_free(player->in_rb, player->lent, player->lent_len);
+		player->lent = NULL;
+		player->lent_len = 0;
+	}
+	if(player->io_own == NULL)
+	{
+		return;
+	}
+	player->io_ctx->buffer = player->io_own;
+	player->io_ctx->buffer_size = player->io_own_size;
+	player->io_ctx->buf_ptr = player->io_own;
+	player->io_ctx->buf_end = player->io_own;
+	player->io_own = NULL;
+	player->io_own_size = 0;
+}
+
 static void cron_plyr_free_pkt(void* msg_data, size_t msg_size)
 {
 	if(msg_data == NULL || msg_size != sizeof(AVPacket))
@@ -1184,11 +1481,103 @@ static void cron_plyr_free_pkt(void* msg_data, size_t msg_size)
 	return;
 }
 
-static void* cron_plyr_probe(void* arg)
+/*
+ * Called from the writer's context after each commit. Only measures the input
+ * bitrate: the buffer is moved by the reader (cron_plyr_inbuff_resize), as a
+ * span lent to the demuxer is outstanding at every commit.
+ */
+static void cron_plyr_inbuff_adapt(cron_plyr_t* player, size_t size)
+{
+	osi_time_t now = {0, 0}, diff = {0, 0};
+	uint64_t elapsed = 0, target = 0;
+
+	if(player->in_target != 0)
+	{
+		return;
+	}
+	if(player->in_bytes == 0)
+	{
+		osi_time_get_timestamp(&player->in_start);
+	}
+	player->in_bytes += size;
+	osi_time_get_timestamp(&now);
+	osi_time_diff(&player->in_start, &now, &diff);
+	OSI_TIME_CONVERT_TO_MSEC(diff, elapsed);
+	if(elapsed < CRON_PLYR_INBUFF_MEASURE_MS)
+	{
+		return;
+	}
+	target = (player->in_bytes * 1000 / elapsed) * CRON_PLYR_INBUFF_SEC;
+	if(target < CRON_PLYR_INBUFF_MIN_SZ)
+	{
+		target = CRON_PLYR_INBUFF_MIN_SZ;
+	}
+	if(target > CRON_PLYR_INBUFF_MAX_SZ)
+	{
+		target = CRON_PLYR_INBUFF_MAX_SZ;
+	}
+	target -= target % 188;
+	UTIL_LOGI(player->log, "Input %llu kbps, buffer %u -> %llu bytes",
+			(unsigned long long)(player->in_bytes * 8 / elapsed),
+			player->in_size, (unsigned long long)target);
+	/* small differences are not worth the copy */
+	if(target > player->in_size - player->in_size / 4 &&
+			target < player->in_size + player->in_size / 4)
+	{
+		target = player->in_size;
+	}
+	player->in_target = (uint32_t)target;
+}
+
+/* Reader side, called with no span lent: only a writer reservation can hold
+ * the resize off, the new block is then kept for the next attempt */
+static void cron_plyr_inbuff_resize(cron_plyr_t* player)
+{
+	uint32_t target = player->in_target;
+	uint32_t fullness = 0;
+	void *old = NULL;
+
+	if(target == 0 || target == player->in_size)
+	{
+		return;
+	}
+	/* when shrinking, wait until the reader drains enough data */
+	if(util_rbuff_get_fullness(player->in_rb, &fullness) != EOS_ERROR_OK ||
+			fullness > target)
+	{
+		return;
+	}
+	if(player->in_spare == NULL &&
+			(player->in_spare = osi_malloc(target)) == NULL)
+	{
+		player->in_target = player->in_size;
+		return;
+	}
+	if(util_rbuff_resize(player->in_rb, player->in_spare, target, &old)
+			== EOS_ERROR_OK)
+	{
+		osi_free(&old);
+		player->in_buff = player->in_spare;
+		player->in_size = target;
+		player->in_spare = NULL;
+		player->in_tries = 0;
+		return;
+	}
+	if(++player->in_tries < CRON_PLYR_INBUFF_TRIES)
+	{
+		return;
+	}
+	UTIL_LOGW(player->log, "Input buffer kept at %u bytes", player->in_size);
+	osi_free((void**)&player->in_spare);
+	player->in_tries = 0;
+	player->in_target = player->in_size;
+}
+
+static void cron_plyr_probe(void* arg)
 {
 	cron_plyr_t* player = (cron_plyr_t*)arg;
-	libav_dmx_pkt_cb_t dmx_cb = {NULL, NULL, NULL};
-	libav_dec_frame_cb_t dec_cb = {NULL, NULL, NULL, NULL};
+	libav_dmx_pkt_cb_t dmx_cb = {NULL, NULL, NULL, NULL};
+	libav_dec_frame_cb_t dec_cb = {NULL, NULL, NULL, NULL, NULL, NULL};
 	osi_time_t start, end, diff;
 	eos_error_t err = EOS_ERROR_OK;
 
@@ -1197,16 +1586,21 @@ static void* cron_plyr_probe(void* arg)
 	{
 		UTIL_LOGE(player->log, "DMX init failed!");
 		cron_plyr_fire_err_ev(player, CRON_PLYR_ERR_GEN);
-		return NULL;
+		return;
 	}
 	osi_time_get_timestamp(&start);
-	err = libav_dmx_probe(&player->dmx, &player->avf_ctx, CRON_PLYR_PROBE_SZ);
+	if((err = cron_plyr_fast_open(player)) != EOS_ERROR_OK)
+	{
+		UTIL_LOGD(player->log, "Fast open not possible (%d), probing", err);
+		err = libav_dmx_probe(&player->dmx, &player->avf_ctx,
+				CRON_PLYR_PROBE_SZ);
+	}
 	if(err != EOS_ERROR_OK)
 	{
 		libav_dmx_deinit(&player->dmx);
 		UTIL_LOGE(player->log, "DMX probe failed!");
 		cron_plyr_fire_err_ev(player, CRON_PLYR_ERR_DMX);
-		return NULL;
+		return;
 	}
 	osi_time_get_timestamp(&end);
 	osi_time_diff(&start, &end, &diff);
@@ -1217,23 +1611,24 @@ static void* cron_plyr_probe(void* arg)
 			player->probe_len, diff.sec, diff.nsec);
 	dmx_cb.handle_a = cron_plyr_dmx_aud;
 	dmx_cb.handle_v = cron_plyr_dmx_vid;
+	dmx_cb.prepare_io = cron_plyr_lend_io;
 	dmx_cb.opaque = player;
 	libav_dmx_setup(&player->dmx, &dmx_cb);
 
 	dec_cb.handle_a = cron_plyr_dec_aud;
 	dec_cb.handle_v = cron_plyr_dec_vid;
 	dec_cb.key_frm = cron_plyr_i_frm;
+	dec_cb.degrade = cron_plyr_vdec_lvl;
+	dec_cb.late = cron_plyr_vdec_late;
 	dec_cb.opaque = player;
 	libav_dec_init(&player->dec, player->aud_queue, player->vid_queue,
 			player->log);
 	libav_dec_setup(&player->dec, &dec_cb);
 
-	player->sync.a_pts = 0.0;
-	player->sync.v_pts = 0.0;
 	player->sync.t_base = 0.0;
 	player->sync.a_start = 0.0;
 	player->sync.v_start = 0.0;
-	player->sync.v_clk_tmt = 0;
+	util_clk_reset(player->clk);
 	osi_mutex_create(&player->sync.lock);
 
 	libav_dmx_start(&player->dmx);
@@ -1241,8 +1636,48 @@ static void* cron_plyr_probe(void* arg)
 	player->stopped = false;
 	cron_plyr_es_start(player, CRON_PLYR_ES_AUD);
 	cron_plyr_es_start(player, CRON_PLYR_ES_VID);
+}
 
-	return NULL;
+static eos_error_t cron_plyr_fast_open(cron_plyr_t* player)
+{
+	libav_dmx_es_t es[2];
+	eos_media_es_t *sel = NULL;
+	uint8_t cnt = 0;
+
+	osi_memset(es, 0, sizeof(es));
+	CRON_PLYR_LOCK(player);
+	if((sel = cron_plyr_get_sel(player, CRON_PLYR_ES_VID)) != NULL)
+	{
+		es[cnt].id = (int)sel->id;
+		es[cnt].type = AVMEDIA_TYPE_VIDEO;
+		es[cnt].width = sel->atr.video.resolution.width;
+		es[cnt].height = sel->atr.video.resolution.height;
+		/* Exact rate keeps 29.97/59.94, whole fps is the fallback */
+		if(sel->atr.video.rate.den != 0)
+		{
+			es[cnt].rate = av_make_q((int)sel->atr.video.rate.num,
+					(int)sel->atr.video.rate.den);
+		}
+		else
+		{
+			es[cnt].rate = av_make_q(sel->atr.video.fps, 1);
+		}
+		cnt++;
+	}
+	if((sel = cron_plyr_get_sel(player, CRON_PLYR_ES_AUD)) != NULL)
+	{
+		es[cnt].id = (int)sel->id;
+		es[cnt].type = AVMEDIA_TYPE_AUDIO;
+		es[cnt].sample_rate = sel->atr.audio.rate;
+		cnt++;
+	}
+	CRON_PLYR_UNLOCK(player);
+	if(cnt == 0)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+
+	return libav_dmx_open(&player->dmx, &player->avf_ctx, es, cnt);
 }
 
 static eos_error_t cron_plyr_dmx_aud(void* opaque, AVPacket* pkt)
@@ -1277,6 +1712,8 @@ static eos_error_t cron_plyr_dmx_vid(void* opaque, AVPacket* pkt)
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
 	AVPacket *packet = NULL;
 	eos_error_t err = EOS_ERROR_OK;
+	AVRational clk_tb = {1, UTIL_CLK_HZ};
+	osi_time_t now;
 
 	if(cron_plyr_get_sel(player, CRON_PLYR_ES_VID) == NULL)
 	{
@@ -1288,6 +1725,13 @@ static eos_error_t cron_plyr_dmx_vid(void* opaque, AVPacket* pkt)
 #endif
 		return EOS_ERROR_OK;
 	}
+	if(player->clk_master == CRON_CLK_EXT && pkt->dts != AV_NOPTS_VALUE)
+	{
+		/* Live input arrives at PCR pace, its time stamps at arrival are the reference */
+		osi_time_get_mono(&now);
+		util_clk_update(player->clk, UTIL_CLK_SRC_EXT,
+				av_rescale_q(pkt->dts, player->sync.v_tb, clk_tb), &now);
+	}
 	packet = osi_calloc(sizeof(AVPacket));
 	*packet = *pkt;
 	err = util_msgq_put(player->vid_queue, packet, sizeof(AVPacket), NULL);
@@ -1299,98 +1743,112 @@ static eos_error_t cron_plyr_dmx_vid(void* opaque, AVPacket* pkt)
 	return err;
 }
 
-/*
- * TODO: SYNC!!!
- */
-
 static eos_error_t cron_plyr_dec_aud(void* opaque, AVFrame* frame)
 {
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
+	AVRational clk_tb = {1, UTIL_CLK_HZ};
+	eos_error_t err = EOS_ERROR_OK;
+	osi_time_t now;
+	uint32_t delay = 0, rate = 0;
+	int64_t pts = 0;
 
-	osi_mutex_lock(player->sync.lock);
-	player->sync.a_pts = frame->pts * player->sync.t_base;
-	osi_mutex_unlock(player->sync.lock);
+	if((err = alsa_aren_play(&player->aren, frame)) != EOS_ERROR_OK)
+	{
+		return err;
+	}
+	if(frame->pts == AV_NOPTS_VALUE || frame->sample_rate <= 0 ||
+			alsa_aren_get_delay(&player->aren, &delay, &rate) != EOS_ERROR_OK ||
+			rate == 0)
+	{
+		return EOS_ERROR_OK;
+	}
+	/* End of this frame is heard once everything queued in ALSA before it is */
+	pts = av_rescale_q(frame->pts, player->sync.a_tb, clk_tb) +
+			av_rescale(frame->nb_samples, UTIL_CLK_HZ, frame->sample_rate) -
+			av_rescale(delay, UTIL_CLK_HZ, rate);
+	osi_time_get_mono(&now);
+	util_clk_update(player->clk, UTIL_CLK_SRC_AUD, pts, &now);
 
-	return alsa_aren_play(&player->aren, frame);
+	return EOS_ERROR_OK;
 }
 
 static eos_error_t cron_plyr_clk_vid(void* opaque, x11_frame_t* frame,
-		uint32_t* micros, osi_time_t* offset)
+		osi_time_t* deadline, bool* drop)
 {
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
-	double aud_buff = 0.0, delta = 0.0;
-	uint32_t s = 0;
-	uint32_t micro_offset = 0;
+	AVRational clk_tb = {1, UTIL_CLK_HZ};
+	util_clk_act_t act = UTIL_CLK_ACT_SHOW;
+	uint32_t dur = player->sync.v_dur;
+	uint32_t max_wait = CRON_PLYR_MAX_WAIT;
+	osi_time_t now;
+	eos_error_t err = EOS_ERROR_OK;
 
-	osi_mutex_lock(player->sync.lock);
-	if(cron_plyr_get_sel(player, CRON_PLYR_ES_AUD) != NULL)
+	if(frame->pts == AV_NOPTS_VALUE)
 	{
-		if(alsa_aren_get_buff_dur(&player->aren, &aud_buff)
-				!= EOS_ERROR_OK)
-		{
-			delta = player->sync.v_clk_tmt;
-		}
-		else
-		{
-			player->sync.v_pts = frame->pts * player->sync.t_base;
-			delta = player->sync.a_pts - aud_buff;
-			delta = player->sync.v_pts - delta;
-		}
+		return EOS_ERROR_INVAL;
 	}
-	else
+	if(dur == 0)
 	{
-		delta = player->sync.v_pts;
-		player->sync.v_pts = frame->pts * player->sync.t_base;
-		delta = player->sync.v_pts - delta;
-
-		osi_mutex_unlock(player->sync.lock);
-
-		s = (uint32_t)OSI_TIME_SEC_TO_USEC(delta);
-		OSI_TIME_CONVERT_TO_USEC((*offset), micro_offset);
-		if(micro_offset > s)
-		{
-			UTIL_LOGWTF(player->log, "We are too slow in scaling: "
-					"sleep %u : offset %u", s, micro_offset);
-			s = 0;
-		}
-		else
-		{
-			s -= micro_offset;
-		}
-		*micros = s;
-
-		return EOS_ERROR_OK;
-
+		dur = CRON_PLYR_DFLT_FRM_DUR;
 	}
-	osi_mutex_unlock(player->sync.lock);
-
-	/* video in front, v pts is smaller */
-	if(delta > 0)
+	if(player->freerun)
 	{
-		s = (uint32_t)OSI_TIME_SEC_TO_USEC(delta);
-		if(s > player->sync.threshold)
-		{
-			s = player->sync.threshold;
-		}
+		/* Start as soon as possible, converge within the sync time */
+		max_wait = (uint32_t)UTIL_CLK_USEC_TO_TICKS(player->sync.threshold);
 	}
-	/* audio in front, v pts is bigger */
-	else
+	util_clk_set_master(player->clk, cron_plyr_clk_src(player));
+	osi_time_get_mono(&now);
+	if((err = util_clk_sched(player->clk,
+			av_rescale_q(frame->pts, player->sync.v_tb, clk_tb), dur, max_wait,
+			&now, deadline, &act)) != EOS_ERROR_OK)
 	{
-		s = 0;
+		return err;
+	}
+	*drop = (act == UTIL_CLK_ACT_DROP);
+	if(*drop == false && player->frm_disp_ev == false)
+	{
+		/* Renderer asks for the deadline right before showing the frame */
+		player->frm_disp_ev = true;
+		cron_plyr_fire_ev(player, CRON_PLYR_EV_FRM_DISP, NULL);
 	}
-
-	*micros = s;
 
 	return EOS_ERROR_OK;
 }
 
+static util_clk_src_t cron_plyr_clk_src(cron_plyr_t* player)
+{
+	switch(player->clk_master)
+	{
+	case CRON_CLK_AUD:
+		return UTIL_CLK_SRC_AUD;
+	case CRON_CLK_VID:
+		return UTIL_CLK_SRC_VID;
+	case CRON_CLK_EXT:
+		return UTIL_CLK_SRC_EXT;
+	default:
+		break;
+	}
+
+	return (cron_plyr_get_sel(player, CRON_PLYR_ES_AUD) != NULL) ?
+			UTIL_CLK_SRC_AUD : UTIL_CLK_SRC_VID;
+}
+
 static eos_error_t cron_plyr_dec_vid(void* opaque, AVFrame* frame)
 {
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
 	x11_frame_t* x11_frm = NULL;
 	eos_error_t err = EOS_ERROR_OK;
 
-	x11_vren_frame_alloc(frame, &x11_frm);
+	if((err = x11_vren_frame_alloc(&player->vren, frame, &x11_frm))
+			!= EOS_ERROR_OK)
+	{
+		if(err == EOS_ERROR_BUSY)
+		{
+			UTIL_LOGW(player->log, "No free render frame, dropping");
+			return EOS_ERROR_OK;
+		}
+		return err;
+	}
 	err = x11_vren_queue(&player->vren, x11_frm);
 
 	if(err != EOS_ERROR_OK)
@@ -1400,6 +1858,37 @@ static eos_error_t cron_plyr_dec_vid(void* opaque, AVFrame* frame)
 	return err;
 }
 
+static libav_dec_thr_t cron_plyr_dec_thr(cron_plyr_t* player, double frm_dur)
+{
+	uint32_t delay = 0;
+
+	switch(player->dec_thr)
+	{
+	case CRON_DEC_THR_FRAME:
+		return LIBAV_DEC_THR_FRAME;
+	case CRON_DEC_THR_SLICE:
+		return LIBAV_DEC_THR_SLICE;
+	case CRON_DEC_THR_OFF:
+		return LIBAV_DEC_THR_OFF;
+	default:
+		break;
+	}
+	/* Every frame thread but the first holds back one picture (rate may be unknown) */
+	if(frm_dur > 0.0 && frm_dur < 1.0)
+	{
+		delay = (uint32_t)((libav_dec_thr_cnt(player->dec_thr_cnt) - 1) *
+				frm_dur * 1000);
+	}
+	if(player->freerun || (player->dec_trshld != 0 && delay > player->dec_trshld))
+	{
+		UTIL_LOGD(player->log, "Low latency decoding (frame threads: +%ums)",
+				delay);
+		return LIBAV_DEC_THR_SLICE;
+	}
+
+	return LIBAV_DEC_THR_FRAME;
+}
+
 static void cron_plyr_i_frm(void* opaque, uint64_t pts)
 {
 	cron_plyr_t* player = (cron_plyr_t*)opaque;
@@ -1409,6 +1898,30 @@ static void cron_plyr_i_frm(void* opaque, uint64_t pts)
 	cron_plyr_fire_ev(player, CRON_PLYR_EV_FRM, &data);
 }
 
+static void cron_plyr_vdec_lvl(void* opaque, libav_dec_lvl_t lvl,
+		uint32_t dropped, uint32_t queued)
+{
+	cron_plyr_t* player = (cron_plyr_t*)opaque;
+	cron_ply_ev_data_t data;
+
+	/* Same order, one to one */
+	data.vdec_lvl.level = (cron_vdec_lvl_t)lvl;
+	data.vdec_lvl.dropped = dropped;
+	data.vdec_lvl.queued = queued;
+	cron_plyr_fire_ev(player, CRON_PLYR_EV_VDEC_LVL, &data);
+}
+
+static uint32_t cron_plyr_vdec_late(void* opaque)
+{
+	cron_plyr_t* player = (cron_plyr_t*)opaque;
+	uint32_t dropped = 0, repeated = 0;
+
+	/* Counted by cron_plyr_clk_vid() as the renderer schedules the frames */
+	util_clk_stats(player->clk, &dropped, &repeated);
+
+	return dropped;
+}
+
 static void cron_plyr_libav_log(void* ptr, int level, const char* fmt,
 		va_list vl)
 {
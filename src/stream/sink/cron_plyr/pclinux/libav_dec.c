@@ -33,8 +33,10 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include "libav_dec.h"
 #include "osi_memory.h"
+#include "osi_time.h"
 #include "eos_types.h"
 
+#include <libavutil/cpu.h>
 
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55,28,1)
 #include <libavutil/frame.h>
@@ -50,8 +52,33 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 		osi_free((void**)&pkt); \
 	} while(0);
 
+/* More threads than this bring nothing (and some decoders warn about it) */
+#define LIBAVDEC_THR_MAX (16)
+
+/* Degradation: late frames before going a level down */
+#define LIBAVDEC_ADAPT_UP (4)
+/* Packets without a late frame that forget the late ones counted so far */
+#define LIBAVDEC_ADAPT_WIN (25)
+/* Packets in a row without a late frame before going a level up */
+#define LIBAVDEC_ADAPT_RCV (100)
+/* Packets to let a level change reach the screen (frames already queued) */
+#define LIBAVDEC_ADAPT_HOLD (25)
+/* Recovery waits up to 2^this times longer when it does not last */
+#define LIBAVDEC_ADAPT_BACKOFF_MAX (3)
+
+#ifndef AV_CODEC_CAP_FRAME_THREADS
+#define AV_CODEC_CAP_FRAME_THREADS CODEC_CAP_FRAME_THREADS
+#define AV_CODEC_CAP_SLICE_THREADS CODEC_CAP_SLICE_THREADS
+#endif
+
 static void* a_dec_thread(void* arg);
 static void* v_dec_thread(void* arg);
+static eos_error_t libav_dec_frm_v(libav_dec_t* dec, uint8_t* frst_key_frm,
+		uint32_t* skipped);
+static void libav_dec_apply_thr(libav_dec_t* dec, AVCodecContext* ctx);
+static void libav_dec_adapt(libav_dec_t* dec);
+static void libav_dec_apply_lvl(libav_dec_t* dec, libav_dec_lvl_t lvl,
+		uint32_t queued);
 
 
 eos_error_t libav_dec_init(libav_dec_t* dec, util_msgq_t* aqueue,
@@ -81,6 +108,49 @@ eos_error_t libav_dec_setup(libav_dec_t* dec, libav_dec_frame_cb_t* cb)
 	return EOS_ERROR_OK;
 }
 
+eos_error_t libav_dec_set_thr(libav_dec_t* dec, libav_dec_thr_t type,
+		uint8_t count)
+{
+	if(dec == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	dec->v_thr = type;
+	dec->v_thr_cnt = count;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t libav_dec_set_adapt(libav_dec_t* dec, bool enable)
+{
+	if(dec == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	dec->v_adapt.on = enable;
+	/* Decoder thread picks it up with the next packet */
+	dec->v_adapt.rst = true;
+
+	return EOS_ERROR_OK;
+}
+
+uint8_t libav_dec_thr_cnt(uint8_t count)
+{
+	int cpus = 0;
+
+	if(count != 0)
+	{
+		return count > LIBAVDEC_THR_MAX ? LIBAVDEC_THR_MAX : count;
+	}
+	cpus = av_cpu_count();
+	if(cpus < 1)
+	{
+		cpus = 1;
+	}
+
+	return cpus > LIBAVDEC_THR_MAX ? LIBAVDEC_THR_MAX : (uint8_t)cpus;
+}
+
 eos_error_t libav_dec_start_aud(libav_dec_t* dec, AVCodecContext* a_codec_ctx)
 {
 	if(dec == NULL || a_codec_ctx == NULL)
@@ -118,6 +188,7 @@ eos_error_t libav_dec_start_vid(libav_dec_t* dec, AVCodecContext* v_codec_ctx)
 	{
 		return EOS_ERROR_INVAL;
 	}
+	libav_dec_apply_thr(dec, v_codec_ctx);
 	if(avcodec_open2(v_codec_ctx, dec->v_codec, NULL) < 0)
 	{
 		return EOS_ERROR_GENERAL;
@@ -322,6 +393,8 @@ eos_error_t libav_dec_flush_vid(libav_dec_t* dec)
 	{
 		avcodec_flush_buffers(dec->v_codec_ctx);
 	}
+	/* New content, the load measured so far says nothing about it */
+	dec->v_adapt.rst = true;
 
 	return err;
 }
@@ -352,6 +425,7 @@ void* a_dec_thread(void* arg)
 		{
 			UTIL_LOGW(dec->log, "First AUD pkt %lld", packet->pts);
 		}
+		got_frame = 0;
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
 		ret = avcodec_send_packet(dec->a_codec_ctx, packet);
 		if(ret < 0)
@@ -361,11 +435,7 @@ void* a_dec_thread(void* arg)
 			LIBAVDEC_FREE_PKT(packet);
 			continue;
 		}
-		ret = avcodec_receive_frame(dec->a_codec_ctx, dec->a_frame);
-		if(ret == 0)
-		{
-			got_frame = true;
-		}
+		got_frame = avcodec_receive_frame(dec->a_codec_ctx, dec->a_frame) == 0;
 #else
 		ret = avcodec_decode_audio4(dec->a_codec_ctx, dec->a_frame, &got_frame, packet);
 		if(ret < 0)
@@ -376,9 +446,15 @@ void* a_dec_thread(void* arg)
 			continue;
 		}
 #endif
-		if(got_frame)
+		/* One packet may hold several frames (or none yet) */
+		while(got_frame)
 		{
 			dec->cb.handle_a(dec->cb.opaque, dec->a_frame);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
+			got_frame = avcodec_receive_frame(dec->a_codec_ctx, dec->a_frame) == 0;
+#else
+			got_frame = 0;
+#endif
 		}
 		pts = packet->pts;
 		LIBAVDEC_FREE_PKT(packet);
@@ -397,6 +473,7 @@ void* v_dec_thread(void* arg)
 	uint8_t frst_key_frm = false;
 	char errbuf[256];
 	uint32_t skipped = 0;
+	eos_error_t err = EOS_ERROR_OK;
 
 	UTIL_LOGI(dec->log, "Video DEC thread started");
 	while(util_msgq_get(dec->vid_queue, (void**)&packet, &sz, NULL) == EOS_ERROR_OK)
@@ -411,6 +488,21 @@ void* v_dec_thread(void* arg)
 			LIBAVDEC_FREE_PKT(packet);
 			break;
 		}
+		if(dec->v_adapt.rst)
+		{
+			dec->v_adapt.rst = false;
+			libav_dec_apply_lvl(dec, LIBAV_DEC_LVL_FULL, 0);
+			dec->v_adapt.late = dec->cb.late != NULL ?
+					dec->cb.late(dec->cb.opaque) : 0;
+			dec->v_adapt.dropped = 0;
+			dec->v_adapt.over = 0;
+			dec->v_adapt.under = 0;
+			dec->v_adapt.hold = LIBAVDEC_ADAPT_HOLD;
+			dec->v_adapt.probe = 0;
+			dec->v_adapt.backoff = 0;
+		}
+		got_frame = 0;
+		err = EOS_ERROR_OK;
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
 		ret = avcodec_send_packet(dec->v_codec_ctx, packet);
 		if(ret < 0)
@@ -420,11 +512,7 @@ void* v_dec_thread(void* arg)
 			LIBAVDEC_FREE_PKT(packet);
 			continue;
 		}
-		ret = avcodec_receive_frame(dec->v_codec_ctx, dec->v_frame);
-		if(ret == 0)
-		{
-			got_frame = true;
-		}
+		got_frame = avcodec_receive_frame(dec->v_codec_ctx, dec->v_frame) == 0;
 #else
 		ret = avcodec_decode_video2(dec->v_codec_ctx, dec->v_frame, &got_frame, packet);
 		if(ret < 0)
@@ -435,38 +523,184 @@ void* v_dec_thread(void* arg)
 			continue;
 		}
 #endif
-		if(got_frame)
+		/*
+		 * Frame threads hand frames out with a delay and skipped ones never come
+		 * out, so it is not one frame per packet. Take whatever is ready.
+		 */
+		while(got_frame)
 		{
-			if(frst_key_frm == false && dec->v_frame->key_frame == 0)
-			{
-				skipped++;
-				LIBAVDEC_FREE_PKT(packet);
-				continue;
-			}
-			if(frst_key_frm == false)
-			{
-				UTIL_LOGI(dec->log, "Found first I-frame (skipped %d)", skipped);
-				frst_key_frm = true;
-			}
-			if(dec->cb.handle_v(dec->cb.opaque, dec->v_frame) != EOS_ERROR_OK)
-			{
-				LIBAVDEC_FREE_PKT(packet);
-				UTIL_LOGW(dec->log, "Video callback returned error -> abandon");
-
-				break;
-			}
-			if(dec->v_frame->key_frame == 1)
-			{
-				if(dec->cb.key_frm != NULL)
-				{
-					dec->cb.key_frm(dec->cb.opaque, dec->v_frame->pts);
-				}
-			}
+			err = libav_dec_frm_v(dec, &frst_key_frm, &skipped);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
+			got_frame = err == EOS_ERROR_OK &&
+					avcodec_receive_frame(dec->v_codec_ctx, dec->v_frame) == 0;
+#else
+			got_frame = 0;
+#endif
 		}
-
+		libav_dec_adapt(dec);
 		LIBAVDEC_FREE_PKT(packet);
+		if(err != EOS_ERROR_OK)
+		{
+			UTIL_LOGW(dec->log, "Video callback returned error -> abandon");
+			break;
+		}
 	}
 	UTIL_LOGI(dec->log, "Video DEC thread exited");
 
 	return NULL;
 }
+
+static eos_error_t libav_dec_frm_v(libav_dec_t* dec, uint8_t* frst_key_frm,
+		uint32_t* skipped)
+{
+	if(*frst_key_frm == false && dec->v_frame->key_frame == 0)
+	{
+		(*skipped)++;
+		return EOS_ERROR_OK;
+	}
+	if(*frst_key_frm == false)
+	{
+		UTIL_LOGI(dec->log, "Found first I-frame (skipped %u)", *skipped);
+		*frst_key_frm = true;
+	}
+	if(dec->cb.handle_v(dec->cb.opaque, dec->v_frame) != EOS_ERROR_OK)
+	{
+		return EOS_ERROR_GENERAL;
+	}
+	if(dec->v_frame->key_frame == 1 && dec->cb.key_frm != NULL)
+	{
+		dec->cb.key_frm(dec->cb.opaque, dec->v_frame->pts);
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static void libav_dec_apply_thr(libav_dec_t* dec, AVCodecContext* ctx)
+{
+	int caps = dec->v_codec->capabilities;
+	int type = 0;
+
+	/* Fall back to what the decoder can do instead of silently running single threaded */
+	if(dec->v_thr == LIBAV_DEC_THR_FRAME)
+	{
+		type = (caps & AV_CODEC_CAP_FRAME_THREADS) ? FF_THREAD_FRAME :
+				((caps & AV_CODEC_CAP_SLICE_THREADS) ? FF_THREAD_SLICE : 0);
+	}
+	else if(dec->v_thr == LIBAV_DEC_THR_SLICE)
+	{
+		type = (caps & AV_CODEC_CAP_SLICE_THREADS) ? FF_THREAD_SLICE :
+				((caps & AV_CODEC_CAP_FRAME_THREADS) ? FF_THREAD_FRAME : 0);
+	}
+	if(type == 0)
+	{
+		ctx->thread_count = 1;
+		UTIL_LOGI(dec->log, "%s: single threaded", dec->v_codec->name);
+		return;
+	}
+	ctx->thread_type = type;
+	ctx->thread_count = libav_dec_thr_cnt(dec->v_thr_cnt);
+	UTIL_LOGI(dec->log, "%s: %d %s threads", dec->v_codec->name,
+			ctx->thread_count, type == FF_THREAD_FRAME ? "frame" : "slice");
+}
+
+static void libav_dec_apply_lvl(libav_dec_t* dec, libav_dec_lvl_t lvl,
+		uint32_t queued)
+{
+	AVCodecContext *ctx = dec->v_codec_ctx;
+	libav_dec_lvl_t old = dec->v_adapt.lvl;
+
+	/* Read per frame, frame threads get them with the next packet */
+	ctx->skip_loop_filter = lvl >= LIBAV_DEC_LVL_NO_LPF ?
+			AVDISCARD_ALL : AVDISCARD_DEFAULT;
+	switch(lvl)
+	{
+	case LIBAV_DEC_LVL_NO_NREF:
+		ctx->skip_frame = AVDISCARD_NONREF;
+		break;
+	case LIBAV_DEC_LVL_KEY:
+		ctx->skip_frame = AVDISCARD_NONKEY;
+		break;
+	default:
+		ctx->skip_frame = AVDISCARD_DEFAULT;
+		break;
+	}
+	dec->v_adapt.lvl = lvl;
+	if(lvl == old)
+	{
+		return;
+	}
+	UTIL_LOGI(dec->log, "Video decoding level %d -> %d (%u late frames, "
+			"%u queued)", old, lvl, dec->v_adapt.dropped, queued);
+	if(dec->cb.degrade != NULL)
+	{
+		dec->cb.degrade(dec->cb.opaque, lvl, dec->v_adapt.dropped, queued);
+	}
+	dec->v_adapt.dropped = 0;
+}
+
+static void libav_dec_adapt(libav_dec_t* dec)
+{
+	libav_dec_adapt_t *ad = &dec->v_adapt;
+	uint32_t late = 0, dropped = 0, queued = 0;
+
+	if(ad->on == false || dec->cb.late == NULL)
+	{
+		return;
+	}
+	/* Frames handed over so far had their turn at the clock */
+	late = dec->cb.late(dec->cb.opaque);
+	dropped = late >= ad->late ? late - ad->late : late;
+	ad->late = late;
+	ad->dropped += dropped;
+	util_msgq_count(dec->vid_queue, &queued);
+	/*
+	 * Late frames close together mean the decoder is behind, a single one
+	 * now and then (a hiccup elsewhere) is forgotten after a while.
+	 */
+	if(dropped != 0)
+	{
+		ad->over += dropped;
+		ad->under = 0;
+	}
+	else if(++ad->under >= LIBAVDEC_ADAPT_WIN)
+	{
+		ad->over = 0;
+	}
+	if(ad->probe != 0)
+	{
+		/* Recovery held, next one may come sooner */
+		if(--ad->probe == 0 && ad->backoff != 0)
+		{
+			ad->backoff--;
+		}
+	}
+	if(ad->hold != 0)
+	{
+		/* Still those decoded before the change */
+		ad->hold--;
+		ad->over = 0;
+		return;
+	}
+	if(ad->over >= LIBAVDEC_ADAPT_UP && ad->lvl < LIBAV_DEC_LVL_KEY)
+	{
+		if(ad->probe != 0 && ad->backoff < LIBAVDEC_ADAPT_BACKOFF_MAX)
+		{
+			ad->backoff++;
+		}
+		libav_dec_apply_lvl(dec, ad->lvl + 1, queued);
+		ad->over = 0;
+		ad->under = 0;
+		ad->probe = 0;
+		ad->hold = LIBAVDEC_ADAPT_HOLD;
+	}
+	else if(ad->under >= ((uint32_t)LIBAVDEC_ADAPT_RCV << ad->backoff) &&
+			ad->lvl > LIBAV_DEC_LVL_FULL)
+	{
+		libav_dec_apply_lvl(dec, ad->lvl - 1, queued);
+		ad->over = 0;
+		ad->under = 0;
+		/* Going back down within this many packets means it came too early */
+		ad->probe = LIBAVDEC_ADAPT_RCV;
+		ad->hold = LIBAVDEC_ADAPT_HOLD;
+	}
+}
@@ -41,14 +41,54 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include <libavformat/avformat.h>
 
+typedef enum libav_dec_thr
+{
+	LIBAV_DEC_THR_OFF = 0,
+	LIBAV_DEC_THR_FRAME,
+	LIBAV_DEC_THR_SLICE
+} libav_dec_thr_t;
+
+/* Video decoding quality, lowered while the decoder cannot keep up */
+typedef enum libav_dec_lvl
+{
+	LIBAV_DEC_LVL_FULL = 0, /* Everything decoded */
+	LIBAV_DEC_LVL_NO_LPF,   /* Loop (deblocking) filter skipped */
+	LIBAV_DEC_LVL_NO_NREF,  /* Non-reference frames skipped as well */
+	LIBAV_DEC_LVL_KEY,      /* Key frames only */
+	LIBAV_DEC_LVL_CNT
+} libav_dec_lvl_t;
+
 typedef struct libav_dec_frame_cb
 {
 	eos_error_t (*handle_a)(void* opaque, AVFrame* a_frame);
 	eos_error_t (*handle_v)(void* opaque, AVFrame* v_frame);
 	void (*key_frm)(void* opaque, uint64_t pts);
+	void (*degrade)(void* opaque, libav_dec_lvl_t lvl, uint32_t dropped,
+			uint32_t queued);
+	/* Frames dropped so far for being late on screen (may restart from 0) */
+	uint32_t (*late)(void* opaque);
 	void *opaque;
 } libav_dec_frame_cb_t;
 
+/*
+ * Level is driven by frames the renderer drops as late, not by how long
+ * decoding calls take: with frame threads those block on the renderer as
+ * much as on the decoder, only late frames tell it is really behind.
+ */
+typedef struct libav_dec_adapt
+{
+	bool on;
+	bool rst;
+	libav_dec_lvl_t lvl;
+	uint32_t late;     /* late count last seen */
+	uint32_t dropped;  /* late frames since the last level change */
+	uint32_t over;
+	uint32_t under;
+	uint32_t hold;
+	uint32_t probe;
+	uint8_t backoff;
+} libav_dec_adapt_t;
+
 typedef struct libav_dec
 {
 	osi_thread_t *a_thread;
@@ -64,12 +104,19 @@ typedef struct libav_dec
 	util_msgq_t *vid_queue;
 	bool a_finish;
 	bool v_finish;
+	libav_dec_thr_t v_thr;
+	uint8_t v_thr_cnt;
+	libav_dec_adapt_t v_adapt;
 	util_log_t *log;
 } libav_dec_t;
 
 eos_error_t libav_dec_init(libav_dec_t* dec, util_msgq_t* aqueue,
 		util_msgq_t* vqueue, util_log_t *log);
 eos_error_t libav_dec_setup(libav_dec_t* dec, libav_dec_frame_cb_t* cb);
+eos_error_t libav_dec_set_thr(libav_dec_t* dec, libav_dec_thr_t type,
+		uint8_t count);
+uint8_t libav_dec_thr_cnt(uint8_t count);
+eos_error_t libav_dec_set_adapt(libav_dec_t* dec, bool enable);
 eos_error_t libav_dec_start_aud(libav_dec_t* dec, AVCodecContext* a_codec_ctx);
 eos_error_t libav_dec_start_vid(libav_dec_t* dec, AVCodecContext* v_codec_ctx);
 eos_error_t libav_dec_stop_aud(libav_dec_t* dec);
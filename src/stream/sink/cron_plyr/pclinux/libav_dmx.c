@@ -35,6 +35,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "osi_memory.h"
 #include "osi_time.h"
 #include "eos_types.h"
+#include "eos_macro.h"
 
 #ifdef MODULE_NAME
 #undef MODULE_NAME
@@ -62,7 +63,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 static eos_error_t libav_dmx_open_avf(libav_dmx_t* dmx);
 static void* libav_dmx_thread(void* arg);
+static int libav_dmx_read(libav_dmx_t* dmx);
 static eos_error_t libav_dmx_check_probe(AVFormatContext* avf_ctx);
+static AVStream* libav_dmx_find_stream(AVFormatContext* avf_ctx, int id);
 
 eos_error_t libav_dmx_init(libav_dmx_t* dmx, AVIOContext* io_ctx, util_log_t* log)
 {
@@ -122,6 +125,71 @@ eos_error_t libav_dmx_probe(libav_dmx_t* dmx, AVFormatContext** avf_ctx, uint32_
 	return EOS_ERROR_OK;
 }
 
+eos_error_t libav_dmx_open(libav_dmx_t* dmx, AVFormatContext** avf_ctx,
+		libav_dmx_es_t* es, uint8_t es_cnt)
+{
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57,48,101)
+	AVStream *st = NULL;
+	uint8_t i = 0;
+
+	if(dmx == NULL || avf_ctx == NULL || es == NULL || es_cnt == 0)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	*avf_ctx = NULL;
+	/* Check everything first, so that probing can still follow on a clean context */
+	for(i=0; i<es_cnt; i++)
+	{
+		/* Codec comes from the PMT, an ES that libav could not map needs probing */
+		if((st = libav_dmx_find_stream(dmx->avf_ctx, es[i].id)) == NULL ||
+				st->codecpar->codec_type != es[i].type ||
+				st->codecpar->codec_id == AV_CODEC_ID_NONE)
+		{
+			UTIL_LOGD(dmx->log, "ES 0x%x not matched in PMT", es[i].id);
+			return EOS_ERROR_NFOUND;
+		}
+		if(es[i].type == AVMEDIA_TYPE_VIDEO &&
+				(es[i].width == 0 || es[i].height == 0 || es[i].rate.num == 0 ||
+				es[i].rate.den == 0))
+		{
+			UTIL_LOGD(dmx->log, "ES 0x%x video params unknown", es[i].id);
+			return EOS_ERROR_NFOUND;
+		}
+	}
+	for(i=0; i<es_cnt; i++)
+	{
+		st = libav_dmx_find_stream(dmx->avf_ctx, es[i].id);
+		if(st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+		{
+			st->codecpar->width = es[i].width;
+			st->codecpar->height = es[i].height;
+			/* Renderer follows the decoded frames, this is only a starting point */
+			if(st->codecpar->format < 0)
+			{
+				st->codecpar->format = AV_PIX_FMT_YUV420P;
+			}
+			st->r_frame_rate = es[i].rate;
+			st->avg_frame_rate = st->r_frame_rate;
+		}
+		else if(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+				es[i].sample_rate != 0)
+		{
+			st->codecpar->sample_rate = es[i].sample_rate;
+		}
+	}
+	*avf_ctx = dmx->avf_ctx;
+
+	return EOS_ERROR_OK;
+#else
+	EOS_UNUSED(dmx);
+	EOS_UNUSED(avf_ctx);
+	EOS_UNUSED(es);
+	EOS_UNUSED(es_cnt);
+
+	return EOS_ERROR_NIMPLEMENTED;
+#endif
+}
+
 eos_error_t libav_dmx_set_aud(libav_dmx_t* dmx, int32_t aud_idx)
 {
 	eos_error_t err = EOS_ERROR_OK;
@@ -328,7 +396,7 @@ void* libav_dmx_thread(void* arg)
 
 	UTIL_LOGI(dmx->log, "Starting DMX thread");
 	osi_memset(&dmx->packet, 0, sizeof(AVPacket));
-	while(av_read_frame(dmx->avf_ctx, &dmx->packet) == 0)
+	while(libav_dmx_read(dmx) == 0)
 	{
 		if((err = osi_mutex_lock(dmx->lock)) != EOS_ERROR_OK)
 		{
@@ -385,11 +453,37 @@ void* libav_dmx_thread(void* arg)
 	return NULL;
 }
 
+static int libav_dmx_read(libav_dmx_t* dmx)
+{
+	if(dmx->cb.prepare_io != NULL)
+	{
+		dmx->cb.prepare_io(dmx->cb.opaque, dmx->io_ctx);
+	}
+
+	return av_read_frame(dmx->avf_ctx, &dmx->packet);
+}
+
+static AVStream* libav_dmx_find_stream(AVFormatContext* avf_ctx, int id)
+{
+	int i = 0;
+
+	for(i = 0; i < (int)avf_ctx->nb_streams; i++)
+	{
+		if(avf_ctx->streams[i]->id == id)
+		{
+			return avf_ctx->streams[i];
+		}
+	}
+
+	return NULL;
+}
+
 static eos_error_t libav_dmx_check_probe(AVFormatContext* avf_ctx)
 {
 	bool aud = false, vid = false;
+	int i = 0;
 
-	for(int i = 0; i < (int)avf_ctx->nb_streams; i++)
+	for(i = 0; i < (int)avf_ctx->nb_streams; i++)
 	{
 		if(avf_ctx->streams[i]->codecpar->codec_type
 				== AVMEDIA_TYPE_VIDEO)
@@ -46,14 +46,28 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define LIBAV_DMX_IDX_NA (-1)
 
 typedef eos_error_t (*handle_dmx_data_t)(void* opaque, AVPacket* a_pkt);
+/* Called before every frame read, so the owner can (re)fill the AVIO buffer in place */
+typedef void (*prepare_dmx_io_t)(void* opaque, AVIOContext* io_ctx);
 
 typedef struct libav_dmx_frame_cb
 {
 	handle_dmx_data_t handle_a;
 	handle_dmx_data_t handle_v;
 	void *opaque;
+	prepare_dmx_io_t prepare_io;
 } libav_dmx_pkt_cb_t;
 
+/* Stream parameters known up front (e.g. from the PMT), used instead of probing */
+typedef struct libav_dmx_es
+{
+	int id;
+	enum AVMediaType type;
+	uint16_t width;
+	uint16_t height;
+	AVRational rate;
+	uint32_t sample_rate;
+} libav_dmx_es_t;
+
 typedef struct libav_dmx
 {
 	osi_thread_t *t;
@@ -73,6 +87,8 @@ typedef struct libav_dmx
 
 eos_error_t libav_dmx_init(libav_dmx_t* dmx, AVIOContext* io_ctx, util_log_t* log);
 eos_error_t libav_dmx_probe(libav_dmx_t* dmx, AVFormatContext** avf_ctx, uint32_t max_size);
+eos_error_t libav_dmx_open(libav_dmx_t* dmx, AVFormatContext** avf_ctx,
+		libav_dmx_es_t* es, uint8_t es_cnt);
 eos_error_t libav_dmx_setup(libav_dmx_t* dmx, libav_dmx_pkt_cb_t* cb);
 eos_error_t libav_dmx_set_aud(libav_dmx_t* dmx, int32_t aud_idx);
 eos_error_t libav_dmx_set_vid(libav_dmx_t* dmx, int32_t vid_idx);
@@ -37,23 +37,39 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "util_log.h"
 
 #include <X11/Xutil.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 #define X11_VREN_WIDTH  (1920)
 #define X11_VREN_HEIGHT (1080)
-#define X11_FRAME_CNT   (50)
 
 #define X11_VREN_DEST_PIX_FMT (AV_PIX_FMT_RGB32)
 #define X11_VREN_SWS_FLG (SWS_BICUBIC)
+/* Xv gets the planes at source size, the adaptor does the scaling */
+#define X11_VREN_XV_PIX_FMT (AV_PIX_FMT_YUV420P)
+#define X11_VREN_FOURCC_I420 (0x30323449)
+#define X11_VREN_FOURCC_YV12 (0x32315659)
 
 static Display *disp = NULL;
 static Window root = 0;
 static XWindowAttributes root_attr;
+static volatile int x11_err = 0;
 
 
 static XImage* get_ximg(Display* d, Visual* v, int width, int height);
 static void set_fullscr(Window win);
 static void frame_free_cbk(void* msg_data, size_t msg_size);
 static void* render_thread(void* arg);
+static eos_error_t pool_create(x11_vren_t* vren);
+static void pool_destroy(x11_vren_t* vren);
+static eos_error_t out_open(x11_vren_t* vren);
+static void out_close(x11_vren_t* vren);
+static eos_error_t sws_update(x11_vren_t* vren);
+static eos_error_t xv_port_grab(x11_vren_t* vren);
+static eos_error_t xv_img_create(x11_vren_t* vren);
+static void xv_img_destroy(x11_vren_t* vren);
+static eos_error_t shm_attach(XShmSegmentInfo* shm, size_t size);
+static void shm_detach(XShmSegmentInfo* shm);
 
 eos_error_t x11_vren_sys_init(void)
 {
@@ -135,7 +151,12 @@ eos_error_t x11_vren_init(x11_vren_t* vren, uint16_t w, uint16_t h, uint16_t x,
 		vren->dst_h = h;
 	}
 	vren->pix_fmt = pix_fmt;
+	vren->log = log;
 
+	if((err = pool_create(vren)) != EOS_ERROR_OK)
+	{
+		goto cleanup;
+	}
 	if((err = osi_mutex_create(&vren->lock)) != EOS_ERROR_OK)
 	{
 		goto cleanup;
@@ -164,17 +185,14 @@ eos_error_t x11_vren_init(x11_vren_t* vren, uint16_t w, uint16_t h, uint16_t x,
 	vren->db = XdbeAllocateBackBufferName(disp, vren->win, XdbeBackground);
 	UTIL_GLOGD("Created Window: %d", vren->win);
 
-	vren->ximg = get_ximg(disp, root_attr.visual, root_attr.width,
-			root_attr.height);
-	if(vren->ximg == NULL)
+	if((err = out_open(vren)) != EOS_ERROR_OK)
+	{
+		goto cleanup;
+	}
+	if((err = sws_update(vren)) != EOS_ERROR_OK)
 	{
-		err = EOS_ERROR_NOMEM;
 		goto cleanup;
 	}
-	vren->sws_ctx = sws_getCachedContext(NULL, vren->src_w, vren->src_h, pix_fmt,
-			vren->dst_w, vren->dst_h, X11_VREN_DEST_PIX_FMT, X11_VREN_SWS_FLG,
-			NULL, NULL, NULL);
-
 
 	return EOS_ERROR_OK;
 
@@ -191,9 +209,9 @@ cleanup:
 	{
 		XFreeGC(disp, vren->gc);
 	}
-	if(vren->ximg)
+	out_close(vren);
+	if(vren->db)
 	{
-		XDestroyImage(vren->ximg);
 		XdbeDeallocateBackBufferName(disp, vren->db);
 	}
 	if(vren->win)
@@ -205,6 +223,7 @@ cleanup:
 	{
 		sws_freeContext(vren->sws_ctx);
 	}
+	pool_destroy(vren);
 
 	return err;
 }
@@ -235,9 +254,12 @@ eos_error_t x11_vren_deinit(x11_vren_t* vren)
 	osi_thread_release(&vren->thread);
 	osi_mutex_lock(vren->lock);
 	sws_freeContext(vren->sws_ctx);
-	XPutImage(disp, XDefaultRootWindow(disp), vren->gc, vren->ximg, 0, 0, 0, 0,
-			vren->ximg->width, vren->ximg->height);
-	XDestroyImage(vren->ximg);
+	if(vren->ximg)
+	{
+		XPutImage(disp, XDefaultRootWindow(disp), vren->gc, vren->ximg, 0, 0, 0, 0,
+				vren->ximg->width, vren->ximg->height);
+	}
+	out_close(vren);
 	XFreeGC(disp, vren->gc);
 	XdbeDeallocateBackBufferName(disp, vren->db);
 	XUnmapWindow(disp, vren->win);
@@ -245,6 +267,7 @@ eos_error_t x11_vren_deinit(x11_vren_t* vren)
 	util_msgq_destroy(&vren->queue);
 	osi_mutex_unlock(vren->lock);
 	osi_mutex_destroy(&vren->lock);
+	pool_destroy(vren);
 
 	return EOS_ERROR_OK;
 }
@@ -298,9 +321,53 @@ eos_error_t x11_vren_prepare(x11_vren_t* vren, x11_frame_t *v_frame)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	sws_scale(vren->sws_ctx, (const uint8_t **)v_frame->data,
-			v_frame->linesize, 0, vren->src_h,
-			(uint8_t* const *)&vren->ximg->data, &vren->ximg->bytes_per_line);
+	/* Source may have been opened without probing, follow what decoder delivers */
+	if(v_frame->width != vren->src_w || v_frame->height != vren->src_h ||
+			v_frame->format != vren->pix_fmt)
+	{
+		UTIL_LOGI(vren->log, "Source changed %ux%u (%d) -> %ux%u (%d)",
+				vren->src_w, vren->src_h, vren->pix_fmt, v_frame->width,
+				v_frame->height, v_frame->format);
+		vren->src_w = v_frame->width;
+		vren->src_h = v_frame->height;
+		vren->pix_fmt = v_frame->format;
+		if(vren->out == X11_VREN_OUT_XV)
+		{
+			xv_img_destroy(vren);
+			if(xv_img_create(vren) != EOS_ERROR_OK)
+			{
+				return EOS_ERROR_NOMEM;
+			}
+		}
+		if(sws_update(vren) != EOS_ERROR_OK)
+		{
+			return EOS_ERROR_GENERAL;
+		}
+	}
+	if(vren->out == X11_VREN_OUT_XV)
+	{
+		uint8_t *planes[3];
+		int pitches[3];
+		/* I420 carries U before V, YV12 the other way around */
+		int u = (vren->xv_fmt == X11_VREN_FOURCC_I420) ? 1 : 2;
+		int v = (vren->xv_fmt == X11_VREN_FOURCC_I420) ? 2 : 1;
+
+		planes[0] = (uint8_t*)vren->xvimg->data + vren->xvimg->offsets[0];
+		planes[1] = (uint8_t*)vren->xvimg->data + vren->xvimg->offsets[u];
+		planes[2] = (uint8_t*)vren->xvimg->data + vren->xvimg->offsets[v];
+		pitches[0] = vren->xvimg->pitches[0];
+		pitches[1] = vren->xvimg->pitches[u];
+		pitches[2] = vren->xvimg->pitches[v];
+		/* Same size, so for YUV420P sources this is a plain plane copy */
+		sws_scale(vren->sws_ctx, (const uint8_t **)v_frame->data,
+				v_frame->linesize, 0, vren->src_h, planes, pitches);
+	}
+	else
+	{
+		sws_scale(vren->sws_ctx, (const uint8_t **)v_frame->data,
+				v_frame->linesize, 0, vren->src_h,
+				(uint8_t* const *)&vren->ximg->data, &vren->ximg->bytes_per_line);
+	}
 
 	return EOS_ERROR_OK;
 }
@@ -310,16 +377,50 @@ eos_error_t x11_vren_show(x11_vren_t* vren)
 	XdbeSwapInfo swap_info[1] = {{vren->win, XdbeBackground}};
 	int err = 0;
 
+	if(vren->out == X11_VREN_OUT_XV)
+	{
+		/* Adaptor scales to the window, no back buffer involved */
+		if(vren->shm.shmaddr != NULL)
+		{
+			XvShmPutImage(disp, vren->xv_port, vren->win, vren->gc, vren->xvimg,
+					0, 0, vren->src_w, vren->src_h, 0, 0, vren->dst_w, vren->dst_h,
+					False);
+			/* Segment is reused by the next prepare, wait for the server */
+			XSync(disp, False);
+		}
+		else
+		{
+			XvPutImage(disp, vren->xv_port, vren->win, vren->gc, vren->xvimg,
+					0, 0, vren->src_w, vren->src_h, 0, 0, vren->dst_w, vren->dst_h);
+			XFlush(disp);
+		}
+		return EOS_ERROR_OK;
+	}
 	XdbeBeginIdiom(disp);
-	XPutImage(disp, vren->db, vren->gc, vren->ximg, 0, 0, 0, 0,
-			vren->ximg->width, vren->ximg->height);
+	if(vren->out == X11_VREN_OUT_SHM)
+	{
+		XShmPutImage(disp, vren->db, vren->gc, vren->ximg, 0, 0, 0, 0,
+				vren->dst_w, vren->dst_h, False);
+	}
+	else
+	{
+		XPutImage(disp, vren->db, vren->gc, vren->ximg, 0, 0, 0, 0,
+				vren->ximg->width, vren->ximg->height);
+	}
 	XdbeEndIdiom(disp);
 	if((err = XdbeSwapBuffers(disp, swap_info, 1)) == 0)
 	{
 		UTIL_GLOGE("Rendering failed with %d", err);
 		return EOS_ERROR_GENERAL;
 	}
-	XFlush(disp);
+	if(vren->out == X11_VREN_OUT_SHM)
+	{
+		XSync(disp, False);
+	}
+	else
+	{
+		XFlush(disp);
+	}
 
 	return EOS_ERROR_OK;
 }
@@ -345,6 +446,8 @@ eos_error_t x11_vren_move(x11_vren_t* vren, uint16_t x, uint16_t y)
 eos_error_t x11_vren_scale(x11_vren_t* vren,
 		uint16_t w, uint16_t h)
 {
+	eos_error_t err = EOS_ERROR_OK;
+
 	if(vren == NULL)
 	{
 		return EOS_ERROR_INVAL;
@@ -357,15 +460,12 @@ eos_error_t x11_vren_scale(x11_vren_t* vren,
 	osi_mutex_lock(vren->lock);
 	XResizeWindow(disp, vren->win, w, h);
 	XFlush(disp);
-	sws_freeContext(vren->sws_ctx);
 	vren->dst_w = w;
 	vren->dst_h = h;
-	vren->sws_ctx = sws_getCachedContext(NULL, vren->src_w, vren->src_h, vren->pix_fmt,
-			w, h, X11_VREN_DEST_PIX_FMT, X11_VREN_SWS_FLG,
-			NULL, NULL, NULL);
+	err = sws_update(vren);
 	osi_mutex_unlock(vren->lock);
 
-	return EOS_ERROR_OK;
+	return err;
 }
 
 static XImage* get_ximg(Display* d, Visual* v, int width, int height)
@@ -418,8 +518,8 @@ static void* render_thread(void* arg)
 	x11_vren_t *vren = (x11_vren_t*) arg;
 	size_t sz = 0;
 	x11_frame_t* frame = NULL;
-	uint32_t micros = 0;
-	osi_time_t start, end, offset;
+	osi_time_t deadline;
+	bool drop = false;
 
 	UTIL_LOGD(vren->log, "Renderer thread started");
 	while(util_msgq_get(vren->queue, (void**)&frame, &sz, NULL) == EOS_ERROR_OK)
@@ -430,21 +530,26 @@ static void* render_thread(void* arg)
 			continue;
 		}
 		osi_mutex_lock(vren->lock);
-		if(osi_time_get_timestamp(&start) != EOS_ERROR_OK)
+		drop = false;
+		if(vren->clk_cbk(vren->clk_opaque, frame, &deadline, &drop)
+				!= EOS_ERROR_OK)
 		{
-			UTIL_LOGW(vren->log, "Start timestamp get failed!!");
+			/* No clock, show it as soon as it is ready */
+			osi_time_get_mono(&deadline);
 		}
-		if(x11_vren_prepare(vren, frame) != EOS_ERROR_OK)
+		if(drop)
 		{
-			UTIL_LOGW(vren->log, "VREN prepare failed!!!");
+			/* Late frame is not even converted */
+			x11_vren_frame_free(&frame);
+			osi_mutex_unlock(vren->lock);
+			continue;
 		}
-		if(osi_time_get_timestamp(&end) != EOS_ERROR_OK)
+		if(x11_vren_prepare(vren, frame) != EOS_ERROR_OK)
 		{
-			UTIL_LOGW(vren->log, "End timestamp get failed!!");
+			UTIL_LOGW(vren->log, "VREN prepare failed!!!");
 		}
-		osi_time_diff(&start, &end, &offset);
-		vren->clk_cbk(vren->clk_opaque, frame, &micros, &offset);
-		osi_time_usleep(micros);
+		/* Conversion time is already accounted for by the absolute deadline */
+		osi_time_sleep_until(&deadline);
 		x11_vren_show(vren);
 		x11_vren_frame_free(&frame);
 		osi_mutex_unlock(vren->lock);
@@ -454,32 +559,42 @@ static void* render_thread(void* arg)
 	return NULL;
 }
 
-eos_error_t x11_vren_frame_alloc(AVFrame *av, x11_frame_t** frame)
+eos_error_t x11_vren_frame_alloc(x11_vren_t* vren, AVFrame *av, x11_frame_t** frame)
 {
 	x11_frame_t* tmp = NULL;
-	uint8_t shift = 0;
+	int i = 0;
 
-	if(av == NULL || frame == NULL)
+	if(vren == NULL || vren->queue == NULL || av == NULL || frame == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
-	tmp = osi_calloc(sizeof(x11_frame_t));
+	*frame = NULL;
+	for(i=0; i<X11_VREN_POOL_SZ; i++)
+	{
+		if(__sync_bool_compare_and_swap(&vren->pool[i].used, 0, 1))
+		{
+			tmp = &vren->pool[i];
+			break;
+		}
+	}
 	if(tmp == NULL)
 	{
-		*frame = NULL;
+		return EOS_ERROR_BUSY;
+	}
+	/* Decoder buffers are reference counted, keep the picture instead of copying it */
+	if(av_frame_ref(tmp->av, av) < 0)
+	{
+		__sync_lock_release(&tmp->used);
 		return EOS_ERROR_NOMEM;
 	}
 	tmp->pts = av->pts;
-	for(int i=0; i<AV_NUM_DATA_POINTERS; i++)
+	tmp->width = (uint16_t)av->width;
+	tmp->height = (uint16_t)av->height;
+	tmp->format = (enum AVPixelFormat)av->format;
+	for(i=0; i<AV_NUM_DATA_POINTERS; i++)
 	{
-		if(av->data[i] == NULL)
-		{
-			break;
-		}
-		shift = i == 0 ? 0 : 1;
-		tmp->data[i] = osi_calloc((av->linesize[i] * av->height >> shift) + 8);
-		osi_memcpy(tmp->data[i], av->data[i], av->linesize[i] * av->height  >> shift);
-		tmp->linesize[i] = av->linesize[i];
+		tmp->data[i] = tmp->av->data[i];
+		tmp->linesize[i] = tmp->av->linesize[i];
 	}
 	*frame = tmp;
 
@@ -500,15 +615,293 @@ eos_error_t x11_vren_frame_free(x11_frame_t** frame)
 		return EOS_ERROR_INVAL;
 	}
 	tmp = *frame;
-	for(int i=0; i<AV_NUM_DATA_POINTERS; i++)
+	av_frame_unref(tmp->av);
+	osi_memset(tmp->data, 0, sizeof(tmp->data));
+	__sync_lock_release(&tmp->used);
+	*frame = NULL;
+
+	return EOS_ERROR_OK;
+}
+
+static eos_error_t pool_create(x11_vren_t* vren)
+{
+	int i = 0;
+
+	for(i=0; i<X11_VREN_POOL_SZ; i++)
 	{
-		if(tmp->data[i] == NULL)
+		vren->pool[i].used = 0;
+		if((vren->pool[i].av = av_frame_alloc()) == NULL)
 		{
-			break;
+			return EOS_ERROR_NOMEM;
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static void pool_destroy(x11_vren_t* vren)
+{
+	int i = 0;
+
+	/* Frames are all back by now (queue is destroyed and render thread joined) */
+	for(i=0; i<X11_VREN_POOL_SZ; i++)
+	{
+		if(vren->pool[i].av != NULL)
+		{
+			av_frame_free(&vren->pool[i].av);
+		}
+	}
+}
+
+static eos_error_t out_open(x11_vren_t* vren)
+{
+	int major = 0, minor = 0;
+	Bool pixmaps = False;
+	size_t size = 0;
+
+	if(xv_port_grab(vren) == EOS_ERROR_OK)
+	{
+		if(xv_img_create(vren) == EOS_ERROR_OK)
+		{
+			vren->out = X11_VREN_OUT_XV;
+			UTIL_LOGI(vren->log, "Output: Xv (port %lu, %s)", vren->xv_port,
+					vren->shm.shmaddr != NULL ? "shared" : "copied");
+			return EOS_ERROR_OK;
+		}
+		XvUngrabPort(disp, vren->xv_port, CurrentTime);
+		vren->xv_port = 0;
+	}
+	if(XShmQueryVersion(disp, &major, &minor, &pixmaps) == True)
+	{
+		vren->ximg = XShmCreateImage(disp, root_attr.visual, 24, ZPixmap, NULL,
+				&vren->shm, root_attr.width, root_attr.height);
+		if(vren->ximg != NULL)
+		{
+			size = vren->ximg->bytes_per_line * vren->ximg->height;
+			if(shm_attach(&vren->shm, size) == EOS_ERROR_OK)
+			{
+				vren->ximg->data = vren->shm.shmaddr;
+				vren->out = X11_VREN_OUT_SHM;
+				UTIL_LOGI(vren->log, "Output: MIT-SHM %d.%d", major, minor);
+				return EOS_ERROR_OK;
+			}
+			XDestroyImage(vren->ximg);
+			vren->ximg = NULL;
 		}
-		osi_free((void**)&tmp->data[i]);
 	}
-	osi_free((void**)frame);
+	vren->ximg = get_ximg(disp, root_attr.visual, root_attr.width,
+			root_attr.height);
+	if(vren->ximg == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	vren->out = X11_VREN_OUT_PLAIN;
+	UTIL_LOGI(vren->log, "Output: XPutImage");
+
+	return EOS_ERROR_OK;
+}
+
+static void out_close(x11_vren_t* vren)
+{
+	if(vren->xv_port)
+	{
+		xv_img_destroy(vren);
+		XvUngrabPort(disp, vren->xv_port, CurrentTime);
+		vren->xv_port = 0;
+	}
+	if(vren->ximg)
+	{
+		if(vren->out == X11_VREN_OUT_SHM)
+		{
+			shm_detach(&vren->shm);
+			/* Shared segment is gone, keep Xlib from freeing it */
+			vren->ximg->data = NULL;
+		}
+		XDestroyImage(vren->ximg);
+		vren->ximg = NULL;
+	}
+}
+
+static eos_error_t sws_update(x11_vren_t* vren)
+{
+	if(vren->out == X11_VREN_OUT_XV)
+	{
+		vren->sws_ctx = sws_getCachedContext(vren->sws_ctx, vren->src_w,
+				vren->src_h, vren->pix_fmt, vren->src_w, vren->src_h,
+				X11_VREN_XV_PIX_FMT, X11_VREN_SWS_FLG, NULL, NULL, NULL);
+	}
+	else
+	{
+		vren->sws_ctx = sws_getCachedContext(vren->sws_ctx, vren->src_w,
+				vren->src_h, vren->pix_fmt, vren->dst_w, vren->dst_h,
+				X11_VREN_DEST_PIX_FMT, X11_VREN_SWS_FLG, NULL, NULL, NULL);
+	}
+
+	return (vren->sws_ctx == NULL) ? EOS_ERROR_GENERAL : EOS_ERROR_OK;
+}
+
+static eos_error_t xv_port_grab(x11_vren_t* vren)
+{
+	unsigned int ver = 0, rel = 0, req = 0, ev = 0, err = 0;
+	unsigned int adaptor_cnt = 0;
+	XvAdaptorInfo *adaptors = NULL;
+	XvImageFormatValues *fmts = NULL;
+	XvPortID port = 0;
+	unsigned long p = 0;
+	unsigned int i = 0;
+	int fmt_cnt = 0, f = 0, id = 0;
+
+	if(XvQueryExtension(disp, &ver, &rel, &req, &ev, &err) != Success)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	if(XvQueryAdaptors(disp, root, &adaptor_cnt, &adaptors) != Success)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	for(i=0; i<adaptor_cnt && vren->xv_port == 0; i++)
+	{
+		if((adaptors[i].type & XvInputMask) == 0 ||
+				(adaptors[i].type & XvImageMask) == 0)
+		{
+			continue;
+		}
+		for(p=0; p<adaptors[i].num_ports && vren->xv_port == 0; p++)
+		{
+			port = adaptors[i].base_id + p;
+			id = 0;
+			fmts = XvListImageFormats(disp, port, &fmt_cnt);
+			for(f=0; f<fmt_cnt; f++)
+			{
+				if(fmts[f].id == X11_VREN_FOURCC_I420 ||
+						(fmts[f].id == X11_VREN_FOURCC_YV12 && id == 0))
+				{
+					id = fmts[f].id;
+				}
+			}
+			if(fmts != NULL)
+			{
+				XFree(fmts);
+			}
+			if(id != 0 && XvGrabPort(disp, port, CurrentTime) == Success)
+			{
+				vren->xv_port = port;
+				vren->xv_fmt = id;
+			}
+		}
+	}
+	XvFreeAdaptorInfo(adaptors);
+
+	return (vren->xv_port == 0) ? EOS_ERROR_NFOUND : EOS_ERROR_OK;
+}
+
+static eos_error_t xv_img_create(x11_vren_t* vren)
+{
+	if(XShmQueryExtension(disp) == True)
+	{
+		vren->xvimg = XvShmCreateImage(disp, vren->xv_port, vren->xv_fmt, NULL,
+				vren->src_w, vren->src_h, &vren->shm);
+		if(vren->xvimg != NULL)
+		{
+			if(shm_attach(&vren->shm, vren->xvimg->data_size) == EOS_ERROR_OK)
+			{
+				vren->xvimg->data = vren->shm.shmaddr;
+				return EOS_ERROR_OK;
+			}
+			XFree(vren->xvimg);
+			vren->xvimg = NULL;
+		}
+	}
+	/* Remote display or no MIT-SHM, images travel over the connection */
+	vren->xvimg = XvCreateImage(disp, vren->xv_port, vren->xv_fmt, NULL,
+			vren->src_w, vren->src_h);
+	if(vren->xvimg == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	vren->xvimg->data = osi_calloc(vren->xvimg->data_size);
+	if(vren->xvimg->data == NULL)
+	{
+		XFree(vren->xvimg);
+		vren->xvimg = NULL;
+		return EOS_ERROR_NOMEM;
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static void xv_img_destroy(x11_vren_t* vren)
+{
+	if(vren->xvimg == NULL)
+	{
+		return;
+	}
+	if(vren->shm.shmaddr != NULL)
+	{
+		shm_detach(&vren->shm);
+	}
+	else
+	{
+		osi_free((void**)&vren->xvimg->data);
+	}
+	XFree(vren->xvimg);
+	vren->xvimg = NULL;
+}
+
+static int shm_err_handler(Display* d, XErrorEvent* e)
+{
+	(void)d;
+	x11_err = e->error_code;
+
+	return 0;
+}
+
+static eos_error_t shm_attach(XShmSegmentInfo* shm, size_t size)
+{
+	int (*handler)(Display*, XErrorEvent*) = NULL;
+
+	shm->shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+	if(shm->shmid < 0)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	shm->shmaddr = shmat(shm->shmid, NULL, 0);
+	if(shm->shmaddr == (char*)-1)
+	{
+		shmctl(shm->shmid, IPC_RMID, NULL);
+		shm->shmaddr = NULL;
+		return EOS_ERROR_NOMEM;
+	}
+	shm->readOnly = False;
+	/* Attach fails asynchronously on remote displays, catch it before going on */
+	XLockDisplay(disp);
+	XSync(disp, False);
+	x11_err = 0;
+	handler = XSetErrorHandler(shm_err_handler);
+	XShmAttach(disp, shm);
+	XSync(disp, False);
+	XSetErrorHandler(handler);
+	XUnlockDisplay(disp);
+	/* Segment is released with the last detach, even if we never get to it */
+	shmctl(shm->shmid, IPC_RMID, NULL);
+	if(x11_err != 0)
+	{
+		shmdt(shm->shmaddr);
+		shm->shmaddr = NULL;
+		return EOS_ERROR_GENERAL;
+	}
 
 	return EOS_ERROR_OK;
 }
+
+static void shm_detach(XShmSegmentInfo* shm)
+{
+	if(shm->shmaddr == NULL)
+	{
+		return;
+	}
+	XShmDetach(disp, shm);
+	XSync(disp, False);
+	shmdt(shm->shmaddr);
+	shm->shmaddr = NULL;
+}
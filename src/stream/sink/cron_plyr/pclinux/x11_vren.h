@@ -35,6 +35,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define X11_VREN_H_
 
 #include "eos_error.h"
+#include "eos_types.h"
 #include "util_log.h"
 #include "util_msgq.h"
 #include "osi_mutex.h"
@@ -42,23 +43,49 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include <X11/Xlib.h>
 #include <X11/extensions/Xdbe.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xvlib.h>
 
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
 
+#define X11_FRAME_CNT   (50)
+/* Queued frames, plus the one being rendered and the one being queued */
+#define X11_VREN_POOL_SZ (X11_FRAME_CNT + 2)
+
 typedef struct x11_frame
 {
     uint8_t *data[AV_NUM_DATA_POINTERS];
     int linesize[AV_NUM_DATA_POINTERS];
     int64_t pts;
+    uint16_t width;
+    uint16_t height;
+    enum AVPixelFormat format;
+    /* Decoded picture, referenced (not copied) until the frame is freed */
+    AVFrame *av;
+    volatile int used;
 } x11_frame_t;
 
-typedef eos_error_t (*x11_clk_cbk_t)(void* opaque, x11_frame_t* frame, uint32_t* micros, osi_time_t* offset);
+/* Output path, picked at init in this order of preference */
+typedef enum x11_vren_out
+{
+	X11_VREN_OUT_XV = 0, /* YUV planes to the Xv adaptor, scaled and converted by the server */
+	X11_VREN_OUT_SHM,    /* RGB converted here, image shared with the server (MIT-SHM) */
+	X11_VREN_OUT_PLAIN   /* RGB converted here, image sent over the X connection */
+} x11_vren_out_t;
+
+/* Tells when the frame is due (absolute, osi_time_get_mono() base), or that it should be dropped */
+typedef eos_error_t (*x11_clk_cbk_t)(void* opaque, x11_frame_t* frame, osi_time_t* deadline, bool* drop);
 
 typedef struct x11_vren
 {
 	struct SwsContext *sws_ctx;
+	x11_vren_out_t out;
 	XImage *ximg;
+	XvImage *xvimg;
+	XvPortID xv_port;
+	int xv_fmt;
+	XShmSegmentInfo shm;
 	Window win;
 	GC gc;
 	XdbeBackBuffer db;
@@ -74,6 +101,7 @@ typedef struct x11_vren
 	x11_clk_cbk_t clk_cbk;
 	void *clk_opaque;
 	enum AVPixelFormat pix_fmt;
+	x11_frame_t pool[X11_VREN_POOL_SZ];
 } x11_vren_t;
 
 eos_error_t x11_vren_sys_init(void);
@@ -83,7 +111,7 @@ eos_error_t x11_vren_init(x11_vren_t* vren, uint16_t w, uint16_t h, uint16_t x,
 		enum AVPixelFormat pix_fmt, util_log_t* log, uint16_t src_h, uint16_t src_w);
 eos_error_t x11_vren_set_clk_cb(x11_vren_t* vren, x11_clk_cbk_t clk_cbk,
 		void *cookie);
-eos_error_t x11_vren_frame_alloc(AVFrame *av, x11_frame_t** frame);
+eos_error_t x11_vren_frame_alloc(x11_vren_t* vren, AVFrame *av, x11_frame_t** frame);
 eos_error_t x11_vren_frame_free(x11_frame_t** frame);
 eos_error_t x11_vren_queue(x11_vren_t* vren, x11_frame_t* frame);
 eos_error_t x11_vren_pause(x11_vren_t* vren);
@@ -31,6 +31,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+/* MODULE_NAME ("core") is shared with other modules */
+#define OSI_MEMORY_TAG "sink:cron_plyr"
+
 #include "sink_cron_plyr.h"
 #include "eos_macro.h"
 #include "osi_memory.h"
@@ -78,6 +81,7 @@ typedef struct sink_cron_plyr_priv
 	cron_plyr_state_t state;
 	util_log_t *log;
 	bool frst_I_frame_rcvd;
+	bool frst_pkt_rcvd;
 } sink_cron_plyr_priv_t;
 
 static eos_error_t sink_cron_plyr_init(sink_t* sink,
@@ -96,7 +100,7 @@ static eos_error_t sink_cron_plyr_reg_ev_hnd(link_handle_t link,
 static eos_error_t sink_cron_plyr_ev_cbk(void* opaque, cron_plyr_ev_t event,
 		cron_ply_ev_data_t* data);
 static eos_error_t sink_cron_plyr_setup(sink_t* sink, uint32_t id,
-		eos_media_desc_t* media);
+		util_mdesc_t* media);
 static eos_error_t sink_cron_plyr_manufacture(sink_factory_id_data_t* data,
 		sink_t* model, uint64_t model_id,
 		sink_t** product, uint64_t product_id);
@@ -122,6 +126,8 @@ static eos_error_t sink_cron_plyr_aud_pass_trgh(link_handle_t link,
 		bool enable);
 static eos_error_t sink_cron_plyr_vol_leveling(link_handle_t link,
 		bool enable, eos_out_vol_lvl_t lvl);
+static eos_error_t sink_cron_plyr_dec_threads(sink_t* sink,
+		eos_out_dec_thr_t mode, uint8_t count);
 static eos_error_t sink_cron_plyr_set_reg(set_reg_opt_t opt,
 		set_reg_val_t* val, void* cookie);
 static inline void sink_cron_plyr_set_state(sink_cron_plyr_priv_t* priv,
@@ -321,6 +327,7 @@ static eos_error_t sink_cron_plyr_start(sink_t* sink)
 	else
 	{
 		priv->frst_I_frame_rcvd = false;
+		priv->frst_pkt_rcvd = false;
 		sink_cron_plyr_set_state(priv, CRON_PLYR_STATE_STARTED, false);
 	}
 	SINK_CRON_PLYR_UNLOCK(priv);
@@ -545,10 +552,20 @@ static eos_error_t sink_cron_plyr_ev_cbk(void* opaque, cron_plyr_ev_t event,
 			cron_plyr_set_sync_time(priv->player,
 					SINK_CRON_SYNC_COEFF * mills);
 			priv->frst_I_frame_rcvd = true;
+			ev_data.milestone.id = EOS_ZAP_MS_FIRST_IFRM;
+			priv->handler(LINK_EV_MILESTONE, &ev_data, priv->hnd_cookie,
+					priv->product_id);
+			ev_data.frame.pts = data->first_frm.pts;
+			ev_data.frame.key_frm = true;
 		}
 		priv->handler(LINK_EV_FRAME_DISP, &ev_data, priv->hnd_cookie,
 				priv->product_id);
 		break;
+	case CRON_PLYR_EV_FRM_DISP:
+		ev_data.milestone.id = EOS_ZAP_MS_FIRST_DISP;
+		priv->handler(LINK_EV_MILESTONE, &ev_data, priv->hnd_cookie,
+				priv->product_id);
+		break;
 	case CRON_PLYR_EV_VDEC_INFO:
 		UTIL_GLOGD("Video info: w = %u h = %u frame rate = %u/%u",
 				data->vdec_info.width, data->vdec_info.height,
@@ -559,6 +576,11 @@ static eos_error_t sink_cron_plyr_ev_cbk(void* opaque, cron_plyr_ev_t event,
 		UTIL_GLOGD("Video resolution changed to w = %u, h = %u",
 				data->vdec_res.width, data->vdec_res.height);
 		break;
+	case CRON_PLYR_EV_VDEC_LVL:
+		UTIL_GLOGI("Video decoding level %d (%u late frames, %u queued)",
+				data->vdec_lvl.level, data->vdec_lvl.dropped,
+				data->vdec_lvl.queued);
+		break;
 	case CRON_PLYR_EV_ERR:
 		/* TODO: switch/case error code */
 		ev_data.err.desc = LINK_PBK_ERR_SYS;
@@ -600,7 +622,7 @@ static eos_error_t sink_cron_plyr_ev_cbk(void* opaque, cron_plyr_ev_t event,
 }
 
 static eos_error_t sink_cron_plyr_setup(sink_t* sink, uint32_t id,
-		eos_media_desc_t* media)
+		util_mdesc_t* media)
 {
 	eos_error_t err = EOS_ERROR_OK;
 	set_reg_val_t val ;
@@ -659,6 +681,12 @@ static eos_error_t sink_cron_plyr_setup(sink_t* sink, uint32_t id,
 		cron_plyr_vol_leveling(priv->player, val.vol_lvl.enable,
 				cron_lvl);
 	}
+	err = set_reg_fetch(sink->id, SET_REG_OPT_DEC_THR, &val);
+	if(err == EOS_ERROR_OK)
+	{
+		sink_cron_plyr_dec_threads(sink, val.dec_thr.mode,
+				val.dec_thr.count);
+	}
 
 	return set_reg_add_cbk(id, sink_cron_plyr_set_reg, sink);
 }
@@ -757,6 +785,20 @@ static eos_error_t sink_cron_plyr_commit(link_handle_t opaque,
 	{
 		return EOS_ERROR_AGAIN;
 	}
+	if (!priv->frst_pkt_rcvd)
+	{
+		link_ev_data_t ev_data;
+
+		SINK_CRON_PLYR_LOCK(priv);
+		priv->frst_pkt_rcvd = true;
+		if(priv->handler != NULL)
+		{
+			ev_data.milestone.id = EOS_ZAP_MS_FIRST_PKT;
+			priv->handler(LINK_EV_MILESTONE, &ev_data, priv->hnd_cookie,
+					priv->product_id);
+		}
+		SINK_CRON_PLYR_UNLOCK(priv);
+	}
 
 	return cron_plyr_buff_cons(priv->player, *buff, size, extended_info,
 			msec, id);
@@ -994,6 +1036,37 @@ static eos_error_t sink_cron_plyr_vol_leveling(link_handle_t link,
 	return cron_plyr_vol_leveling(priv->player, enable, cron_lvl);
 }
 
+static eos_error_t sink_cron_plyr_dec_threads(sink_t* sink,
+		eos_out_dec_thr_t mode, uint8_t count)
+{
+	sink_cron_plyr_priv_t *priv = NULL;
+	cron_dec_thr_t cron_mode = CRON_DEC_THR_AUTO;
+
+	if(sink == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	priv = SINK_CRON_PLYR_GET_PRIV(sink);
+
+	switch (mode)
+	{
+		case EOS_OUT_DEC_THR_FRAME:
+			cron_mode = CRON_DEC_THR_FRAME;
+			break;
+		case EOS_OUT_DEC_THR_SLICE:
+			cron_mode = CRON_DEC_THR_SLICE;
+			break;
+		case EOS_OUT_DEC_THR_OFF:
+			cron_mode = CRON_DEC_THR_OFF;
+			break;
+		default:
+			cron_mode = CRON_DEC_THR_AUTO;
+			break;
+	}
+
+	return cron_plyr_dec_threads(priv->player, cron_mode, count);
+}
+
 static eos_error_t sink_cron_plyr_set_reg(set_reg_opt_t opt,
 		set_reg_val_t* val, void* cookie)
 {
@@ -1016,6 +1089,9 @@ static eos_error_t sink_cron_plyr_set_reg(set_reg_opt_t opt,
 	case SET_REG_OPT_VOL_LVL:
 		return sink_cron_plyr_vol_leveling(sink,
 				val->vol_lvl.enable, val->vol_lvl.lvl);
+	case SET_REG_OPT_DEC_THR:
+		return sink_cron_plyr_dec_threads(sink, val->dec_thr.mode,
+				val->dec_thr.count);
 	default:
 		break;
 	}
@@ -55,7 +55,7 @@ typedef struct sink_factory_id_data
 
 typedef struct sink_command
 {
-	eos_error_t (*setup)(sink_t* sink, uint32_t id, eos_media_desc_t* media);
+	eos_error_t (*setup)(sink_t* sink, uint32_t id, util_mdesc_t* media);
 	eos_error_t (*start)(sink_t* sink);
 	eos_error_t (*stop)(sink_t* sink);
 	eos_error_t (*pause)(sink_t* sink, bool buffering);
@@ -48,6 +48,8 @@ static osi_mutex_t *list_lock = NULL;
 
 static eos_error_t sink_factory_identify_cbk(sink_t* model,
 		sink_factory_id_data_t* data);
+static void sink_factory_key_cbk(sink_factory_id_data_t* data,
+		uint32_t* key, uint32_t* hint);
 static bool sink_factory_comparator(void* search_param,
 		void* data_address);
 
@@ -55,6 +57,9 @@ eos_error_t sink_factory_register(sink_t* model, uint64_t* model_id, sink_manufa
 		sink_dismantle_func_t dismantle)
 {
 	eos_error_t ret = EOS_ERROR_OK;
+	uint32_t keys[sizeof(link_io_type_t) * 8];
+	uint8_t key_cnt = 0;
+	uint8_t i = 0;
 
 	if (model == NULL || manufacture == NULL)
 	{
@@ -74,7 +79,9 @@ eos_error_t sink_factory_register(sink_t* model, uint64_t* model_id, sink_manufa
 			osi_mutex_destroy(&list_lock);
 			return ret;
 		}
-		ret = util_factory_create(&factory, (util_probe_cb_t)sink_factory_identify_cbk);
+		ret = util_factory_create(&factory,
+				(util_probe_cb_t)sink_factory_identify_cbk,
+				(util_key_cb_t)sink_factory_key_cbk);
 		if(ret != EOS_ERROR_OK)
 		{
 			osi_mutex_destroy(&list_lock);
@@ -82,7 +89,16 @@ eos_error_t sink_factory_register(sink_t* model, uint64_t* model_id, sink_manufa
 			return ret;
 		}
 	}
+	/* Sink is a candidate for every input type it can be plugged to */
+	for (i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+	{
+		if ((uint32_t)model->plug_type & (1U << i))
+		{
+			keys[key_cnt++] = 1U << i;
+		}
+	}
 	ret = util_factory_register(factory, (void*)model, model_id,
+			keys, key_cnt,
 			(util_manufacture_cb_t)manufacture, (util_dismantle_cb_t)dismantle);
 	if(ret != EOS_ERROR_OK)
 	{
@@ -129,7 +145,7 @@ eos_error_t sink_factory_unregister(sink_t* model, uint64_t model_id)
 	return EOS_ERROR_OK;
 }
 
-eos_error_t sink_factory_manufacture(uint32_t id, eos_media_desc_t* media,
+eos_error_t sink_factory_manufacture(uint32_t id, util_mdesc_t* media,
 		uint64_t caps, link_io_type_t input_type, sink_t** product)
 {
 	sink_factory_id_data_t data = {caps, id, input_type};
@@ -230,6 +246,17 @@ eos_error_t sink_factory_identify_cbk(sink_t* model,
 	return EOS_ERROR_NFOUND;
 }
 
+static void sink_factory_key_cbk(sink_factory_id_data_t* data,
+		uint32_t* key, uint32_t* hint)
+{
+	uint32_t type = (data != NULL) ? (uint32_t)data->input_type : 0;
+
+	/* Only a single input type maps to a key, a mix is probed against
+	 * every model */
+	*key = ((type & (type - 1)) == 0) ? type : 0;
+	*hint = *key;
+}
+
 static bool sink_factory_comparator(void* search_param,
 		void* data_address)
 {
@@ -46,7 +46,7 @@ typedef eos_error_t (*sink_dismantle_func_t) (uint64_t model_id,
 eos_error_t sink_factory_register (sink_t* model, uint64_t* model_id,
 		sink_manufacture_func_t manufacture, sink_dismantle_func_t dismantle);
 eos_error_t sink_factory_unregister (sink_t* model, uint64_t model_id);
-eos_error_t sink_factory_manufacture (uint32_t id, eos_media_desc_t* media,
+eos_error_t sink_factory_manufacture (uint32_t id, util_mdesc_t* media,
 		uint64_t caps, link_io_type_t input_type, sink_t** product);
 eos_error_t sink_factory_dismantle (sink_t** product);
 
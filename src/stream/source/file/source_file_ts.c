@@ -77,6 +77,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define START_WAIT_TIMEOUT 2000 // msec
 
 #define READ_CHUNK_SIZE (7 * 188)
+/* How far (in read chunks) ES headers are looked for after the PMT */
+#define ES_INFO_CHUNK_CNT (1000)
 
 // *************************************
 // *              Types                *
@@ -154,12 +156,15 @@ static void source_file_ts_dispatch_event(source_t* source, link_ev_t event, voi
 // *         Global variables          *
 // *************************************
 
+static const char* const source_file_ts_schemes[] = {"file", NULL};
+
 static source_t source_file_ts_model =
 {
 	.handle = NULL,
 
 	.name = source_file_ts_name,
 	.probe = source_file_ts_probe,
+	.schemes = source_file_ts_schemes,
 	.prelock = source_file_ts_prelock,
 	.lock = source_file_ts_lock,
 	.resume = source_file_ts_resume,
@@ -196,6 +201,8 @@ void* source_file_ts_read_thread (void* arg)
 	uint8_t packet[188*7] = {0};
 	util_tsparser_t *tsparser = NULL;
 	link_ev_data_t ev_data;
+	uint16_t pmt_pid = 0;
+	bool pat_found = false;
 
 	EOS_UNUSED(result)
 
@@ -239,6 +246,11 @@ void* source_file_ts_read_thread (void* arg)
 	}
 	for (i = 0; i < 3000; i++)
 	{
+		if (handle->private->state == SOURCE_STATE_STOPPING)
+		{
+			/* Suspended (e.g. zapped away) while waiting for PSI */
+			break;
+		}
 		size = sizeof(packet);
 		error = fsi_file_read(handle->private->fd, packet, &size);
 		if (error != EOS_ERROR_OK)
@@ -247,11 +259,34 @@ void* source_file_ts_read_thread (void* arg)
 			break;
 		}
 		error = util_tsparser_get_media_info(tsparser, packet, sizeof(packet), INFO_ID_FIRST_FOUND, &desc);
+		if ((pat_found == false) && (util_tsparser_get_pmt_pid(tsparser, &pmt_pid) == EOS_ERROR_OK))
+		{
+			pat_found = true;
+			ev_data.milestone.id = EOS_ZAP_MS_PAT;
+			source_file_ts_dispatch_event(source, LINK_EV_MILESTONE, &ev_data);
+		}
 		if (error == EOS_ERROR_OK)
 		{
 			break;
 		}
 	}
+	/* Complete A/V attributes from the ES headers, so that sinks need not probe */
+	for (i = 0; (desc.es_cnt != 0) && (i < ES_INFO_CHUNK_CNT); i++)
+	{
+		if (handle->private->state == SOURCE_STATE_STOPPING)
+		{
+			break;
+		}
+		size = sizeof(packet);
+		if (fsi_file_read(handle->private->fd, packet, &size) != EOS_ERROR_OK)
+		{
+			break;
+		}
+		if (util_tsparser_get_es_info(tsparser, packet, size, &desc) == EOS_ERROR_OK)
+		{
+			break;
+		}
+	}
 	util_tsparser_destroy(&tsparser);
 
 	if (desc.es_cnt == 0)
@@ -269,9 +304,17 @@ void* source_file_ts_read_thread (void* arg)
 		source_file_ts_dispatch_event(source, LINK_EV_NO_CONNECT, &ev_data);
 		return NULL;
 	}
-	ev_data.conn_info.media = desc;
+	if (util_mdesc_create(&ev_data.conn_info.media, &desc) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("<ID:0x%llX> Read thread [Failure]", handle->product_id);
+		ev_data.conn_info.reason = LINK_CONN_ERR_READ;
+		source_file_ts_dispatch_event(source, LINK_EV_NO_CONNECT, &ev_data);
+		return NULL;
+	}
+	ev_data.conn_info.gen = util_mdesc_get_gen(ev_data.conn_info.media);
 	ev_data.conn_info.reason = LINK_CONN_ERR_NONE;
 	source_file_ts_dispatch_event(source, LINK_EV_CONNECTED, &ev_data);
+	util_mdesc_unref(&ev_data.conn_info.media);
 
 	fsi_file_seek(handle->private->fd, 0, F_S_BEG);
 	CHECK_AND_SET(handle->shared.cas, result, handle->private->state, SOURCE_STATE_SUSPENDED, ((error == EOS_ERROR_OK) && (handle->private->state == SOURCE_STATE_STARTING)));
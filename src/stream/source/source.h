@@ -74,6 +74,9 @@ struct source
 
 	const char* (*name) (void);
 	eos_error_t (*probe) (char* uri);
+	/* NULL terminated list of handled URI schemes (without "://"), the
+	 * factory probes the source only for these. NULL probes every URI. */
+	const char* const* schemes;
 	eos_error_t (*prelock) (source_t* source, char* uri);
 	// TODO expand with throughput preference
 	eos_error_t (*lock) (source_t* source, char* uri, char* extras,
@@ -33,18 +33,26 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include "source_factory.h"
 #include "link_factory.h"
+#include "util_dispatch.h"
+
+#include <string.h>
 
 #define MODULE_NAME SOURCE_MODULE_NAME
 #include "util_log.h"
 
+#define SOURCE_FACTORY_SCHEMES_MAX (8)
+#define SOURCE_FACTORY_SCHEME_SEP "://"
 
 static link_factory_t *factory = NULL;
 
 static eos_error_t source_factory_identify_cbk (source_t* model, char* url);
+static void source_factory_key_cbk (char* url, uint32_t* key, uint32_t* hint);
 
 eos_error_t source_factory_register_model (source_t* model, uint64_t* model_id, source_manufacture_func_t manufacture, source_dismantle_func_t dismantle)
 {
 	eos_error_t ret = EOS_ERROR_OK;
+	uint32_t keys[SOURCE_FACTORY_SCHEMES_MAX];
+	uint8_t key_cnt = 0;
 
 	if (model == NULL || manufacture == NULL)
 	{
@@ -54,13 +62,27 @@ eos_error_t source_factory_register_model (source_t* model, uint64_t* model_id,
 	if (factory == NULL)
 	{
 		ret = link_factory_create(&factory,
-				(link_identify_cbk_t)source_factory_identify_cbk);
+				(link_identify_cbk_t)source_factory_identify_cbk,
+				(link_key_cbk_t)source_factory_key_cbk);
 		if(ret != EOS_ERROR_OK)
 		{
 			return ret;
 		}
 	}
+	while (model->schemes != NULL && model->schemes[key_cnt] != NULL)
+	{
+		if (key_cnt == SOURCE_FACTORY_SCHEMES_MAX)
+		{
+			/* Too many to index, probe it for everything */
+			key_cnt = 0;
+			break;
+		}
+		keys[key_cnt] = util_dispatch_hash(model->schemes[key_cnt],
+				SOURCE_URI_SCHEME_MAX);
+		key_cnt++;
+	}
 	ret = link_factory_register(factory, (link_handle_t*)model, model_id,
+			keys, key_cnt,
 			(link_manufacture_func_t)manufacture, (link_dismantle_func_t)dismantle);
 	if(ret != EOS_ERROR_OK)
 	{
@@ -132,3 +154,25 @@ eos_error_t source_factory_identify_cbk(source_t* model, char* url)
 
 	return model->probe(url);
 }
+
+static void source_factory_key_cbk (char* url, uint32_t* key, uint32_t* hint)
+{
+	char *sep = NULL;
+	char *last = NULL;
+
+	*key = UTIL_DISPATCH_ANY;
+	*hint = UTIL_DISPATCH_ANY;
+	if (url == NULL || (sep = strstr(url, SOURCE_FACTORY_SCHEME_SEP)) == NULL)
+	{
+		return;
+	}
+	*key = util_dispatch_hash(url, sep - url);
+	/* Everything up to the last path separator: zapping between channels
+	 * of the same server (or directory) hits the same cache entry */
+	last = strrchr(sep + strlen(SOURCE_FACTORY_SCHEME_SEP), '/');
+	if (last == NULL)
+	{
+		last = url + strlen(url);
+	}
+	*hint = util_dispatch_hash(url, last - url);
+}
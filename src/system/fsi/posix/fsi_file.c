@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "fsi"
+
 #include "fsi_file.h"
 #include "osi_memory.h"
 #include "osi_error.h"
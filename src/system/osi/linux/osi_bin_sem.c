@@ -0,0 +1,159 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#define MODULE_NAME "osi"
+
+#include "osi_bin_sem.h"
+#include "osi_memory.h"
+#include "osi_futex.h"
+
+/* ############### Futex based binary semaphore ################ */
+/*
+ * Futex word states. Give/take are single atomic operations while there is
+ * nobody to wait, kernel is entered only if the "waiters" state is set.
+ */
+#define BIN_SEM_DOWN         (0)
+#define BIN_SEM_UP           (1)
+#define BIN_SEM_DOWN_WAITERS (2)
+
+struct osi_bin_sem_handle
+{
+	int32_t state;
+};
+
+static eos_error_t osi_bin_sem_wait(osi_bin_sem_t* handle, const struct timespec* deadline)
+{
+	int32_t c = BIN_SEM_UP;
+
+	/* Fast path */
+	if (OSI_FUTEX_CAS(&handle->state, &c, BIN_SEM_DOWN))
+	{
+		return EOS_ERROR_OK;
+	}
+	for (;;)
+	{
+		c = OSI_FUTEX_LOAD(&handle->state);
+		if (c == BIN_SEM_UP)
+		{
+			/* Other waiters may still sleep, so keep the "waiters" state */
+			if (OSI_FUTEX_CAS(&handle->state, &c, BIN_SEM_DOWN_WAITERS))
+			{
+				return EOS_ERROR_OK;
+			}
+			continue;
+		}
+		if (c == BIN_SEM_DOWN && !OSI_FUTEX_CAS(&handle->state, &c, BIN_SEM_DOWN_WAITERS))
+		{
+			continue;
+		}
+		if (osi_futex_wait(&handle->state, BIN_SEM_DOWN_WAITERS, deadline, false) == ETIMEDOUT)
+		{
+			return EOS_ERROR_TIMEDOUT;
+		}
+	}
+}
+
+eos_error_t osi_bin_sem_create(osi_bin_sem_t** handle, bool given)
+{
+	osi_bin_sem_t *s = NULL;
+
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	*handle = NULL;
+	s = (osi_bin_sem_t *)osi_malloc(sizeof(osi_bin_sem_t));
+	if(s == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	s->state = given? BIN_SEM_UP : BIN_SEM_DOWN;
+	*handle = s;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_bin_sem_destroy(osi_bin_sem_t** handle)
+{
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_free((void**)handle);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_bin_sem_take(osi_bin_sem_t* handle)
+{
+	return osi_bin_sem_wait(handle, NULL);
+}
+
+eos_error_t osi_bin_sem_timedtake(osi_bin_sem_t* handle, osi_time_t* timeout)
+{
+	struct timespec deadline = {0, 0};
+	struct timespec now = {0, 0};
+	eos_error_t error = EOS_ERROR_OK;
+	int64_t left = 0;
+
+	osi_futex_deadline(timeout->sec, timeout->nsec, &deadline);
+	error = osi_bin_sem_wait(handle, &deadline);
+	if (error != EOS_ERROR_OK)
+	{
+		timeout->sec = 0;
+		timeout->nsec = 0;
+		return error;
+	}
+	/* Give the caller the rest of the timeout, so it can be reused in the wait loop */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	left = (int64_t)(deadline.tv_sec - now.tv_sec) * OSI_FUTEX_NSEC_IN_SEC +
+			(deadline.tv_nsec - now.tv_nsec);
+	if (left < 0)
+	{
+		left = 0;
+	}
+	timeout->sec = left / OSI_FUTEX_NSEC_IN_SEC;
+	timeout->nsec = left % OSI_FUTEX_NSEC_IN_SEC;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_bin_sem_give(osi_bin_sem_t* handle)
+{
+	if (OSI_FUTEX_XCHG(&handle->state, BIN_SEM_UP) == BIN_SEM_DOWN_WAITERS)
+	{
+		osi_futex_wake(&handle->state, 1);
+	}
+
+	return EOS_ERROR_OK;
+}
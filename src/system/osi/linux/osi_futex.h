@@ -0,0 +1,106 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#ifndef OSI_FUTEX_H_
+#define OSI_FUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FUTEX_PRIVATE_FLAG
+#define FUTEX_PRIVATE_FLAG (0)
+#endif
+
+#define OSI_FUTEX_NSEC_IN_SEC (1000000000L)
+
+#define OSI_FUTEX_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define OSI_FUTEX_XCHG(ptr, val) __atomic_exchange_n((ptr), (val), __ATOMIC_SEQ_CST)
+#define OSI_FUTEX_CAS(ptr, expected, desired) \
+	__atomic_compare_exchange_n((ptr), (expected), (desired), false, \
+			__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define OSI_FUTEX_ADD(ptr, val) __atomic_add_fetch((ptr), (val), __ATOMIC_SEQ_CST)
+
+/**
+ * Sleeps while *addr == val.
+ * @param addr Futex word.
+ * @param val Expected value.
+ * @param deadline Absolute timeout (NULL for infinite wait).
+ * @param realtime If set, deadline is CLOCK_REALTIME based, CLOCK_MONOTONIC otherwise.
+ * @return 0 when woken (or value changed, or interrupted), ETIMEDOUT on timeout.
+ */
+static inline int osi_futex_wait(int32_t* addr, int32_t val,
+		const struct timespec* deadline, bool realtime)
+{
+	int op = FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG;
+
+	if (realtime)
+	{
+		op |= FUTEX_CLOCK_REALTIME;
+	}
+	if (syscall(SYS_futex, addr, op, val, deadline, NULL, FUTEX_BITSET_MATCH_ANY) == -1)
+	{
+		if (errno == ETIMEDOUT)
+		{
+			return ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+static inline void osi_futex_wake(int32_t* addr, int32_t count)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, NULL, NULL, 0);
+}
+
+/**
+ * Converts relative timeout to the absolute CLOCK_MONOTONIC deadline.
+ */
+static inline void osi_futex_deadline(uint32_t sec, uint32_t nsec, struct timespec* deadline)
+{
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+	deadline->tv_sec += sec + nsec / OSI_FUTEX_NSEC_IN_SEC;
+	deadline->tv_nsec += nsec % OSI_FUTEX_NSEC_IN_SEC;
+	if (deadline->tv_nsec >= OSI_FUTEX_NSEC_IN_SEC)
+	{
+		deadline->tv_sec++;
+		deadline->tv_nsec -= OSI_FUTEX_NSEC_IN_SEC;
+	}
+}
+
+#endif /* OSI_FUTEX_H_ */
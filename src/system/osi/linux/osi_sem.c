@@ -0,0 +1,173 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#define MODULE_NAME "osi"
+
+#include "osi_sem.h"
+#include "osi_memory.h"
+#include "osi_futex.h"
+
+/* ############### Futex based counting semaphore ################ */
+
+struct osi_sem_handle
+{
+	/** Futex word (semaphore value) */
+	int32_t count;
+	/** Number of threads sleeping (or about to sleep) on the futex */
+	int32_t waiters;
+	int32_t max;
+};
+
+static eos_error_t osi_sem_take(osi_sem_t* sem, const struct timespec* deadline)
+{
+	int32_t c = 0;
+	eos_error_t error = EOS_ERROR_OK;
+
+	/* Fast path */
+	c = OSI_FUTEX_LOAD(&sem->count);
+	while (c > 0)
+	{
+		if (OSI_FUTEX_CAS(&sem->count, &c, c - 1))
+		{
+			return EOS_ERROR_OK;
+		}
+	}
+	OSI_FUTEX_ADD(&sem->waiters, 1);
+	for (;;)
+	{
+		c = OSI_FUTEX_LOAD(&sem->count);
+		if (c > 0)
+		{
+			if (OSI_FUTEX_CAS(&sem->count, &c, c - 1))
+			{
+				break;
+			}
+			continue;
+		}
+		/* Absolute deadline is CLOCK_REALTIME based (see osi_sem_timedwait) */
+		if (osi_futex_wait(&sem->count, 0, deadline, true) == ETIMEDOUT)
+		{
+			error = EOS_ERROR_TIMEDOUT;
+			break;
+		}
+	}
+	OSI_FUTEX_ADD(&sem->waiters, -1);
+
+	return error;
+}
+
+eos_error_t osi_sem_create(osi_sem_t** handle, uint8_t initial, uint8_t max)
+{
+	osi_sem_t *tmp = NULL;
+
+	if(handle == NULL || initial > max)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	*handle = NULL;
+	tmp = (osi_sem_t*) osi_calloc(sizeof(osi_sem_t));
+	if(tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->count = initial;
+	tmp->waiters = 0;
+	tmp->max = max;
+	*handle = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_sem_destroy(osi_sem_t** handle)
+{
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_free((void**)handle);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_sem_wait(osi_sem_t* handle)
+{
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	return osi_sem_take(handle, NULL);
+}
+
+eos_error_t osi_sem_timedwait(osi_sem_t* handle, osi_time_t* timeout)
+{
+	struct timespec ts;
+
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(timeout == NULL)
+	{
+		return osi_sem_wait(handle);
+	}
+	/* Same contract as sem_timedwait: absolute time, as given by osi_time_get_time */
+	ts.tv_sec = timeout->sec;
+	ts.tv_nsec = timeout->nsec;
+
+	return osi_sem_take(handle, &ts);
+}
+
+eos_error_t osi_sem_post(osi_sem_t* handle)
+{
+	int32_t c = 0;
+
+	if(handle == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	c = OSI_FUTEX_LOAD(&handle->count);
+	do
+	{
+		if(c >= handle->max)
+		{
+			return EOS_ERROR_INVAL;
+		}
+	} while(!OSI_FUTEX_CAS(&handle->count, &c, c + 1));
+	if(OSI_FUTEX_LOAD(&handle->waiters) > 0)
+	{
+		osi_futex_wake(&handle->count, 1);
+	}
+
+	return EOS_ERROR_OK;
+}
@@ -0,0 +1,156 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#ifndef OSI_EXECUTOR_H_
+#define OSI_EXECUTOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osi_error.h"
+
+/**
+ * Fixed pool of worker threads for event handling and one-shot jobs.
+ * Every worker owns a deque: it pops its own work LIFO and, when idle,
+ * steals FIFO from the others. A task may carry an affinity hint (the
+ * worker index it should preferably run on); hinted tasks can still be
+ * stolen by an idle worker.
+ * Tasks that have to run in order (e.g. events of one chain) go through
+ * a serial queue, which keeps at most one of its tasks running at a time.
+ * Long blocking loops (readers, decoders, renderers) should keep their
+ * own threads.
+ */
+
+/** No affinity, task goes to the submitting worker or round-robin */
+#define OSI_EXECUTOR_ANY (-1)
+/** Max number of workers in one executor */
+#define OSI_EXECUTOR_MAX_WORKERS (32)
+
+typedef struct osi_executor osi_executor_t;
+typedef struct osi_executor_task osi_executor_task_t;
+typedef struct osi_executor_serial osi_executor_serial_t;
+
+typedef void (*osi_executor_func_t)(void* arg);
+/** Releases argument of a serial task that was dropped without running */
+typedef void (*osi_executor_free_t)(void* arg);
+
+/**
+ * Creates executor and starts its workers.
+ * @param exec Executor handle.
+ * @param workers Number of workers (1..OSI_EXECUTOR_MAX_WORKERS).
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_create(osi_executor_t** exec, uint8_t workers);
+/**
+ * Runs all queued tasks, stops the workers and releases executor.
+ * @param exec Executor handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_destroy(osi_executor_t** exec);
+/**
+ * Returns process wide executor (created on first use, sized after the
+ * number of online CPUs). It lives until the process exits.
+ * @return Executor or NULL if it could not be created.
+ */
+osi_executor_t* osi_executor_shared(void);
+/**
+ * Returns number of workers.
+ * @param exec Executor handle.
+ * @return Number of workers (0 for invalid handle).
+ */
+uint8_t osi_executor_get_workers(osi_executor_t* exec);
+/**
+ * Queues a task.
+ * @param exec Executor handle.
+ * @param func Task function.
+ * @param arg Task argument.
+ * @param hint Preferred worker index or OSI_EXECUTOR_ANY.
+ * @param task Task handle to be joined with osi_executor_join() (can be
+ * NULL for fire-and-forget tasks).
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_run(osi_executor_t* exec, osi_executor_func_t func,
+		void* arg, int8_t hint, osi_executor_task_t** task);
+/**
+ * Waits for the task to finish and releases the handle. A task that has
+ * not been picked up yet is run by the caller, so joining from a worker
+ * does not deadlock the pool.
+ * @param task Task handle (set to NULL).
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_join(osi_executor_task_t** task);
+
+/**
+ * Creates serial queue on the executor.
+ * @param serial Serial queue handle.
+ * @param exec Executor handle.
+ * @param free_arg Called for tasks dropped by flush/destroy (can be NULL).
+ * @param hint Preferred worker index or OSI_EXECUTOR_ANY.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_serial_create(osi_executor_serial_t** serial,
+		osi_executor_t* exec, osi_executor_free_t free_arg, int8_t hint);
+/**
+ * Drops queued tasks, waits for the running one and releases the queue.
+ * Must not be called from a task of the same queue.
+ * @param serial Serial queue handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_serial_destroy(osi_executor_serial_t** serial);
+/**
+ * Queues a task; tasks of one serial queue run one by one, in order.
+ * @param serial Serial queue handle.
+ * @param func Task function.
+ * @param arg Task argument.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_serial_run(osi_executor_serial_t* serial,
+		osi_executor_func_t func, void* arg);
+/**
+ * Drops tasks that have not started yet.
+ * @param serial Serial queue handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_serial_flush(osi_executor_serial_t* serial);
+/**
+ * Waits for the task that is running at the moment of the call (if any)
+ * to finish. Together with flush, nothing queued before is left running
+ * afterwards. Called from a task of the same queue, it returns right away.
+ * @param serial Serial queue handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t osi_executor_serial_sync(osi_executor_serial_t* serial);
+
+#endif /* OSI_EXECUTOR_H_ */
@@ -37,6 +37,30 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include <stddef.h>
 #include <stdint.h>
 
+#include "osi_error.h"
+
+/** Maximum number of modules tracked separately */
+#define OSI_MEMORY_MODULES_MAX (64)
+
+/**
+ * Per-module memory usage, see osi_memory_get_stats().
+ */
+typedef struct osi_memory_stats
+{
+	/** Module name (MODULE_NAME of the allocating file) */
+	const char *module;
+	/** Bytes currently held */
+	size_t live;
+	/** High-water mark of live bytes */
+	size_t peak;
+	/** Number of allocations */
+	uint64_t allocs;
+	/** Number of frees */
+	uint64_t frees;
+	/** Allocations per second since previous osi_memory_get_stats() call */
+	uint32_t rate;
+} osi_memory_stats_t;
+
 void* osi_malloc(size_t size);
 void osi_free(void** ptr);
 void* osi_calloc(size_t size);
@@ -46,4 +70,31 @@ void* osi_memmove(void* to, void* from, size_t size);
 void* osi_memcpy(void* to, void* from, size_t size);
 int32_t osi_memcmp(void* adr1, void* adr2, size_t size);
 
+/**
+ * Retrieves per-module memory usage. Available only when built with
+ * OSI_MEMORY_ACCOUNTING.
+ * @param stats Array to fill.
+ * @param count Size of the array on input, number of modules on output.
+ * @return EOS_ERROR_NIMPLEMENTED if accounting is not built in.
+ */
+eos_error_t osi_memory_get_stats(osi_memory_stats_t* stats, uint32_t* count);
+
+#ifdef OSI_MEMORY_ACCOUNTING
+/* Every allocation is tagged with the calling module. A file can override
+ * its tag by defining OSI_MEMORY_TAG before including this header. */
+#ifndef OSI_MEMORY_TAG
+#define OSI_MEMORY_TAG MODULE_NAME
+#endif
+
+void* osi_malloc_tag(size_t size, const char* module);
+void* osi_calloc_tag(size_t size, const char* module);
+void* osi_realloc_tag(void* ptr, size_t size, const char* module);
+
+#ifndef OSI_MEMORY_IMPL
+#define osi_malloc(size) osi_malloc_tag((size), OSI_MEMORY_TAG)
+#define osi_calloc(size) osi_calloc_tag((size), OSI_MEMORY_TAG)
+#define osi_realloc(ptr, size) osi_realloc_tag((ptr), (size), OSI_MEMORY_TAG)
+#endif
+#endif
+
 #endif /* OSI_MEMORY_H_ */
@@ -0,0 +1,81 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#ifndef OSI_POOL_H_
+#define OSI_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Size-class pool allocator for small, short-lived objects (messages, packet
+ * wrappers, frame descriptors...). Objects are carved from 64KB slabs of a
+ * single reserved arena and recycled through per-thread caches, so the hot
+ * path does not touch any lock. Requests bigger than OSI_POOL_MAX_SIZE, or
+ * made when the arena is exhausted, fall back to the C library.
+ */
+
+/** Largest size served from the pool */
+#define OSI_POOL_MAX_SIZE (2048)
+
+/**
+ * Allocates zeroed memory block.
+ * @param size Block size.
+ * @return Block or NULL if out of memory.
+ */
+void* osi_pool_alloc(size_t size);
+/**
+ * Frees a block returned by osi_pool_alloc() (any thread may free it).
+ * @param ptr Block to free, set to NULL on return.
+ */
+void osi_pool_free(void** ptr);
+/**
+ * Checks whether the block belongs to the pool arena.
+ * @param ptr Block.
+ * @return true if the block is pool memory.
+ */
+bool osi_pool_owns(void* ptr);
+/**
+ * Returns usable size of the pool block.
+ * @param ptr Pool block.
+ * @return Size of the size-class, 0 if ptr is not a pool block.
+ */
+size_t osi_pool_usable_size(void* ptr);
+/**
+ * Returns calling thread's cached blocks to the shared free lists. Done
+ * automatically on thread exit.
+ */
+void osi_pool_flush(void);
+
+#endif /* OSI_POOL_H_ */
@@ -34,6 +34,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #ifndef OSI_THREAD_H_
 #define OSI_THREAD_H_
 
+#include <stdbool.h>
+
 #include "osi_error.h"
 
 typedef enum
@@ -55,5 +57,6 @@ eos_error_t osi_thread_create(osi_thread_t** thread, osi_thread_attr_t* attr,
 		osi_thread_func_t func, void* arg);
 eos_error_t osi_thread_release(osi_thread_t** thread);
 eos_error_t osi_thread_join(osi_thread_t* thread, void** retval);
+bool osi_thread_is_current(osi_thread_t* thread);
 
 #endif /* OSI_THREAD_H_ */
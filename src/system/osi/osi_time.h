@@ -108,5 +108,15 @@ eos_error_t osi_time_get_timestamp(osi_time_t* timestamp);
 eos_error_t osi_time_add(osi_time_t* first, osi_time_t* second, osi_time_t* sum);
 eos_error_t osi_time_diff(osi_time_t* first, osi_time_t* second, osi_time_t* diff);
 eos_error_t osi_time_usleep(uint32_t micros);
+/**
+ * Precise timestamp, same time base as osi_time_get_timestamp() (which may be
+ * coarse), meant for deadline calculation.
+ */
+eos_error_t osi_time_get_mono(osi_time_t* timestamp);
+/**
+ * Sleeps until the absolute deadline (osi_time_get_mono() time base) passes.
+ * Returns immediately if it already did.
+ */
+eos_error_t osi_time_sleep_until(osi_time_t* deadline);
 
 #endif /* OSI_TIME_H_ */
@@ -63,6 +63,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
  *
  ******************************************************************************/
 
+#define MODULE_NAME "osi"
+
 #include "osi_bin_sem.h"
 #include "osi_memory.h"
 
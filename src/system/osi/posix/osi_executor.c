@@ -0,0 +1,693 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#define MODULE_NAME "osi"
+
+#include "osi_executor.h"
+#include "osi_memory.h"
+#include "osi_thread.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define OSI_EXECUTOR_RING_INIT (64)
+/* Serial queue hands the worker back after this many tasks */
+#define OSI_EXECUTOR_SERIAL_BATCH (16)
+/* Tasks may block (probing, sink stop), so the shared pool is wider than
+ * the number of CPUs */
+#define OSI_EXECUTOR_SHARED_MIN (4)
+#define OSI_EXECUTOR_SHARED_MAX (16)
+
+enum
+{
+	OSI_EXECUTOR_QUEUED,
+	OSI_EXECUTOR_RUNNING,
+	OSI_EXECUTOR_DONE
+};
+
+struct osi_executor_task
+{
+	osi_executor_t *exec;
+	osi_executor_func_t func;
+	void *arg;
+	volatile uint32_t state;
+	/* Queue entry plus the handle owner, if any */
+	volatile uint32_t refs;
+};
+
+typedef struct osi_executor_worker
+{
+	osi_executor_t *exec;
+	osi_thread_t *thread;
+	pthread_mutex_t lock;
+	/* Deque: owner pushes/pops at the tail, thieves take from the head */
+	osi_executor_task_t **ring;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+	uint8_t idx;
+} osi_executor_worker_t;
+
+struct osi_executor
+{
+	osi_executor_worker_t workers[OSI_EXECUTOR_MAX_WORKERS];
+	uint8_t count;
+	volatile uint32_t rr;
+	pthread_mutex_t idle_lock;
+	pthread_cond_t idle_cond;
+	/* Queued tasks not picked up yet (may go negative for a moment) */
+	volatile int32_t pending;
+	uint32_t sleepers;
+	bool stop;
+	pthread_mutex_t done_lock;
+	pthread_cond_t done_cond;
+};
+
+typedef struct osi_executor_item
+{
+	struct osi_executor_item *next;
+	osi_executor_func_t func;
+	void *arg;
+} osi_executor_item_t;
+
+struct osi_executor_serial
+{
+	osi_executor_t *exec;
+	pthread_mutex_t lock;
+	pthread_cond_t idle;
+	osi_executor_free_t free_arg;
+	osi_executor_item_t *head;
+	osi_executor_item_t *tail;
+	/* Scheduled drain task, NULL while the queue is idle */
+	osi_executor_task_t *drain;
+	/* Tasks started/finished so far and the thread running the current one */
+	uint32_t started;
+	uint32_t finished;
+	pthread_t runner;
+	int8_t hint;
+};
+
+static pthread_once_t osi_executor_once = PTHREAD_ONCE_INIT;
+static pthread_key_t osi_executor_key;
+static pthread_once_t osi_executor_shared_once = PTHREAD_ONCE_INIT;
+static osi_executor_t *osi_executor_dflt = NULL;
+
+static void osi_executor_key_init(void)
+{
+	pthread_key_create(&osi_executor_key, NULL);
+}
+
+static void osi_executor_release(osi_executor_task_t* task)
+{
+	if(__sync_sub_and_fetch(&task->refs, 1) == 0)
+	{
+		osi_free((void**)&task);
+	}
+}
+
+static void osi_executor_done(osi_executor_task_t* task)
+{
+	osi_executor_t *exec = task->exec;
+
+	if(task->refs == 1)
+	{
+		/* Nobody holds the handle, nobody waits */
+		task->state = OSI_EXECUTOR_DONE;
+		return;
+	}
+	pthread_mutex_lock(&exec->done_lock);
+	task->state = OSI_EXECUTOR_DONE;
+	pthread_cond_broadcast(&exec->done_cond);
+	pthread_mutex_unlock(&exec->done_lock);
+}
+
+static eos_error_t osi_executor_push(osi_executor_worker_t* worker,
+		osi_executor_task_t* task)
+{
+	osi_executor_task_t **ring = NULL;
+	uint32_t cnt = 0, i = 0;
+
+	pthread_mutex_lock(&worker->lock);
+	cnt = worker->tail - worker->head;
+	if(cnt == worker->size)
+	{
+		ring = osi_malloc(2 * worker->size * sizeof(osi_executor_task_t*));
+		if(ring == NULL)
+		{
+			pthread_mutex_unlock(&worker->lock);
+			return EOS_ERROR_NOMEM;
+		}
+		for(i=0; i<cnt; i++)
+		{
+			ring[i] = worker->ring[(worker->head + i) & (worker->size - 1)];
+		}
+		osi_free((void**)&worker->ring);
+		worker->ring = ring;
+		worker->size *= 2;
+		worker->head = 0;
+		worker->tail = cnt;
+	}
+	worker->ring[worker->tail & (worker->size - 1)] = task;
+	worker->tail++;
+	pthread_mutex_unlock(&worker->lock);
+
+	return EOS_ERROR_OK;
+}
+
+static osi_executor_task_t* osi_executor_pop(osi_executor_worker_t* worker,
+		bool steal)
+{
+	osi_executor_task_t *task = NULL;
+
+	pthread_mutex_lock(&worker->lock);
+	if(worker->tail != worker->head)
+	{
+		if(steal)
+		{
+			task = worker->ring[worker->head & (worker->size - 1)];
+			worker->head++;
+		}
+		else
+		{
+			worker->tail--;
+			task = worker->ring[worker->tail & (worker->size - 1)];
+		}
+	}
+	pthread_mutex_unlock(&worker->lock);
+
+	return task;
+}
+
+static osi_executor_task_t* osi_executor_next(osi_executor_worker_t* self)
+{
+	osi_executor_t *exec = self->exec;
+	osi_executor_task_t *task = NULL;
+	uint8_t i = 0;
+
+	if((task = osi_executor_pop(self, false)) != NULL)
+	{
+		return task;
+	}
+	for(i=1; i<exec->count && task == NULL; i++)
+	{
+		task = osi_executor_pop(&exec->workers[(self->idx + i) % exec->count],
+				true);
+	}
+
+	return task;
+}
+
+static void osi_executor_exec(osi_executor_t* exec, osi_executor_task_t* task)
+{
+	__sync_sub_and_fetch(&exec->pending, 1);
+	/* Joiner (or serial destroy) may have claimed it already */
+	if(__sync_bool_compare_and_swap(&task->state, OSI_EXECUTOR_QUEUED,
+			OSI_EXECUTOR_RUNNING))
+	{
+		task->func(task->arg);
+		osi_executor_done(task);
+	}
+	osi_executor_release(task);
+}
+
+static void* osi_executor_worker(void* arg)
+{
+	osi_executor_worker_t *self = (osi_executor_worker_t*) arg;
+	osi_executor_t *exec = self->exec;
+	osi_executor_task_t *task = NULL;
+
+	pthread_setspecific(osi_executor_key, self);
+	for(;;)
+	{
+		if((task = osi_executor_next(self)) != NULL)
+		{
+			osi_executor_exec(exec, task);
+			continue;
+		}
+		pthread_mutex_lock(&exec->idle_lock);
+		if(exec->pending <= 0)
+		{
+			if(exec->stop)
+			{
+				pthread_mutex_unlock(&exec->idle_lock);
+				break;
+			}
+			exec->sleepers++;
+			pthread_cond_wait(&exec->idle_cond, &exec->idle_lock);
+			exec->sleepers--;
+		}
+		pthread_mutex_unlock(&exec->idle_lock);
+	}
+
+	return NULL;
+}
+
+eos_error_t osi_executor_create(osi_executor_t** exec, uint8_t workers)
+{
+	osi_executor_t *tmp = NULL;
+	osi_executor_worker_t *worker = NULL;
+	eos_error_t err = EOS_ERROR_OK;
+	uint8_t i = 0;
+
+	if(exec == NULL || workers == 0 || workers > OSI_EXECUTOR_MAX_WORKERS)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	pthread_once(&osi_executor_once, osi_executor_key_init);
+	if((tmp = osi_calloc(sizeof(osi_executor_t))) == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	pthread_mutex_init(&tmp->idle_lock, NULL);
+	pthread_cond_init(&tmp->idle_cond, NULL);
+	pthread_mutex_init(&tmp->done_lock, NULL);
+	pthread_cond_init(&tmp->done_cond, NULL);
+	for(i=0; i<workers; i++)
+	{
+		worker = &tmp->workers[i];
+		worker->exec = tmp;
+		worker->idx = i;
+		worker->size = OSI_EXECUTOR_RING_INIT;
+		worker->ring = osi_calloc(worker->size * sizeof(osi_executor_task_t*));
+		if(worker->ring == NULL)
+		{
+			err = EOS_ERROR_NOMEM;
+			break;
+		}
+		pthread_mutex_init(&worker->lock, NULL);
+		tmp->count++;
+	}
+	/* Workers may steal from each other only once all deques exist */
+	for(i=0; i<tmp->count && err == EOS_ERROR_OK; i++)
+	{
+		err = osi_thread_create(&tmp->workers[i].thread, NULL,
+				osi_executor_worker, &tmp->workers[i]);
+	}
+	if(err != EOS_ERROR_OK)
+	{
+		osi_executor_destroy(&tmp);
+		return err;
+	}
+	*exec = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_executor_destroy(osi_executor_t** exec)
+{
+	osi_executor_worker_t *worker = NULL;
+	uint8_t i = 0;
+
+	if(exec == NULL || *exec == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	pthread_mutex_lock(&(*exec)->idle_lock);
+	(*exec)->stop = true;
+	pthread_cond_broadcast(&(*exec)->idle_cond);
+	pthread_mutex_unlock(&(*exec)->idle_lock);
+	for(i=0; i<(*exec)->count; i++)
+	{
+		worker = &(*exec)->workers[i];
+		if(worker->thread != NULL)
+		{
+			osi_thread_join(worker->thread, NULL);
+			osi_thread_release(&worker->thread);
+		}
+	}
+	for(i=0; i<(*exec)->count; i++)
+	{
+		worker = &(*exec)->workers[i];
+		pthread_mutex_destroy(&worker->lock);
+		osi_free((void**)&worker->ring);
+	}
+	pthread_mutex_destroy(&(*exec)->idle_lock);
+	pthread_cond_destroy(&(*exec)->idle_cond);
+	pthread_mutex_destroy(&(*exec)->done_lock);
+	pthread_cond_destroy(&(*exec)->done_cond);
+	osi_free((void**)exec);
+
+	return EOS_ERROR_OK;
+}
+
+static void osi_executor_shared_init(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	long workers = 2 * cpus;
+
+	if(workers < OSI_EXECUTOR_SHARED_MIN)
+	{
+		workers = OSI_EXECUTOR_SHARED_MIN;
+	}
+	if(workers > OSI_EXECUTOR_SHARED_MAX)
+	{
+		workers = OSI_EXECUTOR_SHARED_MAX;
+	}
+	if(osi_executor_create(&osi_executor_dflt, (uint8_t)workers)
+			!= EOS_ERROR_OK)
+	{
+		osi_executor_dflt = NULL;
+	}
+}
+
+osi_executor_t* osi_executor_shared(void)
+{
+	pthread_once(&osi_executor_shared_once, osi_executor_shared_init);
+
+	return osi_executor_dflt;
+}
+
+uint8_t osi_executor_get_workers(osi_executor_t* exec)
+{
+	return (exec == NULL) ? 0 : exec->count;
+}
+
+eos_error_t osi_executor_run(osi_executor_t* exec, osi_executor_func_t func,
+		void* arg, int8_t hint, osi_executor_task_t** task)
+{
+	osi_executor_task_t *tmp = NULL;
+	osi_executor_worker_t *target = NULL;
+	eos_error_t err = EOS_ERROR_OK;
+
+	if(exec == NULL || func == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if((tmp = osi_calloc(sizeof(osi_executor_task_t))) == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->exec = exec;
+	tmp->func = func;
+	tmp->arg = arg;
+	tmp->state = OSI_EXECUTOR_QUEUED;
+	tmp->refs = (task != NULL) ? 2 : 1;
+	if(hint >= 0)
+	{
+		target = &exec->workers[hint % exec->count];
+	}
+	else
+	{
+		/* Work spawned by a worker stays local (cache warm) */
+		target = (osi_executor_worker_t*) pthread_getspecific(osi_executor_key);
+		if(target == NULL || target->exec != exec)
+		{
+			target = &exec->workers[__sync_fetch_and_add(&exec->rr, 1)
+					% exec->count];
+		}
+	}
+	if((err = osi_executor_push(target, tmp)) != EOS_ERROR_OK)
+	{
+		osi_free((void**)&tmp);
+		return err;
+	}
+	if(task != NULL)
+	{
+		*task = tmp;
+	}
+	pthread_mutex_lock(&exec->idle_lock);
+	__sync_add_and_fetch(&exec->pending, 1);
+	if(exec->sleepers > 0)
+	{
+		pthread_cond_signal(&exec->idle_cond);
+	}
+	pthread_mutex_unlock(&exec->idle_lock);
+
+	return EOS_ERROR_OK;
+}
+
+static void osi_executor_wait(osi_executor_task_t* task)
+{
+	osi_executor_t *exec = task->exec;
+
+	pthread_mutex_lock(&exec->done_lock);
+	while(task->state != OSI_EXECUTOR_DONE)
+	{
+		pthread_cond_wait(&exec->done_cond, &exec->done_lock);
+	}
+	pthread_mutex_unlock(&exec->done_lock);
+}
+
+eos_error_t osi_executor_join(osi_executor_task_t** task)
+{
+	osi_executor_task_t *tmp = NULL;
+
+	if(task == NULL || *task == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = *task;
+	if(__sync_bool_compare_and_swap(&tmp->state, OSI_EXECUTOR_QUEUED,
+			OSI_EXECUTOR_RUNNING))
+	{
+		/* Not picked up yet, do it ourselves */
+		tmp->func(tmp->arg);
+		tmp->state = OSI_EXECUTOR_DONE;
+	}
+	else
+	{
+		osi_executor_wait(tmp);
+	}
+	osi_executor_release(tmp);
+	*task = NULL;
+
+	return EOS_ERROR_OK;
+}
+
+static void osi_executor_serial_drop(osi_executor_serial_t* serial,
+		osi_executor_item_t* item)
+{
+	osi_executor_item_t *next = NULL;
+
+	while(item != NULL)
+	{
+		next = item->next;
+		if(serial->free_arg != NULL)
+		{
+			serial->free_arg(item->arg);
+		}
+		osi_free((void**)&item);
+		item = next;
+	}
+}
+
+static void osi_executor_serial_drain(void* arg)
+{
+	osi_executor_serial_t *serial = (osi_executor_serial_t*) arg;
+	osi_executor_item_t *item = NULL;
+	osi_executor_task_t *self = NULL;
+	osi_executor_task_t *next = NULL;
+	uint32_t n = 0;
+
+	pthread_mutex_lock(&serial->lock);
+	/* Stays the registered drain until it runs dry or hands over, so that
+	 * serial_run never starts a second one next to it */
+	self = serial->drain;
+	for(;;)
+	{
+		for(n=0; n<OSI_EXECUTOR_SERIAL_BATCH && serial->head != NULL; n++)
+		{
+			item = serial->head;
+			serial->head = item->next;
+			if(serial->head == NULL)
+			{
+				serial->tail = NULL;
+			}
+			serial->started++;
+			serial->runner = pthread_self();
+			pthread_mutex_unlock(&serial->lock);
+			item->func(item->arg);
+			osi_free((void**)&item);
+			pthread_mutex_lock(&serial->lock);
+			serial->finished++;
+			pthread_cond_broadcast(&serial->idle);
+		}
+		if(serial->head == NULL)
+		{
+			serial->drain = NULL;
+			break;
+		}
+		/* Give other work a chance; if that fails, keep draining here */
+		if(osi_executor_run(serial->exec, osi_executor_serial_drain, serial,
+				serial->hint, &next) == EOS_ERROR_OK)
+		{
+			serial->drain = next;
+			break;
+		}
+	}
+	if(serial->drain == NULL)
+	{
+		pthread_cond_broadcast(&serial->idle);
+	}
+	pthread_mutex_unlock(&serial->lock);
+	osi_executor_release(self);
+}
+
+eos_error_t osi_executor_serial_create(osi_executor_serial_t** serial,
+		osi_executor_t* exec, osi_executor_free_t free_arg, int8_t hint)
+{
+	osi_executor_serial_t *tmp = NULL;
+
+	if(serial == NULL || exec == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if((tmp = osi_calloc(sizeof(osi_executor_serial_t))) == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	pthread_mutex_init(&tmp->lock, NULL);
+	pthread_cond_init(&tmp->idle, NULL);
+	tmp->exec = exec;
+	tmp->free_arg = free_arg;
+	tmp->hint = hint;
+	*serial = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_executor_serial_destroy(osi_executor_serial_t** serial)
+{
+	osi_executor_serial_t *tmp = NULL;
+	osi_executor_item_t *items = NULL;
+
+	if(serial == NULL || *serial == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = *serial;
+	pthread_mutex_lock(&tmp->lock);
+	items = tmp->head;
+	tmp->head = tmp->tail = NULL;
+	if(tmp->drain != NULL && __sync_bool_compare_and_swap(&tmp->drain->state,
+			OSI_EXECUTOR_QUEUED, OSI_EXECUTOR_DONE))
+	{
+		/* Queue entry is released by the worker that pops it */
+		osi_executor_release(tmp->drain);
+		tmp->drain = NULL;
+	}
+	while(tmp->drain != NULL)
+	{
+		pthread_cond_wait(&tmp->idle, &tmp->lock);
+	}
+	pthread_mutex_unlock(&tmp->lock);
+	osi_executor_serial_drop(tmp, items);
+	pthread_mutex_destroy(&tmp->lock);
+	pthread_cond_destroy(&tmp->idle);
+	osi_free((void**)serial);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_executor_serial_run(osi_executor_serial_t* serial,
+		osi_executor_func_t func, void* arg)
+{
+	osi_executor_item_t *item = NULL;
+	eos_error_t err = EOS_ERROR_OK;
+
+	if(serial == NULL || func == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if((item = osi_calloc(sizeof(osi_executor_item_t))) == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	item->func = func;
+	item->arg = arg;
+	pthread_mutex_lock(&serial->lock);
+	/* Drain cannot start before we unlock, so the item is not missed */
+	if(serial->drain == NULL && (err = osi_executor_run(serial->exec,
+			osi_executor_serial_drain, serial, serial->hint,
+			&serial->drain)) != EOS_ERROR_OK)
+	{
+		pthread_mutex_unlock(&serial->lock);
+		osi_free((void**)&item);
+		return err;
+	}
+	if(serial->tail == NULL)
+	{
+		serial->head = item;
+	}
+	else
+	{
+		serial->tail->next = item;
+	}
+	serial->tail = item;
+	pthread_mutex_unlock(&serial->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_executor_serial_flush(osi_executor_serial_t* serial)
+{
+	osi_executor_item_t *items = NULL;
+
+	if(serial == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	pthread_mutex_lock(&serial->lock);
+	items = serial->head;
+	serial->head = serial->tail = NULL;
+	pthread_mutex_unlock(&serial->lock);
+	osi_executor_serial_drop(serial, items);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_executor_serial_sync(osi_executor_serial_t* serial)
+{
+	uint32_t started = 0;
+
+	if(serial == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	pthread_mutex_lock(&serial->lock);
+	started = serial->started;
+	/* Task of this queue syncing on it would wait for itself */
+	if(serial->finished != started && !pthread_equal(serial->runner,
+			pthread_self()))
+	{
+		while((int32_t)(serial->finished - started) < 0)
+		{
+			pthread_cond_wait(&serial->idle, &serial->lock);
+		}
+	}
+	pthread_mutex_unlock(&serial->lock);
+
+	return EOS_ERROR_OK;
+}
@@ -31,31 +31,126 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define OSI_MEMORY_IMPL
 #include "osi_memory.h"
+#include "osi_pool.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef OSI_MEMORY_ACCOUNTING
+#include "osi_time.h"
+
+#include <pthread.h>
+
+#define OSI_MEMORY_BUCKETS (4096)
+#define OSI_MEMORY_UNKNOWN "unknown"
+#define OSI_MEMORY_OTHER "other"
+
+typedef struct osi_memory_rec
+{
+	void *ptr;
+	size_t size;
+	uint32_t module;
+	struct osi_memory_rec *next;
+} osi_memory_rec_t;
+
+typedef struct osi_memory_module
+{
+	const char *name;
+	size_t live;
+	size_t peak;
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t window;
+} osi_memory_module_t;
+
+static pthread_mutex_t osi_memory_lock = PTHREAD_MUTEX_INITIALIZER;
+static osi_memory_rec_t *osi_memory_recs[OSI_MEMORY_BUCKETS];
+static osi_memory_module_t osi_memory_modules[OSI_MEMORY_MODULES_MAX];
+static uint32_t osi_memory_module_cnt = 0;
+static osi_time_t osi_memory_window_start = {0, 0};
+
+static void osi_memory_track(void* ptr, size_t size, const char* module);
+static void osi_memory_untrack(void* ptr);
+#endif
+
+static void* osi_memory_calloc(size_t size)
+{
+#ifdef OSI_MEMORY_POOL
+	/* Small objects come from the size-class pool */
+	if(size <= OSI_POOL_MAX_SIZE)
+	{
+		return osi_pool_alloc(size);
+	}
+#endif
+	return calloc(size, 1);
+}
+
+static void* osi_memory_realloc(void* ptr, size_t size)
+{
+	void *tmp = NULL;
+	size_t old = 0;
+
+	if(!osi_pool_owns(ptr))
+	{
+		return realloc(ptr, size);
+	}
+	old = osi_pool_usable_size(ptr);
+	if(size <= old)
+	{
+		return ptr;
+	}
+	tmp = malloc(size);
+	if(tmp == NULL)
+	{
+		return NULL;
+	}
+	memcpy(tmp, ptr, old);
+	osi_pool_free(&ptr);
+
+	return tmp;
+}
 
 void* osi_malloc(size_t size)
 {
+#ifdef OSI_MEMORY_ACCOUNTING
+	return osi_malloc_tag(size, NULL);
+#else
 	return malloc(size);
+#endif
 }
 
 void osi_free(void** ptr)
 {
+#ifdef OSI_MEMORY_ACCOUNTING
+	osi_memory_untrack(*ptr);
+#endif
+	if(osi_pool_owns(*ptr))
+	{
+		osi_pool_free(ptr);
+		return;
+	}
 	free(*ptr);
 	*ptr = NULL;
 }
 
 void* osi_calloc(size_t size)
 {
-	return calloc(size, 1);
+#ifdef OSI_MEMORY_ACCOUNTING
+	return osi_calloc_tag(size, NULL);
+#else
+	return osi_memory_calloc(size);
+#endif
 }
 
 void* osi_realloc(void* ptr, size_t size)
 {
-	return realloc(ptr, size);
+#ifdef OSI_MEMORY_ACCOUNTING
+	return osi_realloc_tag(ptr, size, NULL);
+#else
+	return osi_memory_realloc(ptr, size);
+#endif
 }
 
 void* osi_memset(void* ptr, uint8_t c, size_t size)
@@ -78,3 +173,185 @@ int32_t osi_memcmp(void* adr1, void* adr2, size_t size)
 	return memcmp(adr1, adr2, size);
 }
 
+#ifdef OSI_MEMORY_ACCOUNTING
+void* osi_malloc_tag(size_t size, const char* module)
+{
+	void *ptr = malloc(size);
+
+	osi_memory_track(ptr, size, module);
+
+	return ptr;
+}
+
+void* osi_calloc_tag(size_t size, const char* module)
+{
+	void *ptr = osi_memory_calloc(size);
+
+	osi_memory_track(ptr, size, module);
+
+	return ptr;
+}
+
+void* osi_realloc_tag(void* ptr, size_t size, const char* module)
+{
+	void *tmp = osi_memory_realloc(ptr, size);
+
+	if(tmp != NULL || size == 0)
+	{
+		osi_memory_untrack(ptr);
+		osi_memory_track(tmp, size, module);
+	}
+
+	return tmp;
+}
+
+eos_error_t osi_memory_get_stats(osi_memory_stats_t* stats, uint32_t* count)
+{
+	osi_time_t now = {0, 0}, diff = {0, 0};
+	uint64_t elapsed = 0;
+	uint32_t i;
+
+	if(stats == NULL || count == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_time_get_timestamp(&now);
+	pthread_mutex_lock(&osi_memory_lock);
+	osi_time_diff(&osi_memory_window_start, &now, &diff);
+	OSI_TIME_CONVERT_TO_MSEC(diff, elapsed);
+	for(i=0; i<osi_memory_module_cnt && i<*count; i++)
+	{
+		stats[i].module = osi_memory_modules[i].name;
+		stats[i].live = osi_memory_modules[i].live;
+		stats[i].peak = osi_memory_modules[i].peak;
+		stats[i].allocs = osi_memory_modules[i].allocs;
+		stats[i].frees = osi_memory_modules[i].frees;
+		stats[i].rate = elapsed? (uint32_t)(osi_memory_modules[i].window * 1000 / elapsed): 0;
+	}
+	for(i=0; i<osi_memory_module_cnt; i++)
+	{
+		osi_memory_modules[i].window = 0;
+	}
+	osi_memory_window_start = now;
+	*count = osi_memory_module_cnt;
+	pthread_mutex_unlock(&osi_memory_lock);
+
+	return EOS_ERROR_OK;
+}
+
+static inline uint32_t osi_memory_hash(void* ptr)
+{
+	return (uint32_t)((((uintptr_t)ptr) >> 4) * 2654435761u) % OSI_MEMORY_BUCKETS;
+}
+
+/* Called with the lock held */
+static uint32_t osi_memory_module_get(const char* name)
+{
+	uint32_t i;
+
+	if(name == NULL)
+	{
+		name = OSI_MEMORY_UNKNOWN;
+	}
+	for(i=0; i<osi_memory_module_cnt; i++)
+	{
+		if(osi_memory_modules[i].name == name ||
+				strcmp(osi_memory_modules[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	if(osi_memory_module_cnt == OSI_MEMORY_MODULES_MAX - 1)
+	{
+		/* Last slot collects everything that did not fit */
+		name = OSI_MEMORY_OTHER;
+	}
+	else if(osi_memory_module_cnt == OSI_MEMORY_MODULES_MAX)
+	{
+		return OSI_MEMORY_MODULES_MAX - 1;
+	}
+	if(osi_memory_module_cnt == 0)
+	{
+		osi_time_get_timestamp(&osi_memory_window_start);
+	}
+	osi_memory_modules[osi_memory_module_cnt].name = name;
+
+	return osi_memory_module_cnt++;
+}
+
+static void osi_memory_remove(void* ptr)
+{
+	osi_memory_rec_t **link = &osi_memory_recs[osi_memory_hash(ptr)];
+	osi_memory_rec_t *rec = NULL;
+
+	while(*link != NULL && (*link)->ptr != ptr)
+	{
+		link = &(*link)->next;
+	}
+	if(*link == NULL)
+	{
+		return;
+	}
+	rec = *link;
+	*link = rec->next;
+	osi_memory_modules[rec->module].live -= rec->size;
+	osi_memory_modules[rec->module].frees++;
+	free(rec);
+}
+
+static void osi_memory_track(void* ptr, size_t size, const char* module)
+{
+	osi_memory_rec_t *rec = NULL;
+	osi_memory_module_t *mod = NULL;
+	uint32_t bucket;
+
+	if(ptr == NULL)
+	{
+		return;
+	}
+	rec = malloc(sizeof(osi_memory_rec_t));
+	if(rec == NULL)
+	{
+		return;
+	}
+	bucket = osi_memory_hash(ptr);
+	pthread_mutex_lock(&osi_memory_lock);
+	/* Address may still be recorded if it was released with plain free() */
+	osi_memory_remove(ptr);
+	rec->ptr = ptr;
+	rec->size = size;
+	rec->module = osi_memory_module_get(module);
+	rec->next = osi_memory_recs[bucket];
+	osi_memory_recs[bucket] = rec;
+	mod = &osi_memory_modules[rec->module];
+	mod->live += size;
+	if(mod->live > mod->peak)
+	{
+		mod->peak = mod->live;
+	}
+	mod->allocs++;
+	mod->window++;
+	pthread_mutex_unlock(&osi_memory_lock);
+}
+
+static void osi_memory_untrack(void* ptr)
+{
+	if(ptr == NULL)
+	{
+		return;
+	}
+	pthread_mutex_lock(&osi_memory_lock);
+	osi_memory_remove(ptr);
+	pthread_mutex_unlock(&osi_memory_lock);
+}
+#else
+eos_error_t osi_memory_get_stats(osi_memory_stats_t* stats, uint32_t* count)
+{
+	if(stats == NULL || count == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	return EOS_ERROR_NIMPLEMENTED;
+}
+#endif
@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "osi"
+
 #include <pthread.h>
 #include <time.h>
 
@@ -0,0 +1,330 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#include "osi_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE (0)
+#endif
+
+/* Address space reserved once; pages are committed by the kernel on first
+ * touch, so unused slabs cost nothing */
+#define OSI_POOL_ARENA_SIZE (64 * 1024 * 1024)
+#define OSI_POOL_SLAB_SIZE (64 * 1024)
+#define OSI_POOL_SLAB_CNT (OSI_POOL_ARENA_SIZE / OSI_POOL_SLAB_SIZE)
+#define OSI_POOL_ALIGN (16)
+/* Per-thread cache depth; half of it moves to/from the shared list at once */
+#define OSI_POOL_MAG_SIZE (64)
+#define OSI_POOL_BATCH (OSI_POOL_MAG_SIZE / 2)
+#define OSI_POOL_CLASS_CNT (sizeof(osi_pool_class_size) / sizeof(osi_pool_class_size[0]))
+
+static const uint16_t osi_pool_class_size[] =
+{
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048
+};
+
+typedef struct osi_pool_block
+{
+	struct osi_pool_block *next;
+} osi_pool_block_t;
+
+typedef struct osi_pool_class
+{
+	pthread_mutex_t lock;
+	osi_pool_block_t *free;
+	uint8_t *carve;
+	uint8_t *carve_end;
+} osi_pool_class_t;
+
+typedef struct osi_pool_mag
+{
+	osi_pool_block_t *head;
+	uint32_t count;
+} osi_pool_mag_t;
+
+typedef struct osi_pool_cache
+{
+	osi_pool_mag_t mag[OSI_POOL_CLASS_CNT];
+} osi_pool_cache_t;
+
+static pthread_once_t osi_pool_once = PTHREAD_ONCE_INIT;
+static pthread_key_t osi_pool_key;
+static bool osi_pool_key_valid = false;
+static pthread_mutex_t osi_pool_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *osi_pool_base = NULL;
+static uint8_t *osi_pool_end = NULL;
+static uint8_t *osi_pool_next = NULL;
+/* Size-class of each slab, plus one (0 means not used yet) */
+static uint8_t osi_pool_slab_class[OSI_POOL_SLAB_CNT];
+static uint8_t osi_pool_lookup[OSI_POOL_MAX_SIZE / OSI_POOL_ALIGN + 1];
+static osi_pool_class_t osi_pool_classes[OSI_POOL_CLASS_CNT];
+
+static void osi_pool_drain(uint8_t cls, osi_pool_mag_t *mag, uint32_t count)
+{
+	osi_pool_block_t *first = mag->head, *last = mag->head;
+	uint32_t i;
+
+	if(count == 0 || first == NULL)
+	{
+		return;
+	}
+	for(i=1; i<count && last->next != NULL; i++)
+	{
+		last = last->next;
+	}
+	mag->head = last->next;
+	mag->count -= i;
+	pthread_mutex_lock(&osi_pool_classes[cls].lock);
+	last->next = osi_pool_classes[cls].free;
+	osi_pool_classes[cls].free = first;
+	pthread_mutex_unlock(&osi_pool_classes[cls].lock);
+}
+
+static void osi_pool_cache_release(void* arg)
+{
+	osi_pool_cache_t *cache = (osi_pool_cache_t*) arg;
+	uint8_t cls;
+
+	for(cls=0; cls<OSI_POOL_CLASS_CNT; cls++)
+	{
+		osi_pool_drain(cls, &cache->mag[cls], cache->mag[cls].count);
+	}
+	free(cache);
+}
+
+static void osi_pool_init(void)
+{
+	void *arena = NULL;
+	uint8_t cls = 0;
+	uint32_t i;
+
+	for(i=0; i<OSI_POOL_CLASS_CNT; i++)
+	{
+		pthread_mutex_init(&osi_pool_classes[i].lock, NULL);
+	}
+	for(i=0; i<sizeof(osi_pool_lookup); i++)
+	{
+		while(osi_pool_class_size[cls] < i * OSI_POOL_ALIGN)
+		{
+			cls++;
+		}
+		osi_pool_lookup[i] = cls;
+	}
+	if(pthread_key_create(&osi_pool_key, osi_pool_cache_release) == 0)
+	{
+		osi_pool_key_valid = true;
+	}
+	arena = mmap(NULL, OSI_POOL_ARENA_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(arena == MAP_FAILED)
+	{
+		/* Everything goes to libc */
+		return;
+	}
+	osi_pool_base = (uint8_t*) arena;
+	osi_pool_end = osi_pool_base + OSI_POOL_ARENA_SIZE;
+	osi_pool_next = osi_pool_base;
+}
+
+static osi_pool_cache_t* osi_pool_cache_get(bool create)
+{
+	osi_pool_cache_t *cache = NULL;
+
+	if(!osi_pool_key_valid)
+	{
+		return NULL;
+	}
+	cache = (osi_pool_cache_t*) pthread_getspecific(osi_pool_key);
+	if(cache == NULL && create)
+	{
+		cache = (osi_pool_cache_t*) calloc(1, sizeof(osi_pool_cache_t));
+		if(cache != NULL && pthread_setspecific(osi_pool_key, cache) != 0)
+		{
+			free(cache);
+			cache = NULL;
+		}
+	}
+
+	return cache;
+}
+
+/* Moves up to count blocks of the class into the magazine. Shared free list
+ * is used first, then the class' current slab, then a fresh slab. */
+static void osi_pool_refill(uint8_t cls, osi_pool_mag_t *mag, uint32_t count)
+{
+	osi_pool_class_t *pc = &osi_pool_classes[cls];
+	osi_pool_block_t *block = NULL;
+	size_t size = osi_pool_class_size[cls];
+
+	pthread_mutex_lock(&pc->lock);
+	while(mag->count < count)
+	{
+		if(pc->free != NULL)
+		{
+			block = pc->free;
+			pc->free = block->next;
+		}
+		else
+		{
+			if(pc->carve == NULL || pc->carve + size > pc->carve_end)
+			{
+				pthread_mutex_lock(&osi_pool_arena_lock);
+				if(osi_pool_next == NULL || osi_pool_next >= osi_pool_end)
+				{
+					pthread_mutex_unlock(&osi_pool_arena_lock);
+					break;
+				}
+				pc->carve = osi_pool_next;
+				pc->carve_end = osi_pool_next + OSI_POOL_SLAB_SIZE;
+				osi_pool_slab_class[(osi_pool_next - osi_pool_base) /
+						OSI_POOL_SLAB_SIZE] = cls + 1;
+				osi_pool_next += OSI_POOL_SLAB_SIZE;
+				pthread_mutex_unlock(&osi_pool_arena_lock);
+			}
+			block = (osi_pool_block_t*) pc->carve;
+			pc->carve += size;
+		}
+		block->next = mag->head;
+		mag->head = block;
+		mag->count++;
+	}
+	pthread_mutex_unlock(&pc->lock);
+}
+
+void* osi_pool_alloc(size_t size)
+{
+	osi_pool_cache_t *cache = NULL;
+	osi_pool_mag_t single = {NULL, 0};
+	osi_pool_mag_t *mag = &single;
+	osi_pool_block_t *block = NULL;
+	uint8_t cls = 0;
+
+	if(size > OSI_POOL_MAX_SIZE)
+	{
+		return calloc(size, 1);
+	}
+	pthread_once(&osi_pool_once, osi_pool_init);
+	cls = osi_pool_lookup[(size + OSI_POOL_ALIGN - 1) / OSI_POOL_ALIGN];
+	cache = osi_pool_cache_get(true);
+	if(cache != NULL)
+	{
+		mag = &cache->mag[cls];
+	}
+	if(mag->head == NULL)
+	{
+		osi_pool_refill(cls, mag, cache != NULL? OSI_POOL_BATCH: 1);
+	}
+	block = mag->head;
+	if(block == NULL)
+	{
+		return calloc(size, 1);
+	}
+	mag->head = block->next;
+	mag->count--;
+	/* The link word is always cleared, even for zero-sized requests */
+	memset(block, 0, size < sizeof(osi_pool_block_t)? sizeof(osi_pool_block_t): size);
+
+	return block;
+}
+
+void osi_pool_free(void** ptr)
+{
+	osi_pool_cache_t *cache = NULL;
+	osi_pool_mag_t single = {NULL, 0};
+	osi_pool_mag_t *mag = &single;
+	osi_pool_block_t *block = NULL;
+	uint8_t cls = 0;
+
+	if(ptr == NULL || *ptr == NULL)
+	{
+		return;
+	}
+	if(!osi_pool_owns(*ptr))
+	{
+		free(*ptr);
+		*ptr = NULL;
+		return;
+	}
+	block = (osi_pool_block_t*) *ptr;
+	*ptr = NULL;
+	cls = osi_pool_slab_class[((uint8_t*)block - osi_pool_base) / OSI_POOL_SLAB_SIZE] - 1;
+	cache = osi_pool_cache_get(false);
+	if(cache != NULL)
+	{
+		mag = &cache->mag[cls];
+	}
+	block->next = mag->head;
+	mag->head = block;
+	mag->count++;
+	if(mag->count > OSI_POOL_MAG_SIZE || cache == NULL)
+	{
+		osi_pool_drain(cls, mag, cache != NULL? OSI_POOL_BATCH: 1);
+	}
+}
+
+bool osi_pool_owns(void* ptr)
+{
+	return osi_pool_base != NULL && (uint8_t*)ptr >= osi_pool_base &&
+			(uint8_t*)ptr < osi_pool_end;
+}
+
+size_t osi_pool_usable_size(void* ptr)
+{
+	if(!osi_pool_owns(ptr))
+	{
+		return 0;
+	}
+
+	return osi_pool_class_size[osi_pool_slab_class[((uint8_t*)ptr - osi_pool_base) /
+			OSI_POOL_SLAB_SIZE] - 1];
+}
+
+void osi_pool_flush(void)
+{
+	osi_pool_cache_t *cache = osi_pool_cache_get(false);
+	uint8_t cls;
+
+	if(cache == NULL)
+	{
+		return;
+	}
+	for(cls=0; cls<OSI_POOL_CLASS_CNT; cls++)
+	{
+		osi_pool_drain(cls, &cache->mag[cls], cache->mag[cls].count);
+	}
+}
@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "osi"
+
 #include <semaphore.h>
 #include <pthread.h>
 #include <errno.h>
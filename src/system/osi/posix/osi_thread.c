@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "osi"
+
 #include <pthread.h>
 #include <stdlib.h>
 
@@ -114,3 +116,13 @@ eos_error_t osi_thread_join(osi_thread_t* thread, void** retval)
 
 	return EOS_ERROR_OK;
 }
+
+bool osi_thread_is_current(osi_thread_t* thread)
+{
+	if(thread == NULL)
+	{
+		return false;
+	}
+
+	return pthread_equal(thread->pthread, pthread_self()) != 0;
+}
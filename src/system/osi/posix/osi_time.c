@@ -33,6 +33,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
 
 #include "osi_time.h"
 
@@ -140,3 +141,45 @@ eos_error_t osi_time_usleep(uint32_t micros)
 
 	return EOS_ERROR_OK;
 }
+
+eos_error_t osi_time_get_mono(osi_time_t* timestamp)
+{
+	struct timespec t;
+	int err;
+
+	if(timestamp == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	/* Returns -1, the reason is in errno */
+	if((err = clock_gettime(CLOCK_MONOTONIC, &t)) != 0)
+	{
+		return osi_error_conv(errno);
+	}
+	timestamp->sec = t.tv_sec;
+	timestamp->nsec = t.tv_nsec;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t osi_time_sleep_until(osi_time_t* deadline)
+{
+	struct timespec t;
+	int err;
+
+	if(deadline == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	t.tv_sec = deadline->sec;
+	t.tv_nsec = deadline->nsec;
+	/* Absolute deadline, so signal restarts do not stretch the sleep */
+	while((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL))
+			== EINTR);
+	if(err != 0)
+	{
+		return osi_error_conv(err);
+	}
+
+	return EOS_ERROR_OK;
+}
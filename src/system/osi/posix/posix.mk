@@ -31,12 +31,30 @@
 POSIXDIR := $(OSIDIR)/posix
 
 SRCS += $(POSIXDIR)/osi_error.c
+SRCS += $(POSIXDIR)/osi_executor.c
 SRCS += $(POSIXDIR)/osi_memory.c
 SRCS += $(POSIXDIR)/osi_mutex.c
+SRCS += $(POSIXDIR)/osi_pool.c
 SRCS += $(POSIXDIR)/osi_thread.c
 SRCS += $(POSIXDIR)/osi_time.c
+
+# Linux has futex based semaphores, other targets use pthread ones
+ifeq ($(OS),LINUX)
+include $(OSIDIR)/linux/linux.mk
+else
 SRCS += $(POSIXDIR)/osi_sem.c
 SRCS += $(POSIXDIR)/osi_bin_sem.c
+endif
+
+# Route small osi_calloc() allocations through the size-class pool
+ifeq ($(MEMORY_POOL),1)
+CFLAGS += -DOSI_MEMORY_POOL
+endif
+
+# Per-module live/peak memory accounting (debug instrumentation)
+ifeq ($(MEMORY_ACCOUNTING),1)
+CFLAGS += -DOSI_MEMORY_ACCOUNTING
+endif
 
 CFLAGS += -D_GNU_SOURCE
 LDFLAGS += -pthread 
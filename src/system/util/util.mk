@@ -34,9 +34,16 @@ LOCAL_C_INCLUDES += $(UTILSDIR)/
 SRCS += $(UTILSDIR)/util_log.c
 SRCS += $(UTILSDIR)/util_slist.c
 SRCS += $(UTILSDIR)/util_ilist.c
+SRCS += $(UTILSDIR)/util_timer.c
 SRCS += $(UTILSDIR)/util_wdt.c
 SRCS += $(UTILSDIR)/util_rbuff.c
 SRCS += $(UTILSDIR)/util_seq_buff.c
+SRCS += $(UTILSDIR)/util_bcast_buff.c
 SRCS += $(UTILSDIR)/util_msgq.c
 SRCS += $(UTILSDIR)/util_tsparser.c
+SRCS += $(UTILSDIR)/util_esparser.c
+SRCS += $(UTILSDIR)/util_clk.c
+SRCS += $(UTILSDIR)/util_audio_dsp.c
+SRCS += $(UTILSDIR)/util_dispatch.c
 SRCS += $(UTILSDIR)/util_factory.c
+SRCS += $(UTILSDIR)/util_mdesc.c
@@ -0,0 +1,1174 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "util_audio_dsp.h"
+
+#if defined(__SSE2__)
+#define UTIL_AUDIO_DSP_SSE2
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && \
+		(defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+/* Built for the baseline, used only when the CPU has it */
+#define UTIL_AUDIO_DSP_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define UTIL_AUDIO_DSP_NEON
+#include <arm_neon.h>
+#endif
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+#define UTIL_AUDIO_DSP_S16_SCALE (32768.0f)
+#define UTIL_AUDIO_DSP_S16_MIN (-32768.0f)
+#define UTIL_AUDIO_DSP_S16_MAX (32767.0f)
+/* Adding and taking away 1.5 * 2^23 rounds to nearest (even), like cvtps2dq */
+#define UTIL_AUDIO_DSP_RND (12582912.0f)
+#define UTIL_AUDIO_DSP_LANE(i) ((i) & (UTIL_AUDIO_DSP_DITHER_LANES - 1))
+#define UTIL_AUDIO_DSP_ONE_BITS (0x3F800000U)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+/*
+ * Every kernel does the vector part and leaves the rest (from sample `i`) to
+ * the C one, which is written so that both give the same result.
+ */
+typedef struct util_audio_dsp_ops
+{
+	void (*interleave2)(float* dst, const float* l, const float* r,
+			uint32_t n);
+	void (*deinterleave2)(float* l, float* r, const float* src, uint32_t n);
+	void (*f32_to_s16)(int16_t* dst, const float* src, uint32_t n,
+			uint32_t* seed);
+	void (*s16_to_f32)(float* dst, const int16_t* src, uint32_t n);
+	void (*downmix)(float* l, float* r, const float* const* src, uint32_t ch,
+			const float* coef, uint32_t n);
+	void (*gain)(float* dst, const float* src, uint32_t n, float from,
+			float step);
+	void (*meter)(const float* src, uint32_t n, float* peak, float* sum);
+} util_audio_dsp_ops_t;
+
+// *************************************
+// *       Function prototypes         *
+// *************************************
+
+static void util_audio_dsp_interleave2_c(float* dst, const float* l,
+		const float* r, uint32_t i, uint32_t n);
+static void util_audio_dsp_deinterleave2_c(float* l, float* r,
+		const float* src, uint32_t i, uint32_t n);
+static void util_audio_dsp_f32_to_s16_c(int16_t* dst, const float* src,
+		uint32_t i, uint32_t n, uint32_t* seed);
+static void util_audio_dsp_s16_to_f32_c(float* dst, const int16_t* src,
+		uint32_t i, uint32_t n);
+static void util_audio_dsp_downmix_c(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t i,
+		uint32_t n);
+static void util_audio_dsp_gain_c(float* dst, const float* src, uint32_t i,
+		uint32_t n, float from, float step);
+static void util_audio_dsp_meter_c(const float* src, uint32_t i, uint32_t n,
+		float* peak, float* sum);
+static const util_audio_dsp_ops_t* util_audio_dsp_ops_get(void);
+static bool util_audio_dsp_supported(util_audio_dsp_isa_t isa);
+
+/* C */
+static void util_audio_dsp_interleave2_gen(float* dst, const float* l,
+		const float* r, uint32_t n);
+static void util_audio_dsp_deinterleave2_gen(float* l, float* r,
+		const float* src, uint32_t n);
+static void util_audio_dsp_f32_to_s16_gen(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed);
+static void util_audio_dsp_s16_to_f32_gen(float* dst, const int16_t* src,
+		uint32_t n);
+static void util_audio_dsp_downmix_gen(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n);
+static void util_audio_dsp_gain_gen(float* dst, const float* src, uint32_t n,
+		float from, float step);
+static void util_audio_dsp_meter_gen(const float* src, uint32_t n,
+		float* peak, float* sum);
+
+#ifdef UTIL_AUDIO_DSP_SSE2
+static void util_audio_dsp_interleave2_sse2(float* dst, const float* l,
+		const float* r, uint32_t n);
+static void util_audio_dsp_deinterleave2_sse2(float* l, float* r,
+		const float* src, uint32_t n);
+static void util_audio_dsp_f32_to_s16_sse2(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed);
+static void util_audio_dsp_s16_to_f32_sse2(float* dst, const int16_t* src,
+		uint32_t n);
+static void util_audio_dsp_downmix_sse2(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n);
+static void util_audio_dsp_gain_sse2(float* dst, const float* src, uint32_t n,
+		float from, float step);
+static void util_audio_dsp_meter_sse2(const float* src, uint32_t n,
+		float* peak, float* sum);
+#endif
+#ifdef UTIL_AUDIO_DSP_AVX2
+static void util_audio_dsp_interleave2_avx2(float* dst, const float* l,
+		const float* r, uint32_t n);
+static void util_audio_dsp_deinterleave2_avx2(float* l, float* r,
+		const float* src, uint32_t n);
+static void util_audio_dsp_f32_to_s16_avx2(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed);
+static void util_audio_dsp_s16_to_f32_avx2(float* dst, const int16_t* src,
+		uint32_t n);
+static void util_audio_dsp_downmix_avx2(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n);
+static void util_audio_dsp_gain_avx2(float* dst, const float* src, uint32_t n,
+		float from, float step);
+static void util_audio_dsp_meter_avx2(const float* src, uint32_t n,
+		float* peak, float* sum);
+#endif
+#ifdef UTIL_AUDIO_DSP_NEON
+static void util_audio_dsp_interleave2_neon(float* dst, const float* l,
+		const float* r, uint32_t n);
+static void util_audio_dsp_deinterleave2_neon(float* l, float* r,
+		const float* src, uint32_t n);
+static void util_audio_dsp_f32_to_s16_neon(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed);
+static void util_audio_dsp_s16_to_f32_neon(float* dst, const int16_t* src,
+		uint32_t n);
+static void util_audio_dsp_downmix_neon(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n);
+static void util_audio_dsp_gain_neon(float* dst, const float* src, uint32_t n,
+		float from, float step);
+static void util_audio_dsp_meter_neon(const float* src, uint32_t n,
+		float* peak, float* sum);
+#endif
+
+// *************************************
+// *         Local variables           *
+// *************************************
+
+static const util_audio_dsp_ops_t util_audio_dsp_ops[UTIL_AUDIO_DSP_ISA_CNT] =
+{
+	[UTIL_AUDIO_DSP_ISA_C] =
+	{
+		util_audio_dsp_interleave2_gen, util_audio_dsp_deinterleave2_gen,
+		util_audio_dsp_f32_to_s16_gen, util_audio_dsp_s16_to_f32_gen,
+		util_audio_dsp_downmix_gen, util_audio_dsp_gain_gen,
+		util_audio_dsp_meter_gen
+	},
+#ifdef UTIL_AUDIO_DSP_SSE2
+	[UTIL_AUDIO_DSP_ISA_SSE2] =
+	{
+		util_audio_dsp_interleave2_sse2, util_audio_dsp_deinterleave2_sse2,
+		util_audio_dsp_f32_to_s16_sse2, util_audio_dsp_s16_to_f32_sse2,
+		util_audio_dsp_downmix_sse2, util_audio_dsp_gain_sse2,
+		util_audio_dsp_meter_sse2
+	},
+#endif
+#ifdef UTIL_AUDIO_DSP_AVX2
+	[UTIL_AUDIO_DSP_ISA_AVX2] =
+	{
+		util_audio_dsp_interleave2_avx2, util_audio_dsp_deinterleave2_avx2,
+		util_audio_dsp_f32_to_s16_avx2, util_audio_dsp_s16_to_f32_avx2,
+		util_audio_dsp_downmix_avx2, util_audio_dsp_gain_avx2,
+		util_audio_dsp_meter_avx2
+	},
+#endif
+#ifdef UTIL_AUDIO_DSP_NEON
+	[UTIL_AUDIO_DSP_ISA_NEON] =
+	{
+		util_audio_dsp_interleave2_neon, util_audio_dsp_deinterleave2_neon,
+		util_audio_dsp_f32_to_s16_neon, util_audio_dsp_s16_to_f32_neon,
+		util_audio_dsp_downmix_neon, util_audio_dsp_gain_neon,
+		util_audio_dsp_meter_neon
+	},
+#endif
+};
+
+/* Picked on first use; every thread picks the same, so no lock */
+static volatile int util_audio_dsp_cur = -1;
+
+// *************************************
+// *         Global functions          *
+// *************************************
+
+util_audio_dsp_isa_t util_audio_dsp_isa_get(void)
+{
+	return (util_audio_dsp_isa_t)(util_audio_dsp_ops_get() -
+			util_audio_dsp_ops);
+}
+
+eos_error_t util_audio_dsp_isa_set(util_audio_dsp_isa_t isa)
+{
+	if(isa >= UTIL_AUDIO_DSP_ISA_CNT)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(!util_audio_dsp_supported(isa))
+	{
+		return EOS_ERROR_NIMPLEMENTED;
+	}
+	util_audio_dsp_cur = (int)isa;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_dither_init(util_audio_dsp_dither_t* dither,
+		uint32_t seed)
+{
+	uint32_t i = 0;
+
+	if(dither == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	for(i = 0; i < UTIL_AUDIO_DSP_DITHER_LANES; i++)
+	{
+		/* Lanes must differ, and xorshift never leaves zero */
+		dither->seed[i] = (seed ^ 0x9E3779B9U) + i * 0x6C8E9CF5U;
+		if(dither->seed[i] == 0)
+		{
+			dither->seed[i] = i + 1;
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_interleave(float* dst, const float* const* src,
+		uint32_t ch, uint32_t n)
+{
+	uint32_t i = 0, c = 0;
+
+	if(dst == NULL || src == NULL || ch == 0)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(ch == 2)
+	{
+		util_audio_dsp_ops_get()->interleave2(dst, src[0], src[1], n);
+		return EOS_ERROR_OK;
+	}
+	for(i = 0; i < n; i++)
+	{
+		for(c = 0; c < ch; c++)
+		{
+			*dst++ = src[c][i];
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_deinterleave(float* const* dst, const float* src,
+		uint32_t ch, uint32_t n)
+{
+	uint32_t i = 0, c = 0;
+
+	if(dst == NULL || src == NULL || ch == 0)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(ch == 2)
+	{
+		util_audio_dsp_ops_get()->deinterleave2(dst[0], dst[1], src, n);
+		return EOS_ERROR_OK;
+	}
+	for(i = 0; i < n; i++)
+	{
+		for(c = 0; c < ch; c++)
+		{
+			dst[c][i] = *src++;
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_f32_to_s16(int16_t* dst, const float* src,
+		uint32_t n, util_audio_dsp_dither_t* dither)
+{
+	if(dst == NULL || src == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_audio_dsp_ops_get()->f32_to_s16(dst, src, n,
+			dither != NULL ? dither->seed : NULL);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_s16_to_f32(float* dst, const int16_t* src,
+		uint32_t n)
+{
+	if(dst == NULL || src == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_audio_dsp_ops_get()->s16_to_f32(dst, src, n);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_downmix(float* const* dst, const float* const* src,
+		uint32_t ch, const float* coef, uint32_t n)
+{
+	if(dst == NULL || src == NULL || coef == NULL || ch == 0)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_audio_dsp_ops_get()->downmix(dst[0], dst[1], src, ch, coef, n);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_gain(float* dst, const float* src, uint32_t n,
+		float from, float to)
+{
+	if(dst == NULL || src == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(n == 0)
+	{
+		return EOS_ERROR_OK;
+	}
+	util_audio_dsp_ops_get()->gain(dst, src, n, from, (to - from) / (float)n);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_audio_dsp_meter(util_audio_dsp_meter_t* meter,
+		const float* src, uint32_t n)
+{
+	float peak = 0.0f, sum = 0.0f;
+
+	if(meter == NULL || src == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_audio_dsp_ops_get()->meter(src, n, &peak, &sum);
+	if(peak > meter->peak)
+	{
+		meter->peak = peak;
+	}
+	meter->sum += sum;
+	meter->cnt += n;
+
+	return EOS_ERROR_OK;
+}
+
+float util_audio_dsp_meter_ms(util_audio_dsp_meter_t* meter)
+{
+	if(meter == NULL || meter->cnt == 0)
+	{
+		return 0.0f;
+	}
+
+	return (float)(meter->sum / (double)meter->cnt);
+}
+
+eos_error_t util_audio_dsp_meter_rst(util_audio_dsp_meter_t* meter)
+{
+	if(meter == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	meter->peak = 0.0f;
+	meter->sum = 0.0;
+	meter->cnt = 0;
+
+	return EOS_ERROR_OK;
+}
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+static bool util_audio_dsp_supported(util_audio_dsp_isa_t isa)
+{
+	switch(isa)
+	{
+	case UTIL_AUDIO_DSP_ISA_C:
+		return true;
+#ifdef UTIL_AUDIO_DSP_SSE2
+	case UTIL_AUDIO_DSP_ISA_SSE2:
+		return true;
+#endif
+#ifdef UTIL_AUDIO_DSP_AVX2
+	case UTIL_AUDIO_DSP_ISA_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+#ifdef UTIL_AUDIO_DSP_NEON
+	case UTIL_AUDIO_DSP_ISA_NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+static const util_audio_dsp_ops_t* util_audio_dsp_ops_get(void)
+{
+	int cur = util_audio_dsp_cur;
+
+	if(cur < 0)
+	{
+		for(cur = UTIL_AUDIO_DSP_ISA_CNT - 1; cur > UTIL_AUDIO_DSP_ISA_C; cur--)
+		{
+			if(util_audio_dsp_supported((util_audio_dsp_isa_t)cur))
+			{
+				break;
+			}
+		}
+		util_audio_dsp_cur = cur;
+	}
+
+	return &util_audio_dsp_ops[cur];
+}
+
+static inline uint32_t util_audio_dsp_xorshift(uint32_t x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return x;
+}
+
+/* Uniform [0, 1): random mantissa under a 1.0 exponent, minus one */
+static inline float util_audio_dsp_unif(uint32_t x)
+{
+	union
+	{
+		uint32_t u;
+		float f;
+	} v;
+
+	v.u = (x >> 9) | UTIL_AUDIO_DSP_ONE_BITS;
+
+	return v.f - 1.0f;
+}
+
+static void util_audio_dsp_interleave2_c(float* dst, const float* l,
+		const float* r, uint32_t i, uint32_t n)
+{
+	for(; i < n; i++)
+	{
+		dst[2 * i] = l[i];
+		dst[2 * i + 1] = r[i];
+	}
+}
+
+static void util_audio_dsp_deinterleave2_c(float* l, float* r,
+		const float* src, uint32_t i, uint32_t n)
+{
+	for(; i < n; i++)
+	{
+		l[i] = src[2 * i];
+		r[i] = src[2 * i + 1];
+	}
+}
+
+static void util_audio_dsp_f32_to_s16_c(int16_t* dst, const float* src,
+		uint32_t i, uint32_t n, uint32_t* seed)
+{
+	uint32_t *s = NULL;
+	float v = 0.0f, u = 0.0f;
+
+	for(; i < n; i++)
+	{
+		v = src[i] * UTIL_AUDIO_DSP_S16_SCALE;
+		if(seed != NULL)
+		{
+			/* Sample i always takes lane i % 8, as the vector code does */
+			s = &seed[UTIL_AUDIO_DSP_LANE(i)];
+			*s = util_audio_dsp_xorshift(*s);
+			u = util_audio_dsp_unif(*s);
+			*s = util_audio_dsp_xorshift(*s);
+			v = v + (u - util_audio_dsp_unif(*s));
+		}
+		v = v < UTIL_AUDIO_DSP_S16_MIN ? UTIL_AUDIO_DSP_S16_MIN : v;
+		v = v > UTIL_AUDIO_DSP_S16_MAX ? UTIL_AUDIO_DSP_S16_MAX : v;
+		v = (v + UTIL_AUDIO_DSP_RND) - UTIL_AUDIO_DSP_RND;
+		dst[i] = (int16_t)v;
+	}
+}
+
+static void util_audio_dsp_s16_to_f32_c(float* dst, const int16_t* src,
+		uint32_t i, uint32_t n)
+{
+	for(; i < n; i++)
+	{
+		dst[i] = (float)src[i] * (1.0f / UTIL_AUDIO_DSP_S16_SCALE);
+	}
+}
+
+static void util_audio_dsp_downmix_c(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t i,
+		uint32_t n)
+{
+	uint32_t c = 0;
+	float acc_l = 0.0f, acc_r = 0.0f;
+
+	for(; i < n; i++)
+	{
+		acc_l = 0.0f;
+		acc_r = 0.0f;
+		for(c = 0; c < ch; c++)
+		{
+			acc_l = acc_l + coef[c] * src[c][i];
+			acc_r = acc_r + coef[ch + c] * src[c][i];
+		}
+		l[i] = acc_l;
+		r[i] = acc_r;
+	}
+}
+
+static void util_audio_dsp_gain_c(float* dst, const float* src, uint32_t i,
+		uint32_t n, float from, float step)
+{
+	for(; i < n; i++)
+	{
+		dst[i] = src[i] * (from + step * (float)(i + 1));
+	}
+}
+
+static void util_audio_dsp_meter_c(const float* src, uint32_t i, uint32_t n,
+		float* peak, float* sum)
+{
+	float a = 0.0f;
+
+	for(; i < n; i++)
+	{
+		a = src[i] < 0.0f ? -src[i] : src[i];
+		if(a > *peak)
+		{
+			*peak = a;
+		}
+		*sum += src[i] * src[i];
+	}
+}
+
+static void util_audio_dsp_interleave2_gen(float* dst, const float* l,
+		const float* r, uint32_t n)
+{
+	util_audio_dsp_interleave2_c(dst, l, r, 0, n);
+}
+
+static void util_audio_dsp_deinterleave2_gen(float* l, float* r,
+		const float* src, uint32_t n)
+{
+	util_audio_dsp_deinterleave2_c(l, r, src, 0, n);
+}
+
+static void util_audio_dsp_f32_to_s16_gen(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed)
+{
+	util_audio_dsp_f32_to_s16_c(dst, src, 0, n, seed);
+}
+
+static void util_audio_dsp_s16_to_f32_gen(float* dst, const int16_t* src,
+		uint32_t n)
+{
+	util_audio_dsp_s16_to_f32_c(dst, src, 0, n);
+}
+
+static void util_audio_dsp_downmix_gen(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n)
+{
+	util_audio_dsp_downmix_c(l, r, src, ch, coef, 0, n);
+}
+
+static void util_audio_dsp_gain_gen(float* dst, const float* src, uint32_t n,
+		float from, float step)
+{
+	util_audio_dsp_gain_c(dst, src, 0, n, from, step);
+}
+
+static void util_audio_dsp_meter_gen(const float* src, uint32_t n,
+		float* peak, float* sum)
+{
+	util_audio_dsp_meter_c(src, 0, n, peak, sum);
+}
+
+#ifdef UTIL_AUDIO_DSP_SSE2
+
+static inline __m128i util_audio_dsp_xorshift_sse2(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+
+	return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+static inline __m128 util_audio_dsp_tpdf_sse2(__m128i* s)
+{
+	const __m128i one_bits = _mm_set1_epi32((int)UTIL_AUDIO_DSP_ONE_BITS);
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 u1, u2;
+
+	*s = util_audio_dsp_xorshift_sse2(*s);
+	u1 = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(*s, 9),
+			one_bits)), one);
+	*s = util_audio_dsp_xorshift_sse2(*s);
+	u2 = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(*s, 9),
+			one_bits)), one);
+
+	return _mm_sub_ps(u1, u2);
+}
+
+static void util_audio_dsp_interleave2_sse2(float* dst, const float* l,
+		const float* r, uint32_t n)
+{
+	uint32_t i = 0;
+	__m128 a, b;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		a = _mm_loadu_ps(l + i);
+		b = _mm_loadu_ps(r + i);
+		_mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(a, b));
+		_mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(a, b));
+	}
+	util_audio_dsp_interleave2_c(dst, l, r, i, n);
+}
+
+static void util_audio_dsp_deinterleave2_sse2(float* l, float* r,
+		const float* src, uint32_t n)
+{
+	uint32_t i = 0;
+	__m128 a, b;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		a = _mm_loadu_ps(src + 2 * i);
+		b = _mm_loadu_ps(src + 2 * i + 4);
+		_mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	util_audio_dsp_deinterleave2_c(l, r, src, i, n);
+}
+
+static void util_audio_dsp_f32_to_s16_sse2(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed)
+{
+	const __m128 scale = _mm_set1_ps(UTIL_AUDIO_DSP_S16_SCALE);
+	const __m128 lo = _mm_set1_ps(UTIL_AUDIO_DSP_S16_MIN);
+	const __m128 hi = _mm_set1_ps(UTIL_AUDIO_DSP_S16_MAX);
+	__m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+	__m128 v0, v1;
+	uint32_t i = 0;
+
+	if(seed != NULL)
+	{
+		s0 = _mm_loadu_si128((const __m128i*)seed);
+		s1 = _mm_loadu_si128((const __m128i*)(seed + 4));
+	}
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		v0 = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+		v1 = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+		if(seed != NULL)
+		{
+			v0 = _mm_add_ps(v0, util_audio_dsp_tpdf_sse2(&s0));
+			v1 = _mm_add_ps(v1, util_audio_dsp_tpdf_sse2(&s1));
+		}
+		v0 = _mm_min_ps(_mm_max_ps(v0, lo), hi);
+		v1 = _mm_min_ps(_mm_max_ps(v1, lo), hi);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(
+				_mm_cvtps_epi32(v0), _mm_cvtps_epi32(v1)));
+	}
+	if(seed != NULL)
+	{
+		_mm_storeu_si128((__m128i*)seed, s0);
+		_mm_storeu_si128((__m128i*)(seed + 4), s1);
+	}
+	util_audio_dsp_f32_to_s16_c(dst, src, i, n, seed);
+}
+
+static void util_audio_dsp_s16_to_f32_sse2(float* dst, const int16_t* src,
+		uint32_t n)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / UTIL_AUDIO_DSP_S16_SCALE);
+	__m128i x;
+	uint32_t i = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		x = _mm_loadu_si128((const __m128i*)(src + i));
+		/* Sign extend: sample into the upper half, shift back down */
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(
+				_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+		_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(
+				_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+	}
+	util_audio_dsp_s16_to_f32_c(dst, src, i, n);
+}
+
+static void util_audio_dsp_downmix_sse2(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n)
+{
+	__m128 acc_l, acc_r, x;
+	uint32_t i = 0, c = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		acc_l = _mm_setzero_ps();
+		acc_r = _mm_setzero_ps();
+		for(c = 0; c < ch; c++)
+		{
+			x = _mm_loadu_ps(src[c] + i);
+			acc_l = _mm_add_ps(acc_l, _mm_mul_ps(_mm_set1_ps(coef[c]), x));
+			acc_r = _mm_add_ps(acc_r, _mm_mul_ps(_mm_set1_ps(coef[ch + c]), x));
+		}
+		_mm_storeu_ps(l + i, acc_l);
+		_mm_storeu_ps(r + i, acc_r);
+	}
+	util_audio_dsp_downmix_c(l, r, src, ch, coef, i, n);
+}
+
+static void util_audio_dsp_gain_sse2(float* dst, const float* src, uint32_t n,
+		float from, float step)
+{
+	const __m128 base = _mm_set_ps(4.0f, 3.0f, 2.0f, 1.0f);
+	const __m128 f = _mm_set1_ps(from), s = _mm_set1_ps(step);
+	__m128 g;
+	uint32_t i = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		g = _mm_add_ps(f, _mm_mul_ps(s, _mm_add_ps(_mm_set1_ps((float)i), base)));
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+	}
+	util_audio_dsp_gain_c(dst, src, i, n, from, step);
+}
+
+static void util_audio_dsp_meter_sse2(const float* src, uint32_t n,
+		float* peak, float* sum)
+{
+	const __m128 abs_msk = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 pk = _mm_setzero_ps(), acc = _mm_setzero_ps(), x;
+	float lanes_pk[4], lanes_acc[4];
+	uint32_t i = 0, k = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		x = _mm_loadu_ps(src + i);
+		pk = _mm_max_ps(pk, _mm_and_ps(x, abs_msk));
+		acc = _mm_add_ps(acc, _mm_mul_ps(x, x));
+	}
+	_mm_storeu_ps(lanes_pk, pk);
+	_mm_storeu_ps(lanes_acc, acc);
+	for(k = 0; k < 4; k++)
+	{
+		*peak = lanes_pk[k] > *peak ? lanes_pk[k] : *peak;
+		*sum += lanes_acc[k];
+	}
+	util_audio_dsp_meter_c(src, i, n, peak, sum);
+}
+
+#endif /* UTIL_AUDIO_DSP_SSE2 */
+
+#ifdef UTIL_AUDIO_DSP_AVX2
+
+#define UTIL_AUDIO_DSP_AVX2_FN __attribute__((target("avx2")))
+
+UTIL_AUDIO_DSP_AVX2_FN
+static inline __m256i util_audio_dsp_xorshift_avx2(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+
+	return _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static inline __m256 util_audio_dsp_tpdf_avx2(__m256i* s)
+{
+	const __m256i one_bits = _mm256_set1_epi32((int)UTIL_AUDIO_DSP_ONE_BITS);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	__m256 u1, u2;
+
+	*s = util_audio_dsp_xorshift_avx2(*s);
+	u1 = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_srli_epi32(*s, 9), one_bits)), one);
+	*s = util_audio_dsp_xorshift_avx2(*s);
+	u2 = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_or_si256(
+			_mm256_srli_epi32(*s, 9), one_bits)), one);
+
+	return _mm256_sub_ps(u1, u2);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_interleave2_avx2(float* dst, const float* l,
+		const float* r, uint32_t n)
+{
+	uint32_t i = 0;
+	__m256 a, b, lo, hi;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		a = _mm256_loadu_ps(l + i);
+		b = _mm256_loadu_ps(r + i);
+		/* Unpacks stay within 128 bit halves, put the halves in order */
+		lo = _mm256_unpacklo_ps(a, b);
+		hi = _mm256_unpackhi_ps(a, b);
+		_mm256_storeu_ps(dst + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(dst + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+	util_audio_dsp_interleave2_c(dst, l, r, i, n);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_deinterleave2_avx2(float* l, float* r,
+		const float* src, uint32_t n)
+{
+	const __m256i idx = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+	uint32_t i = 0;
+	__m256 a, b;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		/* Lefts to the lower half, rights to the upper one */
+		a = _mm256_permutevar8x32_ps(_mm256_loadu_ps(src + 2 * i), idx);
+		b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(src + 2 * i + 8), idx);
+		_mm256_storeu_ps(l + i, _mm256_permute2f128_ps(a, b, 0x20));
+		_mm256_storeu_ps(r + i, _mm256_permute2f128_ps(a, b, 0x31));
+	}
+	util_audio_dsp_deinterleave2_c(l, r, src, i, n);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_f32_to_s16_avx2(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed)
+{
+	const __m256 scale = _mm256_set1_ps(UTIL_AUDIO_DSP_S16_SCALE);
+	const __m256 lo = _mm256_set1_ps(UTIL_AUDIO_DSP_S16_MIN);
+	const __m256 hi = _mm256_set1_ps(UTIL_AUDIO_DSP_S16_MAX);
+	__m256i s = _mm256_setzero_si256(), q;
+	__m256 v;
+	uint32_t i = 0;
+
+	if(seed != NULL)
+	{
+		s = _mm256_loadu_si256((const __m256i*)seed);
+	}
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		v = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+		if(seed != NULL)
+		{
+			v = _mm256_add_ps(v, util_audio_dsp_tpdf_avx2(&s));
+		}
+		v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+		q = _mm256_cvtps_epi32(v);
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(
+				_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+	}
+	if(seed != NULL)
+	{
+		_mm256_storeu_si256((__m256i*)seed, s);
+	}
+	util_audio_dsp_f32_to_s16_c(dst, src, i, n, seed);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_s16_to_f32_avx2(float* dst, const int16_t* src,
+		uint32_t n)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / UTIL_AUDIO_DSP_S16_SCALE);
+	uint32_t i = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(
+				_mm256_cvtepi16_epi32(_mm_loadu_si128(
+						(const __m128i*)(src + i)))), scale));
+	}
+	util_audio_dsp_s16_to_f32_c(dst, src, i, n);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_downmix_avx2(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n)
+{
+	__m256 acc_l, acc_r, x;
+	uint32_t i = 0, c = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		acc_l = _mm256_setzero_ps();
+		acc_r = _mm256_setzero_ps();
+		for(c = 0; c < ch; c++)
+		{
+			x = _mm256_loadu_ps(src[c] + i);
+			acc_l = _mm256_add_ps(acc_l, _mm256_mul_ps(
+					_mm256_set1_ps(coef[c]), x));
+			acc_r = _mm256_add_ps(acc_r, _mm256_mul_ps(
+					_mm256_set1_ps(coef[ch + c]), x));
+		}
+		_mm256_storeu_ps(l + i, acc_l);
+		_mm256_storeu_ps(r + i, acc_r);
+	}
+	util_audio_dsp_downmix_c(l, r, src, ch, coef, i, n);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_gain_avx2(float* dst, const float* src, uint32_t n,
+		float from, float step)
+{
+	const __m256 base = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f,
+			7.0f, 8.0f);
+	const __m256 f = _mm256_set1_ps(from), s = _mm256_set1_ps(step);
+	__m256 g;
+	uint32_t i = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		g = _mm256_add_ps(f, _mm256_mul_ps(s,
+				_mm256_add_ps(_mm256_set1_ps((float)i), base)));
+		_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+	}
+	util_audio_dsp_gain_c(dst, src, i, n, from, step);
+}
+
+UTIL_AUDIO_DSP_AVX2_FN
+static void util_audio_dsp_meter_avx2(const float* src, uint32_t n,
+		float* peak, float* sum)
+{
+	const __m256 abs_msk = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+	__m256 pk = _mm256_setzero_ps(), acc = _mm256_setzero_ps(), x;
+	float lanes_pk[8], lanes_acc[8];
+	uint32_t i = 0, k = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		x = _mm256_loadu_ps(src + i);
+		pk = _mm256_max_ps(pk, _mm256_and_ps(x, abs_msk));
+		acc = _mm256_add_ps(acc, _mm256_mul_ps(x, x));
+	}
+	_mm256_storeu_ps(lanes_pk, pk);
+	_mm256_storeu_ps(lanes_acc, acc);
+	for(k = 0; k < 8; k++)
+	{
+		*peak = lanes_pk[k] > *peak ? lanes_pk[k] : *peak;
+		*sum += lanes_acc[k];
+	}
+	util_audio_dsp_meter_c(src, i, n, peak, sum);
+}
+
+#endif /* UTIL_AUDIO_DSP_AVX2 */
+
+#ifdef UTIL_AUDIO_DSP_NEON
+
+static inline uint32x4_t util_audio_dsp_xorshift_neon(uint32x4_t x)
+{
+	x = veorq_u32(x, vshlq_n_u32(x, 13));
+	x = veorq_u32(x, vshrq_n_u32(x, 17));
+
+	return veorq_u32(x, vshlq_n_u32(x, 5));
+}
+
+static inline float32x4_t util_audio_dsp_tpdf_neon(uint32x4_t* s)
+{
+	const uint32x4_t one_bits = vdupq_n_u32(UTIL_AUDIO_DSP_ONE_BITS);
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	float32x4_t u1, u2;
+
+	*s = util_audio_dsp_xorshift_neon(*s);
+	u1 = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(*s, 9),
+			one_bits)), one);
+	*s = util_audio_dsp_xorshift_neon(*s);
+	u2 = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vshrq_n_u32(*s, 9),
+			one_bits)), one);
+
+	return vsubq_f32(u1, u2);
+}
+
+static void util_audio_dsp_interleave2_neon(float* dst, const float* l,
+		const float* r, uint32_t n)
+{
+	float32x4x2_t v;
+	uint32_t i = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		v.val[0] = vld1q_f32(l + i);
+		v.val[1] = vld1q_f32(r + i);
+		vst2q_f32(dst + 2 * i, v);
+	}
+	util_audio_dsp_interleave2_c(dst, l, r, i, n);
+}
+
+static void util_audio_dsp_deinterleave2_neon(float* l, float* r,
+		const float* src, uint32_t n)
+{
+	float32x4x2_t v;
+	uint32_t i = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		v = vld2q_f32(src + 2 * i);
+		vst1q_f32(l + i, v.val[0]);
+		vst1q_f32(r + i, v.val[1]);
+	}
+	util_audio_dsp_deinterleave2_c(l, r, src, i, n);
+}
+
+static void util_audio_dsp_f32_to_s16_neon(int16_t* dst, const float* src,
+		uint32_t n, uint32_t* seed)
+{
+	const float32x4_t scale = vdupq_n_f32(UTIL_AUDIO_DSP_S16_SCALE);
+	const float32x4_t lo = vdupq_n_f32(UTIL_AUDIO_DSP_S16_MIN);
+	const float32x4_t hi = vdupq_n_f32(UTIL_AUDIO_DSP_S16_MAX);
+	const float32x4_t rnd = vdupq_n_f32(UTIL_AUDIO_DSP_RND);
+	uint32x4_t s0 = vdupq_n_u32(0), s1 = vdupq_n_u32(0);
+	float32x4_t v0, v1;
+	uint32_t i = 0;
+
+	if(seed != NULL)
+	{
+		s0 = vld1q_u32(seed);
+		s1 = vld1q_u32(seed + 4);
+	}
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		v0 = vmulq_f32(vld1q_f32(src + i), scale);
+		v1 = vmulq_f32(vld1q_f32(src + i + 4), scale);
+		if(seed != NULL)
+		{
+			v0 = vaddq_f32(v0, util_audio_dsp_tpdf_neon(&s0));
+			v1 = vaddq_f32(v1, util_audio_dsp_tpdf_neon(&s1));
+		}
+		v0 = vminq_f32(vmaxq_f32(v0, lo), hi);
+		v1 = vminq_f32(vmaxq_f32(v1, lo), hi);
+		/* ARMv7 converts by truncation, round first (exact after that) */
+		v0 = vsubq_f32(vaddq_f32(v0, rnd), rnd);
+		v1 = vsubq_f32(vaddq_f32(v1, rnd), rnd);
+		vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(v0)),
+				vqmovn_s32(vcvtq_s32_f32(v1))));
+	}
+	if(seed != NULL)
+	{
+		vst1q_u32(seed, s0);
+		vst1q_u32(seed + 4, s1);
+	}
+	util_audio_dsp_f32_to_s16_c(dst, src, i, n, seed);
+}
+
+static void util_audio_dsp_s16_to_f32_neon(float* dst, const int16_t* src,
+		uint32_t n)
+{
+	const float32x4_t scale = vdupq_n_f32(1.0f / UTIL_AUDIO_DSP_S16_SCALE);
+	int16x8_t x;
+	uint32_t i = 0;
+
+	for(i = 0; i + 8 <= n; i += 8)
+	{
+		x = vld1q_s16(src + i);
+		vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(
+				vmovl_s16(vget_low_s16(x))), scale));
+		vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(
+				vmovl_s16(vget_high_s16(x))), scale));
+	}
+	util_audio_dsp_s16_to_f32_c(dst, src, i, n);
+}
+
+static void util_audio_dsp_downmix_neon(float* l, float* r,
+		const float* const* src, uint32_t ch, const float* coef, uint32_t n)
+{
+	float32x4_t acc_l, acc_r, x;
+	uint32_t i = 0, c = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		acc_l = vdupq_n_f32(0.0f);
+		acc_r = vdupq_n_f32(0.0f);
+		for(c = 0; c < ch; c++)
+		{
+			/* No vmla: a fused/unrounded step would differ from the C code */
+			x = vld1q_f32(src[c] + i);
+			acc_l = vaddq_f32(acc_l, vmulq_n_f32(x, coef[c]));
+			acc_r = vaddq_f32(acc_r, vmulq_n_f32(x, coef[ch + c]));
+		}
+		vst1q_f32(l + i, acc_l);
+		vst1q_f32(r + i, acc_r);
+	}
+	util_audio_dsp_downmix_c(l, r, src, ch, coef, i, n);
+}
+
+static void util_audio_dsp_gain_neon(float* dst, const float* src, uint32_t n,
+		float from, float step)
+{
+	const float base_f[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+	const float32x4_t base = vld1q_f32(base_f);
+	const float32x4_t f = vdupq_n_f32(from), s = vdupq_n_f32(step);
+	float32x4_t g;
+	uint32_t i = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		g = vaddq_f32(f, vmulq_f32(s, vaddq_f32(vdupq_n_f32((float)i), base)));
+		vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), g));
+	}
+	util_audio_dsp_gain_c(dst, src, i, n, from, step);
+}
+
+static void util_audio_dsp_meter_neon(const float* src, uint32_t n,
+		float* peak, float* sum)
+{
+	float32x4_t pk = vdupq_n_f32(0.0f), acc = vdupq_n_f32(0.0f), x;
+	float lanes_pk[4], lanes_acc[4];
+	uint32_t i = 0, k = 0;
+
+	for(i = 0; i + 4 <= n; i += 4)
+	{
+		x = vld1q_f32(src + i);
+		pk = vmaxq_f32(pk, vabsq_f32(x));
+		acc = vaddq_f32(acc, vmulq_f32(x, x));
+	}
+	vst1q_f32(lanes_pk, pk);
+	vst1q_f32(lanes_acc, acc);
+	for(k = 0; k < 4; k++)
+	{
+		*peak = lanes_pk[k] > *peak ? lanes_pk[k] : *peak;
+		*sum += lanes_acc[k];
+	}
+	util_audio_dsp_meter_c(src, i, n, peak, sum);
+}
+
+#endif /* UTIL_AUDIO_DSP_NEON */
@@ -0,0 +1,179 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+#ifndef UTIL_AUDIO_DSP_H_
+#define UTIL_AUDIO_DSP_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+
+/* Dither generator lanes (widest vector), output does not depend on the ISA */
+#define UTIL_AUDIO_DSP_DITHER_LANES (8)
+
+/**
+ * Kernel sets. The best one the CPU supports is picked on first use.
+ */
+typedef enum util_audio_dsp_isa
+{
+	UTIL_AUDIO_DSP_ISA_C = 0, /**< Portable C */
+	UTIL_AUDIO_DSP_ISA_SSE2,  /**< x86 SSE2 */
+	UTIL_AUDIO_DSP_ISA_AVX2,  /**< x86 AVX2 (checked at run time) */
+	UTIL_AUDIO_DSP_ISA_NEON,  /**< ARM NEON */
+	UTIL_AUDIO_DSP_ISA_CNT
+} util_audio_dsp_isa_t;
+
+/**
+ * TPDF dither state (one xorshift generator per lane).
+ */
+typedef struct util_audio_dsp_dither
+{
+	uint32_t seed[UTIL_AUDIO_DSP_DITHER_LANES];
+} util_audio_dsp_dither_t;
+
+/**
+ * Level meter, accumulates until reset.
+ */
+typedef struct util_audio_dsp_meter
+{
+	float peak;   /**< Largest absolute sample */
+	double sum;   /**< Sum of squares */
+	uint64_t cnt; /**< Samples */
+} util_audio_dsp_meter_t;
+
+/**
+ * Gets kernel set in use.
+ * @return Kernel set.
+ */
+util_audio_dsp_isa_t util_audio_dsp_isa_get(void);
+/**
+ * Selects kernel set (meant for tests and benchmarking).
+ * @param isa Kernel set.
+ * @return EOS_ERROR_OK on success, EOS_ERROR_NIMPLEMENTED if it is not built
+ * in or not supported by the CPU.
+ */
+eos_error_t util_audio_dsp_isa_set(util_audio_dsp_isa_t isa);
+/**
+ * Seeds dither generator.
+ * @param dither Dither state.
+ * @param seed Any value.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_dither_init(util_audio_dsp_dither_t* dither,
+		uint32_t seed);
+/**
+ * Interleaves planar samples.
+ * @param dst Interleaved output (`ch` * `n` samples).
+ * @param src Planes.
+ * @param ch Number of channels.
+ * @param n Samples per channel.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_interleave(float* dst, const float* const* src,
+		uint32_t ch, uint32_t n);
+/**
+ * Splits interleaved samples into planes.
+ * @param dst Planes.
+ * @param src Interleaved input (`ch` * `n` samples).
+ * @param ch Number of channels.
+ * @param n Samples per channel.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_deinterleave(float* const* dst, const float* src,
+		uint32_t ch, uint32_t n);
+/**
+ * Converts float [-1, 1) to S16 with saturation.
+ * With dither, triangular noise of one LSB peak is added before rounding.
+ * @param dst Output.
+ * @param src Input.
+ * @param n Number of samples.
+ * @param dither Dither state, or `NULL` for plain rounding.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_f32_to_s16(int16_t* dst, const float* src,
+		uint32_t n, util_audio_dsp_dither_t* dither);
+/**
+ * Converts S16 to float [-1, 1).
+ * @param dst Output.
+ * @param src Input.
+ * @param n Number of samples.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_s16_to_f32(float* dst, const int16_t* src,
+		uint32_t n);
+/**
+ * Mixes planar channels down to two planes.
+ * @param dst Left and right output planes.
+ * @param src Input planes.
+ * @param ch Number of input channels.
+ * @param coef Mixing matrix: `ch` coefficients for left, then `ch` for right.
+ * @param n Samples per channel.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_downmix(float* const* dst, const float* const* src,
+		uint32_t ch, const float* coef, uint32_t n);
+/**
+ * Applies gain moving linearly from `from` to `to` over the block (the last
+ * sample gets `to`), so that gain changes do not click. May work in place.
+ * @param dst Output.
+ * @param src Input.
+ * @param n Number of samples.
+ * @param from Gain before the block.
+ * @param to Gain at the end of the block.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_gain(float* dst, const float* src, uint32_t n,
+		float from, float to);
+/**
+ * Adds block peak and energy to the meter.
+ * @param meter Meter.
+ * @param src Samples.
+ * @param n Number of samples.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_meter(util_audio_dsp_meter_t* meter,
+		const float* src, uint32_t n);
+/**
+ * Gets mean square of the metered samples (RMS squared, 1.0 is full scale).
+ * @param meter Meter.
+ * @return Mean square (0 if nothing was metered).
+ */
+float util_audio_dsp_meter_ms(util_audio_dsp_meter_t* meter);
+/**
+ * Resets the meter.
+ * @param meter Meter.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_audio_dsp_meter_rst(util_audio_dsp_meter_t* meter);
+
+#endif /* UTIL_AUDIO_DSP_H_ */
@@ -0,0 +1,516 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+// *************************************
+// *       Module name definition      *
+// *************************************
+
+#define MODULE_NAME "bbuff"
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "osi_mutex.h"
+#include "osi_memory.h"
+#include "osi_bin_sem.h"
+#include "util_bcast_buff.h"
+#include "util_log.h"
+
+#include <stdlib.h>
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+#define SLOT_IDX(buff,seq) ((uint32_t)((seq) % (buff)->count))
+#define SLOT_ADDR(buff,seq) ((buff)->start + SLOT_IDX(buff, seq) * (buff)->segment_size)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+typedef enum util_bcast_buff_state
+{
+	BCAST_BUFF_STOPPED = 0,
+	BCAST_BUFF_EXECUTING
+} util_bcast_buff_state_t;
+
+typedef struct util_bcast_buff_slot
+{
+	/** Sequence number of the segment stored in the slot */
+	uint64_t seq;
+	/** Useful data size */
+	uint32_t size;
+	/** Readers which did not release the segment yet */
+	uint32_t refs;
+} util_bcast_buff_slot_t;
+
+struct util_bcast_buff_reader
+{
+	util_bcast_buff_t *owner;
+	util_bcast_buff_policy_t policy;
+	/** Next segment to be read */
+	uint64_t next_seq;
+	/** Oldest segment which is read, but not released */
+	uint64_t release_seq;
+	uint32_t dropped;
+	osi_bin_sem_t *sem_data;
+	struct util_bcast_buff_reader *next;
+};
+
+struct util_bcast_buff
+{
+	uint8_t *start;
+	uint32_t segment_size;
+	uint32_t count;
+	util_bcast_buff_slot_t *slots;
+
+	/** Sequence number of the next segment to be written */
+	uint64_t write_seq;
+	bool allocated;
+
+	util_bcast_buff_reader_t *readers;
+	uint32_t reader_count;
+
+	osi_mutex_t *lock;
+	osi_bin_sem_t *sem_free;
+
+	util_bcast_buff_state_t state;
+};
+
+// *************************************
+// *            Prototypes             *
+// *************************************
+
+static void util_bcast_buff_ms_to_time(int32_t timeout, osi_time_t* time);
+static void util_bcast_buff_drop_laggards(util_bcast_buff_t* bbuff, util_bcast_buff_slot_t* slot);
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+static void util_bcast_buff_ms_to_time(int32_t timeout, osi_time_t* time)
+{
+	div_t divide = {0, 0};
+
+	time->sec = 0;
+	time->nsec = 0;
+	if (timeout != UTIL_BCAST_BUFF_FOREVER)
+	{
+		divide = div(timeout, 1000);
+		time->sec = divide.quot;
+		time->nsec = divide.rem * 1000000;
+	}
+}
+
+/* Called with the lock held. Skips the slot for every dropping reader which did not read it yet. */
+static void util_bcast_buff_drop_laggards(util_bcast_buff_t* bbuff, util_bcast_buff_slot_t* slot)
+{
+	util_bcast_buff_reader_t *reader = NULL;
+
+	for (reader = bbuff->readers; reader != NULL; reader = reader->next)
+	{
+		if ((reader->policy != UTIL_BCAST_BUFF_POLICY_DROP) || (reader->next_seq > slot->seq))
+		{
+			continue;
+		}
+		/* The oldest slot is not read, so nothing is held by this reader */
+		reader->next_seq = slot->seq + 1;
+		reader->release_seq = reader->next_seq;
+		reader->dropped++;
+		slot->refs--;
+	}
+}
+
+// *************************************
+// *         Global functions          *
+// *************************************
+
+eos_error_t util_bcast_buff_create(util_bcast_buff_t** bbuff, uint8_t* data, uint32_t size,
+                                   uint32_t segment_size)
+{
+	eos_error_t error = EOS_ERROR_OK;
+	util_bcast_buff_t *tmp = NULL;
+
+	if ((bbuff == NULL) || (data == NULL) || (segment_size == 0) || (size / segment_size < 2))
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	tmp = (util_bcast_buff_t*)osi_calloc(sizeof(util_bcast_buff_t));
+	if (tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->count = size / segment_size;
+	tmp->slots = (util_bcast_buff_slot_t*)osi_calloc(tmp->count * sizeof(util_bcast_buff_slot_t));
+	if (tmp->slots == NULL)
+	{
+		osi_free((void**)&tmp);
+		return EOS_ERROR_NOMEM;
+	}
+
+	error = osi_mutex_create(&tmp->lock);
+	if (error != EOS_ERROR_OK)
+	{
+		osi_free((void**)&tmp->slots);
+		osi_free((void**)&tmp);
+		return error;
+	}
+
+	error = osi_bin_sem_create(&tmp->sem_free, false);
+	if (error != EOS_ERROR_OK)
+	{
+		osi_mutex_destroy(&tmp->lock);
+		osi_free((void**)&tmp->slots);
+		osi_free((void**)&tmp);
+		return error;
+	}
+
+	tmp->start = data;
+	tmp->segment_size = segment_size;
+	tmp->write_seq = 0;
+	tmp->allocated = false;
+	tmp->readers = NULL;
+	tmp->reader_count = 0;
+	tmp->state = BCAST_BUFF_EXECUTING;
+
+	*bbuff = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_destroy(util_bcast_buff_t** bbuff)
+{
+	util_bcast_buff_t *tmp = NULL;
+
+	if ((bbuff == NULL) || (*bbuff == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = *bbuff;
+
+	osi_mutex_lock(tmp->lock);
+	if (tmp->readers != NULL)
+	{
+		osi_mutex_unlock(tmp->lock);
+		UTIL_GLOGE("%u reader(s) still attached", tmp->reader_count);
+		return EOS_ERROR_PERM;
+	}
+	osi_mutex_unlock(tmp->lock);
+
+	osi_bin_sem_destroy(&tmp->sem_free);
+	osi_mutex_destroy(&tmp->lock);
+	osi_free((void**)&tmp->slots);
+	osi_free((void**)bbuff);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_attach(util_bcast_buff_t* bbuff, util_bcast_buff_policy_t policy,
+                                   util_bcast_buff_reader_t** reader)
+{
+	eos_error_t error = EOS_ERROR_OK;
+	util_bcast_buff_reader_t *tmp = NULL;
+
+	if ((bbuff == NULL) || (reader == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	tmp = (util_bcast_buff_reader_t*)osi_calloc(sizeof(util_bcast_buff_reader_t));
+	if (tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	error = osi_bin_sem_create(&tmp->sem_data, false);
+	if (error != EOS_ERROR_OK)
+	{
+		osi_free((void**)&tmp);
+		return error;
+	}
+	tmp->owner = bbuff;
+	tmp->policy = policy;
+	tmp->dropped = 0;
+
+	osi_mutex_lock(bbuff->lock);
+	tmp->next_seq = bbuff->write_seq;
+	tmp->release_seq = bbuff->write_seq;
+	tmp->next = bbuff->readers;
+	bbuff->readers = tmp;
+	bbuff->reader_count++;
+	osi_mutex_unlock(bbuff->lock);
+
+	*reader = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_detach(util_bcast_buff_t* bbuff, util_bcast_buff_reader_t** reader)
+{
+	util_bcast_buff_reader_t *tmp = NULL;
+	util_bcast_buff_reader_t **iter = NULL;
+	uint64_t seq = 0;
+
+	if ((bbuff == NULL) || (reader == NULL) || (*reader == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = *reader;
+	if (tmp->owner != bbuff)
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	osi_mutex_lock(bbuff->lock);
+	for (iter = &bbuff->readers; *iter != NULL; iter = &(*iter)->next)
+	{
+		if (*iter == tmp)
+		{
+			*iter = tmp->next;
+			break;
+		}
+	}
+	bbuff->reader_count--;
+	/* Everything held or not yet read by this reader is referenced */
+	for (seq = tmp->release_seq; seq < bbuff->write_seq; seq++)
+	{
+		bbuff->slots[SLOT_IDX(bbuff, seq)].refs--;
+	}
+	osi_bin_sem_give(bbuff->sem_free);
+	osi_mutex_unlock(bbuff->lock);
+
+	osi_bin_sem_destroy(&tmp->sem_data);
+	osi_free((void**)reader);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_allocate(util_bcast_buff_t* bbuff, int32_t timeout,
+                                     uint8_t** address, uint32_t* size)
+{
+	eos_error_t error = EOS_ERROR_OK;
+	util_bcast_buff_slot_t *slot = NULL;
+	osi_time_t msec = {0, 0};
+
+	if ((bbuff == NULL) || (address == NULL) || (size == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_bcast_buff_ms_to_time(timeout, &msec);
+
+	osi_mutex_lock(bbuff->lock);
+	if (bbuff->allocated)
+	{
+		osi_mutex_unlock(bbuff->lock);
+		return EOS_ERROR_BUSY;
+	}
+	slot = &bbuff->slots[SLOT_IDX(bbuff, bbuff->write_seq)];
+	while ((bbuff->state == BCAST_BUFF_EXECUTING) && (slot->refs != 0))
+	{
+		util_bcast_buff_drop_laggards(bbuff, slot);
+		if (slot->refs == 0)
+		{
+			break;
+		}
+		/* Some blocking reader is behind (or still holds the segment) */
+		osi_mutex_unlock(bbuff->lock);
+		if (timeout != UTIL_BCAST_BUFF_FOREVER)
+		{
+			error = osi_bin_sem_timedtake(bbuff->sem_free, &msec);
+		}
+		else
+		{
+			error = osi_bin_sem_take(bbuff->sem_free);
+		}
+		if (error != EOS_ERROR_OK)
+		{
+			return error;
+		}
+		osi_mutex_lock(bbuff->lock);
+	}
+	if (bbuff->state != BCAST_BUFF_EXECUTING)
+	{
+		osi_mutex_unlock(bbuff->lock);
+		return EOS_ERROR_PERM;
+	}
+	bbuff->allocated = true;
+	*address = SLOT_ADDR(bbuff, bbuff->write_seq);
+	*size = bbuff->segment_size;
+	osi_mutex_unlock(bbuff->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_commit(util_bcast_buff_t* bbuff, uint8_t* address, uint32_t size)
+{
+	util_bcast_buff_slot_t *slot = NULL;
+	util_bcast_buff_reader_t *reader = NULL;
+
+	if ((bbuff == NULL) || (address == NULL) || (size > bbuff->segment_size))
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	osi_mutex_lock(bbuff->lock);
+	if ((bbuff->allocated == false) || (address != SLOT_ADDR(bbuff, bbuff->write_seq)))
+	{
+		osi_mutex_unlock(bbuff->lock);
+		return EOS_ERROR_INVAL;
+	}
+	slot = &bbuff->slots[SLOT_IDX(bbuff, bbuff->write_seq)];
+	slot->seq = bbuff->write_seq;
+	slot->size = size;
+	/* Without readers segment is free right away */
+	slot->refs = bbuff->reader_count;
+	bbuff->write_seq++;
+	bbuff->allocated = false;
+	for (reader = bbuff->readers; reader != NULL; reader = reader->next)
+	{
+		osi_bin_sem_give(reader->sem_data);
+	}
+	osi_mutex_unlock(bbuff->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_stop(util_bcast_buff_t* bbuff)
+{
+	util_bcast_buff_reader_t *reader = NULL;
+
+	if (bbuff == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	osi_mutex_lock(bbuff->lock);
+	bbuff->state = BCAST_BUFF_STOPPED;
+	for (reader = bbuff->readers; reader != NULL; reader = reader->next)
+	{
+		osi_bin_sem_give(reader->sem_data);
+	}
+	osi_bin_sem_give(bbuff->sem_free);
+	osi_mutex_unlock(bbuff->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_read(util_bcast_buff_reader_t* reader, int32_t timeout,
+                                 uint8_t** address, uint32_t* size)
+{
+	eos_error_t error = EOS_ERROR_OK;
+	util_bcast_buff_t *bbuff = NULL;
+	osi_time_t msec = {0, 0};
+
+	if ((reader == NULL) || (address == NULL) || (size == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	bbuff = reader->owner;
+	util_bcast_buff_ms_to_time(timeout, &msec);
+
+	osi_mutex_lock(bbuff->lock);
+	while (reader->next_seq == bbuff->write_seq)
+	{
+		if (bbuff->state != BCAST_BUFF_EXECUTING)
+		{
+			osi_mutex_unlock(bbuff->lock);
+			return EOS_ERROR_EOF;
+		}
+		osi_mutex_unlock(bbuff->lock);
+		if (timeout != UTIL_BCAST_BUFF_FOREVER)
+		{
+			error = osi_bin_sem_timedtake(reader->sem_data, &msec);
+		}
+		else
+		{
+			error = osi_bin_sem_take(reader->sem_data);
+		}
+		if (error != EOS_ERROR_OK)
+		{
+			return error;
+		}
+		osi_mutex_lock(bbuff->lock);
+	}
+	*address = SLOT_ADDR(bbuff, reader->next_seq);
+	*size = bbuff->slots[SLOT_IDX(bbuff, reader->next_seq)].size;
+	reader->next_seq++;
+	osi_mutex_unlock(bbuff->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_release(util_bcast_buff_reader_t* reader, uint8_t* address)
+{
+	util_bcast_buff_t *bbuff = NULL;
+	util_bcast_buff_slot_t *slot = NULL;
+
+	if ((reader == NULL) || (address == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	bbuff = reader->owner;
+
+	osi_mutex_lock(bbuff->lock);
+	if ((reader->release_seq == reader->next_seq) ||
+	    (address != SLOT_ADDR(bbuff, reader->release_seq)))
+	{
+		osi_mutex_unlock(bbuff->lock);
+		return EOS_ERROR_INVAL;
+	}
+	slot = &bbuff->slots[SLOT_IDX(bbuff, reader->release_seq)];
+	slot->refs--;
+	reader->release_seq++;
+	if (slot->refs == 0)
+	{
+		osi_bin_sem_give(bbuff->sem_free);
+	}
+	osi_mutex_unlock(bbuff->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_bcast_buff_get_dropped(util_bcast_buff_reader_t* reader, uint32_t* dropped)
+{
+	if ((reader == NULL) || (dropped == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+
+	osi_mutex_lock(reader->owner->lock);
+	*dropped = reader->dropped;
+	osi_mutex_unlock(reader->owner->lock);
+
+	return EOS_ERROR_OK;
+}
@@ -0,0 +1,155 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#ifndef UTIL_BCAST_BUFF_H_
+#define UTIL_BCAST_BUFF_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+
+#define UTIL_BCAST_BUFF_FOREVER (-1)
+
+/**
+ * Broadcast buffer handle.
+ * One writer fills fixed size segments, while any number of readers consume
+ * all of them independently, each one with its own cursor.
+ * Segment is reused only after all readers are done with it.
+ */
+typedef struct util_bcast_buff util_bcast_buff_t;
+/**
+ * Broadcast buffer reader (cursor) handle.
+ */
+typedef struct util_bcast_buff_reader util_bcast_buff_reader_t;
+
+/**
+ * What happens with the reader which is too slow to follow the writer.
+ */
+typedef enum util_bcast_buff_policy
+{
+	/** Writer waits until the reader releases the oldest segment */
+	UTIL_BCAST_BUFF_POLICY_BLOCK = 0,
+	/** Unread segments are dropped for the reader, so the writer is never blocked by it */
+	UTIL_BCAST_BUFF_POLICY_DROP
+} util_bcast_buff_policy_t;
+
+/**
+ * Creates broadcast buffer on top of the caller supplied memory.
+ * @param bbuff Pointer to the handle (output).
+ * @param data Memory used for the buffer.
+ * @param size Memory size in bytes.
+ * @param segment_size Segment size in bytes (e.g. multiple of TS packet size).
+ * At least two segments have to fit in the buffer.
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_create(util_bcast_buff_t** bbuff, uint8_t* data, uint32_t size,
+                                   uint32_t segment_size);
+/**
+ * Destroys broadcast buffer. All readers have to be detached before.
+ * @param bbuff Pointer to the handle.
+ * @return EOS_ERROR_OK, or EOS_ERROR_PERM if some reader is still attached.
+ */
+eos_error_t util_bcast_buff_destroy(util_bcast_buff_t** bbuff);
+
+/**
+ * Attaches new reader. Reader starts at the current write position,
+ * so it will receive only segments committed after this call.
+ * @param bbuff Broadcast buffer handle.
+ * @param policy Laggard policy for this reader.
+ * @param reader Pointer to the reader handle (output).
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_attach(util_bcast_buff_t* bbuff, util_bcast_buff_policy_t policy,
+                                   util_bcast_buff_reader_t** reader);
+/**
+ * Detaches the reader. All segments the reader still holds (or did not read) are released.
+ * @param bbuff Broadcast buffer handle.
+ * @param reader Pointer to the reader handle.
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_detach(util_bcast_buff_t* bbuff, util_bcast_buff_reader_t** reader);
+
+/**
+ * Allocates next segment for writing (whole segment is always given).
+ * @param bbuff Broadcast buffer handle.
+ * @param timeout Timeout in milliseconds. Pass UTIL_BCAST_BUFF_FOREVER for blocking call.
+ * @param address Segment address (output).
+ * @param size Segment size (output).
+ * @return EOS_ERROR_OK, EOS_ERROR_TIMEDOUT if blocking reader did not release the segment
+ * in time, or EOS_ERROR_PERM if the buffer is stopped.
+ */
+eos_error_t util_bcast_buff_allocate(util_bcast_buff_t* bbuff, int32_t timeout,
+                                     uint8_t** address, uint32_t* size);
+/**
+ * Commits allocated segment and makes it available to all attached readers.
+ * @param bbuff Broadcast buffer handle.
+ * @param address Segment address returned by <code>util_bcast_buff_allocate</code>.
+ * @param size Amount of useful data in the segment.
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_commit(util_bcast_buff_t* bbuff, uint8_t* address, uint32_t size);
+/**
+ * Signals end of stream. Readers still get all committed data,
+ * after which they get EOS_ERROR_EOF. Writer can not allocate anymore.
+ * @param bbuff Broadcast buffer handle.
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_stop(util_bcast_buff_t* bbuff);
+
+/**
+ * Lends the next segment to the reader (zero-copy).
+ * Segments have to be released in the same order they were read.
+ * @param reader Reader handle.
+ * @param timeout Timeout in milliseconds. Pass UTIL_BCAST_BUFF_FOREVER for blocking call.
+ * @param address Segment data (output).
+ * @param size Segment data size (output).
+ * @return EOS_ERROR_OK, EOS_ERROR_TIMEDOUT if there is no new data,
+ * or EOS_ERROR_EOF if the buffer is stopped and all data is read.
+ */
+eos_error_t util_bcast_buff_read(util_bcast_buff_reader_t* reader, int32_t timeout,
+                                 uint8_t** address, uint32_t* size);
+/**
+ * Gives the oldest read segment back to the buffer.
+ * @param reader Reader handle.
+ * @param address Segment address returned by <code>util_bcast_buff_read</code>.
+ * @return EOS_ERROR_OK, or EOS_ERROR_INVAL if the address is not the oldest segment held.
+ */
+eos_error_t util_bcast_buff_release(util_bcast_buff_reader_t* reader, uint8_t* address);
+/**
+ * Returns number of segments dropped for this reader (UTIL_BCAST_BUFF_POLICY_DROP only).
+ * @param reader Reader handle.
+ * @param dropped Dropped segments count (output).
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_bcast_buff_get_dropped(util_bcast_buff_reader_t* reader, uint32_t* dropped);
+
+#endif // UTIL_BCAST_BUFF_H_
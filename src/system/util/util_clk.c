@@ -0,0 +1,361 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+// *************************************
+// *       Module name definition      *
+// *************************************
+
+#define MODULE_NAME "util_clk"
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "util_clk.h"
+#include "osi_memory.h"
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+/* External reference jumping more than this is taken as is, not smoothed */
+#define UTIL_CLK_DISCONT (UTIL_CLK_HZ)
+/* External reference moves by 1/N of the measured error per report */
+#define UTIL_CLK_EXT_GAIN (16)
+/* Late frames dropped in a row before one is shown anyway */
+#define UTIL_CLK_DROP_MAX (8)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+typedef struct util_clk_ref
+{
+	/* Odd while the writer is in the middle of an update */
+	volatile uint32_t seq;
+	volatile int64_t pts;
+	volatile int64_t at;
+	volatile bool valid;
+} util_clk_ref_t;
+
+struct util_clk
+{
+	util_clk_ref_t ref[UTIL_CLK_SRC_CNT];
+	volatile util_clk_src_t master;
+	/* Presentation offset to the external reference, fixed at first frame */
+	volatile bool ext_anchored;
+	int64_t ext_offset;
+	uint32_t late_cnt;
+	volatile uint32_t dropped;
+	volatile uint32_t repeated;
+};
+
+// *************************************
+// *       Function prototypes         *
+// *************************************
+
+static inline int64_t util_clk_usec(osi_time_t* time);
+static void util_clk_ref_write(util_clk_ref_t* ref, int64_t pts, int64_t at,
+		bool valid);
+static bool util_clk_ref_read(util_clk_ref_t* ref, int64_t* pts, int64_t* at);
+static bool util_clk_ref_val(util_clk_ref_t* ref, int64_t now, int64_t* pts);
+
+// *************************************
+// *         Global functions          *
+// *************************************
+
+eos_error_t util_clk_create(util_clk_t** clk)
+{
+	util_clk_t *tmp = NULL;
+
+	if(clk == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = (util_clk_t*)osi_calloc(sizeof(util_clk_t));
+	if(tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->master = UTIL_CLK_SRC_VID;
+	*clk = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_destroy(util_clk_t** clk)
+{
+	if(clk == NULL || *clk == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_free((void**)clk);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_set_master(util_clk_t* clk, util_clk_src_t master)
+{
+	if(clk == NULL || master >= UTIL_CLK_SRC_CNT)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	clk->master = master;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_reset(util_clk_t* clk)
+{
+	int i = 0;
+
+	if(clk == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	for(i=0; i<UTIL_CLK_SRC_CNT; i++)
+	{
+		util_clk_ref_write(&clk->ref[i], 0, 0, false);
+	}
+	clk->ext_anchored = false;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_update(util_clk_t* clk, util_clk_src_t src, int64_t pts,
+		osi_time_t* at)
+{
+	int64_t now = 0, cur = 0, diff = 0;
+
+	if(clk == NULL || at == NULL || src >= UTIL_CLK_SRC_CNT)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	now = util_clk_usec(at);
+	/* Arrival of external references jitters, follow it slowly */
+	if(src == UTIL_CLK_SRC_EXT && util_clk_ref_val(&clk->ref[src], now, &cur))
+	{
+		diff = pts - cur;
+		if(diff < UTIL_CLK_DISCONT && diff > -UTIL_CLK_DISCONT)
+		{
+			pts = cur + diff / UTIL_CLK_EXT_GAIN;
+		}
+	}
+	util_clk_ref_write(&clk->ref[src], pts, now, true);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_get(util_clk_t* clk, util_clk_src_t src, osi_time_t* now,
+		int64_t* pts)
+{
+	if(clk == NULL || now == NULL || pts == NULL || src >= UTIL_CLK_SRC_CNT)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(!util_clk_ref_val(&clk->ref[src], util_clk_usec(now), pts))
+	{
+		return EOS_ERROR_NFOUND;
+	}
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_sched(util_clk_t* clk, int64_t pts, uint32_t dur,
+		uint32_t max_wait, osi_time_t* now, osi_time_t* deadline,
+		util_clk_act_t* act)
+{
+	util_clk_src_t src = UTIL_CLK_SRC_VID;
+	int64_t now_us = 0, clock = 0, wait = 0;
+
+	if(clk == NULL || now == NULL || deadline == NULL || act == NULL ||
+			dur == 0)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	now_us = util_clk_usec(now);
+	src = clk->master;
+	if(!util_clk_ref_val(&clk->ref[src], now_us, &clock))
+	{
+		src = UTIL_CLK_SRC_VID;
+		if(!util_clk_ref_val(&clk->ref[src], now_us, &clock))
+		{
+			/* First frame starts the video clock */
+			util_clk_ref_write(&clk->ref[src], pts, now_us, true);
+			clock = pts;
+		}
+	}
+	if(src == UTIL_CLK_SRC_EXT)
+	{
+		if(!clk->ext_anchored)
+		{
+			clk->ext_offset = pts - clock;
+			clk->ext_anchored = true;
+		}
+		clock += clk->ext_offset;
+	}
+	wait = pts - clock;
+	*act = UTIL_CLK_ACT_SHOW;
+	if(wait > (int64_t)max_wait)
+	{
+		/* Discontinuity (or master far behind), continue at frame rate */
+		if(src == UTIL_CLK_SRC_VID)
+		{
+			util_clk_ref_write(&clk->ref[src], pts - dur, now_us, true);
+		}
+		else if(src == UTIL_CLK_SRC_EXT)
+		{
+			clk->ext_anchored = false;
+		}
+		wait = dur;
+	}
+	else if(wait < -(int64_t)max_wait && src != UTIL_CLK_SRC_AUD)
+	{
+		/* Own clock is way off (stall or discontinuity), start over here */
+		if(src == UTIL_CLK_SRC_VID)
+		{
+			util_clk_ref_write(&clk->ref[src], pts, now_us, true);
+		}
+		else
+		{
+			clk->ext_anchored = false;
+		}
+		wait = 0;
+	}
+	else if(wait < -(int64_t)dur)
+	{
+		if(clk->late_cnt < UTIL_CLK_DROP_MAX)
+		{
+			clk->late_cnt++;
+			__sync_fetch_and_add(&clk->dropped, 1);
+			*act = UTIL_CLK_ACT_DROP;
+			return EOS_ERROR_OK;
+		}
+		wait = 0;
+	}
+	else if(wait < 0)
+	{
+		wait = 0;
+	}
+	else if(wait > (int64_t)dur)
+	{
+		/* Previous frame stays on screen for the extra periods */
+		__sync_fetch_and_add(&clk->repeated, (uint32_t)((wait - 1) / dur));
+	}
+	clk->late_cnt = 0;
+	now_us += UTIL_CLK_TICKS_TO_USEC(wait);
+	deadline->sec = (uint32_t)(now_us / OSI_TIME_MICROS);
+	deadline->nsec = (uint32_t)OSI_TIME_USEC_TO_NSEC(now_us % OSI_TIME_MICROS);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_stats(util_clk_t* clk, uint32_t* dropped,
+		uint32_t* repeated)
+{
+	if(clk == NULL || dropped == NULL || repeated == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	*dropped = __sync_fetch_and_add(&clk->dropped, 0);
+	*repeated = __sync_fetch_and_add(&clk->repeated, 0);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_clk_stats_rst(util_clk_t* clk)
+{
+	if(clk == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	__sync_lock_test_and_set(&clk->dropped, 0);
+	__sync_lock_test_and_set(&clk->repeated, 0);
+
+	return EOS_ERROR_OK;
+}
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+static inline int64_t util_clk_usec(osi_time_t* time)
+{
+	return OSI_TIME_SEC_TO_USEC((int64_t)time->sec) +
+			OSI_TIME_NSEC_TO_USEC((int64_t)time->nsec);
+}
+
+static void util_clk_ref_write(util_clk_ref_t* ref, int64_t pts, int64_t at,
+		bool valid)
+{
+	/* Full barriers, readers see either the old or the new reference */
+	__sync_fetch_and_add(&ref->seq, 1);
+	ref->pts = pts;
+	ref->at = at;
+	ref->valid = valid;
+	__sync_fetch_and_add(&ref->seq, 1);
+}
+
+static bool util_clk_ref_read(util_clk_ref_t* ref, int64_t* pts, int64_t* at)
+{
+	uint32_t seq = 0;
+	bool valid = false;
+
+	do
+	{
+		while((seq = ref->seq) & 1)
+		{
+			/* Writer is in the middle (a few stores), spin */
+		}
+		__sync_synchronize();
+		*pts = ref->pts;
+		*at = ref->at;
+		valid = ref->valid;
+		__sync_synchronize();
+	} while(seq != ref->seq);
+
+	return valid;
+}
+
+static bool util_clk_ref_val(util_clk_ref_t* ref, int64_t now, int64_t* pts)
+{
+	int64_t at = 0;
+
+	if(!util_clk_ref_read(ref, pts, &at))
+	{
+		return false;
+	}
+	*pts += UTIL_CLK_USEC_TO_TICKS(now - at);
+
+	return true;
+}
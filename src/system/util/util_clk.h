@@ -0,0 +1,154 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#ifndef UTIL_CLK_H_
+#define UTIL_CLK_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+#include "osi_time.h"
+
+/* Clock ticks per second (MPEG system clock base) */
+#define UTIL_CLK_HZ (90000)
+
+#define UTIL_CLK_USEC_TO_TICKS(usec) (((int64_t)(usec) * 9) / 100)
+#define UTIL_CLK_TICKS_TO_USEC(ticks) (((int64_t)(ticks) * 100) / 9)
+
+/**
+ * Clock sources. Master is the one frames are presented against.
+ */
+typedef enum util_clk_src
+{
+	UTIL_CLK_SRC_AUD = 0, /**< Audio renderer: PTS currently heard */
+	UTIL_CLK_SRC_VID,     /**< Video itself: system time anchored at first frame */
+	UTIL_CLK_SRC_EXT,     /**< External (PCR like) reference, smoothed */
+	UTIL_CLK_SRC_CNT
+} util_clk_src_t;
+
+/**
+ * What to do with the frame.
+ */
+typedef enum util_clk_act
+{
+	UTIL_CLK_ACT_SHOW = 0, /**< Show at the deadline */
+	UTIL_CLK_ACT_DROP      /**< Too late, skip it */
+} util_clk_act_t;
+
+typedef struct util_clk util_clk_t;
+
+/**
+ * Creates a clock. Master is video until set otherwise.
+ * @param clk Clock handle (output).
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_create(util_clk_t** clk);
+/**
+ * Destroys a clock.
+ * @param clk Clock handle.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_destroy(util_clk_t** clk);
+/**
+ * Selects master clock. If master has no reference yet (e.g. audio did not
+ * start), frames are presented against video until it gets one.
+ * @param clk Clock handle.
+ * @param master Master clock source.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_set_master(util_clk_t* clk, util_clk_src_t master);
+/**
+ * Forgets all references (discontinuity, flush or resume).
+ * Drop and repeat counters are kept.
+ * @param clk Clock handle.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_reset(util_clk_t* clk);
+/**
+ * Reports that clock source was at `pts` at time `at`.
+ * Every source should be updated from a single thread. Readers never block
+ * writers (sequence lock).
+ * @param clk Clock handle.
+ * @param src Clock source.
+ * @param pts Time stamp (90 kHz).
+ * @param at Monotonic time (osi_time_get_mono()) of the report.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_update(util_clk_t* clk, util_clk_src_t src, int64_t pts,
+		osi_time_t* at);
+/**
+ * Reads clock source value.
+ * @param clk Clock handle.
+ * @param src Clock source.
+ * @param now Monotonic time the value is needed for.
+ * @param pts Clock value (90 kHz, output).
+ * @return EOS_ERROR_OK on success, EOS_ERROR_NFOUND if source has no reference
+ * yet, or other error code.
+ */
+eos_error_t util_clk_get(util_clk_t* clk, util_clk_src_t src, osi_time_t* now,
+		int64_t* pts);
+/**
+ * Schedules video frame against the master clock.
+ * Frames late by more than a frame duration are dropped (but never more than
+ * a few in a row, so the picture keeps moving). Frames waiting more than a frame
+ * duration keep the previous frame on screen, which is counted as repeat.
+ * Frames too far ahead (more than `max_wait`) are treated as a discontinuity.
+ * Should be called from the rendering thread only.
+ * @param clk Clock handle.
+ * @param pts Frame time stamp (90 kHz).
+ * @param dur Frame duration (90 kHz).
+ * @param max_wait Longest wait for the master (90 kHz).
+ * @param now Current monotonic time.
+ * @param deadline When to show the frame (output, valid for UTIL_CLK_ACT_SHOW).
+ * @param act What to do with the frame (output).
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_sched(util_clk_t* clk, int64_t pts, uint32_t dur,
+		uint32_t max_wait, osi_time_t* now, osi_time_t* deadline,
+		util_clk_act_t* act);
+/**
+ * Gets drop and repeat counters (since create or last util_clk_stats_rst()).
+ * @param clk Clock handle.
+ * @param dropped Dropped frames (output).
+ * @param repeated Frame periods the previous frame was held for (output).
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_stats(util_clk_t* clk, uint32_t* dropped,
+		uint32_t* repeated);
+/**
+ * Resets drop and repeat counters.
+ * @param clk Clock handle.
+ * @return EOS_ERROR_OK on success or proper error code.
+ */
+eos_error_t util_clk_stats_rst(util_clk_t* clk);
+
+#endif /* UTIL_CLK_H_ */
@@ -0,0 +1,434 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "util_dispatch.h"
+#include "osi_memory.h"
+#include "osi_mutex.h"
+
+#include <ctype.h>
+
+#define MODULE_NAME "dispatch"
+#include "util_log.h"
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+#define UTIL_DISPATCH_MIN_BUCKETS (16)
+/* Average chain length that triggers growing the table */
+#define UTIL_DISPATCH_LOAD (2)
+#define UTIL_DISPATCH_FNV_BASIS (2166136261U)
+#define UTIL_DISPATCH_FNV_PRIME (16777619U)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+typedef struct util_dispatch_entry
+{
+	struct util_dispatch_entry *next;
+	uint32_t key;
+	void *item;
+} util_dispatch_entry_t;
+
+typedef struct util_dispatch_cached
+{
+	uint32_t hint;
+	void *item;
+} util_dispatch_cached_t;
+
+struct util_dispatch
+{
+	osi_mutex_t *lock;
+	util_dispatch_entry_t **buckets;
+	uint32_t bucket_cnt;
+	uint32_t entry_cnt;
+	util_dispatch_entry_t *any;
+	util_dispatch_cached_t cache[UTIL_DISPATCH_CACHE_SIZE];
+	uint8_t cached;
+};
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+static inline uint32_t util_dispatch_bucket(util_dispatch_t* dispatch,
+		uint32_t key)
+{
+	/* Keys are either small consecutive numbers or hashes already, one
+	 * multiplicative round spreads both */
+	key *= 2654435761U;
+
+	return (key ^ (key >> 16)) & (dispatch->bucket_cnt - 1);
+}
+
+static void util_dispatch_append(util_dispatch_entry_t** head,
+		util_dispatch_entry_t* entry)
+{
+	while (*head != NULL)
+	{
+		head = &(*head)->next;
+	}
+	entry->next = NULL;
+	*head = entry;
+}
+
+static void util_dispatch_grow(util_dispatch_t* dispatch)
+{
+	util_dispatch_entry_t **old = dispatch->buckets;
+	util_dispatch_entry_t *entry = NULL;
+	uint32_t old_cnt = dispatch->bucket_cnt;
+	uint32_t i = 0;
+
+	dispatch->buckets = osi_calloc(2 * old_cnt *
+			sizeof(util_dispatch_entry_t*));
+	if (dispatch->buckets == NULL)
+	{
+		/* Longer chains, still correct */
+		dispatch->buckets = old;
+		return;
+	}
+	dispatch->bucket_cnt = 2 * old_cnt;
+	for (i = 0; i < old_cnt; i++)
+	{
+		while ((entry = old[i]) != NULL)
+		{
+			old[i] = entry->next;
+			util_dispatch_append(&dispatch->buckets[
+					util_dispatch_bucket(dispatch, entry->key)], entry);
+		}
+	}
+	osi_free((void**)&old);
+}
+
+static bool util_dispatch_unlink(util_dispatch_entry_t** head, void* item)
+{
+	util_dispatch_entry_t *entry = NULL;
+	bool found = false;
+
+	while ((entry = *head) != NULL)
+	{
+		if (entry->item == item)
+		{
+			*head = entry->next;
+			osi_free((void**)&entry);
+			found = true;
+			continue;
+		}
+		head = &entry->next;
+	}
+
+	return found;
+}
+
+static void util_dispatch_remember(util_dispatch_t* dispatch, uint32_t hint,
+		void* item, uint8_t at)
+{
+	if (at == dispatch->cached)
+	{
+		/* Not cached, evict the least recently used */
+		if (dispatch->cached < UTIL_DISPATCH_CACHE_SIZE)
+		{
+			dispatch->cached++;
+		}
+		at = dispatch->cached - 1;
+	}
+	osi_memmove(&dispatch->cache[1], &dispatch->cache[0],
+			at * sizeof(util_dispatch_cached_t));
+	dispatch->cache[0].hint = hint;
+	dispatch->cache[0].item = item;
+}
+
+static void util_dispatch_forget(util_dispatch_t* dispatch, void* item)
+{
+	uint8_t i = 0;
+
+	while (i < dispatch->cached)
+	{
+		if (dispatch->cache[i].item == item)
+		{
+			dispatch->cached--;
+			osi_memmove(&dispatch->cache[i], &dispatch->cache[i + 1],
+					(dispatch->cached - i) *
+					sizeof(util_dispatch_cached_t));
+			continue;
+		}
+		i++;
+	}
+}
+
+static util_dispatch_entry_t* util_dispatch_match(
+		util_dispatch_entry_t* entry, uint32_t key,
+		util_dispatch_match_t match, void* cookie)
+{
+	for (; entry != NULL; entry = entry->next)
+	{
+		if (key != UTIL_DISPATCH_ANY && entry->key != key)
+		{
+			continue;
+		}
+		if (match(entry->item, cookie))
+		{
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+// *************************************
+// *         Global functions          *
+// *************************************
+
+eos_error_t util_dispatch_create(util_dispatch_t** dispatch)
+{
+	util_dispatch_t *tmp = NULL;
+	eos_error_t err = EOS_ERROR_OK;
+
+	if (dispatch == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	tmp = osi_calloc(sizeof(util_dispatch_t));
+	if (tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->buckets = osi_calloc(UTIL_DISPATCH_MIN_BUCKETS *
+			sizeof(util_dispatch_entry_t*));
+	if (tmp->buckets == NULL)
+	{
+		osi_free((void**)&tmp);
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->bucket_cnt = UTIL_DISPATCH_MIN_BUCKETS;
+	if ((err = osi_mutex_create(&tmp->lock)) != EOS_ERROR_OK)
+	{
+		osi_free((void**)&tmp->buckets);
+		osi_free((void**)&tmp);
+		return err;
+	}
+	*dispatch = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_dispatch_destroy(util_dispatch_t** dispatch)
+{
+	util_dispatch_entry_t *entry = NULL;
+	uint32_t i = 0;
+
+	if (dispatch == NULL || *dispatch == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	for (i = 0; i < (*dispatch)->bucket_cnt; i++)
+	{
+		while ((entry = (*dispatch)->buckets[i]) != NULL)
+		{
+			(*dispatch)->buckets[i] = entry->next;
+			osi_free((void**)&entry);
+		}
+	}
+	while ((entry = (*dispatch)->any) != NULL)
+	{
+		(*dispatch)->any = entry->next;
+		osi_free((void**)&entry);
+	}
+	osi_mutex_destroy(&(*dispatch)->lock);
+	osi_free((void**)&(*dispatch)->buckets);
+	osi_free((void**)dispatch);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_dispatch_add(util_dispatch_t* dispatch, uint32_t key,
+		void* item)
+{
+	util_dispatch_entry_t *entry = NULL;
+
+	if (dispatch == NULL || item == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	entry = osi_calloc(sizeof(util_dispatch_entry_t));
+	if (entry == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	entry->key = key;
+	entry->item = item;
+	osi_mutex_lock(dispatch->lock);
+	if (key == UTIL_DISPATCH_ANY)
+	{
+		util_dispatch_append(&dispatch->any, entry);
+	}
+	else
+	{
+		if (dispatch->entry_cnt >= UTIL_DISPATCH_LOAD * dispatch->bucket_cnt)
+		{
+			util_dispatch_grow(dispatch);
+		}
+		util_dispatch_append(&dispatch->buckets[
+				util_dispatch_bucket(dispatch, key)], entry);
+		dispatch->entry_cnt++;
+	}
+	osi_mutex_unlock(dispatch->lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_dispatch_remove(util_dispatch_t* dispatch, void* item)
+{
+	util_dispatch_entry_t **head = NULL;
+	util_dispatch_entry_t *entry = NULL;
+	bool found = false;
+	uint32_t i = 0;
+
+	if (dispatch == NULL || item == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(dispatch->lock);
+	for (i = 0; i < dispatch->bucket_cnt; i++)
+	{
+		head = &dispatch->buckets[i];
+		while ((entry = *head) != NULL)
+		{
+			if (entry->item == item)
+			{
+				*head = entry->next;
+				osi_free((void**)&entry);
+				dispatch->entry_cnt--;
+				found = true;
+				continue;
+			}
+			head = &entry->next;
+		}
+	}
+	if (util_dispatch_unlink(&dispatch->any, item))
+	{
+		found = true;
+	}
+	util_dispatch_forget(dispatch, item);
+	osi_mutex_unlock(dispatch->lock);
+
+	return found ? EOS_ERROR_OK : EOS_ERROR_NFOUND;
+}
+
+eos_error_t util_dispatch_find(util_dispatch_t* dispatch, uint32_t key,
+		uint32_t hint, util_dispatch_match_t match, void* cookie,
+		void** item)
+{
+	util_dispatch_entry_t *entry = NULL;
+	uint32_t i = 0;
+	uint8_t at = 0;
+
+	if (dispatch == NULL || match == NULL || item == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(dispatch->lock);
+	if (hint != UTIL_DISPATCH_ANY)
+	{
+		for (at = 0; at < dispatch->cached; at++)
+		{
+			if (dispatch->cache[at].hint != hint)
+			{
+				continue;
+			}
+			if (match(dispatch->cache[at].item, cookie))
+			{
+				*item = dispatch->cache[at].item;
+				util_dispatch_remember(dispatch, hint, *item, at);
+				osi_mutex_unlock(dispatch->lock);
+				return EOS_ERROR_OK;
+			}
+			break;
+		}
+	}
+	if (key != UTIL_DISPATCH_ANY)
+	{
+		entry = util_dispatch_match(dispatch->buckets[
+				util_dispatch_bucket(dispatch, key)], key, match, cookie);
+	}
+	else
+	{
+		for (i = 0; i < dispatch->bucket_cnt && entry == NULL; i++)
+		{
+			entry = util_dispatch_match(dispatch->buckets[i], key, match,
+					cookie);
+		}
+	}
+	if (entry == NULL)
+	{
+		entry = util_dispatch_match(dispatch->any, UTIL_DISPATCH_ANY, match,
+				cookie);
+	}
+	if (entry == NULL)
+	{
+		osi_mutex_unlock(dispatch->lock);
+		return EOS_ERROR_NFOUND;
+	}
+	*item = entry->item;
+	if (hint != UTIL_DISPATCH_ANY)
+	{
+		/* Stale entry for the hint (if any) is replaced */
+		util_dispatch_remember(dispatch, hint, *item, at);
+	}
+	osi_mutex_unlock(dispatch->lock);
+
+	return EOS_ERROR_OK;
+}
+
+uint32_t util_dispatch_hash(const char* str, size_t len)
+{
+	uint32_t hash = UTIL_DISPATCH_FNV_BASIS;
+	size_t i = 0;
+
+	if (str == NULL)
+	{
+		return UTIL_DISPATCH_ANY;
+	}
+	for (i = 0; i < len && str[i] != '\0'; i++)
+	{
+		hash ^= (uint8_t)tolower((unsigned char)str[i]);
+		hash *= UTIL_DISPATCH_FNV_PRIME;
+	}
+
+	return hash == UTIL_DISPATCH_ANY ? 1 : hash;
+}
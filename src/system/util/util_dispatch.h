@@ -0,0 +1,119 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#ifndef UTIL_DISPATCH_H_
+#define UTIL_DISPATCH_H_
+
+#include "eos_types.h"
+
+#include <stddef.h>
+
+/**
+ * Keyed dispatch index used by the factories. Items are stored under
+ * the keys they declare (URI scheme, codec, I/O type...) so a lookup only
+ * visits the candidates registered for the key, plus the items that did
+ * not declare any key. Successful lookups are remembered in a small LRU
+ * cache indexed by a caller chosen hint (e.g. URI prefix) which is tried
+ * first next time.
+ */
+
+/** Key/hint of an item or lookup that matches anything */
+#define UTIL_DISPATCH_ANY (0)
+/** Number of remembered lookups */
+#define UTIL_DISPATCH_CACHE_SIZE (8)
+
+typedef struct util_dispatch util_dispatch_t;
+
+/**
+ * Called for every candidate until it returns true.
+ * @param item Candidate item.
+ * @param cookie Lookup cookie.
+ * @return true if the item is the one being looked for.
+ */
+typedef bool (*util_dispatch_match_t) (void* item, void* cookie);
+
+/**
+ * Creates empty dispatch index.
+ * @param dispatch Index handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_dispatch_create(util_dispatch_t** dispatch);
+/**
+ * Releases the index. Items are not touched.
+ * @param dispatch Index handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_dispatch_destroy(util_dispatch_t** dispatch);
+/**
+ * Stores item under the key. Item can be stored under several keys,
+ * UTIL_DISPATCH_ANY makes it a candidate for every lookup.
+ * @param dispatch Index handle.
+ * @param key Key.
+ * @param item Item.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_dispatch_add(util_dispatch_t* dispatch, uint32_t key,
+		void* item);
+/**
+ * Removes item (under all its keys) and forgets cached lookups of it.
+ * @param dispatch Index handle.
+ * @param item Item.
+ * @return EOS_ERROR_OK on success, EOS_ERROR_NFOUND if not stored.
+ */
+eos_error_t util_dispatch_remove(util_dispatch_t* dispatch, void* item);
+/**
+ * Finds the first candidate accepted by match callback. Cached item for
+ * the hint is tried first, then items stored under the key in the order
+ * they were added, then items stored under UTIL_DISPATCH_ANY. Lookup with
+ * UTIL_DISPATCH_ANY key visits all items. Callback is invoked with the
+ * index locked and must not call back into it.
+ * @param dispatch Index handle.
+ * @param key Lookup key.
+ * @param hint Cache hint, UTIL_DISPATCH_ANY to bypass the cache.
+ * @param match Match callback.
+ * @param cookie Match callback cookie.
+ * @param item Found item.
+ * @return EOS_ERROR_OK on success, EOS_ERROR_NFOUND if nothing matched.
+ */
+eos_error_t util_dispatch_find(util_dispatch_t* dispatch, uint32_t key,
+		uint32_t hint, util_dispatch_match_t match, void* cookie,
+		void** item);
+/**
+ * Case insensitive string hash, never UTIL_DISPATCH_ANY.
+ * @param str String.
+ * @param len String length.
+ * @return Hash.
+ */
+uint32_t util_dispatch_hash(const char* str, size_t len);
+
+#endif /* UTIL_DISPATCH_H_ */
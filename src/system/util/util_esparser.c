@@ -0,0 +1,734 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "util_esparser.h"
+#include "osi_memory.h"
+#define MODULE_NAME "es_parser"
+#include "util_log.h"
+
+#include "bitstream/mpeg/aac.h"
+#include "bitstream/mpeg/mpga.h"
+#include "bitstream/mpeg/mp2v.h"
+#include "bitstream/mpeg/h264.h"
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+/* SPS is small, everything after what is parsed may be cut off */
+#define UTIL_ESPARSER_RBSP_MAX (256)
+
+#define UTIL_ESPARSER_H264_PROFILE_HIGH(profile) ((profile) == 100 || \
+		(profile) == 110 || (profile) == 122 || (profile) == 244 || \
+		(profile) == 44 || (profile) == 83 || (profile) == 86 || \
+		(profile) == 118 || (profile) == 128 || (profile) == 138 || \
+		(profile) == 139 || (profile) == 134 || (profile) == 135)
+
+#define UTIL_ESPARSER_HEVC_NAL_SPS (33)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+typedef struct util_esparser_bits
+{
+	const uint8_t *data;
+	uint32_t len;
+	uint32_t pos;
+	bool err;
+} util_esparser_bits_t;
+
+// *************************************
+// *         Global variables          *
+// *************************************
+
+static const uint32_t aac_rates[] = {96000, 88200, 64000, 48000, 44100,
+		32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350};
+static const uint8_t aac_channels[] = {0, 1, 2, 3, 4, 5, 6, 8};
+static const uint32_t ac3_rates[] = {48000, 44100, 32000};
+static const uint8_t ac3_channels[] = {2, 1, 2, 3, 3, 4, 4, 5};
+static const uint32_t mpga_rates[] = {44100, 48000, 32000};
+/* frame_rate_code to num/den */
+static const uint32_t mp2v_rates[][2] = {{0, 0}, {24000, 1001}, {24, 1},
+		{25, 1}, {30000, 1001}, {30, 1}, {50, 1}, {60000, 1001}, {60, 1}};
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+static uint32_t util_esparser_bits_get(util_esparser_bits_t* bits, uint8_t cnt)
+{
+	uint32_t val = 0;
+
+	if(bits->pos + cnt > bits->len * 8)
+	{
+		bits->err = true;
+		bits->pos = bits->len * 8;
+		return 0;
+	}
+	while(cnt--)
+	{
+		val <<= 1;
+		val |= (bits->data[bits->pos >> 3] >> (7 - (bits->pos & 7))) & 1;
+		bits->pos++;
+	}
+
+	return val;
+}
+
+static void util_esparser_bits_skip(util_esparser_bits_t* bits, uint32_t cnt)
+{
+	if(bits->pos + cnt > bits->len * 8)
+	{
+		bits->err = true;
+		bits->pos = bits->len * 8;
+		return;
+	}
+	bits->pos += cnt;
+}
+
+/* Exp-Golomb, unsigned */
+static uint32_t util_esparser_bits_ue(util_esparser_bits_t* bits)
+{
+	uint8_t zeros = 0;
+
+	while(util_esparser_bits_get(bits, 1) == 0)
+	{
+		if(bits->err || ++zeros > 31)
+		{
+			bits->err = true;
+			return 0;
+		}
+	}
+
+	return ((1U << zeros) - 1) + util_esparser_bits_get(bits, zeros);
+}
+
+/* Exp-Golomb, signed */
+static int32_t util_esparser_bits_se(util_esparser_bits_t* bits)
+{
+	uint32_t val = util_esparser_bits_ue(bits);
+
+	return (val & 1) ? (int32_t)((val + 1) >> 1) : -(int32_t)(val >> 1);
+}
+
+/*
+ * Finds the next start code prefix (00 00 01) and returns the offset of the
+ * first byte after it, or len if there is none.
+ */
+static void util_esparser_set_rate(eos_media_es_attr_t* atr, uint64_t num,
+		uint64_t den)
+{
+	uint64_t a = num, b = den, t = 0;
+
+	if(num == 0 || den == 0)
+	{
+		return;
+	}
+	/* Reduced, so that 60000/2002 ends up as the usual 30000/1001 */
+	while(b != 0)
+	{
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	num /= a;
+	den /= a;
+	if(num > UINT32_MAX || den > UINT32_MAX)
+	{
+		return;
+	}
+	atr->video.rate.num = (uint32_t)num;
+	atr->video.rate.den = (uint32_t)den;
+	atr->video.fps = (uint16_t)((num + den / 2) / den);
+}
+
+static uint32_t util_esparser_find_start(const uint8_t* data, uint32_t len,
+		uint32_t from)
+{
+	uint32_t i = 0;
+
+	for(i = from; i + 3 <= len; i++)
+	{
+		if(data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+		{
+			return i + 3;
+		}
+	}
+
+	return len;
+}
+
+/* Copies NAL unit without emulation prevention bytes, stopping at the next start code */
+static uint32_t util_esparser_rbsp(const uint8_t* nal, uint32_t len,
+		uint8_t* rbsp, uint32_t size)
+{
+	uint32_t i = 0, out = 0, zeros = 0;
+
+	for(i = 0; i < len && out < size; i++)
+	{
+		if(zeros >= 2 && nal[i] == 0x03)
+		{
+			zeros = 0;
+			continue;
+		}
+		if(zeros >= 2 && nal[i] <= 0x01)
+		{
+			/* Next start code, drop trailing zeros */
+			out -= zeros;
+			break;
+		}
+		zeros = nal[i] == 0 ? zeros + 1 : 0;
+		rbsp[out++] = nal[i];
+	}
+
+	return out;
+}
+
+static void util_esparser_h264_scaling_list(util_esparser_bits_t* bits,
+		uint8_t size)
+{
+	int32_t last = 8, next = 8;
+	uint8_t i = 0;
+
+	for(i = 0; i < size && !bits->err; i++)
+	{
+		if(next != 0)
+		{
+			next = (last + util_esparser_bits_se(bits) + 256) % 256;
+		}
+		last = next == 0 ? last : next;
+	}
+}
+
+static eos_error_t util_esparser_h264_sps(util_esparser_bits_t* bits,
+		eos_media_es_attr_t* atr)
+{
+	uint32_t profile = 0, chroma = 1, poc_type = 0, cnt = 0, i = 0;
+	uint32_t w_mbs = 0, h_units = 0, frame_mbs_only = 0;
+	uint32_t crop[4] = {0, 0, 0, 0};
+	uint32_t crop_x = 0, crop_y = 0, tick = 0, scale = 0;
+
+	profile = util_esparser_bits_get(bits, 8);
+	/* constraint flags, level */
+	util_esparser_bits_skip(bits, 16);
+	util_esparser_bits_ue(bits);
+	if(UTIL_ESPARSER_H264_PROFILE_HIGH(profile))
+	{
+		if((chroma = util_esparser_bits_ue(bits)) == 3)
+		{
+			/* separate colour plane is coded as monochrome for cropping */
+			if(util_esparser_bits_get(bits, 1))
+			{
+				chroma = 0;
+			}
+		}
+		util_esparser_bits_ue(bits);
+		util_esparser_bits_ue(bits);
+		util_esparser_bits_skip(bits, 1);
+		if(util_esparser_bits_get(bits, 1))
+		{
+			cnt = chroma == 3 ? 12 : 8;
+			for(i = 0; i < cnt && !bits->err; i++)
+			{
+				if(util_esparser_bits_get(bits, 1))
+				{
+					util_esparser_h264_scaling_list(bits, i < 6 ? 16 : 64);
+				}
+			}
+		}
+	}
+	util_esparser_bits_ue(bits);
+	poc_type = util_esparser_bits_ue(bits);
+	if(poc_type == 0)
+	{
+		util_esparser_bits_ue(bits);
+	}
+	else if(poc_type == 1)
+	{
+		util_esparser_bits_skip(bits, 1);
+		util_esparser_bits_se(bits);
+		util_esparser_bits_se(bits);
+		cnt = util_esparser_bits_ue(bits);
+		for(i = 0; i < cnt && !bits->err; i++)
+		{
+			util_esparser_bits_se(bits);
+		}
+	}
+	util_esparser_bits_ue(bits);
+	util_esparser_bits_skip(bits, 1);
+	w_mbs = util_esparser_bits_ue(bits) + 1;
+	h_units = util_esparser_bits_ue(bits) + 1;
+	if((frame_mbs_only = util_esparser_bits_get(bits, 1)) == 0)
+	{
+		util_esparser_bits_skip(bits, 1);
+	}
+	util_esparser_bits_skip(bits, 1);
+	if(util_esparser_bits_get(bits, 1))
+	{
+		for(i = 0; i < 4; i++)
+		{
+			crop[i] = util_esparser_bits_ue(bits);
+		}
+	}
+	if(bits->err)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	crop_x = chroma == 1 || chroma == 2 ? 2 : 1;
+	crop_y = (2 - frame_mbs_only) * (chroma == 1 ? 2 : 1);
+	atr->video.resolution.width = (uint16_t)(w_mbs * 16 -
+			crop_x * (crop[0] + crop[1]));
+	atr->video.resolution.height = (uint16_t)((2 - frame_mbs_only) *
+			h_units * 16 - crop_y * (crop[2] + crop[3]));
+	/* VUI, only as far as timing info */
+	if(util_esparser_bits_get(bits, 1) == 0)
+	{
+		return EOS_ERROR_OK;
+	}
+	if(util_esparser_bits_get(bits, 1) &&
+			util_esparser_bits_get(bits, 8) == 255)
+	{
+		util_esparser_bits_skip(bits, 32);
+	}
+	if(util_esparser_bits_get(bits, 1))
+	{
+		util_esparser_bits_skip(bits, 1);
+	}
+	if(util_esparser_bits_get(bits, 1))
+	{
+		util_esparser_bits_skip(bits, 4);
+		if(util_esparser_bits_get(bits, 1))
+		{
+			util_esparser_bits_skip(bits, 24);
+		}
+	}
+	if(util_esparser_bits_get(bits, 1))
+	{
+		util_esparser_bits_ue(bits);
+		util_esparser_bits_ue(bits);
+	}
+	if(util_esparser_bits_get(bits, 1))
+	{
+		tick = util_esparser_bits_get(bits, 32);
+		scale = util_esparser_bits_get(bits, 32);
+		if(!bits->err && tick != 0)
+		{
+			/* Two ticks per frame */
+			util_esparser_set_rate(atr, scale, 2 * (uint64_t)tick);
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static eos_error_t util_esparser_hevc_sps(util_esparser_bits_t* bits,
+		eos_media_es_attr_t* atr)
+{
+	uint32_t sub_layers = 0, chroma = 0, w = 0, h = 0, i = 0;
+	uint32_t crop[4] = {0, 0, 0, 0};
+	uint32_t crop_x = 0, crop_y = 0;
+	bool profile[8] = {false}, level[8] = {false};
+
+	util_esparser_bits_skip(bits, 4);
+	sub_layers = util_esparser_bits_get(bits, 3);
+	util_esparser_bits_skip(bits, 1);
+	/* profile_tier_level(): general part */
+	util_esparser_bits_skip(bits, 2 + 1 + 5 + 32 + 48 + 8);
+	for(i = 0; i < sub_layers; i++)
+	{
+		profile[i] = util_esparser_bits_get(bits, 1);
+		level[i] = util_esparser_bits_get(bits, 1);
+	}
+	if(sub_layers > 0)
+	{
+		util_esparser_bits_skip(bits, 2 * (8 - sub_layers));
+	}
+	for(i = 0; i < sub_layers; i++)
+	{
+		if(profile[i])
+		{
+			util_esparser_bits_skip(bits, 88);
+		}
+		if(level[i])
+		{
+			util_esparser_bits_skip(bits, 8);
+		}
+	}
+	util_esparser_bits_ue(bits);
+	if((chroma = util_esparser_bits_ue(bits)) == 3)
+	{
+		if(util_esparser_bits_get(bits, 1))
+		{
+			chroma = 0;
+		}
+	}
+	w = util_esparser_bits_ue(bits);
+	h = util_esparser_bits_ue(bits);
+	if(util_esparser_bits_get(bits, 1))
+	{
+		for(i = 0; i < 4; i++)
+		{
+			crop[i] = util_esparser_bits_ue(bits);
+		}
+	}
+	if(bits->err)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	crop_x = chroma == 1 || chroma == 2 ? 2 : 1;
+	crop_y = chroma == 1 ? 2 : 1;
+	atr->video.resolution.width = (uint16_t)(w - crop_x * (crop[0] + crop[1]));
+	atr->video.resolution.height = (uint16_t)(h - crop_y * (crop[2] + crop[3]));
+
+	return EOS_ERROR_OK;
+}
+
+static eos_error_t util_esparser_nal(eos_media_codec_t codec,
+		const uint8_t* data, uint32_t len, eos_media_es_attr_t* atr)
+{
+	uint8_t rbsp[UTIL_ESPARSER_RBSP_MAX];
+	util_esparser_bits_t bits;
+	uint32_t pos = 0, hdr = 0;
+	bool sps = false;
+
+	hdr = codec == EOS_MEDIA_CODEC_H264 ? 1 : 2;
+	while((pos = util_esparser_find_start(data, len, pos)) + hdr < len)
+	{
+		if(codec == EOS_MEDIA_CODEC_H264)
+		{
+			sps = h264nalst_get_type(data[pos]) == H264NAL_TYPE_SPS;
+		}
+		else
+		{
+			sps = ((data[pos] >> 1) & 0x3f) == UTIL_ESPARSER_HEVC_NAL_SPS;
+		}
+		if(!sps)
+		{
+			continue;
+		}
+		osi_memset(&bits, 0, sizeof(bits));
+		bits.data = rbsp;
+		bits.len = util_esparser_rbsp(data + pos + hdr, len - pos - hdr,
+				rbsp, sizeof(rbsp));
+		if(codec == EOS_MEDIA_CODEC_H264)
+		{
+			return util_esparser_h264_sps(&bits, atr);
+		}
+		return util_esparser_hevc_sps(&bits, atr);
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+static eos_error_t util_esparser_mp2v(const uint8_t* data, uint32_t len,
+		eos_media_es_attr_t* atr)
+{
+	const uint8_t *seq = NULL;
+	uint32_t pos = 0;
+	uint8_t rate = 0;
+
+	while((pos = util_esparser_find_start(data, len, pos)) < len)
+	{
+		seq = data + pos - 3;
+		if(data[pos] != MP2VSEQ_START_CODE ||
+				pos - 3 + MP2VSEQ_HEADER_SIZE > len)
+		{
+			continue;
+		}
+		atr->video.resolution.width = mp2vseq_get_horizontal(seq);
+		/* bitstream helper drops the lower byte bits here */
+		atr->video.resolution.height = ((seq[5] & 0x0f) << 8) | seq[6];
+		rate = mp2vseq_get_framerate(seq);
+		if(rate < sizeof(mp2v_rates) / sizeof(mp2v_rates[0]))
+		{
+			util_esparser_set_rate(atr, mp2v_rates[rate][0],
+					mp2v_rates[rate][1]);
+		}
+		return EOS_ERROR_OK;
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+static eos_error_t util_esparser_adts(const uint8_t* data, uint32_t len,
+		eos_media_es_attr_t* atr)
+{
+	uint32_t i = 0;
+	uint8_t freq = 0, ch = 0;
+
+	for(i = 0; i + ADTS_HEADER_SIZE <= len; i++)
+	{
+		if(data[i] != 0xff || (data[i + 1] & 0xf6) != 0xf0)
+		{
+			continue;
+		}
+		freq = adts_get_sampling_freq(data + i);
+		ch = adts_get_channels(data + i);
+		if(freq >= sizeof(aac_rates) / sizeof(aac_rates[0]))
+		{
+			continue;
+		}
+		atr->audio.rate = aac_rates[freq];
+		atr->audio.ch = aac_channels[ch];
+		return EOS_ERROR_OK;
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+static uint32_t util_esparser_aac_rate(util_esparser_bits_t* bits)
+{
+	uint32_t idx = util_esparser_bits_get(bits, 4);
+
+	if(idx == 0x0f)
+	{
+		return util_esparser_bits_get(bits, 24);
+	}
+	if(idx >= sizeof(aac_rates) / sizeof(aac_rates[0]))
+	{
+		bits->err = true;
+		return 0;
+	}
+
+	return aac_rates[idx];
+}
+
+static eos_error_t util_esparser_latm(const uint8_t* data, uint32_t len,
+		eos_media_es_attr_t* atr)
+{
+	util_esparser_bits_t bits;
+	uint32_t i = 0, aot = 0, rate = 0, ch = 0;
+
+	for(i = 0; i + 3 < len; i++)
+	{
+		if(data[i] != 0x56 || (data[i + 1] & 0xe0) != 0xe0)
+		{
+			continue;
+		}
+		osi_memset(&bits, 0, sizeof(bits));
+		bits.data = data + i;
+		bits.len = len - i;
+		/* sync, length */
+		util_esparser_bits_skip(&bits, 24);
+		/* useSameStreamMux, config comes only with some of the frames */
+		if(util_esparser_bits_get(&bits, 1))
+		{
+			continue;
+		}
+		/* audioMuxVersion 1 carries extra LATM values, not supported */
+		if(util_esparser_bits_get(&bits, 1))
+		{
+			continue;
+		}
+		/* allStreamsSameTimeFraming, numSubFrames, numProgram, numLayer */
+		util_esparser_bits_skip(&bits, 1 + 6 + 4 + 3);
+		/* AudioSpecificConfig */
+		if((aot = util_esparser_bits_get(&bits, 5)) == 31)
+		{
+			aot = 32 + util_esparser_bits_get(&bits, 6);
+		}
+		rate = util_esparser_aac_rate(&bits);
+		ch = util_esparser_bits_get(&bits, 4);
+		/* SBR/PS signaled explicitly, output rate is the extension one */
+		if(aot == 5 || aot == 29)
+		{
+			rate = util_esparser_aac_rate(&bits);
+		}
+		if(bits.err || ch >= sizeof(aac_channels))
+		{
+			continue;
+		}
+		atr->audio.rate = rate;
+		atr->audio.ch = aac_channels[ch];
+		return EOS_ERROR_OK;
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+static eos_error_t util_esparser_a52(const uint8_t* data, uint32_t len,
+		eos_media_es_attr_t* atr)
+{
+	util_esparser_bits_t bits;
+	uint32_t i = 0, bsid = 0, fscod = 0, acmod = 0, rate = 0;
+
+	for(i = 0; i + 8 <= len; i++)
+	{
+		if(data[i] != 0x0b || data[i + 1] != 0x77)
+		{
+			continue;
+		}
+		osi_memset(&bits, 0, sizeof(bits));
+		bits.data = data + i;
+		bits.len = len - i;
+		bsid = data[i + 5] >> 3;
+		if(bsid <= 10)
+		{
+			/* AC-3: sync, crc1, fscod, frmsizecod, bsid, bsmod */
+			util_esparser_bits_skip(&bits, 32);
+			fscod = util_esparser_bits_get(&bits, 2);
+			util_esparser_bits_skip(&bits, 6 + 5 + 3);
+			if(fscod == 3)
+			{
+				continue;
+			}
+			rate = ac3_rates[fscod];
+			acmod = util_esparser_bits_get(&bits, 3);
+			if((acmod & 1) && acmod != 1)
+			{
+				util_esparser_bits_skip(&bits, 2);
+			}
+			if(acmod & 4)
+			{
+				util_esparser_bits_skip(&bits, 2);
+			}
+			if(acmod == 2)
+			{
+				util_esparser_bits_skip(&bits, 2);
+			}
+		}
+		else if(bsid <= 16)
+		{
+			/* E-AC-3: sync, strmtyp, substreamid, frmsiz */
+			util_esparser_bits_skip(&bits, 16 + 2 + 3 + 11);
+			fscod = util_esparser_bits_get(&bits, 2);
+			if(fscod == 3)
+			{
+				/* fscod2, rates are halved */
+				fscod = util_esparser_bits_get(&bits, 2);
+				if(fscod == 3)
+				{
+					continue;
+				}
+				rate = ac3_rates[fscod] / 2;
+			}
+			else
+			{
+				/* numblkscod */
+				util_esparser_bits_skip(&bits, 2);
+				rate = ac3_rates[fscod];
+			}
+			acmod = util_esparser_bits_get(&bits, 3);
+		}
+		else
+		{
+			continue;
+		}
+		atr->audio.ch = ac3_channels[acmod] + util_esparser_bits_get(&bits, 1);
+		if(bits.err)
+		{
+			return EOS_ERROR_NFOUND;
+		}
+		atr->audio.rate = rate;
+		return EOS_ERROR_OK;
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+static eos_error_t util_esparser_mpga(const uint8_t* data, uint32_t len,
+		eos_media_es_attr_t* atr)
+{
+	uint32_t i = 0;
+	uint8_t freq = 0;
+
+	for(i = 0; i + MPGA_HEADER_SIZE <= len; i++)
+	{
+		if(data[i] != 0xff || (data[i + 1] & 0xe0) != 0xe0)
+		{
+			continue;
+		}
+		freq = mpga_get_sampling_freq(data + i);
+		if(mpga_get_layer(data + i) == MPGA_LAYER_ADTS ||
+				mpga_get_bitrate_index(data + i) == MPGA_BITRATE_INVALID ||
+				freq == MPGA_SAMPLERATE_INVALID ||
+				(mpga_get_mpeg25(data + i) && mpga_get_id(data + i)))
+		{
+			continue;
+		}
+		atr->audio.rate = mpga_rates[freq];
+		if(mpga_get_id(data + i) == MPGA_ID_2)
+		{
+			atr->audio.rate /= mpga_get_mpeg25(data + i) ? 4 : 2;
+		}
+		atr->audio.ch = mpga_get_mode(data + i) == MPGA_MODE_MONO ? 1 : 2;
+		return EOS_ERROR_OK;
+	}
+
+	return EOS_ERROR_NFOUND;
+}
+
+// *************************************
+// *         Global functions          *
+// *************************************
+
+eos_error_t util_esparser_parse(eos_media_codec_t codec, const uint8_t* data,
+		uint32_t len, eos_media_es_attr_t* atr)
+{
+	if(data == NULL || atr == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	switch(codec)
+	{
+		case EOS_MEDIA_CODEC_H264:
+		case EOS_MEDIA_CODEC_H265:
+			return util_esparser_nal(codec, data, len, atr);
+		case EOS_MEDIA_CODEC_MPEG1:
+		case EOS_MEDIA_CODEC_MPEG2:
+			return util_esparser_mp2v(data, len, atr);
+		case EOS_MEDIA_CODEC_AAC:
+			return util_esparser_adts(data, len, atr);
+		case EOS_MEDIA_CODEC_HEAAC:
+			/* Stream type 0x11 is LATM, but some streams signal ADTS as HE-AAC */
+			if(util_esparser_latm(data, len, atr) == EOS_ERROR_OK)
+			{
+				return EOS_ERROR_OK;
+			}
+			return util_esparser_adts(data, len, atr);
+		case EOS_MEDIA_CODEC_AC3:
+		case EOS_MEDIA_CODEC_EAC3:
+			return util_esparser_a52(data, len, atr);
+		case EOS_MEDIA_CODEC_MP1:
+		case EOS_MEDIA_CODEC_MP2:
+		case EOS_MEDIA_CODEC_MP3:
+			return util_esparser_mpga(data, len, atr);
+		default:
+			return EOS_ERROR_NIMPLEMENTED;
+	}
+}
@@ -0,0 +1,61 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+#ifndef UTIL_ESPARSER_H_
+#define UTIL_ESPARSER_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+#include "eos_media.h"
+
+/**
+ * Parses elementary stream headers and completes ES attributes.
+ * Supported are H.264 and HEVC SPS, MPEG-1/2 video sequence header,
+ * AAC (ADTS and LATM), AC-3/E-AC-3 sync frames and MPEG audio headers.
+ * Parser does not allocate memory and does not keep any state, so it can
+ * be called with every new PES payload until it succeeds.
+ * HEVC frame rate is not extracted (it is in VUI, behind the parts of SPS
+ * which are not parsed), so it stays 0.
+ * @param codec ES codec (as signaled in PMT).
+ * @param data ES data (PES payload, starting anywhere).
+ * @param len Data length.
+ * @param atr ES attributes (output). Only fields found in the header are written.
+ * @return EOS_ERROR_OK if header was found and parsed, EOS_ERROR_NFOUND if
+ * data does not contain complete header, EOS_ERROR_NIMPLEMENTED if codec
+ * is not supported, or error if there was some other problem.
+ */
+eos_error_t util_esparser_parse(eos_media_codec_t codec, const uint8_t* data,
+		uint32_t len, eos_media_es_attr_t* atr);
+
+#endif // UTIL_ESPARSER_H_
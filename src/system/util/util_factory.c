@@ -43,6 +43,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #include "util_factory.h"
 #include "util_slist.h"
+#include "util_dispatch.h"
 #include "osi_memory.h"
 #include "osi_mutex.h"
 #include "eos_macro.h"
@@ -73,12 +74,20 @@ typedef struct util_factory_product
 	uint64_t id;
 } util_factory_product_t;
 
+typedef struct util_factory_lookup
+{
+	util_factory_t *factory;
+	void *data;
+} util_factory_lookup_t;
+
 struct util_factory
 {
 	util_slist_t specs;
+	util_dispatch_t *index;
 	util_slist_t products;
 	osi_mutex_t *products_mutex;
 	util_probe_cb_t probe;
+	util_key_cb_t key;
 };
 
 // *************************************
@@ -88,6 +97,7 @@ struct util_factory
 static util_factory_spec_t* util_factory_id_and_remove (util_factory_t* factory, void* instance);
 static int32_t util_factory_dismantle_all (util_factory_t* factory, util_factory_spec_t* spec);
 static uint64_t util_factory_gen_model_id (void);
+static bool util_factory_match (void* item, void* cookie);
 
 // *************************************
 // *         Global variables          *
@@ -215,11 +225,20 @@ static uint64_t util_factory_gen_model_id (void)
 	return ret;
 }
 
+static bool util_factory_match (void* item, void* cookie)
+{
+	util_factory_spec_t *spec = (util_factory_spec_t*)item;
+	util_factory_lookup_t *lookup = (util_factory_lookup_t*)cookie;
+
+	return lookup->factory->probe(spec->model, lookup->data) == EOS_ERROR_OK;
+}
+
 // *************************************
 // *         Global functions          *
 // *************************************
 
-eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe)
+eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe,
+		util_key_cb_t key)
 {
 	util_factory_t *tmp = NULL;
 
@@ -239,10 +258,18 @@ eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe)
 		return EOS_ERROR_GENERAL;
 	}
 	UTIL_GLOGI("Created util manufacturing specs register");
+	if (util_dispatch_create(&tmp->index) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Unable to create util manufacturing specs index");
+		util_slist_destroy(&tmp->specs);
+		osi_free((void**)&tmp);
+		return EOS_ERROR_GENERAL;
+	}
 	UTIL_GLOGD("Creating manufactured utils register...");
 	if (util_slist_create(&tmp->products, NULL) != EOS_ERROR_OK)
 	{
 		UTIL_GLOGE("Unable to create manufactured utils register");
+		util_dispatch_destroy(&tmp->index);
 		util_slist_destroy(&tmp->specs);
 		osi_free((void**)&tmp);
 		return EOS_ERROR_GENERAL;
@@ -251,11 +278,13 @@ eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe)
 	{
 		UTIL_GLOGE("Unable to create manufactured utils register");
 		util_slist_destroy(&tmp->products);
+		util_dispatch_destroy(&tmp->index);
 		util_slist_destroy(&tmp->specs);
 		osi_free((void**)&tmp);
 		return EOS_ERROR_GENERAL;
 	}
 	tmp->probe = probe;
+	tmp->key = key;
 	*factory = tmp;
 	UTIL_GLOGI("Created manufactured utils register");
 
@@ -290,6 +319,7 @@ eos_error_t util_factory_destroy(util_factory_t** factory)
 	{
 		UTIL_GLOGE("Unable to destroy util manufacturing specs register");
 	}
+	util_dispatch_destroy(&tmp->index);
 	UTIL_GLOGD("Destroying manufactured utils register...");
 	if (util_slist_destroy(&tmp->products) == EOS_ERROR_OK)
 	{
@@ -309,15 +339,23 @@ eos_error_t util_factory_destroy(util_factory_t** factory)
 }
 
 eos_error_t util_factory_register (util_factory_t* factory, void* model, uint64_t* model_id,
+		const uint32_t* keys, uint8_t key_cnt,
 		util_manufacture_cb_t manufacture, util_dismantle_cb_t dismantle)
 {
 	util_factory_spec_t *product_spec = NULL;
+	eos_error_t error = EOS_ERROR_OK;
+	uint8_t i = 0;
 
-	if (factory == NULL || model == NULL || model_id == NULL)
+	if (factory == NULL || model == NULL || model_id == NULL ||
+			(keys == NULL && key_cnt != 0))
 	{
 		return EOS_ERROR_INVAL;
 	}
 	product_spec = (util_factory_spec_t*)osi_calloc(sizeof(util_factory_spec_t));
+	if (product_spec == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
 	product_spec->model = model;
 	if(*model_id == 0LL)
 	{
@@ -333,6 +371,23 @@ eos_error_t util_factory_register (util_factory_t* factory, void* model, uint64_
 		UTIL_GLOGE("Unable to register util model: %llu", *model_id);
 		return EOS_ERROR_GENERAL;
 	}
+	for (i = 0; i < key_cnt && error == EOS_ERROR_OK; i++)
+	{
+		error = util_dispatch_add(factory->index, keys[i], product_spec);
+	}
+	if (key_cnt == 0)
+	{
+		error = util_dispatch_add(factory->index, UTIL_DISPATCH_ANY,
+				product_spec);
+	}
+	if (error != EOS_ERROR_OK)
+	{
+		util_dispatch_remove(factory->index, product_spec);
+		factory->specs.remove(factory->specs, (void*)product_spec);
+		osi_free((void**)&product_spec);
+		UTIL_GLOGE("Unable to index util model: %llu", *model_id);
+		return error;
+	}
 	UTIL_GLOGD("Registered model id: 0x%llX", *model_id);
 
 	return EOS_ERROR_OK;
@@ -367,6 +422,7 @@ eos_error_t util_factory_unregister (util_factory_t* factory, void* model, uint6
 				{
 					UTIL_GLOGW("%d manufactured %s forcefully dismantled", count, ((count % 10 == 1) && (count % 100 != 11))? "util was" : "utils were");
 				}
+				util_dispatch_remove(factory->index, product_spec);
 				if (factory->specs.remove(factory->specs, (void*)product_spec) == EOS_ERROR_OK)
 				{
 					osi_free((void**)&product_spec);
@@ -406,91 +462,72 @@ eos_error_t util_factory_manufacture (util_factory_t* factory, void** product, v
 {
 	util_factory_spec_t *product_spec = NULL;
 	util_factory_product_t *product_data = NULL;
-	bool found = false;
+	util_factory_lookup_t lookup = {factory, data};
 	uint64_t product_id = UTIL_FACTORY_START_PRODUCT_ID;
+	uint32_t key = UTIL_DISPATCH_ANY;
+	uint32_t hint = UTIL_DISPATCH_ANY;
 	eos_error_t error = EOS_ERROR_OK;
-	eos_error_t spec_error = EOS_ERROR_OK;
 
-	if (product == NULL)
+	if (factory == NULL || product == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 
-	spec_error = factory->specs.first(factory->specs, (void**)&product_spec);
-	while ((spec_error == EOS_ERROR_OK) || (spec_error == EOS_ERROR_EOL))
+	if (factory->key != NULL)
 	{
-		if (product_spec == NULL)
-		{
-			continue;
-		}
-		if (factory->probe(product_spec->model, data) == EOS_ERROR_OK)
-		{
-			UTIL_GLOGD("Found model");
-			error = factory->products.last(factory->products, (void**)&product_data);
-			if (error == EOS_ERROR_OK)
-			{
-				product_id = product_data->id + 1;
-			}
-			else
-			{
-				if (error != EOS_ERROR_EMPTY)
-				{
-					UTIL_GLOGD("Product list not empty but failed");
-					UTIL_GLOGD("Element manufacturing failed");
-					break;
-				}
-			}
-			if (product_id == UTIL_FACTORY_START_PRODUCT_ID)
-			{
-				// In theory possible but in practice quite impossible to overlap (ever)
-			}
-			if (product_spec->manufacture(data, product_spec->model, 
-			    product_spec->model_id, product, product_id) == EOS_ERROR_OK)
-			{
-				product_data = (util_factory_product_t*)osi_calloc(sizeof(util_factory_product_t));
-				if (product_data == NULL)
-				{
-					UTIL_GLOGD("No memory");
-					product_spec->dismantle(product_spec->model_id, product);
-					UTIL_GLOGD("Element manufacturing failed");
-					break;
-				}
-				product_data->instance = *product;
-				product_data->spec = product_spec;
-				product_data->id = product_id;
-				if (factory->products.add(factory->products, (void*)product_data) != EOS_ERROR_OK)
-				{
-					UTIL_GLOGD("Unable to add to products list");
-					product_spec->dismantle(product_spec->model_id, product);
-					osi_free((void**)&product_data);
-					UTIL_GLOGD("Element manufacturing failed");
-					break;
-				}
-				found = true;
-				break;
-			}
-			else
-			{
-				UTIL_GLOGD("Element manufacturing failed");
-				break;
-			}
-		}
-		if (spec_error == EOS_ERROR_EOL)
+		factory->key(data, &key, &hint);
+	}
+	if (util_dispatch_find(factory->index, key, hint, util_factory_match,
+			&lookup, (void**)&product_spec) != EOS_ERROR_OK)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	UTIL_GLOGD("Found model");
+	error = factory->products.last(factory->products, (void**)&product_data);
+	if (error == EOS_ERROR_OK)
+	{
+		product_id = product_data->id + 1;
+	}
+	else
+	{
+		if (error != EOS_ERROR_EMPTY)
 		{
-			break;
+			UTIL_GLOGD("Product list not empty but failed");
+			UTIL_GLOGD("Element manufacturing failed");
+			return EOS_ERROR_NFOUND;
 		}
-
-		spec_error = factory->specs.next(factory->specs, (void**)&product_spec);
 	}
-
-	if (found == true)
+	if (product_id == UTIL_FACTORY_START_PRODUCT_ID)
 	{
-		return EOS_ERROR_OK;
+		// In theory possible but in practice quite impossible to overlap (ever)
 	}
-	else
+	if (product_spec->manufacture(data, product_spec->model,
+	    product_spec->model_id, product, product_id) != EOS_ERROR_OK)
 	{
+		UTIL_GLOGD("Element manufacturing failed");
 		return EOS_ERROR_NFOUND;
 	}
+	product_data = (util_factory_product_t*)osi_calloc(sizeof(util_factory_product_t));
+	if (product_data == NULL)
+	{
+		UTIL_GLOGD("No memory");
+		product_spec->dismantle(product_spec->model_id, product);
+		UTIL_GLOGD("Element manufacturing failed");
+		return EOS_ERROR_NFOUND;
+	}
+	product_data->instance = *product;
+	product_data->spec = product_spec;
+	product_data->id = product_id;
+	if (factory->products.add(factory->products, (void*)product_data) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGD("Unable to add to products list");
+		product_spec->dismantle(product_spec->model_id, product);
+		osi_free((void**)&product_data);
+		UTIL_GLOGD("Element manufacturing failed");
+		return EOS_ERROR_NFOUND;
+	}
+
+	return EOS_ERROR_OK;
 }
 
 eos_error_t util_factory_dismantle (util_factory_t* factory, void** product)
@@ -41,14 +41,21 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 typedef struct util_factory util_factory_t;
 
+/* Models declare dispatch keys (codec, I/O type...) at registration, key
+ * callback derives the key of the manufacture data. Only models registered
+ * under that key (or without any key) are probed. Hint selects the LRU
+ * cache entry tried before anything else. */
 typedef eos_error_t (*util_probe_cb_t) (void* model, void* data);
+typedef void (*util_key_cb_t) (void* data, uint32_t* key, uint32_t* hint);
 typedef eos_error_t (*util_manufacture_cb_t) (void* data, void* model, uint64_t model_id,
 		void** product, uint64_t product_id);
 typedef eos_error_t (*util_dismantle_cb_t) (uint64_t model_id, void** product);
 
-eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe);
+eos_error_t util_factory_create(util_factory_t** factory, util_probe_cb_t probe,
+		util_key_cb_t key);
 eos_error_t util_factory_destroy(util_factory_t** factory);
 eos_error_t util_factory_register (util_factory_t* factory, void* model, uint64_t* model_id,
+		const uint32_t* keys, uint8_t key_cnt,
 		util_manufacture_cb_t manufacture, util_dismantle_cb_t dismantle);
 eos_error_t util_factory_unregister (util_factory_t* factory, void* model, uint64_t model_id);
 eos_error_t util_factory_get_count (util_factory_t* factory, uint32_t* count);
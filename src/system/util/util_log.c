@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "log"
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -0,0 +1,177 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+// *************************************
+// *       Module name definition      *
+// *************************************
+
+#define MODULE_NAME "mdesc"
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "osi_memory.h"
+#include "util_mdesc.h"
+#include "util_log.h"
+
+#include <stddef.h>
+
+// *************************************
+// *              Types                *
+// *************************************
+
+struct util_mdesc
+{
+	/** Reference count (changed atomically) */
+	volatile uint32_t refs;
+	uint32_t gen;
+	eos_media_cont_t container;
+	uint8_t es_cnt;
+	uint32_t drm_id;
+	eos_media_drm_type_t drm_type;
+	uint16_t drm_system;
+	uint16_t drm_size;
+	/** DRM data, placed right after the ES table */
+	uint8_t *drm_data;
+	/** ES table, sized to es_cnt */
+	eos_media_es_t es[];
+};
+
+// *************************************
+// *         Global variables          *
+// *************************************
+
+static volatile uint32_t util_mdesc_gen = 0;
+
+// *************************************
+// *         Public functions          *
+// *************************************
+
+eos_error_t util_mdesc_create(util_mdesc_t** mdesc, eos_media_desc_t* desc)
+{
+	util_mdesc_t *tmp = NULL;
+	uint8_t es_cnt = 0;
+	uint16_t drm_size = 0;
+	size_t size = 0;
+
+	if ((mdesc == NULL) || (desc == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	es_cnt = (desc->es_cnt > EOS_MEDIA_ES_MAX) ? EOS_MEDIA_ES_MAX : desc->es_cnt;
+	drm_size = (desc->drm.size > EOS_MEDIA_DRM_SIZE_MAX) ? EOS_MEDIA_DRM_SIZE_MAX : desc->drm.size;
+
+	size = sizeof(util_mdesc_t) + es_cnt * sizeof(eos_media_es_t) + drm_size;
+	tmp = (util_mdesc_t*)osi_malloc(size);
+	if (tmp == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	tmp->refs = 1;
+	tmp->gen = __sync_add_and_fetch(&util_mdesc_gen, 1);
+	tmp->container = desc->container;
+	tmp->es_cnt = es_cnt;
+	tmp->drm_id = desc->drm.id;
+	tmp->drm_type = desc->drm.type;
+	tmp->drm_system = desc->drm.system;
+	tmp->drm_size = drm_size;
+	osi_memcpy(tmp->es, desc->es, es_cnt * sizeof(eos_media_es_t));
+	tmp->drm_data = (uint8_t*)&tmp->es[es_cnt];
+	osi_memcpy(tmp->drm_data, desc->drm.data, drm_size);
+
+	*mdesc = tmp;
+
+	return EOS_ERROR_OK;
+}
+
+util_mdesc_t* util_mdesc_ref(util_mdesc_t* mdesc)
+{
+	if (mdesc != NULL)
+	{
+		__sync_add_and_fetch(&mdesc->refs, 1);
+	}
+
+	return mdesc;
+}
+
+void util_mdesc_unref(util_mdesc_t** mdesc)
+{
+	if ((mdesc == NULL) || (*mdesc == NULL))
+	{
+		return;
+	}
+	if (__sync_sub_and_fetch(&(*mdesc)->refs, 1) == 0)
+	{
+		osi_free((void**)mdesc);
+	}
+	*mdesc = NULL;
+}
+
+uint32_t util_mdesc_get_gen(util_mdesc_t* mdesc)
+{
+	return (mdesc == NULL) ? 0 : mdesc->gen;
+}
+
+uint8_t util_mdesc_get_es_cnt(util_mdesc_t* mdesc)
+{
+	return (mdesc == NULL) ? 0 : mdesc->es_cnt;
+}
+
+const eos_media_es_t* util_mdesc_get_es(util_mdesc_t* mdesc, uint8_t idx)
+{
+	if ((mdesc == NULL) || (idx >= mdesc->es_cnt))
+	{
+		return NULL;
+	}
+
+	return &mdesc->es[idx];
+}
+
+eos_error_t util_mdesc_expand(util_mdesc_t* mdesc, eos_media_desc_t* desc)
+{
+	if ((mdesc == NULL) || (desc == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	desc->container = mdesc->container;
+	desc->es_cnt = mdesc->es_cnt;
+	desc->drm.id = mdesc->drm_id;
+	desc->drm.type = mdesc->drm_type;
+	desc->drm.system = mdesc->drm_system;
+	desc->drm.size = mdesc->drm_size;
+	osi_memcpy(desc->drm.data, mdesc->drm_data, mdesc->drm_size);
+	osi_memcpy(desc->es, mdesc->es, mdesc->es_cnt * sizeof(eos_media_es_t));
+
+	return EOS_ERROR_OK;
+}
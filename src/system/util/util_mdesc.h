@@ -0,0 +1,99 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+#ifndef UTIL_MDESC_H_
+#define UTIL_MDESC_H_
+
+#include "eos_error.h"
+#include "eos_types.h"
+#include "eos_media.h"
+
+/**
+ * Media descriptor handle.
+ * Immutable, reference counted copy of <code>eos_media_desc_t</code> which
+ * holds only ES entries and DRM data the stream actually has.
+ * Handle is passed by pointer (e.g. in link events), and whoever wants to keep it
+ * beyond the call takes its own reference.
+ */
+typedef struct util_mdesc util_mdesc_t;
+
+/**
+ * Creates media descriptor from the full description. Reference count is set to one.
+ * @param mdesc Pointer to the handle (output).
+ * @param desc Media description which is copied.
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_mdesc_create(util_mdesc_t** mdesc, eos_media_desc_t* desc);
+/**
+ * Takes one more reference.
+ * @param mdesc Media descriptor handle.
+ * @return The same handle (for convenience), or NULL if NULL was passed.
+ */
+util_mdesc_t* util_mdesc_ref(util_mdesc_t* mdesc);
+/**
+ * Releases one reference. Descriptor is freed when the last reference is released.
+ * @param mdesc Pointer to the handle (set to NULL).
+ */
+void util_mdesc_unref(util_mdesc_t** mdesc);
+
+/**
+ * Returns descriptor generation. Every created descriptor gets a new one,
+ * so two handles describe the same media only if generations are equal.
+ * @param mdesc Media descriptor handle.
+ * @return Generation number (0 for NULL handle).
+ */
+uint32_t util_mdesc_get_gen(util_mdesc_t* mdesc);
+/**
+ * Returns number of elementary streams.
+ * @param mdesc Media descriptor handle.
+ * @return ES count (0 for NULL handle).
+ */
+uint8_t util_mdesc_get_es_cnt(util_mdesc_t* mdesc);
+/**
+ * Returns elementary stream description.
+ * @param mdesc Media descriptor handle.
+ * @param idx ES index.
+ * @return ES description, or NULL if index is out of range.
+ */
+const eos_media_es_t* util_mdesc_get_es(util_mdesc_t* mdesc, uint8_t idx);
+/**
+ * Fills in full media description (for the parts which need mutable copy, like ES selection).
+ * Only container, ES count, used ES entries and used DRM data are written.
+ * @param mdesc Media descriptor handle.
+ * @param desc Media description (output).
+ * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
+ */
+eos_error_t util_mdesc_expand(util_mdesc_t* mdesc, eos_media_desc_t* desc);
+
+#endif // UTIL_MDESC_H_
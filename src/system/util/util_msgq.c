@@ -62,6 +62,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
  ******************************************************************************/
 
 
+#define MODULE_NAME "msgq"
+
 #include "util_msgq.h"
 #include "osi_error.h"
 #include "osi_memory.h"
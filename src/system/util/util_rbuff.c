@@ -62,6 +62,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
  ******************************************************************************/
 
 
+/* MODULE_NAME is the function name here */
+#define OSI_MEMORY_TAG "rbuff"
+
 #include "util_rbuff.h"
 #include "osi_mutex.h"
 #include "osi_bin_sem.h"
@@ -119,8 +122,15 @@ struct util_rbuff_handle
 	 * reading before write pointer wrapped to the buffer start.
 	 */
 	uint8_t *eod;
+	/**
+	 * End of the last chunk read before the reader wrapped. Once freed up to
+	 * there, the read pointer is equivalent to the buffer start.
+	 */
+	uint8_t *wrap;
 	/** Continuous data available */
 	uint32_t acc_size;
+	/** Incremented on every resize, so that blocked writers can start over */
+	uint32_t resized;
 	/** State */
 	util_rbuff_state_t state;
 	/** Buffer lock */
@@ -270,6 +280,7 @@ eos_error_t util_rbuff_reserve(util_rbuff_t* rb, void** buff, uint32_t size, int
 {
 	osi_time_t timeout = {0, 0};
 	div_t divide = {0, 0};
+	uint32_t resized = 0;
 
 	if (wait != -1)
 	{
@@ -282,16 +293,19 @@ eos_error_t util_rbuff_reserve(util_rbuff_t* rb, void** buff, uint32_t size, int
 	{
 		return EOS_ERROR_INVAL;
 	}
+	UTIL_RBUFF_ENTER_CTX(rb);
+retry:
 	if(size > rb->size)
 	{
+		UTIL_RBUFF_LEAVE_CTX(rb);
 		return EOS_ERROR_INVAL;
 	}
-	UTIL_RBUFF_ENTER_CTX(rb);
 	if(util_rbuff_check_state(rb, UTIL_RING_BUFF_STATE_ACTIVE))
 	{
 		UTIL_RBUFF_LEAVE_CTX(rb);
 		return EOS_ERROR_PERM;
 	}
+	resized = rb->resized;
 	/* simple situation, there is enough space left till the end of buffer */
 	if(rb->write + size <= rb->buff + rb->size)
 	{
@@ -323,6 +337,11 @@ eos_error_t util_rbuff_reserve(util_rbuff_t* rb, void** buff, uint32_t size, int
 				UTIL_RBUFF_LEAVE_CTX(rb);
 				return EOS_ERROR_PERM;
 			}
+			/* buffer moved while waiting, pointers are not valid anymore */
+			if(resized != rb->resized)
+			{
+				goto retry;
+			}
 		}
 		*buff = rb->write;
 		rb->write += size;
@@ -362,6 +381,11 @@ eos_error_t util_rbuff_reserve(util_rbuff_t* rb, void** buff, uint32_t size, int
 				UTIL_RBUFF_LEAVE_CTX(rb);
 				return EOS_ERROR_PERM;
 			}
+			/* buffer moved while waiting, pointers are not valid anymore */
+			if(resized != rb->resized)
+			{
+				goto retry;
+			}
 		}
 		/* reader must not exceed data available (current write) */
 		rb->eod = rb->write;
@@ -439,11 +463,17 @@ eos_error_t util_rbuff_read(util_rbuff_t* rb, void** buff, uint32_t size, uint32
 {
 	eos_error_t err = EOS_ERROR_OK;
 
-	if(rb == NULL || buff == NULL || size > rb->size || read == NULL || wait < -1)
+	if(rb == NULL || buff == NULL || read == NULL || wait < -1)
 	{
 		return EOS_ERROR_INVAL;
 	}
 	UTIL_RBUFF_ENTER_CTX(rb);
+	/* Size may change with a resize, checked under the lock */
+	if(size > rb->size)
+	{
+		UTIL_RBUFF_LEAVE_CTX(rb);
+		return EOS_ERROR_INVAL;
+	}
 	if((err = util_rbuff_data_wait(rb, size, wait)) != EOS_ERROR_OK)
 	{
 		UTIL_RBUFF_LEAVE_CTX(rb);
@@ -462,11 +492,16 @@ eos_error_t util_rbuff_read_all(util_rbuff_t* rb, void *buff, uint32_t size, int
 	uint8_t *dest = (uint8_t *)buff;
 	eos_error_t err = EOS_ERROR_OK;
 
-	if(rb == NULL || buff == NULL || size > rb->size || wait < -1)
+	if(rb == NULL || buff == NULL || wait < -1)
 	{
 		return EOS_ERROR_INVAL;
 	}
 	UTIL_RBUFF_ENTER_CTX(rb);
+	if(size > rb->size)
+	{
+		UTIL_RBUFF_LEAVE_CTX(rb);
+		return EOS_ERROR_INVAL;
+	}
 #ifdef RING_BUFF_DBG_MSG
 	UTIL_LOGV(rb->log, "READ ALL wait %d (%d) RD %p ACC %p WR %p", size, rb->acc_size, rb->read, rb->acc, rb->write);
 #endif
@@ -559,6 +594,7 @@ eos_error_t util_rbuff_rst(util_rbuff_t* rb)
 	rb->write = rb->buff;
 	rb->acc = rb->buff;
 	rb->eod = NULL;
+	rb->wrap = NULL;
 	rb->acc_size = 0;
 	rb->last_level = util_rbuff_wm_low;
 	rb->state = UTIL_RING_BUFF_STATE_ACTIVE;
@@ -569,6 +605,69 @@ eos_error_t util_rbuff_rst(util_rbuff_t* rb)
 	return EOS_ERROR_OK;
 }
 
+eos_error_t util_rbuff_resize(util_rbuff_t* rb, void* buff, uint32_t size, void** old)
+{
+	uint8_t *dest = (uint8_t*)buff;
+	uint8_t *committed = NULL, *read = NULL;
+	uint32_t first = 0, second = 0;
+
+	if(rb == NULL || buff == NULL || size == 0 || old == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if(rb->accumulate && rb->notify_func)
+	{
+		return EOS_ERROR_NIMPLEMENTED;
+	}
+	UTIL_RBUFF_ENTER_CTX(rb);
+	if(rb->acc_size > size)
+	{
+		UTIL_RBUFF_LEAVE_CTX(rb);
+		return EOS_ERROR_NOMEM;
+	}
+	/* Unread data is [acc, eod) + [buff, write) if writer wrapped, [acc, write) otherwise */
+	if(rb->eod != NULL)
+	{
+		first = rb->eod - rb->acc;
+		second = rb->acc_size - first;
+		committed = rb->buff + second;
+	}
+	else
+	{
+		first = rb->acc_size;
+		committed = rb->acc + first;
+	}
+	/* Freed up to where the reader wrapped is the same as freed up to acc */
+	read = (rb->acc == rb->buff && rb->read == rb->wrap) ? rb->buff : rb->read;
+	/* Chunk which is read and not freed, or reserved and not committed, points to the old block */
+	if(read != rb->acc || rb->write != committed)
+	{
+		UTIL_RBUFF_LEAVE_CTX(rb);
+		return EOS_ERROR_BUSY;
+	}
+	osi_memcpy(dest, rb->acc, first);
+	osi_memcpy(dest + first, rb->buff, second);
+	if(rb->wm_cb != NULL)
+	{
+		rb->wm_low = (uint32_t)(((uint64_t)rb->wm_low * size) / rb->size);
+		rb->wm_high = (uint32_t)(((uint64_t)rb->wm_high * size) / rb->size);
+	}
+	*old = rb->buff;
+	rb->buff = dest;
+	rb->size = size;
+	rb->read = dest;
+	rb->acc = dest;
+	rb->write = dest + rb->acc_size;
+	rb->eod = NULL;
+	rb->wrap = NULL;
+	rb->resized++;
+	/* writers waiting for space have to re-evaluate */
+	osi_bin_sem_give(rb->write_sem);
+	UTIL_RBUFF_LEAVE_CTX(rb);
+
+	return EOS_ERROR_OK;
+}
+
 eos_error_t util_rbuff_get_fullness(util_rbuff_t* rb, uint32_t *fullness)
 {
 	if(rb == NULL || fullness == NULL)
@@ -708,6 +807,7 @@ static eos_error_t util_rbuff_read_cont(util_rbuff_t* rb, void** buff, uint32_t
 		}
 		else
 		{
+			rb->wrap = rb->eod;
 			rb->acc = rb->buff;
 		}
 		rb->acc_size -= *read;
@@ -240,5 +240,19 @@ eos_error_t util_rbuff_rst(util_rbuff_t* rb);
  * @return EOS_ERROR_OK if everything was OK, or error if there was some problem.
  */
 eos_error_t util_rbuff_get_fullness(util_rbuff_t* rb, uint32_t *fullness);
+/**
+ * Moves the ring buffer to another memory block (bigger or smaller), preserving data that
+ * is not read yet. Writers blocked in "util_rbuff_reserve" continue on the new block.
+ * Resize is possible only when there are no outstanding chunks (everything reserved is
+ * committed and everything read is freed), and it is not supported with the
+ * accumulation/notify mechanism. Watermarks are scaled to the new size.
+ * @param rb Ring buffer handle.
+ * @param buff New memory block. It must not overlap the current one.
+ * @param size New memory block size.
+ * @param old Output argument with the previous memory block, which is given back to the caller.
+ * @return EOS_ERROR_OK if resized, EOS_ERROR_NOMEM if unread data does not fit into
+ * the new block, EOS_ERROR_BUSY if some chunk is outstanding.
+ */
+eos_error_t util_rbuff_resize(util_rbuff_t* rb, void* buff, uint32_t size, void** old);
 
 #endif /* UTIL_RING_BUFF_H_ */
@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "slist"
+
 #include <stdlib.h>
 
 #include "util_slist.h"
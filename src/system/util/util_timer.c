@@ -0,0 +1,447 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+// *************************************
+// *             Includes              *
+// *************************************
+
+#include "util_timer.h"
+#include "eos_macro.h"
+#include "osi_memory.h"
+#include "osi_mutex.h"
+#include "osi_bin_sem.h"
+#include "osi_thread.h"
+#include "osi_time.h"
+
+#define MODULE_NAME "timer"
+#include "util_log.h"
+
+// *************************************
+// *              Macros               *
+// *************************************
+
+/* Level 0 has one slot per tick (ms), every upper level one slot per
+ * full turn of the level below: 256 ms, 16 s, 17 min, 18 h */
+#define UTIL_TIMER_L0_BITS (8)
+#define UTIL_TIMER_LN_BITS (6)
+#define UTIL_TIMER_LN_CNT (3)
+#define UTIL_TIMER_L0_SIZE (1 << UTIL_TIMER_L0_BITS)
+#define UTIL_TIMER_LN_SIZE (1 << UTIL_TIMER_LN_BITS)
+#define UTIL_TIMER_L0_MASK (UTIL_TIMER_L0_SIZE - 1)
+#define UTIL_TIMER_LN_MASK (UTIL_TIMER_LN_SIZE - 1)
+#define UTIL_TIMER_SHIFT(lvl) (UTIL_TIMER_L0_BITS + (lvl) * UTIL_TIMER_LN_BITS)
+#define UTIL_TIMER_SPAN ((uint64_t)1 << UTIL_TIMER_SHIFT(UTIL_TIMER_LN_CNT))
+#define UTIL_TIMER_IDLE (UINT64_MAX)
+#define UTIL_TIMER_RELEASE_PERIOD_USEC (1000)
+
+// *************************************
+// *              Types                *
+// *************************************
+
+struct util_timer
+{
+	struct util_timer *next;
+	struct util_timer *prev;
+	/* Slot list the timer is linked in, NULL when disarmed */
+	struct util_timer **slot;
+	uint64_t expires;
+	util_timer_cbk_t cbk;
+	void *cookie;
+};
+
+typedef struct util_timer_wheel
+{
+	osi_mutex_t *lock;
+	osi_bin_sem_t *wake;
+	osi_thread_t *thread;
+	bool running;
+	/* Next tick to be processed */
+	uint64_t tick;
+	/* Tick the wheel thread sleeps until */
+	uint64_t wake_at;
+	uint32_t armed;
+	util_timer_t *firing;
+	util_timer_t *l0[UTIL_TIMER_L0_SIZE];
+	util_timer_t *ln[UTIL_TIMER_LN_CNT][UTIL_TIMER_LN_SIZE];
+} util_timer_wheel_t;
+
+// *************************************
+// *            Prototypes             *
+// *************************************
+
+static void* util_timer_thread(void* arg);
+
+// *************************************
+// *         Global variables          *
+// *************************************
+
+static util_timer_wheel_t wheel;
+
+// *************************************
+// *         Local functions           *
+// *************************************
+
+CALL_ON_LOAD(util_timer_init)
+static void util_timer_init(void)
+{
+	wheel.wake_at = UTIL_TIMER_IDLE;
+	if(osi_mutex_create(&wheel.lock) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Lock could not be created");
+		return;
+	}
+	if(osi_bin_sem_create(&wheel.wake, false) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("Semaphore could not be created");
+		osi_mutex_destroy(&wheel.lock);
+	}
+}
+
+CALL_ON_UNLOAD(util_timer_deinit)
+static void util_timer_deinit(void)
+{
+	if(wheel.lock == NULL)
+	{
+		return;
+	}
+	osi_mutex_lock(wheel.lock);
+	wheel.running = false;
+	osi_mutex_unlock(wheel.lock);
+	if(wheel.thread != NULL)
+	{
+		osi_bin_sem_give(wheel.wake);
+		osi_thread_join(wheel.thread, NULL);
+		osi_thread_release(&wheel.thread);
+	}
+	osi_bin_sem_destroy(&wheel.wake);
+	osi_mutex_destroy(&wheel.lock);
+}
+
+static void util_timer_unlink(util_timer_t* timer)
+{
+	if(timer->prev != NULL)
+	{
+		timer->prev->next = timer->next;
+	}
+	else
+	{
+		*timer->slot = timer->next;
+	}
+	if(timer->next != NULL)
+	{
+		timer->next->prev = timer->prev;
+	}
+	timer->next = timer->prev = NULL;
+	timer->slot = NULL;
+}
+
+static void util_timer_place(util_timer_t* timer)
+{
+	uint64_t delta = 0, expires = 0;
+	util_timer_t **slot = NULL;
+	uint8_t lvl = 0;
+
+	if(timer->expires < wheel.tick)
+	{
+		timer->expires = wheel.tick;
+	}
+	expires = timer->expires;
+	delta = expires - wheel.tick;
+	if(delta < UTIL_TIMER_L0_SIZE)
+	{
+		slot = &wheel.l0[expires & UTIL_TIMER_L0_MASK];
+	}
+	else
+	{
+		if(delta >= UTIL_TIMER_SPAN)
+		{
+			/* Parked in the farthest slot, placed again on cascade */
+			expires = wheel.tick + UTIL_TIMER_SPAN - 1;
+			delta = UTIL_TIMER_SPAN - 1;
+		}
+		for(lvl=0; lvl<UTIL_TIMER_LN_CNT - 1; lvl++)
+		{
+			if(delta < ((uint64_t)1 << UTIL_TIMER_SHIFT(lvl + 1)))
+			{
+				break;
+			}
+		}
+		slot = &wheel.ln[lvl][(expires >> UTIL_TIMER_SHIFT(lvl)) &
+				UTIL_TIMER_LN_MASK];
+	}
+	timer->slot = slot;
+	timer->prev = NULL;
+	timer->next = *slot;
+	if(*slot != NULL)
+	{
+		(*slot)->prev = timer;
+	}
+	*slot = timer;
+}
+
+static void util_timer_cascade(void)
+{
+	util_timer_t *list = NULL, *timer = NULL;
+	uint8_t lvl = 0, idx = 0;
+
+	for(lvl=0; lvl<UTIL_TIMER_LN_CNT; lvl++)
+	{
+		idx = (wheel.tick >> UTIL_TIMER_SHIFT(lvl)) & UTIL_TIMER_LN_MASK;
+		list = wheel.ln[lvl][idx];
+		wheel.ln[lvl][idx] = NULL;
+		while(list != NULL)
+		{
+			timer = list;
+			list = list->next;
+			util_timer_place(timer);
+		}
+		if(idx != 0)
+		{
+			break;
+		}
+	}
+}
+
+/* Called with the lock held, releases it around callbacks */
+static void util_timer_expire(uint64_t now)
+{
+	util_timer_t *timer = NULL, *due = NULL;
+	util_timer_cbk_t cbk = NULL;
+	void *cookie = NULL;
+
+	while(wheel.tick <= now && wheel.running)
+	{
+		if((wheel.tick & UTIL_TIMER_L0_MASK) == 0)
+		{
+			util_timer_cascade();
+		}
+		/* Detached, so timers re-armed from callbacks (next tick at the
+		 * earliest) do not end up in the list being fired */
+		due = wheel.l0[wheel.tick & UTIL_TIMER_L0_MASK];
+		wheel.l0[wheel.tick & UTIL_TIMER_L0_MASK] = NULL;
+		for(timer = due; timer != NULL; timer = timer->next)
+		{
+			timer->slot = &due;
+		}
+		wheel.tick++;
+		while((timer = due) != NULL)
+		{
+			util_timer_unlink(timer);
+			wheel.armed--;
+			cbk = timer->cbk;
+			cookie = timer->cookie;
+			wheel.firing = timer;
+			osi_mutex_unlock(wheel.lock);
+			cbk(cookie);
+			osi_mutex_lock(wheel.lock);
+			wheel.firing = NULL;
+		}
+	}
+}
+
+static uint64_t util_timer_next(void)
+{
+	uint64_t next = 0;
+	uint32_t i = 0;
+
+	if(wheel.armed == 0)
+	{
+		return UTIL_TIMER_IDLE;
+	}
+	/* Upper levels move down at the end of the level 0 turn at latest */
+	next = (wheel.tick | UTIL_TIMER_L0_MASK) + 1;
+	for(i=0; wheel.tick + i < next; i++)
+	{
+		if(wheel.l0[(wheel.tick + i) & UTIL_TIMER_L0_MASK] != NULL)
+		{
+			return wheel.tick + i;
+		}
+	}
+
+	return next;
+}
+
+// *************************************
+// *             Threads               *
+// *************************************
+
+static void* util_timer_thread(void* arg)
+{
+	osi_time_t timeout = {0, 0};
+	uint64_t now = 0;
+
+	osi_mutex_lock(wheel.lock);
+	while(wheel.running)
+	{
+		now = util_timer_now();
+		util_timer_expire(now);
+		wheel.wake_at = util_timer_next();
+		osi_mutex_unlock(wheel.lock);
+		if(wheel.wake_at == UTIL_TIMER_IDLE)
+		{
+			osi_bin_sem_take(wheel.wake);
+		}
+		else if(wheel.wake_at > now)
+		{
+			OSI_TIME_CONVERT_FROM_MSEC(timeout, wheel.wake_at - now);
+			osi_bin_sem_timedtake(wheel.wake, &timeout);
+		}
+		osi_mutex_lock(wheel.lock);
+	}
+	osi_mutex_unlock(wheel.lock);
+
+	return arg;
+}
+
+// *************************************
+// *       Global functions            *
+// *************************************
+
+uint64_t util_timer_now(void)
+{
+	osi_time_t ts = {0, 0};
+	uint64_t msec = 0;
+
+	osi_time_get_timestamp(&ts);
+	OSI_TIME_CONVERT_TO_MSEC(ts, msec);
+
+	return msec;
+}
+
+eos_error_t util_timer_create(util_timer_t** timer, util_timer_cbk_t cbk,
+		void* cookie)
+{
+	eos_error_t error = EOS_ERROR_OK;
+
+	if(timer == NULL || cbk == NULL || wheel.lock == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(wheel.lock);
+	if(wheel.thread == NULL)
+	{
+		wheel.running = true;
+		wheel.tick = util_timer_now();
+		error = osi_thread_create(&wheel.thread, NULL, util_timer_thread,
+				NULL);
+		if(error != EOS_ERROR_OK)
+		{
+			wheel.running = false;
+			osi_mutex_unlock(wheel.lock);
+			UTIL_GLOGE("Wheel thread could not be created");
+			return error;
+		}
+	}
+	osi_mutex_unlock(wheel.lock);
+	*timer = osi_calloc(sizeof(util_timer_t));
+	if(*timer == NULL)
+	{
+		return EOS_ERROR_NOMEM;
+	}
+	(*timer)->cbk = cbk;
+	(*timer)->cookie = cookie;
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_timer_destroy(util_timer_t** timer)
+{
+	if(timer == NULL || *timer == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	util_timer_cancel(*timer);
+	osi_free((void**)timer);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_timer_arm(util_timer_t* timer, uint32_t msec)
+{
+	uint64_t now = 0;
+
+	if(timer == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(wheel.lock);
+	now = util_timer_now();
+	if(timer->slot != NULL)
+	{
+		util_timer_unlink(timer);
+	}
+	else
+	{
+		if(wheel.armed == 0 && wheel.firing == NULL && now > wheel.tick)
+		{
+			/* Wheel is empty; skip the ticks it slept through */
+			wheel.tick = now;
+		}
+		wheel.armed++;
+	}
+	timer->expires = now + msec;
+	util_timer_place(timer);
+	if(timer->expires < wheel.wake_at)
+	{
+		wheel.wake_at = timer->expires;
+		osi_bin_sem_give(wheel.wake);
+	}
+	osi_mutex_unlock(wheel.lock);
+
+	return EOS_ERROR_OK;
+}
+
+eos_error_t util_timer_cancel(util_timer_t* timer)
+{
+	if(timer == NULL)
+	{
+		return EOS_ERROR_INVAL;
+	}
+	osi_mutex_lock(wheel.lock);
+	if(timer->slot != NULL)
+	{
+		util_timer_unlink(timer);
+		wheel.armed--;
+	}
+	while(wheel.firing == timer && !osi_thread_is_current(wheel.thread))
+	{
+		osi_mutex_unlock(wheel.lock);
+		osi_time_usleep(UTIL_TIMER_RELEASE_PERIOD_USEC);
+		osi_mutex_lock(wheel.lock);
+	}
+	osi_mutex_unlock(wheel.lock);
+
+	return EOS_ERROR_OK;
+}
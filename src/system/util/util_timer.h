@@ -0,0 +1,89 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#ifndef UTIL_TIMER_H_
+#define UTIL_TIMER_H_
+
+#include "eos_types.h"
+
+/**
+ * One-shot timers driven by a single hierarchical timer wheel thread.
+ * Arm, re-arm and cancel are O(1); resolution is one millisecond tick
+ * (in practice bounded by the monotonic clock granularity). Callbacks run
+ * on the wheel thread and should be short, anything heavier belongs to an
+ * executor task.
+ */
+
+typedef struct util_timer util_timer_t;
+
+typedef void (*util_timer_cbk_t) (void* cookie);
+
+/**
+ * Creates (disarmed) timer.
+ * @param timer Timer handle.
+ * @param cbk Expiration callback.
+ * @param cookie Callback cookie.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_timer_create(util_timer_t** timer, util_timer_cbk_t cbk,
+		void* cookie);
+/**
+ * Cancels and releases the timer. Can be called from its own callback.
+ * @param timer Timer handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_timer_destroy(util_timer_t** timer);
+/**
+ * Arms the timer to expire in given number of milliseconds. Armed timer
+ * is re-armed.
+ * @param timer Timer handle.
+ * @param msec Timeout.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_timer_arm(util_timer_t* timer, uint32_t msec);
+/**
+ * Disarms the timer. When it returns, the callback is not running (unless
+ * called from the callback itself) and will not run until re-armed.
+ * @param timer Timer handle.
+ * @return EOS_ERROR_OK on success.
+ */
+eos_error_t util_timer_cancel(util_timer_t* timer);
+/**
+ * Returns monotonic time the wheel runs on.
+ * @return Milliseconds.
+ */
+uint64_t util_timer_now(void);
+
+#endif /* UTIL_TIMER_H_ */
@@ -38,6 +38,7 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "util_slist.h"
 #include "osi_memory.h"
 #include "util_tsparser.h"
+#include "util_esparser.h"
 #define MODULE_NAME "ts_parser"
 #include "util_log.h"
 
@@ -57,6 +58,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #define MODULE_NAME "ts_parser"
 
 #define AIT_URL_MAX_LENGTH (256)
+/* Enough for a PES header plus SPS (or a few audio frames) */
+#define ES_BUFFER_SIZE (TS_SIZE * 8)
 // *************************************
 // *              Types                *
 // *************************************
@@ -77,6 +80,11 @@ typedef struct ts_data_t {
 	// ECM data
 	uint8_t *ecm_buffer;
 	uint16_t ecm_buffer_size;
+	// ES header gathering (start of the current PES payload)
+	uint8_t *es_buffer;
+	uint16_t es_buffer_used;
+	bool es_started;
+	bool es_done;
 } ts_data_t;
 
 // *************************************
@@ -92,6 +100,9 @@ static eos_error_t util_tsparser_probe_pat(util_tsparser_t* tsparser,
 		uint8_t *buff, uint32_t size, uint8_t **pos);
 static eos_error_t util_tsparser_parse_descriptor(uint8_t* buff, uint16_t len, uint8_t* url_base_byte,
 						uint8_t* initial_path_byte, uint8_t application_control_code);
+static eos_error_t util_tsparser_pid_data(util_tsparser_t* tsparser, uint16_t pid, ts_data_t** ts_data);
+static bool util_tsparser_es_pending(util_tsparser_t* tsparser, eos_media_es_t* es);
+static void util_tsparser_es_gather(ts_data_t* ts_data, uint8_t* ts, eos_media_es_t* es);
 
 // *************************************
 // *         Global variables          *
@@ -390,6 +401,119 @@ static eos_media_codec_t util_tsparser_streamtype2codec(uint8_t stream_type)
 		default: return EOS_MEDIA_CODEC_UNKNOWN;
 	}
 }
+static eos_error_t util_tsparser_pid_data(util_tsparser_t* tsparser, uint16_t pid, ts_data_t** ts_data)
+{
+	switch (tsparser->pid_list.get(tsparser->pid_list, (void*)&pid, (void**)ts_data))
+	{
+		case EOS_ERROR_OK:
+			break;
+		case EOS_ERROR_NFOUND:
+			*ts_data = osi_calloc(sizeof(ts_data_t));
+			if (*ts_data == NULL)
+			{
+				return EOS_ERROR_NOMEM;
+			}
+			(*ts_data)->pid = pid;
+			if (tsparser->pid_list.add(tsparser->pid_list, (void*)*ts_data) != EOS_ERROR_OK)
+			{
+				osi_free((void**)ts_data);
+				return EOS_ERROR_GENERAL;
+			}
+			(*ts_data)->last_cc = -1;
+			psi_assemble_init(&(*ts_data)->psi_buffer, &(*ts_data)->psi_buffer_used);
+			break;
+		default:
+			break;
+	}
+
+	return EOS_ERROR_OK;
+}
+
+static bool util_tsparser_es_pending(util_tsparser_t* tsparser, eos_media_es_t* es)
+{
+	ts_data_t *ts_data = NULL;
+	uint16_t pid = es->id;
+
+	if (EOS_MEDIA_IS_VID(es->codec))
+	{
+		if (es->atr.video.resolution.width != 0 && es->atr.video.resolution.height != 0)
+		{
+			return false;
+		}
+	}
+	else if (EOS_MEDIA_IS_AUD(es->codec))
+	{
+		if (es->atr.audio.rate != 0)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		return false;
+	}
+	// Given up on (codec without a parser)
+	if (tsparser->pid_list.get(tsparser->pid_list, (void*)&pid, (void**)&ts_data) == EOS_ERROR_OK)
+	{
+		return !ts_data->es_done;
+	}
+
+	return true;
+}
+
+static void util_tsparser_es_gather(ts_data_t* ts_data, uint8_t* ts, eos_media_es_t* es)
+{
+	uint8_t *payload = ts_payload(ts);
+	uint16_t length = ts + TS_SIZE - payload;
+	uint16_t header = 0;
+	eos_error_t error = EOS_ERROR_OK;
+
+	if (ts_get_unitstart(ts))
+	{
+		ts_data->es_started = false;
+		if (length < PES_HEADER_SIZE_NOPTS || !pes_validate(payload) || !pes_validate_header(payload))
+		{
+			return;
+		}
+		header = PES_HEADER_SIZE_NOPTS + pes_get_headerlength(payload);
+		if (header > length)
+		{
+			return;
+		}
+		payload += header;
+		length -= header;
+		ts_data->es_buffer_used = 0;
+		ts_data->es_started = true;
+	}
+	if (!ts_data->es_started)
+	{
+		return;
+	}
+	if (ts_data->es_buffer == NULL)
+	{
+		if ((ts_data->es_buffer = osi_malloc(ES_BUFFER_SIZE)) == NULL)
+		{
+			return;
+		}
+	}
+	if (length > ES_BUFFER_SIZE - ts_data->es_buffer_used)
+	{
+		length = ES_BUFFER_SIZE - ts_data->es_buffer_used;
+	}
+	osi_memcpy(ts_data->es_buffer + ts_data->es_buffer_used, payload, length);
+	ts_data->es_buffer_used += length;
+	error = util_esparser_parse(es->codec, ts_data->es_buffer, ts_data->es_buffer_used, &es->atr);
+	if (error == EOS_ERROR_OK || error == EOS_ERROR_NIMPLEMENTED)
+	{
+		ts_data->es_done = true;
+	}
+	else if (ts_data->es_buffer_used == ES_BUFFER_SIZE)
+	{
+		// Header is not at the PES start, wait for the next one
+		ts_data->es_started = false;
+	}
+}
+
 static eos_error_t util_tsparser_payload_extract(util_tsparser_t *parser, ts_data_t *ts_data, const uint8_t** payload, uint8_t *length, eos_media_desc_t* desc, uint16_t pid)
 {
 	uint8_t *section = psi_assemble_payload(&ts_data->psi_buffer, &ts_data->psi_buffer_used, payload, length);
@@ -558,6 +682,21 @@ eos_error_t util_tsparser_create(util_tsparser_t** tsparser)
 }
 
 
+eos_error_t util_tsparser_get_pmt_pid (util_tsparser_t* tsparser, uint16_t* pid)
+{
+	if ((tsparser == NULL) || (pid == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	if (tsparser->pmt_pid == 0)
+	{
+		return EOS_ERROR_NFOUND;
+	}
+	*pid = tsparser->pmt_pid;
+
+	return EOS_ERROR_OK;
+}
+
 eos_error_t util_tsparser_destroy (util_tsparser_t** tsparser)
 {
 	ts_data_t *ts_data = NULL;
@@ -580,6 +719,10 @@ eos_error_t util_tsparser_destroy (util_tsparser_t** tsparser)
 			osi_free((void**)&ts_data->ecm_buffer);
 			ts_data->ecm_buffer = NULL;
 		}
+		if (ts_data->es_buffer != NULL)
+		{
+			osi_free((void**)&ts_data->es_buffer);
+		}
 		osi_free((void**)&ts_data);
 	}
 	util_slist_destroy(&(*tsparser)->pid_list);
@@ -703,28 +846,9 @@ eos_error_t util_tsparser_get_media_info (util_tsparser_t* tsparser, uint8_t* ts
 		}
 
 		pid = ts_get_pid(ts_iterator);
-		error = tsparser->pid_list.get(tsparser->pid_list, (void*)&pid, (void**)&ts_data);
-		switch (error)
+		if ((error = util_tsparser_pid_data(tsparser, pid, &ts_data)) != EOS_ERROR_OK)
 		{
-			case EOS_ERROR_OK:
-				break;
-			case EOS_ERROR_NFOUND:
-				ts_data = osi_calloc(sizeof(ts_data_t));
-				if (ts_data == NULL)
-				{
-					return EOS_ERROR_NOMEM;
-				}
-				ts_data->pid = pid;
-				if (tsparser->pid_list.add(tsparser->pid_list, (void*)ts_data) != EOS_ERROR_OK)
-				{
-					osi_free((void**)&ts_data);
-					return EOS_ERROR_GENERAL;
-				}
-				ts_data->last_cc = -1;
-				psi_assemble_init(&ts_data->psi_buffer, &ts_data->psi_buffer_used);
-				break;
-			default:
-				break;
+			return error;
 		}
 
 		cc = ts_get_cc(ts_iterator);
@@ -762,6 +886,53 @@ eos_error_t util_tsparser_get_media_info (util_tsparser_t* tsparser, uint8_t* ts
 	return EOS_ERROR_NFOUND;
 }
 
+eos_error_t util_tsparser_get_es_info (util_tsparser_t* tsparser, uint8_t* ts, uint32_t size, eos_media_desc_t* desc)
+{
+	uint32_t i = 0;
+	uint8_t j = 0;
+	uint16_t pid = 0;
+	ts_data_t *ts_data = NULL;
+	eos_error_t error = EOS_ERROR_OK;
+
+	if ((ts == NULL) || (tsparser == NULL) || (desc == NULL))
+	{
+		return EOS_ERROR_INVAL;
+	}
+	for (i = 0; i + TS_SIZE <= size; i += TS_SIZE)
+	{
+		if (!ts_validate(&ts[i]) || !ts_has_payload(&ts[i]))
+		{
+			continue;
+		}
+		pid = ts_get_pid(&ts[i]);
+		for (j = 0; j < desc->es_cnt; j++)
+		{
+			if (desc->es[j].id == pid && util_tsparser_es_pending(tsparser, &desc->es[j]))
+			{
+				break;
+			}
+		}
+		if (j == desc->es_cnt)
+		{
+			continue;
+		}
+		if ((error = util_tsparser_pid_data(tsparser, pid, &ts_data)) != EOS_ERROR_OK)
+		{
+			return error;
+		}
+		util_tsparser_es_gather(ts_data, &ts[i], &desc->es[j]);
+	}
+	for (j = 0; j < desc->es_cnt; j++)
+	{
+		if (util_tsparser_es_pending(tsparser, &desc->es[j]))
+		{
+			return EOS_ERROR_NFOUND;
+		}
+	}
+
+	return EOS_ERROR_OK;
+}
+
 eos_error_t util_tsparser_contains_packet (uint8_t* ts, uint32_t size, int16_t pid)
 {
 	uint32_t i = 0;
@@ -61,6 +61,15 @@ eos_error_t util_tsparser_create(util_tsparser_t** tsparser);
 eos_error_t util_tsparser_destroy (util_tsparser_t** tsparser);
 eos_error_t util_tsparser_extract_pmt_media_desc(uint8_t* pmt, eos_media_desc_t* desc);
 eos_error_t util_tsparser_get_media_info (util_tsparser_t* tsparser, uint8_t* ts, uint32_t size, int16_t info_id, eos_media_desc_t* desc);
+/*
+ * Completes audio/video ES attributes (resolution, frame rate, sample rate, channels)
+ * from the ES headers, see util_esparser. To be fed with packets following the PMT,
+ * once util_tsparser_get_media_info has filled the descriptor.
+ * Returns EOS_ERROR_OK once all A/V ES are done (EOS_ERROR_NFOUND before)
+ */
+eos_error_t util_tsparser_get_es_info (util_tsparser_t* tsparser, uint8_t* ts, uint32_t size, eos_media_desc_t* desc);
+/* Returns PMT PID once PAT is parsed by util_tsparser_get_media_info (EOS_ERROR_NFOUND before) */
+eos_error_t util_tsparser_get_pmt_pid (util_tsparser_t* tsparser, uint16_t* pid);
 eos_error_t util_tsparser_check_pid (uint8_t* ts, int16_t pid);
 eos_error_t util_tsparser_get_ts_payload_by_pid (uint8_t* ts, uint32_t size, uint8_t** payload, uint8_t* payload_len, int16_t pid);
 eos_error_t util_tsparser_contains_packet (uint8_t* ts, uint32_t size, int16_t pid);
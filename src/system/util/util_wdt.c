@@ -31,17 +31,16 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+
 // *************************************
 // *             Includes              *
 // *************************************
 
 #include "util_wdt.h"
+#include "util_timer.h"
 #include "eos_macro.h"
 #include "osi_memory.h"
 #include "util_log.h"
-#include "osi_thread.h"
-#include "osi_time.h"
-#include "osi_bin_sem.h"
 #include "osi_mutex.h"
 
 
@@ -54,9 +53,6 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 // *************************************
 
 #define MODULE_NAME "wdt"
-#define WDT_RELEASE_PERIOD_MSEC 5
-#define MSEC_IN_SEC 1000
-#define NSEC_IN_MSEC 1000000
 
 // *************************************
 // *              Types                *
@@ -72,8 +68,7 @@ typedef enum util_wdt_state
 
 struct util_wdt
 {
-	osi_thread_t *thread;
-	osi_bin_sem_t *trigger;
+	util_timer_t *timer;
 	osi_mutex_t *sync;
 
 	util_wdt_state_t state;
@@ -81,74 +76,57 @@ struct util_wdt
 	uint32_t timer_msec;
 	util_wdt_timeout_t callback;
 	void *callback_cookie;
+	/* Time of the last keep alive (wraps, only differences are used) */
+	volatile uint32_t alive;
 };
 
 // *************************************
 // *            Prototypes             *
 // *************************************
 
-static void* watchdog_thread (void* arg);
+static void watchdog_expired (void* arg);
 
 // *************************************
 // *         Global variables          *
 // *************************************
 
 // *************************************
-// *             Threads               *
+// *         Local functions           *
 // *************************************
 
-static void* watchdog_thread (void* arg)
+/*
+ * Keep alive only stores the time; the timer is re-armed lazily, when it
+ * expires and finds out the watchdog was kept alive meanwhile.
+ */
+static void watchdog_expired (void* arg)
 {
 	util_wdt_t *wdt = (util_wdt_t*)arg;
-	osi_time_t wait_timeout = {0, 0};
-	osi_time_t default_wait_timeout = {0, 0};
-	eos_error_t error = EOS_ERROR_OK;
-
-	default_wait_timeout.sec = wdt->timer_msec / MSEC_IN_SEC;
-	default_wait_timeout.nsec = (wdt->timer_msec - (default_wait_timeout.sec * MSEC_IN_SEC)) * NSEC_IN_MSEC;
-
+	util_wdt_timeout_t callback = NULL;
+	void *callback_cookie = NULL;
+	uint32_t idle = 0;
 
-//	UTIL_GLOGE("WDT %p Start", wdt->trigger);
-	while ((wdt->state == EOS_WDT_STATE_RUNNING) || (wdt->state == EOS_WDT_STATE_SUSPENDED))
+	osi_mutex_lock(wdt->sync);
+	if (wdt->state != EOS_WDT_STATE_RUNNING)
 	{
-		if (wdt->state == EOS_WDT_STATE_SUSPENDED)
-		{
-			wait_timeout.sec = 10000;
-			wait_timeout.nsec = 0;
-//			UTIL_GLOGE("WDT %p Suspend", wdt->trigger);
-		}
-		else
-		{
-			wait_timeout.sec = default_wait_timeout.sec;
-			wait_timeout.nsec = default_wait_timeout.nsec;
-		}
-
-		error = osi_bin_sem_timedtake(wdt->trigger, &wait_timeout);
-		if (error != EOS_ERROR_OK)
-		{
-			if (error == EOS_ERROR_TIMEDOUT)
-			{
-				if (wdt->state == EOS_WDT_STATE_SUSPENDED)
-				{
-					continue;
-				}
-
-				wdt->callback(wdt->callback_cookie);
-			}
-			else
-			{
-				// Unexpected
-				EOS_ASSERT(error == EOS_ERROR_OK)
-			}
-		}
+		osi_mutex_unlock(wdt->sync);
+		return;
 	}
-//	UTIL_GLOGE("WDT %p Finish", wdt->trigger);
-	return arg;
-}
+	idle = (uint32_t)util_timer_now() - wdt->alive;
+	if (idle < wdt->timer_msec)
+	{
+		util_timer_arm(wdt->timer, wdt->timer_msec - idle);
+		osi_mutex_unlock(wdt->sync);
+		return;
+	}
+	// Fires again after another period without keep alive
+	wdt->alive = (uint32_t)util_timer_now();
+	util_timer_arm(wdt->timer, wdt->timer_msec);
+	callback = wdt->callback;
+	callback_cookie = wdt->callback_cookie;
+	osi_mutex_unlock(wdt->sync);
 
-// *************************************
-// *         Local functions           *
-// *************************************
+	callback(callback_cookie);
+}
 
 // *************************************
 // *       Global functions            *
@@ -169,7 +147,7 @@ eos_error_t util_wdt_create(util_wdt_t** wdt)
 		return EOS_ERROR_NOMEM;
 	}
 
-	error = osi_bin_sem_create(&(*wdt)->trigger, false);
+	error = util_timer_create(&(*wdt)->timer, watchdog_expired, *wdt);
 	if (error != EOS_ERROR_OK)
 	{
 		osi_free((void**)wdt);
@@ -179,7 +157,7 @@ eos_error_t util_wdt_create(util_wdt_t** wdt)
 	error = osi_mutex_create(&(*wdt)->sync);
 	if (error != EOS_ERROR_OK)
 	{
-		osi_bin_sem_destroy(&(*wdt)->trigger);
+		util_timer_destroy(&(*wdt)->timer);
 		osi_free((void**)wdt);
 		return error;
 	}
@@ -211,33 +189,21 @@ eos_error_t util_wdt_destroy(util_wdt_t** wdt)
 	error = osi_mutex_unlock((*wdt)->sync);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 
-	if  (curerent_state != EOS_WDT_STATE_STOPPED)
+	// Unexpected (assume that it will end well :)
+	if (curerent_state == EOS_WDT_STATE_DESTROYING)
 	{
-		// Unexpected (assume that it will end well :)
-		if (curerent_state == EOS_WDT_STATE_DESTROYING)
-		{
-			return EOS_ERROR_OK;
-		}
-
-		// Somebody is careless
-		if ((curerent_state == EOS_WDT_STATE_RUNNING) || (curerent_state == EOS_WDT_STATE_SUSPENDED))
-		{
-			error = util_wdt_stop(*wdt);
-			if (error != EOS_ERROR_OK)
-			{
-				return error;
-			}
-		}
+		return EOS_ERROR_OK;
 	}
 
-	error = osi_mutex_destroy(&(*wdt)->sync);
+	// Somebody is careless if it is still running, but the timer goes anyway
+	error = util_timer_destroy(&(*wdt)->timer);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 	if (error != EOS_ERROR_OK)
 	{
 		// Unexpected
 	}
 
-	error = osi_bin_sem_destroy(&(*wdt)->trigger);
+	error = osi_mutex_destroy(&(*wdt)->sync);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 	if (error != EOS_ERROR_OK)
 	{
@@ -279,12 +245,14 @@ eos_error_t util_wdt_start (util_wdt_t* wdt, uint32_t timer_msec, util_wdt_timeo
 	wdt->timer_msec = timer_msec;
 	wdt->callback = callback;
 	wdt->callback_cookie = callback_cookie;
+	wdt->alive = (uint32_t)util_timer_now();
 
 	wdt->state = EOS_WDT_STATE_RUNNING;
-	error = osi_thread_create(&wdt->thread, NULL, watchdog_thread, (void*)wdt);
+	error = util_timer_arm(wdt->timer, timer_msec);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 	if (error != EOS_ERROR_OK)
 	{
+		wdt->state = EOS_WDT_STATE_STOPPED;
 		osi_mutex_unlock(wdt->sync);
 		return error;
 	}
@@ -298,6 +266,7 @@ eos_error_t util_wdt_start (util_wdt_t* wdt, uint32_t timer_msec, util_wdt_timeo
 
 	return EOS_ERROR_OK;
 }
+
 eos_error_t util_wdt_stop (util_wdt_t* wdt)
 {
 	eos_error_t error = EOS_ERROR_OK;
@@ -329,89 +298,46 @@ eos_error_t util_wdt_stop (util_wdt_t* wdt)
 	
 	wdt->state = EOS_WDT_STATE_STOPPED;	
 
-	error = osi_bin_sem_give(wdt->trigger);
+	error = osi_mutex_unlock(wdt->sync);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 	if (error != EOS_ERROR_OK)
 	{
-		osi_mutex_unlock(wdt->sync);
-		return error;
+		// Unexpected
 	}
 
-	wdt->timer_msec = 0;
-	wdt->callback = NULL;
-	wdt->callback_cookie = NULL;
-
-	error = osi_thread_join(wdt->thread, NULL);
+	// Not under the lock: waits for a callback that may be running
+	error = util_timer_cancel(wdt->timer);
 	EOS_ASSERT(error == EOS_ERROR_OK)
 	if (error != EOS_ERROR_OK)
 	{
-		osi_mutex_unlock(wdt->sync);
 		return error;
 	}
 
-	error = osi_thread_release(&wdt->thread);
-	EOS_ASSERT(error == EOS_ERROR_OK)
-	if (error != EOS_ERROR_OK)
-	{
-		// Unexpected
-	}
-
-	error = osi_mutex_unlock(wdt->sync);
-	EOS_ASSERT(error == EOS_ERROR_OK)
-	if (error != EOS_ERROR_OK)
-	{
-		// Unexpected
-	}
+	wdt->timer_msec = 0;
+	wdt->callback = NULL;
+	wdt->callback_cookie = NULL;
 
 	return EOS_ERROR_OK;
 }
 
 eos_error_t util_wdt_keep_alive (util_wdt_t* wdt)
 {
-	eos_error_t error = EOS_ERROR_OK;
-
 	if (wdt == NULL)
 	{
 		return EOS_ERROR_INVAL;
 	}
 
-	error = osi_mutex_lock(wdt->sync);
-	EOS_ASSERT(error == EOS_ERROR_OK)
-	if (error != EOS_ERROR_OK)
-	{
-		return error;
-	}
-
 	if (wdt->state != EOS_WDT_STATE_RUNNING)
 	{
-		osi_mutex_unlock(wdt->sync);
 		return EOS_ERROR_INVAL;
 	}
-	else
-	{	
-		error = osi_bin_sem_give(wdt->trigger);
-		EOS_ASSERT(error == EOS_ERROR_OK)
-		if (error != EOS_ERROR_OK)
-		{
-			osi_mutex_unlock(wdt->sync);
-			return error;
-		}
-	}
-
-	error = osi_mutex_unlock(wdt->sync);
-	EOS_ASSERT(error == EOS_ERROR_OK)
-	if (error != EOS_ERROR_OK)
-	{
-		// Unexpected
-	}
+	wdt->alive = (uint32_t)util_timer_now();
 
 	return EOS_ERROR_OK;
 }
 
 eos_error_t util_wdt_suspend (util_wdt_t* wdt, bool suspend)
 {
-	EOS_UNUSED(wdt)
-	
 	eos_error_t error = EOS_ERROR_OK;
 
 	if (wdt == NULL)
@@ -419,7 +345,7 @@ eos_error_t util_wdt_suspend (util_wdt_t* wdt, bool suspend)
 		return EOS_ERROR_INVAL;
 	}
 
-	//UTIL_GLOGE("WDT %p: %s", wdt->trigger, suspend?"suspend":"resume");
+	//UTIL_GLOGE("WDT %p: %s", wdt, suspend?"suspend":"resume");
 
 	error = osi_mutex_lock(wdt->sync);
 	EOS_ASSERT(error == EOS_ERROR_OK)
@@ -433,16 +359,16 @@ eos_error_t util_wdt_suspend (util_wdt_t* wdt, bool suspend)
 		case EOS_WDT_STATE_RUNNING:
 			if (suspend == true)
 			{
+				// Pending expiration finds it suspended and is dropped
 				wdt->state = EOS_WDT_STATE_SUSPENDED;
-				error = osi_bin_sem_give(wdt->trigger);
-				EOS_ASSERT(error == EOS_ERROR_OK)
 			}
 			break;
 		case EOS_WDT_STATE_SUSPENDED:
 			if (suspend == false)
 			{
 				wdt->state = EOS_WDT_STATE_RUNNING;
-				error = osi_bin_sem_give(wdt->trigger);
+				wdt->alive = (uint32_t)util_timer_now();
+				error = util_timer_arm(wdt->timer, wdt->timer_msec);
 				EOS_ASSERT(error == EOS_ERROR_OK)
 			}
 			break;
@@ -460,4 +386,3 @@ eos_error_t util_wdt_suspend (util_wdt_t* wdt, bool suspend)
 
 	return EOS_ERROR_OK;
 }
-
@@ -35,22 +35,55 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "eos_macro.h"
 #include "eos_types.h"
 #include "osi_thread.h"
+#include "osi_time.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
 
+#define CC_TEST_ZAPS (200)
+
+typedef struct cc_test_stats
+{
+	uint64_t total_us;
+	uint64_t max_us;
+	uint32_t count;
+	uint32_t failed;
+} cc_test_stats_t;
+
+static cc_test_stats_t stats[2];
+
+static void timed_play(char* uri, cc_test_stats_t* stat)
+{
+	osi_time_t start = {0, 0};
+	osi_time_t end = {0, 0};
+	osi_time_t diff = {0, 0};
+	uint64_t us = 0;
+
+	osi_time_get_timestamp(&start);
+	if (eos_player_play(uri, NULL, EOS_OUT_MAIN_AV) != EOS_ERROR_OK)
+	{
+		stat->failed++;
+	}
+	osi_time_get_timestamp(&end);
+	osi_time_diff(&start, &end, &diff);
+	OSI_TIME_CONVERT_TO_USEC(diff, us);
+	stat->total_us += us;
+	stat->max_us = (us > stat->max_us) ? us : stat->max_us;
+	stat->count++;
+}
+
 static void* async_sink_stop(void* arg)
 {                       
 	int i = 0;
 	char* uri = (char*)arg;
 	int rnd = 0;
-	for (i = 0; i < 200; i++)
+	for (i = 0; i < CC_TEST_ZAPS; i++)
 	{
 		rnd = rand();
-		printf("Thread2[%d/%d]\n", i + 1, 200);
-		eos_player_play(uri, NULL, EOS_OUT_MAIN_AV);
+		printf("Thread2[%d/%d]\n", i + 1, CC_TEST_ZAPS);
+		timed_play(uri, &stats[1]);
 		usleep(rnd%500000);
 	}
         return arg;
@@ -78,19 +111,26 @@ int main(int argc, char** argv)
 	}
 
 	osi_thread_create(&sink_stop_thread, NULL, async_sink_stop, (void*)argv[1]);
-	for (i = 0; i < 200; i++)
+	for (i = 0; i < CC_TEST_ZAPS; i++)
 	{
 		rnd = rand();
-		printf("Thread1[%d/%d]\n", i + 1, 200);
-		eos_player_play(argv[1], NULL, EOS_OUT_MAIN_AV);
-		printf("Thread1 done[%d/%d]\n", i + 1, 200);
+		printf("Thread1[%d/%d]\n", i + 1, CC_TEST_ZAPS);
+		timed_play(argv[1], &stats[0]);
+		printf("Thread1 done[%d/%d]\n", i + 1, CC_TEST_ZAPS);
 		usleep(rnd%500000);
-		printf("Thread1 after sleep[%d/%d]\n", i + 1, 200);
+		printf("Thread1 after sleep[%d/%d]\n", i + 1, CC_TEST_ZAPS);
 	}
 
 	osi_thread_join(sink_stop_thread, NULL);
 	osi_thread_release(&sink_stop_thread);
 
+	for (i = 0; i < 2; i++)
+	{
+		printf("Thread%d zap time: avg %llu us, max %llu us, failed %u/%u\n", i + 1,
+				(unsigned long long)(stats[i].count ? stats[i].total_us / stats[i].count : 0),
+				(unsigned long long)stats[i].max_us, stats[i].failed, stats[i].count);
+	}
+
 	eos_player_play(argv[1], NULL, EOS_OUT_MAIN_AV);
 	usleep(5000000);
 	eos_player_stop(EOS_OUT_MAIN_AV);
@@ -58,6 +58,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 #define HISTORY_FILE ("./eos_test.txt")
 
+#define MEM_STATS_MAX (64)
+
 typedef int (*command_func_t)(char** args);
 
 typedef struct command
@@ -106,6 +108,9 @@ static int cmd_dvbsub(char** args);
 static int cmd_ttxt(char** args);
 static int cmd_audio_mode(char** args);
 static int cmd_vol_leveling(char** args);
+static int cmd_dec_threads(char** args);
+static int cmd_mem(char** args);
+static int cmd_zap(char** args);
 
 static command_t cmds[] =
 {
@@ -133,6 +138,10 @@ static command_t cmds[] =
 	{"ttxt", "Enable/Disable Teletext: ttxt <main|aux>  <on|off>", cmd_ttxt},
 	{"passthrough", "Switches passthrough on/off <1|0>" , cmd_audio_mode},
 	{"vol_lvl", "Sets volume leveling <on/off> [light|normal|heavy] " , cmd_vol_leveling},
+	{"dec_thr", "Sets video decoder threading (applied on next start): dec_thr <main|aux> "
+			"<auto|frame|slice|off> [<count>]", cmd_dec_threads},
+	{"mem", "Prints per-module memory usage (live/peak bytes, allocations per second): mem", cmd_mem},
+	{"zap", "Prints last zap breakdown and p50/p90/p99 per milestone (ms): zap <main|aux>", cmd_zap},
 	{NULL, NULL, NULL}
 };
 
@@ -638,6 +647,54 @@ static int cmd_vol_leveling(char** args)
 	return 0;
 }
 
+static int cmd_dec_threads(char** args)
+{
+	eos_out_t eos_out = EOS_OUT_MAIN_AV;
+	eos_out_dec_thr_t mode = EOS_OUT_DEC_THR_AUTO;
+	int count = 0;
+
+	eos_puts("DEC THR called");
+	if(get_out_opt(args[0], &eos_out) != 0)
+	{
+		eos_puts("Bad out argument!!!");
+		return -1;
+	}
+	if(args[1] == NULL)
+	{
+		eos_puts("Missing mode argument!!!");
+		return -1;
+	}
+	if(strcasecmp(args[1], "frame") == 0)
+	{
+		mode = EOS_OUT_DEC_THR_FRAME;
+	}
+	else if(strcasecmp(args[1], "slice") == 0)
+	{
+		mode = EOS_OUT_DEC_THR_SLICE;
+	}
+	else if(strcasecmp(args[1], "off") == 0)
+	{
+		mode = EOS_OUT_DEC_THR_OFF;
+	}
+	if(args[2] != NULL)
+	{
+		count = atoi(args[2]);
+		if(count < 0 || count > UINT8_MAX)
+		{
+			eos_puts("Bad count argument!!!");
+			return -1;
+		}
+	}
+	if(eos_out_dec_threads(eos_out, mode, (uint8_t)count) != EOS_ERROR_OK)
+	{
+		eos_puts("DEC THR failed!!!");
+		return -1;
+	}
+	eos_puts("DEC THR set");
+
+	return 0;
+}
+
 static int cmd_scale(char** args)
 {
 	char *out = args[0];
@@ -996,3 +1053,68 @@ static void completition_cbk(const char *str, linenoiseCompletions *lc)
 	}
 }
 
+static int cmd_mem(char** args)
+{
+	eos_mem_stats_t stats[MEM_STATS_MAX];
+	uint32_t count = MEM_STATS_MAX, i;
+	uint64_t live = 0;
+
+	EOS_UNUSED(args);
+	if(eos_mem_stats_get(stats, &count) != EOS_ERROR_OK)
+	{
+		eos_puts("MEM failed (built without MEMORY_ACCOUNTING?)!!!");
+		return -1;
+	}
+	printf("%-36s %12s %12s %10s %10s %8s\r\n", "module", "live", "peak",
+			"allocs", "frees", "alloc/s");
+	for(i=0; i<count && i<MEM_STATS_MAX; i++)
+	{
+		printf("%-36s %12llu %12llu %10llu %10llu %8u\r\n", stats[i].module,
+				(unsigned long long)stats[i].live, (unsigned long long)stats[i].peak,
+				(unsigned long long)stats[i].allocs, (unsigned long long)stats[i].frees,
+				stats[i].rate);
+		live += stats[i].live;
+	}
+	printf("%-36s %12llu\r\n", "total", (unsigned long long)live);
+
+	return 0;
+}
+
+static int cmd_zap(char** args)
+{
+	static const char *names[EOS_ZAP_MS_LAST] = {"play", "create",
+			"lock", "pat", "pmt", "sink", "pkt", "iframe", "disp"};
+	eos_out_t eos_out = EOS_OUT_MAIN_AV;
+	eos_zap_info_t last;
+	eos_zap_hist_t hist;
+	int i;
+
+	if(get_out_opt(args[0], &eos_out) != 0)
+	{
+		eos_puts("Bad out argument!!!");
+		return -1;
+	}
+	if(eos_player_get_zap_stats(eos_out, &last, &hist) != EOS_ERROR_OK)
+	{
+		eos_puts("ZAP stats not available!!!");
+		return -1;
+	}
+	printf("Zap #%u (%u completed)\r\n", last.id, hist.zaps);
+	printf("%-8s %8s %8s %8s %8s\r\n", "stage", "last", "p50", "p90", "p99");
+	for(i=0; i<EOS_ZAP_MS_LAST; i++)
+	{
+		if(last.at[i] == EOS_ZAP_NONE)
+		{
+			printf("%-8s %8s", names[i], "-");
+		}
+		else
+		{
+			printf("%-8s %8u", names[i], last.at[i]);
+		}
+		/* EOS_ZAP_NONE prints as -1 */
+		printf(" %8d %8d %8d\r\n", (int32_t)hist.p50[i],
+				(int32_t)hist.p90[i], (int32_t)hist.p99[i]);
+	}
+
+	return 0;
+}
@@ -47,16 +47,16 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 
 fsi_file_t *file = NULL;
 
-eos_media_es_attr_t lala = {{0, {0, 0}}};
+eos_media_es_attr_t lala = {{0, {0, 0}, {0, 0}}};
 
 eos_media_desc_t media_desc =
 {
 	.container = EOS_MEDIA_CONT_MPEGTS,
 	.es_cnt = 4,
-	.es[0] = {101, EOS_MEDIA_CODEC_H264, "", {{0, {0, 0}}}, true},
-	.es[1] = {301, EOS_MEDIA_CODEC_AAC, "ger", {{0, {0, 0}}}, true},
-	.es[2] = {302, EOS_MEDIA_CODEC_AAC, "aub", {{0, {0, 0}}}, false},
-	.es[3] = {277, EOS_MEDIA_CODEC_TTXT, "ger", {{0, {0, 0}}}, false}
+	.es[0] = {101, EOS_MEDIA_CODEC_H264, "", {{0, {0, 0}, {0, 0}}}, true},
+	.es[1] = {301, EOS_MEDIA_CODEC_AAC, "ger", {{0, {0, 0}, {0, 0}}}, true},
+	.es[2] = {302, EOS_MEDIA_CODEC_AAC, "aub", {{0, {0, 0}, {0, 0}}}, false},
+	.es[3] = {277, EOS_MEDIA_CODEC_TTXT, "ger", {{0, {0, 0}, {0, 0}}}, false}
 };
 
 void err_exit(int err, int line)
@@ -103,6 +103,7 @@ int main(int argc, char** argv)
 	link_io_type_t input_type = LINK_IO_TYPE_SPROG_TS;
 	link_cap_stream_sel_ctrl_t *sel;
 	link_cap_av_out_set_ctrl_t *av_ctrl;
+	util_mdesc_t *media = NULL;
 
 	/* kill warning */
 	if(argc == 1 || argv == NULL)
@@ -110,14 +111,19 @@ int main(int argc, char** argv)
 		UTIL_GLOGE("Please provide MPEG TS file path!");
 		return -1;
 	}
-	if(sink_factory_manufacture(0, &media_desc, caps, input_type, &sink) != EOS_ERROR_OK)
+	if(util_mdesc_create(&media, &media_desc) != EOS_ERROR_OK)
 	{
 		err_exit(-1, __LINE__);
 	}
-	if(sink_factory_manufacture(0, &media_desc, caps, input_type, &sink) == EOS_ERROR_OK)
+	if(sink_factory_manufacture(0, media, caps, input_type, &sink) != EOS_ERROR_OK)
 	{
 		err_exit(-1, __LINE__);
 	}
+	if(sink_factory_manufacture(0, media, caps, input_type, &sink) == EOS_ERROR_OK)
+	{
+		err_exit(-1, __LINE__);
+	}
+	util_mdesc_unref(&media);
 	if((sink->caps & LINK_CAP_STREAM_SEL) == 0)
 	{
 		UTIL_GLOGE("Sink has no stream select cap!");
@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "test:osi"
+
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -41,6 +43,9 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 #include "osi_time.h"
 #include "osi_sem.h"
 #include "osi_bin_sem.h"
+#include "osi_pool.h"
+#include "osi_executor.h"
+#include "eos_macro.h"
 
 #define TEST_ONE_BUFF_SIZE (20 * 1024 * 1024)
 #define TEST_ONE_PATTERN (0xFA)
@@ -417,6 +422,418 @@ void test_six(void)
 	printf("Test 6: Done...\n");
 }
 
+#define TEST_SEVEN_PING_PONG (200000)
+#define TEST_SEVEN_TIMEOUT_MS (200)
+
+typedef struct test_seven_arg
+{
+	osi_bin_sem_t *ping;
+	osi_bin_sem_t *pong;
+} test_seven_arg_t;
+
+void* test_seven_thread(void* arg)
+{
+	test_seven_arg_t *sems = (test_seven_arg_t*) arg;
+	int fail = 7, i;
+
+	for(i=0; i<TEST_SEVEN_PING_PONG; i++)
+	{
+		if(osi_bin_sem_take(sems->ping) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+		osi_bin_sem_give(sems->pong);
+	}
+
+	return NULL;
+}
+
+void test_seven(void)
+{
+	test_seven_arg_t sems = {NULL, NULL};
+	osi_sem_t *sem = NULL;
+	int fail = 7, i;
+	osi_thread_t *t = NULL;
+	osi_thread_attr_t attr = {OSI_THREAD_JOINABLE};
+	osi_time_t timeout = {0, 0}, one, two, diff;
+
+	printf("Test 7: Timed waits and ping-pong test\n");
+	if(osi_bin_sem_create(&sems.ping, false) != EOS_ERROR_OK ||
+			osi_bin_sem_create(&sems.pong, false) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	printf("Test 7: Bin sem timeout...\n");
+	OSI_TIME_CONVERT_FROM_MSEC(timeout, TEST_SEVEN_TIMEOUT_MS);
+	osi_time_get_timestamp(&one);
+	if(osi_bin_sem_timedtake(sems.ping, &timeout) != EOS_ERROR_TIMEDOUT)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_time_get_timestamp(&two);
+	osi_time_diff(&one, &two, &diff);
+	if(diff.sec == 0 && diff.nsec < OSI_TIME_MSEC_TO_NSEC(TEST_SEVEN_TIMEOUT_MS - 20))
+	{
+		err_exit(fail, __LINE__);
+	}
+	printf("Test 7: Bin sem given before timed take...\n");
+	osi_bin_sem_give(sems.ping);
+	OSI_TIME_CONVERT_FROM_MSEC(timeout, TEST_SEVEN_TIMEOUT_MS);
+	if(osi_bin_sem_timedtake(sems.ping, &timeout) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	/* Rest of the timeout is given back */
+	if(timeout.sec != 0 || timeout.nsec == 0 ||
+			timeout.nsec > OSI_TIME_MSEC_TO_NSEC(TEST_SEVEN_TIMEOUT_MS))
+	{
+		err_exit(fail, __LINE__);
+	}
+	printf("Test 7: Sem absolute timeout...\n");
+	if(osi_sem_create(&sem, 0, 1) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_time_get_time(&one);
+	OSI_TIME_CONVERT_FROM_MSEC(diff, TEST_SEVEN_TIMEOUT_MS);
+	osi_time_add(&one, &diff, &timeout);
+	if(osi_sem_timedwait(sem, &timeout) != EOS_ERROR_TIMEDOUT)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_sem_post(sem);
+	osi_time_get_time(&one);
+	osi_time_add(&one, &diff, &timeout);
+	if(osi_sem_timedwait(sem, &timeout) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_sem_destroy(&sem);
+	printf("Test 7: Ping-pong %d times...\n", TEST_SEVEN_PING_PONG);
+	osi_time_get_timestamp(&one);
+	if(osi_thread_create(&t, &attr, test_seven_thread, &sems) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	for(i=0; i<TEST_SEVEN_PING_PONG; i++)
+	{
+		osi_bin_sem_give(sems.ping);
+		if(osi_bin_sem_take(sems.pong) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	osi_thread_join(t, NULL);
+	osi_thread_release(&t);
+	osi_time_get_timestamp(&two);
+	osi_time_diff(&one, &two, &diff);
+	osi_bin_sem_destroy(&sems.ping);
+	osi_bin_sem_destroy(&sems.pong);
+	printf("Test 7: Done...%u[s] %u[ms]\n", diff.sec, diff.nsec / 1000000);
+}
+
+#define TEST_EIGHT_THREADS (4)
+#define TEST_EIGHT_OBJECTS (1000)
+#define TEST_EIGHT_ROUNDS (200)
+
+void* test_eight_thread(void* arg)
+{
+	void **objs = (void**) arg;
+	int fail = 8, i, j;
+	size_t size;
+
+	for(j=0; j<TEST_EIGHT_ROUNDS; j++)
+	{
+		for(i=0; i<TEST_EIGHT_OBJECTS; i++)
+		{
+			/* Free what the main thread (or previous round) left behind */
+			osi_pool_free(&objs[i]);
+			size = (size_t)((i * 37 + j) % (OSI_POOL_MAX_SIZE + 64));
+			objs[i] = osi_pool_alloc(size);
+			if(objs[i] == NULL || (size > 0 && ((uint8_t*)objs[i])[size - 1] != 0))
+			{
+				err_exit(fail, __LINE__);
+			}
+			osi_memset(objs[i], 0xAB, size);
+		}
+	}
+	osi_pool_flush();
+
+	return NULL;
+}
+
+void test_eight(void)
+{
+	void *objs[TEST_EIGHT_THREADS][TEST_EIGHT_OBJECTS];
+	osi_thread_t *t[TEST_EIGHT_THREADS];
+	osi_thread_attr_t attr = {OSI_THREAD_JOINABLE};
+	void *ptr = NULL, *tmp = NULL;
+	int fail = 8, i, j;
+
+	printf("Test 8: Pool allocator\n");
+	ptr = osi_pool_alloc(100);
+	if(ptr == NULL || !osi_pool_owns(ptr) || osi_pool_usable_size(ptr) < 100)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_memset(ptr, 0x55, 100);
+	/* Growing past the size-class moves the block out of the pool */
+	tmp = osi_realloc(ptr, 4 * OSI_POOL_MAX_SIZE);
+	if(tmp == NULL || osi_pool_owns(tmp) || ((uint8_t*)tmp)[99] != 0x55)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_free(&tmp);
+	/* Freed block is reused and comes back zeroed */
+	ptr = osi_pool_alloc(100);
+	osi_memset(ptr, 0x55, 100);
+	osi_pool_free(&ptr);
+	if(ptr != NULL)
+	{
+		err_exit(fail, __LINE__);
+	}
+	ptr = osi_pool_alloc(100);
+	for(i=0; i<100; i++)
+	{
+		if(((uint8_t*)ptr)[i] != 0)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	osi_free(&ptr);
+	ptr = osi_pool_alloc(OSI_POOL_MAX_SIZE + 1);
+	if(ptr == NULL || osi_pool_owns(ptr))
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_pool_free(&ptr);
+	printf("Test 8: Cross-thread alloc/free...\n");
+	for(i=0; i<TEST_EIGHT_THREADS; i++)
+	{
+		for(j=0; j<TEST_EIGHT_OBJECTS; j++)
+		{
+			objs[i][j] = osi_pool_alloc((size_t)j);
+		}
+		if(osi_thread_create(&t[i], &attr, test_eight_thread, objs[i]) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	for(i=0; i<TEST_EIGHT_THREADS; i++)
+	{
+		osi_thread_join(t[i], NULL);
+		osi_thread_release(&t[i]);
+		for(j=0; j<TEST_EIGHT_OBJECTS; j++)
+		{
+			osi_free(&objs[i][j]);
+		}
+	}
+	printf("Test 8: Done\n");
+}
+
+#define TEST_NINE_WORKERS (4)
+#define TEST_NINE_TASKS (100000)
+#define TEST_NINE_SERIALS (8)
+#define TEST_NINE_SERIAL_TASKS (10000)
+
+typedef struct test_nine_serial
+{
+	osi_executor_serial_t *serial;
+	uint32_t next;
+	volatile uint32_t busy;
+	bool broken;
+} test_nine_serial_t;
+
+typedef struct test_nine_item
+{
+	test_nine_serial_t *ctx;
+	uint32_t seq;
+} test_nine_item_t;
+
+static volatile uint32_t test_nine_count = 0;
+static volatile uint32_t test_nine_dropped = 0;
+static volatile bool test_nine_started = false;
+static osi_executor_t *test_nine_exec = NULL;
+
+static void test_nine_task(void* arg)
+{
+	EOS_UNUSED(arg);
+	__sync_add_and_fetch(&test_nine_count, 1);
+}
+
+static void test_nine_order(void* arg)
+{
+	test_nine_item_t *item = (test_nine_item_t*) arg;
+	test_nine_serial_t *ctx = item->ctx;
+
+	/* Serial tasks never overlap and keep submission order */
+	if(__sync_add_and_fetch(&ctx->busy, 1) != 1 || item->seq != ctx->next)
+	{
+		ctx->broken = true;
+	}
+	ctx->next++;
+	__sync_sub_and_fetch(&ctx->busy, 1);
+	osi_free((void**)&item);
+}
+
+static void test_nine_drop(void* arg)
+{
+	__sync_add_and_fetch(&test_nine_dropped, 1);
+	osi_free(&arg);
+}
+
+static void test_nine_slow(void* arg)
+{
+	osi_executor_serial_t *serial = (osi_executor_serial_t*) arg;
+
+	/* Sync from the queue's own task must not wait for itself */
+	osi_executor_serial_sync(serial);
+	test_nine_started = true;
+	osi_time_usleep(50000);
+	__sync_add_and_fetch(&test_nine_dropped, 1);
+}
+
+static void test_nine_nested(void* arg)
+{
+	osi_executor_task_t *task[TEST_NINE_WORKERS * 2];
+	int fail = 9, i;
+
+	EOS_UNUSED(arg);
+	/* Joining from a worker must not starve the pool */
+	for(i=0; i<TEST_NINE_WORKERS * 2; i++)
+	{
+		if(osi_executor_run(test_nine_exec, test_nine_task, NULL,
+				OSI_EXECUTOR_ANY, &task[i]) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	for(i=0; i<TEST_NINE_WORKERS * 2; i++)
+	{
+		osi_executor_join(&task[i]);
+	}
+}
+
+void test_nine(void)
+{
+	test_nine_serial_t ctx[TEST_NINE_SERIALS];
+	osi_executor_task_t *task[TEST_NINE_WORKERS];
+	osi_executor_serial_t *serial = NULL;
+	test_nine_item_t *item = NULL;
+	osi_time_t one, two, diff;
+	int fail = 9, i, j;
+
+	printf("Test 9: Executor\n");
+	if(osi_executor_create(&test_nine_exec, 0) != EOS_ERROR_INVAL)
+	{
+		err_exit(fail, __LINE__);
+	}
+	if(osi_executor_create(&test_nine_exec, TEST_NINE_WORKERS) != EOS_ERROR_OK ||
+			osi_executor_get_workers(test_nine_exec) != TEST_NINE_WORKERS)
+	{
+		err_exit(fail, __LINE__);
+	}
+	printf("Test 9: %d tasks...\n", TEST_NINE_TASKS);
+	osi_time_get_timestamp(&one);
+	for(i=0; i<TEST_NINE_TASKS; i++)
+	{
+		/* Everything hinted to one worker, the others have to steal */
+		if(osi_executor_run(test_nine_exec, test_nine_task, NULL, 0, NULL)
+				!= EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	for(i=0; i<TEST_NINE_WORKERS; i++)
+	{
+		if(osi_executor_run(test_nine_exec, test_nine_nested, NULL, i, &task[i])
+				!= EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	for(i=0; i<TEST_NINE_WORKERS; i++)
+	{
+		osi_executor_join(&task[i]);
+		if(task[i] != NULL)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	printf("Test 9: Serial queues...\n");
+	for(i=0; i<TEST_NINE_SERIALS; i++)
+	{
+		osi_memset(&ctx[i], 0, sizeof(test_nine_serial_t));
+		if(osi_executor_serial_create(&ctx[i].serial, test_nine_exec,
+				test_nine_drop, OSI_EXECUTOR_ANY) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	for(j=0; j<TEST_NINE_SERIAL_TASKS; j++)
+	{
+		for(i=0; i<TEST_NINE_SERIALS; i++)
+		{
+			item = osi_calloc(sizeof(test_nine_item_t));
+			item->ctx = &ctx[i];
+			item->seq = j;
+			if(osi_executor_serial_run(ctx[i].serial, test_nine_order, item)
+					!= EOS_ERROR_OK)
+			{
+				err_exit(fail, __LINE__);
+			}
+		}
+	}
+	for(i=0; i<TEST_NINE_SERIALS; i++)
+	{
+		/* Waits for the running task, drops (and counts) the rest */
+		j = test_nine_dropped;
+		osi_executor_serial_destroy(&ctx[i].serial);
+		if(ctx[i].broken || ctx[i].serial != NULL ||
+				ctx[i].next + (test_nine_dropped - j) != TEST_NINE_SERIAL_TASKS)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	printf("Test 9: Serial flush...\n");
+	if(osi_executor_serial_create(&serial, test_nine_exec, test_nine_drop,
+			1) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_executor_serial_flush(serial);
+	osi_executor_serial_run(serial, test_nine_drop, osi_calloc(1));
+	printf("Test 9: Serial sync...\n");
+	osi_executor_serial_sync(serial);
+	osi_executor_serial_run(serial, test_nine_slow, serial);
+	while(!test_nine_started)
+	{
+		osi_time_usleep(1000);
+	}
+	/* Tasks before it are done, slow one is running: sync has to outwait it */
+	j = test_nine_dropped;
+	osi_executor_serial_sync(serial);
+	if(test_nine_dropped != (uint32_t)j + 1)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_executor_serial_destroy(&serial);
+	osi_executor_destroy(&test_nine_exec);
+	if(test_nine_exec != NULL || test_nine_count !=
+			TEST_NINE_TASKS + TEST_NINE_WORKERS * TEST_NINE_WORKERS * 2)
+	{
+		err_exit(fail, __LINE__);
+	}
+	if(osi_executor_shared() == NULL ||
+			osi_executor_shared() != osi_executor_shared())
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_time_get_timestamp(&two);
+	osi_time_diff(&one, &two, &diff);
+	printf("Test 9: Done...%u[s] %u[ms]\n", diff.sec, diff.nsec / 1000000);
+}
+
 int main(int argc, char** argv)
 {
 	/* kill warning */
@@ -430,6 +847,9 @@ int main(int argc, char** argv)
 	test_four();
 	test_five();
 	test_six();
+	test_seven();
+	test_eight();
+	test_nine();
 
 	return 0;
 }
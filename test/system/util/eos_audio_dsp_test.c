@@ -0,0 +1,377 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "util_audio_dsp.h"
+#include "eos_macro.h"
+
+#define MODULE_NAME "test:audio_dsp"
+#include "util_log.h"
+
+/* Not a multiple of any vector width, so the C tails get exercised too */
+#define TEST_N (1003)
+#define TEST_CH (6)
+#define TEST_EPS (1e-6f)
+
+static const char* test_isa_name[UTIL_AUDIO_DSP_ISA_CNT] =
+{
+	"C", "SSE2", "AVX2", "NEON"
+};
+
+static float test_in[TEST_CH][TEST_N];
+static int16_t test_s16[TEST_N * 2];
+/* C results every other kernel set has to match bit for bit */
+static int16_t test_ref_s16[TEST_N * 2];
+static int16_t test_ref_dith[TEST_N * 2];
+
+static uint32_t test_rand(uint32_t* s)
+{
+	*s = *s * 1664525U + 1013904223U;
+
+	return *s >> 8;
+}
+
+static void test_fill(void)
+{
+	uint32_t s = 1, i = 0, c = 0;
+
+	for(c = 0; c < TEST_CH; c++)
+	{
+		for(i = 0; i < TEST_N; i++)
+		{
+			/* [-1.25, 1.25): some samples clip when converted */
+			test_in[c][i] = ((float)test_rand(&s) / (float)(1 << 24)) * 2.5f
+					- 1.25f;
+		}
+	}
+	for(i = 0; i < TEST_N * 2; i++)
+	{
+		test_s16[i] = (int16_t)(test_rand(&s) & 0xFFFF);
+	}
+	test_s16[0] = -32768;
+	test_s16[1] = 32767;
+}
+
+static bool test_near(float a, float b, float eps)
+{
+	float d = a - b;
+
+	return (d < 0.0f ? -d : d) <= eps;
+}
+
+static bool test_interleave(void)
+{
+	static float il[TEST_N * TEST_CH];
+	static float out[TEST_CH][TEST_N];
+	const float* src[TEST_CH];
+	float* dst[TEST_CH];
+	uint32_t i = 0, c = 0, ch = 0;
+
+	for(c = 0; c < TEST_CH; c++)
+	{
+		src[c] = test_in[c];
+		dst[c] = out[c];
+	}
+	/* Stereo has kernels, the rest goes through the generic loop */
+	for(ch = 1; ch <= TEST_CH; ch++)
+	{
+		memset(il, 0, sizeof(il));
+		memset(out, 0, sizeof(out));
+		if(util_audio_dsp_interleave(il, src, ch, TEST_N) != EOS_ERROR_OK ||
+				util_audio_dsp_deinterleave(dst, il, ch, TEST_N) != EOS_ERROR_OK)
+		{
+			return false;
+		}
+		for(i = 0; i < TEST_N; i++)
+		{
+			for(c = 0; c < ch; c++)
+			{
+				if(il[i * ch + c] != test_in[c][i] || out[c][i] != test_in[c][i])
+				{
+					UTIL_GLOGE("%u channels: sample %u/%u", ch, i, c);
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool test_conv(util_audio_dsp_isa_t isa)
+{
+	static float f[TEST_N * 2];
+	static int16_t s[TEST_N * 2];
+	uint32_t i = 0;
+
+	/* S16 -> float -> S16 is lossless */
+	if(util_audio_dsp_s16_to_f32(f, test_s16, TEST_N * 2) != EOS_ERROR_OK ||
+			util_audio_dsp_f32_to_s16(s, f, TEST_N * 2, NULL) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N * 2; i++)
+	{
+		if(f[i] != (float)test_s16[i] / 32768.0f || s[i] != test_s16[i])
+		{
+			UTIL_GLOGE("S16 round trip: sample %u", i);
+			return false;
+		}
+	}
+	/* Rounding and saturation */
+	if(util_audio_dsp_f32_to_s16(s, test_in[0], TEST_N, NULL) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N; i++)
+	{
+		float v = test_in[0][i] * 32768.0f;
+
+		if((v >= 32767.0f && s[i] != 32767) ||
+				(v <= -32768.0f && s[i] != -32768) ||
+				(v > -32768.0f && v < 32767.0f &&
+						!test_near((float)s[i], v, 0.5f)))
+		{
+			UTIL_GLOGE("Float %f -> %d", v, s[i]);
+			return false;
+		}
+	}
+	if(isa == UTIL_AUDIO_DSP_ISA_C)
+	{
+		memcpy(test_ref_s16, s, TEST_N * sizeof(int16_t));
+	}
+	else if(memcmp(test_ref_s16, s, TEST_N * sizeof(int16_t)) != 0)
+	{
+		UTIL_GLOGE("Conversion differs from C");
+		return false;
+	}
+
+	return true;
+}
+
+static bool test_dither(util_audio_dsp_isa_t isa)
+{
+	static float f[TEST_N * 2];
+	static int16_t s[TEST_N * 2];
+	util_audio_dsp_dither_t dither;
+	int32_t err = 0, sum = 0, moved = 0;
+	uint32_t i = 0;
+
+	/* Exactly representable input, any change is the dither */
+	for(i = 0; i < TEST_N * 2; i++)
+	{
+		f[i] = (float)(test_s16[i] / 2) / 32768.0f;
+	}
+	util_audio_dsp_dither_init(&dither, 1234);
+	/* Two calls: generator state has to carry over */
+	if(util_audio_dsp_f32_to_s16(s, f, TEST_N, &dither) != EOS_ERROR_OK ||
+			util_audio_dsp_f32_to_s16(s + TEST_N, f + TEST_N, TEST_N, &dither)
+					!= EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N * 2; i++)
+	{
+		err = s[i] - test_s16[i] / 2;
+		/* Triangular, one LSB peak: rounds to one step either way at most */
+		if(err < -1 || err > 1)
+		{
+			UTIL_GLOGE("Dither error %d at %u", err, i);
+			return false;
+		}
+		sum += err;
+		moved += err != 0;
+	}
+	if(moved < TEST_N / 4 || sum > TEST_N / 10 || sum < -TEST_N / 10)
+	{
+		UTIL_GLOGE("Dither: %d moved, %d bias", moved, sum);
+		return false;
+	}
+	if(isa == UTIL_AUDIO_DSP_ISA_C)
+	{
+		memcpy(test_ref_dith, s, sizeof(test_ref_dith));
+	}
+	else if(memcmp(test_ref_dith, s, sizeof(test_ref_dith)) != 0)
+	{
+		UTIL_GLOGE("Dither differs from C");
+		return false;
+	}
+
+	return true;
+}
+
+static bool test_downmix(void)
+{
+	/* 5.1 (FL FR FC LFE BL BR) to stereo */
+	const float coef[2 * TEST_CH] =
+	{
+		0.4142f, 0.0f, 0.2929f, 0.0f, 0.2929f, 0.0f,
+		0.0f, 0.4142f, 0.2929f, 0.0f, 0.0f, 0.2929f
+	};
+	static float l[TEST_N], r[TEST_N];
+	float* dst[2] = {l, r};
+	const float* src[TEST_CH];
+	float exp_l = 0.0f, exp_r = 0.0f;
+	uint32_t i = 0, c = 0;
+
+	for(c = 0; c < TEST_CH; c++)
+	{
+		src[c] = test_in[c];
+	}
+	if(util_audio_dsp_downmix(dst, src, TEST_CH, coef, TEST_N) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N; i++)
+	{
+		exp_l = 0.0f;
+		exp_r = 0.0f;
+		for(c = 0; c < TEST_CH; c++)
+		{
+			exp_l += coef[c] * test_in[c][i];
+			exp_r += coef[TEST_CH + c] * test_in[c][i];
+		}
+		if(!test_near(l[i], exp_l, TEST_EPS) || !test_near(r[i], exp_r, TEST_EPS))
+		{
+			UTIL_GLOGE("Downmix: sample %u", i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool test_gain(void)
+{
+	static float out[TEST_N];
+	float g = 0.0f;
+	uint32_t i = 0;
+
+	/* Ramp 1 -> 0.25, last sample at the target */
+	if(util_audio_dsp_gain(out, test_in[1], TEST_N, 1.0f, 0.25f)
+			!= EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N; i++)
+	{
+		g = 1.0f - 0.75f * (float)(i + 1) / (float)TEST_N;
+		if(!test_near(out[i], test_in[1][i] * g, TEST_EPS))
+		{
+			UTIL_GLOGE("Gain ramp: sample %u", i);
+			return false;
+		}
+	}
+	/* Flat gain, in place */
+	memcpy(out, test_in[2], sizeof(out));
+	if(util_audio_dsp_gain(out, out, TEST_N, 0.5f, 0.5f) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for(i = 0; i < TEST_N; i++)
+	{
+		if(out[i] != test_in[2][i] * 0.5f)
+		{
+			UTIL_GLOGE("Flat gain: sample %u", i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool test_meter(void)
+{
+	util_audio_dsp_meter_t meter;
+	double sum = 0.0;
+	float peak = 0.0f, a = 0.0f, ms = 0.0f;
+	uint32_t i = 0, c = 0;
+
+	util_audio_dsp_meter_rst(&meter);
+	for(c = 0; c < 2; c++)
+	{
+		util_audio_dsp_meter(&meter, test_in[c], TEST_N);
+		for(i = 0; i < TEST_N; i++)
+		{
+			a = test_in[c][i] < 0.0f ? -test_in[c][i] : test_in[c][i];
+			peak = a > peak ? a : peak;
+			sum += (double)test_in[c][i] * test_in[c][i];
+		}
+	}
+	ms = util_audio_dsp_meter_ms(&meter);
+	if(meter.peak != peak || meter.cnt != 2 * TEST_N ||
+			!test_near(ms, (float)(sum / (2 * TEST_N)), 1e-5f))
+	{
+		UTIL_GLOGE("Meter: peak %f/%f, ms %f/%f", meter.peak, peak, ms,
+				sum / (2 * TEST_N));
+		return false;
+	}
+	util_audio_dsp_meter_rst(&meter);
+
+	return util_audio_dsp_meter_ms(&meter) == 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+	util_audio_dsp_isa_t isa = UTIL_AUDIO_DSP_ISA_C;
+	util_audio_dsp_isa_t best = util_audio_dsp_isa_get();
+
+	EOS_UNUSED(argc);
+	EOS_UNUSED(argv);
+
+	test_fill();
+	/* C first, it is the reference for the others */
+	for(isa = UTIL_AUDIO_DSP_ISA_C; isa < UTIL_AUDIO_DSP_ISA_CNT; isa++)
+	{
+		if(util_audio_dsp_isa_set(isa) != EOS_ERROR_OK)
+		{
+			printf("%s: not supported\n", test_isa_name[isa]);
+			continue;
+		}
+		if(!test_interleave() || !test_conv(isa) || !test_dither(isa) ||
+				!test_downmix() || !test_gain() || !test_meter())
+		{
+			printf("%s [FAILED]\n", test_isa_name[isa]);
+			return -1;
+		}
+		printf("%s [OK]\n", test_isa_name[isa]);
+	}
+	util_audio_dsp_isa_set(best);
+	printf("Audio DSP test (%s in use) [OK]\n", test_isa_name[best]);
+
+	return 0;
+}
@@ -0,0 +1,343 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+#include "util_bcast_buff.h"
+#include "osi_memory.h"
+#include "osi_thread.h"
+#include "osi_time.h"
+
+#define MODULE_NAME "bbuff test"
+#include "util_log.h"
+
+#include <stdlib.h>
+
+#ifndef __LINE__
+#define __LINE__ (-1)
+#endif
+
+#define TEST_SEGMENT_SIZE (188 * 7)
+#define TEST_SEGMENT_CNT  (16)
+#define TEST_LOOPS        (2000)
+
+void err_exit(int err, int line)
+{
+	UTIL_GLOGE("err: %d [line: %d]", err, line);
+	exit(err);
+}
+
+typedef struct test_reader_arg
+{
+	util_bcast_buff_reader_t *reader;
+	uint32_t sleep_usec;
+	uint32_t received;
+	uint32_t failed;
+} test_reader_arg_t;
+
+typedef struct test_writer_arg
+{
+	util_bcast_buff_t *bbuff;
+	uint32_t loops;
+} test_writer_arg_t;
+
+static void* test_writer(void* arg)
+{
+	test_writer_arg_t *tc_arg = (test_writer_arg_t*)arg;
+	uint8_t *data = NULL;
+	uint32_t size = 0, i = 0, j = 0;
+
+	for (i = 0; i < tc_arg->loops; i++)
+	{
+		if (util_bcast_buff_allocate(tc_arg->bbuff, UTIL_BCAST_BUFF_FOREVER, &data, &size) != EOS_ERROR_OK)
+		{
+			UTIL_GLOGE("ERROR allocating segment %u", i);
+			return NULL;
+		}
+		/* first word is the sequence number, rest is the pattern derived from it */
+		*(uint32_t*)data = i;
+		for (j = sizeof(uint32_t); j < size; j++)
+		{
+			data[j] = (uint8_t)(i + j);
+		}
+		if (util_bcast_buff_commit(tc_arg->bbuff, data, size) != EOS_ERROR_OK)
+		{
+			UTIL_GLOGE("ERROR committing segment %u", i);
+			return NULL;
+		}
+	}
+	util_bcast_buff_stop(tc_arg->bbuff);
+
+	return NULL;
+}
+
+static void* test_reader(void* arg)
+{
+	test_reader_arg_t *tc_arg = (test_reader_arg_t*)arg;
+	uint8_t *data = NULL;
+	uint32_t size = 0, j = 0, seq = 0, last = 0;
+	bool first = true;
+	eos_error_t err = EOS_ERROR_OK;
+
+	while ((err = util_bcast_buff_read(tc_arg->reader, UTIL_BCAST_BUFF_FOREVER, &data, &size)) == EOS_ERROR_OK)
+	{
+		seq = *(uint32_t*)data;
+		if (!first && seq <= last)
+		{
+			tc_arg->failed++;
+		}
+		for (j = sizeof(uint32_t); j < size; j++)
+		{
+			if (data[j] != (uint8_t)(seq + j))
+			{
+				tc_arg->failed++;
+				break;
+			}
+		}
+		first = false;
+		last = seq;
+		tc_arg->received++;
+		if (tc_arg->sleep_usec)
+		{
+			osi_time_usleep(tc_arg->sleep_usec);
+		}
+		if (util_bcast_buff_release(tc_arg->reader, data) != EOS_ERROR_OK)
+		{
+			tc_arg->failed++;
+		}
+	}
+	if (err != EOS_ERROR_EOF)
+	{
+		tc_arg->failed++;
+	}
+
+	return NULL;
+}
+
+static void test_run(util_bcast_buff_t* bbuff, test_reader_arg_t* readers, uint32_t count)
+{
+	osi_thread_t *writer = NULL;
+	osi_thread_t *threads[4];
+	osi_thread_attr_t attr = {OSI_THREAD_JOINABLE};
+	test_writer_arg_t writer_arg = {bbuff, TEST_LOOPS};
+	uint32_t i = 0;
+	int fail = 10;
+
+	for (i = 0; i < count; i++)
+	{
+		if (osi_thread_create(&threads[i], &attr, test_reader, &readers[i]) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	if (osi_thread_create(&writer, &attr, test_writer, &writer_arg) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_thread_join(writer, NULL);
+	osi_thread_release(&writer);
+	for (i = 0; i < count; i++)
+	{
+		osi_thread_join(threads[i], NULL);
+		osi_thread_release(&threads[i]);
+	}
+}
+
+static void test_one(void)
+{
+	util_bcast_buff_t *bbuff = NULL;
+	uint8_t *mem = osi_malloc(TEST_SEGMENT_SIZE * TEST_SEGMENT_CNT);
+	test_reader_arg_t readers[3];
+	uint32_t i = 0;
+	int fail = 1;
+
+	UTIL_GLOGI("Test 1: Three blocking readers (%d segments)", TEST_LOOPS);
+	if (util_bcast_buff_create(&bbuff, mem, TEST_SEGMENT_SIZE * TEST_SEGMENT_CNT,
+			TEST_SEGMENT_SIZE) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_memset(readers, 0, sizeof(readers));
+	for (i = 0; i < 3; i++)
+	{
+		readers[i].sleep_usec = i * 100;
+		if (util_bcast_buff_attach(bbuff, UTIL_BCAST_BUFF_POLICY_BLOCK, &readers[i].reader) != EOS_ERROR_OK)
+		{
+			err_exit(fail, __LINE__);
+		}
+	}
+	test_run(bbuff, readers, 3);
+	for (i = 0; i < 3; i++)
+	{
+		if (readers[i].received != TEST_LOOPS || readers[i].failed != 0)
+		{
+			UTIL_GLOGE("Test 1: reader %u received %u failed %u", i, readers[i].received, readers[i].failed);
+			err_exit(fail, __LINE__);
+		}
+	}
+	if (util_bcast_buff_destroy(&bbuff) != EOS_ERROR_PERM)
+	{
+		UTIL_GLOGE("Test 1: destroy should fail with attached readers");
+		err_exit(fail, __LINE__);
+	}
+	for (i = 0; i < 3; i++)
+	{
+		util_bcast_buff_detach(bbuff, &readers[i].reader);
+	}
+	if (util_bcast_buff_destroy(&bbuff) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_free((void**)&mem);
+
+	UTIL_GLOGI("Test 1: Done...");
+}
+
+static void test_two(void)
+{
+	util_bcast_buff_t *bbuff = NULL;
+	uint8_t *mem = osi_malloc(TEST_SEGMENT_SIZE * TEST_SEGMENT_CNT);
+	test_reader_arg_t readers[2];
+	uint32_t dropped = 0;
+	int fail = 2;
+
+	UTIL_GLOGI("Test 2: Blocking reader with slow dropping reader");
+	if (util_bcast_buff_create(&bbuff, mem, TEST_SEGMENT_SIZE * TEST_SEGMENT_CNT,
+			TEST_SEGMENT_SIZE) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	osi_memset(readers, 0, sizeof(readers));
+	readers[1].sleep_usec = 2000;
+	if (util_bcast_buff_attach(bbuff, UTIL_BCAST_BUFF_POLICY_BLOCK, &readers[0].reader) != EOS_ERROR_OK ||
+	    util_bcast_buff_attach(bbuff, UTIL_BCAST_BUFF_POLICY_DROP, &readers[1].reader) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	test_run(bbuff, readers, 2);
+	util_bcast_buff_get_dropped(readers[1].reader, &dropped);
+	UTIL_GLOGI("Test 2: slow reader received %u dropped %u", readers[1].received, dropped);
+	if (readers[0].received != TEST_LOOPS || readers[0].failed != 0 || readers[1].failed != 0)
+	{
+		err_exit(fail, __LINE__);
+	}
+	if (dropped == 0 || readers[1].received + dropped != TEST_LOOPS)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_detach(bbuff, &readers[0].reader);
+	util_bcast_buff_detach(bbuff, &readers[1].reader);
+	util_bcast_buff_destroy(&bbuff);
+	osi_free((void**)&mem);
+
+	UTIL_GLOGI("Test 2: Done...");
+}
+
+static void test_three(void)
+{
+	util_bcast_buff_t *bbuff = NULL;
+	util_bcast_buff_reader_t *reader = NULL;
+	uint8_t *mem = osi_malloc(TEST_SEGMENT_SIZE * 2);
+	uint8_t *data = NULL, *held = NULL;
+	uint32_t size = 0;
+	int fail = 3;
+
+	UTIL_GLOGI("Test 3: Blocking reader holds the writer");
+	if (util_bcast_buff_create(&bbuff, mem, TEST_SEGMENT_SIZE * 2, TEST_SEGMENT_SIZE) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	/* no readers, data is discarded */
+	util_bcast_buff_allocate(bbuff, 0, &data, &size);
+	util_bcast_buff_commit(bbuff, data, size);
+	util_bcast_buff_attach(bbuff, UTIL_BCAST_BUFF_POLICY_BLOCK, &reader);
+	if (util_bcast_buff_read(reader, 100, &data, &size) != EOS_ERROR_TIMEDOUT)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_allocate(bbuff, 0, &data, &size);
+	util_bcast_buff_commit(bbuff, data, 10);
+	util_bcast_buff_allocate(bbuff, 0, &data, &size);
+	util_bcast_buff_commit(bbuff, data, 20);
+	if (util_bcast_buff_allocate(bbuff, 100, &data, &size) != EOS_ERROR_TIMEDOUT)
+	{
+		UTIL_GLOGE("Test 3: writer should wait for the reader");
+		err_exit(fail, __LINE__);
+	}
+	if (util_bcast_buff_read(reader, 0, &held, &size) != EOS_ERROR_OK || size != 10)
+	{
+		err_exit(fail, __LINE__);
+	}
+	if (util_bcast_buff_release(reader, mem) != EOS_ERROR_INVAL)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_release(reader, held);
+	if (util_bcast_buff_allocate(bbuff, 100, &data, &size) != EOS_ERROR_OK)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_commit(bbuff, data, 30);
+	util_bcast_buff_stop(bbuff);
+	if (util_bcast_buff_read(reader, 0, &data, &size) != EOS_ERROR_OK || size != 20)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_release(reader, data);
+	if (util_bcast_buff_read(reader, 0, &data, &size) != EOS_ERROR_OK || size != 30)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_release(reader, data);
+	if (util_bcast_buff_read(reader, UTIL_BCAST_BUFF_FOREVER, &data, &size) != EOS_ERROR_EOF)
+	{
+		err_exit(fail, __LINE__);
+	}
+	util_bcast_buff_detach(bbuff, &reader);
+	util_bcast_buff_destroy(&bbuff);
+	osi_free((void**)&mem);
+
+	UTIL_GLOGI("Test 3: Done...");
+}
+
+int main(int argc, char** argv)
+{
+	/* kill warning */
+	if(argc == 0 && argv == NULL)
+	{
+
+	}
+	test_one();
+	test_two();
+	test_three();
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "util_clk.h"
+#include "eos_macro.h"
+
+#define MODULE_NAME "test:clk"
+#include "util_log.h"
+
+/* 25 fps */
+#define TEST_DUR (3600)
+#define TEST_MAX_WAIT (UTIL_CLK_HZ)
+
+static osi_time_t test_time(int64_t usec)
+{
+	osi_time_t t;
+
+	t.sec = (uint32_t)(usec / OSI_TIME_MICROS);
+	t.nsec = (uint32_t)OSI_TIME_USEC_TO_NSEC(usec % OSI_TIME_MICROS);
+
+	return t;
+}
+
+static int64_t test_usec(osi_time_t* t)
+{
+	return OSI_TIME_SEC_TO_USEC((int64_t)t->sec) +
+			OSI_TIME_NSEC_TO_USEC((int64_t)t->nsec);
+}
+
+static bool test_sched(util_clk_t* clk, int64_t pts, int64_t now_us,
+		util_clk_act_t exp_act, int64_t exp_wait)
+{
+	osi_time_t now = test_time(now_us), deadline;
+	util_clk_act_t act = UTIL_CLK_ACT_SHOW;
+
+	if(util_clk_sched(clk, pts, TEST_DUR, TEST_MAX_WAIT, &now, &deadline, &act)
+			!= EOS_ERROR_OK)
+	{
+		return false;
+	}
+	if(act != exp_act)
+	{
+		UTIL_GLOGE("PTS %lld: action %d (expected %d)", (long long)pts, act,
+				exp_act);
+		return false;
+	}
+	if(act == UTIL_CLK_ACT_SHOW && test_usec(&deadline) - now_us != exp_wait)
+	{
+		UTIL_GLOGE("PTS %lld: wait %lld (expected %lld)", (long long)pts,
+				(long long)(test_usec(&deadline) - now_us), (long long)exp_wait);
+		return false;
+	}
+
+	return true;
+}
+
+/* Video master: first frame anchors, late frames are dropped, early ones wait */
+static bool test_vid(void)
+{
+	util_clk_t *clk = NULL;
+	uint32_t dropped = 0, repeated = 0;
+	bool ok = true;
+
+	if(util_clk_create(&clk) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	ok = ok && test_sched(clk, 90000, 1000000, UTIL_CLK_ACT_SHOW, 0);
+	/* On time */
+	ok = ok && test_sched(clk, 93600, 1030000, UTIL_CLK_ACT_SHOW, 10000);
+	/* 100ms late (more than a frame) */
+	ok = ok && test_sched(clk, 97200, 1180000, UTIL_CLK_ACT_DROP, 0);
+	/* 20ms late, shown right away */
+	ok = ok && test_sched(clk, 100800, 1140000, UTIL_CLK_ACT_SHOW, 0);
+	/* 120ms early, previous frame held for 2 extra periods */
+	ok = ok && test_sched(clk, 111600, 1120000, UTIL_CLK_ACT_SHOW, 120000);
+	util_clk_stats(clk, &dropped, &repeated);
+	ok = ok && dropped == 1 && repeated == 2;
+	/* Jump ahead, continues at frame rate */
+	ok = ok && test_sched(clk, 900000, 1300000, UTIL_CLK_ACT_SHOW, 40000);
+	ok = ok && test_sched(clk, 903600, 1340000, UTIL_CLK_ACT_SHOW, 40000);
+	util_clk_destroy(&clk);
+
+	return ok;
+}
+
+/* Audio master: video follows audio, falls back to video before audio starts */
+static bool test_aud(void)
+{
+	util_clk_t *clk = NULL;
+	osi_time_t at;
+	int64_t pts = 0;
+	uint32_t dropped = 0, repeated = 0;
+	bool ok = true;
+
+	if(util_clk_create(&clk) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	util_clk_set_master(clk, UTIL_CLK_SRC_AUD);
+	ok = ok && test_sched(clk, 90000, 1000000, UTIL_CLK_ACT_SHOW, 0);
+	at = test_time(1040000);
+	util_clk_update(clk, UTIL_CLK_SRC_AUD, 180000, &at);
+	at = test_time(1050000);
+	ok = ok && util_clk_get(clk, UTIL_CLK_SRC_AUD, &at, &pts) == EOS_ERROR_OK &&
+			pts == 180900;
+	/* Audio is 1s ahead, drops are limited so the picture keeps moving */
+	for(int i=0; i<8; i++)
+	{
+		ok = ok && test_sched(clk, 93600 + i * TEST_DUR, 1050000,
+				UTIL_CLK_ACT_DROP, 0);
+	}
+	ok = ok && test_sched(clk, 93600 + 8 * TEST_DUR, 1050000,
+			UTIL_CLK_ACT_SHOW, 0);
+	/* In sync again */
+	ok = ok && test_sched(clk, 184500, 1050000, UTIL_CLK_ACT_SHOW, 40000);
+	util_clk_stats(clk, &dropped, &repeated);
+	ok = ok && dropped == 8 && repeated == 0;
+	util_clk_stats_rst(clk);
+	util_clk_stats(clk, &dropped, &repeated);
+	ok = ok && dropped == 0;
+	/* Without reference, video is master again */
+	util_clk_reset(clk);
+	ok = ok && util_clk_get(clk, UTIL_CLK_SRC_AUD, &at, &pts) ==
+			EOS_ERROR_NFOUND;
+	ok = ok && test_sched(clk, 500000, 2000000, UTIL_CLK_ACT_SHOW, 0);
+	util_clk_destroy(&clk);
+
+	return ok;
+}
+
+/* External master: offset fixed at first frame, reference jitter smoothed */
+static bool test_ext(void)
+{
+	util_clk_t *clk = NULL;
+	osi_time_t at;
+	int64_t pts = 0;
+	bool ok = true;
+
+	if(util_clk_create(&clk) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	util_clk_set_master(clk, UTIL_CLK_SRC_EXT);
+	at = test_time(1000000);
+	util_clk_update(clk, UTIL_CLK_SRC_EXT, 1000000, &at);
+	/* 16ms (1440 ticks) jitter moves reference by 1/16 */
+	at = test_time(1100000);
+	util_clk_update(clk, UTIL_CLK_SRC_EXT, 1009000 + 1440, &at);
+	ok = ok && util_clk_get(clk, UTIL_CLK_SRC_EXT, &at, &pts) == EOS_ERROR_OK &&
+			pts == 1009090;
+	/* 500ms of buffering between reference and presentation */
+	ok = ok && test_sched(clk, 1054090, 1100000, UTIL_CLK_ACT_SHOW, 0);
+	ok = ok && test_sched(clk, 1057690, 1120000, UTIL_CLK_ACT_SHOW, 20000);
+	/* Reference jump is taken as is */
+	at = test_time(1120000);
+	util_clk_update(clk, UTIL_CLK_SRC_EXT, 5000000, &at);
+	ok = ok && util_clk_get(clk, UTIL_CLK_SRC_EXT, &at, &pts) == EOS_ERROR_OK &&
+			pts == 5000000;
+	util_clk_destroy(&clk);
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	EOS_UNUSED(argc);
+	EOS_UNUSED(argv);
+
+	if (!test_vid())
+	{
+		printf("Video master [FAILED]\n");
+		return -1;
+	}
+	if (!test_aud())
+	{
+		printf("Audio master [FAILED]\n");
+		return -1;
+	}
+	if (!test_ext())
+	{
+		printf("External master [FAILED]\n");
+		return -1;
+	}
+	printf("Clock test [OK]\n");
+
+	return 0;
+}
@@ -0,0 +1,327 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "osi_memory.h"
+#include "util_esparser.h"
+#include "eos_macro.h"
+
+#define MODULE_NAME "test:esparser"
+#include "util_log.h"
+
+#define TEST_BUFF_SZ (256)
+
+typedef struct test_bits
+{
+	uint8_t data[TEST_BUFF_SZ];
+	uint32_t pos;
+} test_bits_t;
+
+static void test_put(test_bits_t* bits, uint32_t val, uint8_t cnt)
+{
+	while(cnt--)
+	{
+		if((val >> cnt) & 1)
+		{
+			bits->data[bits->pos >> 3] |= 0x80 >> (bits->pos & 7);
+		}
+		bits->pos++;
+	}
+}
+
+static void test_put_ue(test_bits_t* bits, uint32_t val)
+{
+	uint8_t len = 0;
+
+	while(((val + 1) >> len) > 1)
+	{
+		len++;
+	}
+	test_put(bits, 0, len);
+	test_put(bits, val + 1, len + 1);
+}
+
+/* Start code, NAL header and RBSP with emulation prevention bytes */
+static uint32_t test_nal(test_bits_t* rbsp, const uint8_t* hdr, uint8_t hdr_len,
+		uint8_t* out)
+{
+	uint32_t len = 0, i = 0, zeros = 0;
+
+	/* rbsp_trailing_bits */
+	test_put(rbsp, 1, 1);
+	out[len++] = 0;
+	out[len++] = 0;
+	out[len++] = 1;
+	for(i = 0; i < hdr_len; i++)
+	{
+		out[len++] = hdr[i];
+	}
+	for(i = 0; i < (rbsp->pos + 7) / 8; i++)
+	{
+		if(zeros == 2 && rbsp->data[i] <= 3)
+		{
+			out[len++] = 3;
+			zeros = 0;
+		}
+		zeros = rbsp->data[i] == 0 ? zeros + 1 : 0;
+		out[len++] = rbsp->data[i];
+	}
+
+	return len;
+}
+
+static bool test_check(const char* name, eos_media_codec_t codec,
+		const uint8_t* data, uint32_t len, uint32_t a, uint32_t b, uint32_t c)
+{
+	eos_media_es_attr_t atr;
+	eos_error_t err = EOS_ERROR_OK;
+	bool ok = false;
+
+	osi_memset(&atr, 0, sizeof(atr));
+	err = util_esparser_parse(codec, data, len, &atr);
+	if(EOS_MEDIA_IS_VID(codec))
+	{
+		ok = err == EOS_ERROR_OK && atr.video.resolution.width == a &&
+				atr.video.resolution.height == b && atr.video.fps == c &&
+				(c != 0) == (atr.video.rate.den != 0);
+		printf("%s: %d %ux%u@%u\n", name, err, atr.video.resolution.width,
+				atr.video.resolution.height, atr.video.fps);
+	}
+	else
+	{
+		ok = err == EOS_ERROR_OK && atr.audio.rate == a && atr.audio.ch == b;
+		printf("%s: %d %u/%u\n", name, err, atr.audio.rate, atr.audio.ch);
+	}
+
+	return ok;
+}
+
+static bool test_rate(const char* name, eos_media_codec_t codec,
+		const uint8_t* data, uint32_t len, uint32_t num, uint32_t den)
+{
+	eos_media_es_attr_t atr;
+	eos_error_t err = EOS_ERROR_OK;
+
+	osi_memset(&atr, 0, sizeof(atr));
+	err = util_esparser_parse(codec, data, len, &atr);
+	printf("%s: %d %u/%u fps\n", name, err, atr.video.rate.num,
+			atr.video.rate.den);
+
+	return err == EOS_ERROR_OK && atr.video.rate.num == num &&
+			atr.video.rate.den == den;
+}
+
+static bool test_h264(uint32_t tick, uint32_t scale, uint32_t fps,
+		uint32_t num, uint32_t den)
+{
+	test_bits_t sps;
+	uint8_t nal[TEST_BUFF_SZ + 16];
+	/* Junk and an AUD in front, as at the start of a PES */
+	uint8_t es[TEST_BUFF_SZ + 32] = {0xaa, 0x00, 0x00, 0x00, 0x01, 0x09, 0xf0};
+	const uint8_t hdr = 0x67;
+	uint32_t len = 0;
+
+	osi_memset(&sps, 0, sizeof(sps));
+	test_put(&sps, 100, 8);
+	test_put(&sps, 0, 8);
+	test_put(&sps, 40, 8);
+	test_put_ue(&sps, 0);
+	/* chroma 4:2:0, 8 bit, no scaling matrix */
+	test_put_ue(&sps, 1);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 0);
+	test_put(&sps, 0, 1);
+	test_put(&sps, 0, 1);
+	test_put_ue(&sps, 0);
+	/* poc type 0 */
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 2);
+	test_put_ue(&sps, 4);
+	test_put(&sps, 0, 1);
+	/* 120x68 MBs, cropped to 1080 lines */
+	test_put_ue(&sps, 119);
+	test_put_ue(&sps, 67);
+	test_put(&sps, 1, 1);
+	test_put(&sps, 1, 1);
+	test_put(&sps, 1, 1);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 4);
+	/* VUI: only timing, two ticks per frame */
+	test_put(&sps, 1, 1);
+	test_put(&sps, 0, 4);
+	test_put(&sps, 1, 1);
+	test_put(&sps, tick, 32);
+	test_put(&sps, scale, 32);
+	test_put(&sps, 1, 1);
+	len = test_nal(&sps, &hdr, 1, nal);
+	osi_memcpy(es + 7, nal, len);
+
+	return test_check("H.264", EOS_MEDIA_CODEC_H264, es, len + 7, 1920, 1080,
+			fps) && test_rate("H.264", EOS_MEDIA_CODEC_H264, es, len + 7,
+			num, den);
+}
+
+static bool test_hevc(void)
+{
+	test_bits_t sps;
+	uint8_t nal[TEST_BUFF_SZ + 16];
+	const uint8_t hdr[2] = {33 << 1, 0x01};
+	uint32_t len = 0;
+
+	osi_memset(&sps, 0, sizeof(sps));
+	test_put(&sps, 0, 4);
+	/* one sub layer */
+	test_put(&sps, 1, 3);
+	test_put(&sps, 1, 1);
+	/* general profile_tier_level */
+	test_put(&sps, 1, 8);
+	test_put(&sps, 0x60000000, 32);
+	test_put(&sps, 0, 24);
+	test_put(&sps, 0, 24);
+	test_put(&sps, 120, 8);
+	/* sub layer: profile and level present */
+	test_put(&sps, 1, 1);
+	test_put(&sps, 1, 1);
+	test_put(&sps, 0, 2 * 7);
+	test_put(&sps, 0, 32);
+	test_put(&sps, 0, 32);
+	test_put(&sps, 0, 24);
+	test_put(&sps, 120, 8);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 1);
+	test_put_ue(&sps, 1920);
+	test_put_ue(&sps, 1088);
+	test_put(&sps, 1, 1);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 0);
+	test_put_ue(&sps, 4);
+	len = test_nal(&sps, hdr, 2, nal);
+
+	return test_check("HEVC", EOS_MEDIA_CODEC_H265, nal, len, 1920, 1080, 0);
+}
+
+static bool test_mp2v(void)
+{
+	const uint8_t seq[] = {0x00, 0x00, 0x01, 0xb3, 0x2d, 0x02, 0x40, 0x33,
+			0xff, 0xff, 0xe0, 0x18};
+	/* 720x480, frame_rate_code 4 (30000/1001) */
+	const uint8_t ntsc[] = {0x00, 0x00, 0x01, 0xb3, 0x2d, 0x01, 0xe0, 0x24,
+			0xff, 0xff, 0xe0, 0x18};
+
+	return test_check("MPEG-2", EOS_MEDIA_CODEC_MPEG2, seq, sizeof(seq),
+			720, 576, 25) && test_rate("MPEG-2", EOS_MEDIA_CODEC_MPEG2, seq,
+			sizeof(seq), 25, 1) && test_check("MPEG-2 NTSC",
+			EOS_MEDIA_CODEC_MPEG2, ntsc, sizeof(ntsc), 720, 480, 30) &&
+			test_rate("MPEG-2 NTSC", EOS_MEDIA_CODEC_MPEG2, ntsc,
+			sizeof(ntsc), 30000, 1001);
+}
+
+static bool test_audio(void)
+{
+	const uint8_t adts[] = {0x12, 0xff, 0xf1, 0x4c, 0x80, 0x2e, 0x7f, 0xfc};
+	const uint8_t ac3[] = {0x0b, 0x77, 0x00, 0x00, 0x14, 0x40, 0xe1, 0x00};
+	const uint8_t eac3[] = {0x0b, 0x77, 0x01, 0x7f, 0x74, 0x80, 0x00, 0x00};
+	const uint8_t mpga[] = {0x00, 0xff, 0xfd, 0x94, 0xc0};
+	test_bits_t latm;
+
+	/* LATM with StreamMuxConfig: HE-AAC (SBR), 24 kHz core, stereo */
+	osi_memset(&latm, 0, sizeof(latm));
+	test_put(&latm, 0x2b7, 11);
+	test_put(&latm, 100, 13);
+	test_put(&latm, 0, 1);
+	test_put(&latm, 0, 1);
+	test_put(&latm, 1, 1);
+	test_put(&latm, 0, 6);
+	test_put(&latm, 0, 4);
+	test_put(&latm, 0, 3);
+	test_put(&latm, 5, 5);
+	test_put(&latm, 6, 4);
+	test_put(&latm, 2, 4);
+	test_put(&latm, 3, 4);
+	test_put(&latm, 2, 5);
+
+	return test_check("ADTS", EOS_MEDIA_CODEC_AAC, adts, sizeof(adts), 48000, 2, 0) &&
+			test_check("LATM", EOS_MEDIA_CODEC_HEAAC, latm.data,
+					(latm.pos + 7) / 8, 48000, 2, 0) &&
+			test_check("AC-3", EOS_MEDIA_CODEC_AC3, ac3, sizeof(ac3), 48000, 6, 0) &&
+			test_check("E-AC-3", EOS_MEDIA_CODEC_EAC3, eac3, sizeof(eac3), 44100, 2, 0) &&
+			test_check("MPEG audio", EOS_MEDIA_CODEC_MP2, mpga, sizeof(mpga), 48000, 1, 0);
+}
+
+static bool test_truncated(void)
+{
+	const uint8_t seq[] = {0x00, 0x00, 0x01, 0xb3, 0x2d, 0x02};
+	eos_media_es_attr_t atr;
+
+	osi_memset(&atr, 0, sizeof(atr));
+
+	return util_esparser_parse(EOS_MEDIA_CODEC_MPEG2, seq, sizeof(seq), &atr)
+			== EOS_ERROR_NFOUND && atr.video.resolution.width == 0 &&
+			util_esparser_parse(EOS_MEDIA_CODEC_DTS, seq, sizeof(seq), &atr)
+			== EOS_ERROR_NIMPLEMENTED;
+}
+
+int main(int argc, char** argv)
+{
+	EOS_UNUSED(argc);
+	EOS_UNUSED(argv);
+
+	/* 25 fps, and 59.94 fps which whole frames per second cannot hold */
+	if (!test_h264(1, 50, 25, 25, 1) || !test_h264(1001, 120000, 60, 60000, 1001) ||
+			!test_hevc() || !test_mp2v())
+	{
+		printf("Video headers [FAILED]\n");
+		return -1;
+	}
+	if (!test_audio())
+	{
+		printf("Audio headers [FAILED]\n");
+		return -1;
+	}
+	if (!test_truncated())
+	{
+		printf("Truncated/unsupported [FAILED]\n");
+		return -1;
+	}
+	printf("ES parser test [OK]\n");
+
+	return 0;
+}
@@ -0,0 +1,291 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "osi_memory.h"
+#include "util_factory.h"
+#include "util_dispatch.h"
+#include "eos_macro.h"
+
+#define MODULE_NAME "test:factory"
+#include "util_log.h"
+
+#define BENCH_ROUNDS (20000)
+#define BENCH_MAX_MODELS (1024)
+
+typedef struct test_model
+{
+	uint32_t key;
+	bool accept;
+	uint64_t id;
+} test_model_t;
+
+typedef struct test_data
+{
+	uint32_t key;
+	uint32_t hint;
+} test_data_t;
+
+static test_model_t models[BENCH_MAX_MODELS];
+
+static eos_error_t test_probe(void* model, void* data)
+{
+	test_model_t *m = (test_model_t*)model;
+	test_data_t *d = (test_data_t*)data;
+
+	return (m->accept && m->key == d->key) ? EOS_ERROR_OK : EOS_ERROR_NFOUND;
+}
+
+static void test_key(void* data, uint32_t* key, uint32_t* hint)
+{
+	test_data_t *d = (test_data_t*)data;
+
+	*key = d->key;
+	*hint = d->hint;
+}
+
+static eos_error_t test_manufacture(void* data, void* model, uint64_t model_id,
+		void** product, uint64_t product_id)
+{
+	EOS_UNUSED(data);
+	EOS_UNUSED(model_id);
+	EOS_UNUSED(product_id);
+
+	*product = model;
+
+	return EOS_ERROR_OK;
+}
+
+static eos_error_t test_dismantle(uint64_t model_id, void** product)
+{
+	EOS_UNUSED(model_id);
+
+	*product = NULL;
+
+	return EOS_ERROR_OK;
+}
+
+static uint64_t test_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool test_register(util_factory_t* factory, test_model_t* model,
+		const uint32_t* keys, uint8_t key_cnt)
+{
+	model->id = 0;
+
+	return util_factory_register(factory, model, &model->id, keys, key_cnt,
+			test_manufacture, test_dismantle) == EOS_ERROR_OK;
+}
+
+static test_model_t* test_make(util_factory_t* factory, uint32_t key,
+		uint32_t hint)
+{
+	test_data_t data = {key, hint};
+	test_model_t *model = NULL;
+	void *product = NULL;
+
+	if (util_factory_manufacture(factory, &product, &data) != EOS_ERROR_OK)
+	{
+		return NULL;
+	}
+	/* Product is the model itself */
+	model = (test_model_t*)product;
+	util_factory_dismantle(factory, &product);
+
+	return model;
+}
+
+static bool test_dispatch(void)
+{
+	util_factory_t *factory = NULL;
+	uint32_t both[] = {1, 2};
+	uint32_t one[] = {1};
+	bool ok = true;
+
+	if (util_factory_create(&factory, test_probe, test_key) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	/* 0: keys 1 and 2, 1: no keys (probed always), 2: key 1 but refuses */
+	models[0].key = 1;
+	models[0].accept = true;
+	models[1].key = 3;
+	models[1].accept = true;
+	models[2].key = 1;
+	models[2].accept = false;
+	ok = test_register(factory, &models[0], both, 2) &&
+			test_register(factory, &models[1], NULL, 0) &&
+			test_register(factory, &models[2], one, 1);
+	if (!ok)
+	{
+		printf("Register failed\n");
+	}
+	if (ok && test_make(factory, 1, UTIL_DISPATCH_ANY) != &models[0])
+	{
+		printf("Keyed lookup failed\n");
+		ok = false;
+	}
+	if (ok && test_make(factory, 3, UTIL_DISPATCH_ANY) != &models[1])
+	{
+		printf("Fallback to keyless model failed\n");
+		ok = false;
+	}
+	if (ok && test_make(factory, 4, UTIL_DISPATCH_ANY) != NULL)
+	{
+		printf("Unknown key matched\n");
+		ok = false;
+	}
+	/* Model 0 gets cached for hint 7, then it disappears */
+	if (ok && test_make(factory, 1, 7) != &models[0])
+	{
+		printf("Cached lookup failed\n");
+		ok = false;
+	}
+	if (ok && test_make(factory, 1, 7) != &models[0])
+	{
+		printf("Cache hit failed\n");
+		ok = false;
+	}
+	if (ok && test_make(factory, 3, 7) != &models[1])
+	{
+		printf("Stale cache entry not bypassed\n");
+		ok = false;
+	}
+	util_factory_unregister(factory, &models[0], models[0].id);
+	if (ok && test_make(factory, 1, 7) != NULL)
+	{
+		printf("Unregistered model still manufactured\n");
+		ok = false;
+	}
+	util_factory_unregister(factory, &models[1], models[1].id);
+	util_factory_unregister(factory, &models[2], models[2].id);
+	util_factory_destroy(&factory);
+
+	return ok;
+}
+
+/* Average manufacture + dismantle time of the last registered model */
+static uint64_t test_bench(uint32_t count, bool keyed, bool cached)
+{
+	util_factory_t *factory = NULL;
+	uint64_t start = 0;
+	uint64_t elapsed = 0;
+	uint32_t key = 0;
+	uint32_t i = 0;
+
+	if (util_factory_create(&factory, test_probe, test_key) != EOS_ERROR_OK)
+	{
+		return 0;
+	}
+	for (i = 0; i < count; i++)
+	{
+		models[i].key = i + 1;
+		models[i].accept = true;
+		key = models[i].key;
+		test_register(factory, &models[i], &key, keyed ? 1 : 0);
+	}
+	start = test_now_ns();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+	{
+		if (test_make(factory, key, cached ? key : UTIL_DISPATCH_ANY)
+				!= &models[count - 1])
+		{
+			elapsed = UINT64_MAX;
+			break;
+		}
+	}
+	if (elapsed == 0)
+	{
+		elapsed = (test_now_ns() - start) / BENCH_ROUNDS;
+	}
+	for (i = 0; i < count; i++)
+	{
+		util_factory_unregister(factory, &models[i], models[i].id);
+	}
+	util_factory_destroy(&factory);
+
+	return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t counts[] = {4, 64, 1024};
+	uint64_t linear = 0, keyed = 0, cached = 0;
+	uint8_t i = 0;
+
+	EOS_UNUSED(argc);
+	EOS_UNUSED(argv);
+
+	if (!test_dispatch())
+	{
+		printf("Dispatch [FAILED]\n");
+		return -1;
+	}
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+	{
+		linear = test_bench(counts[i], false, false);
+		keyed = test_bench(counts[i], true, false);
+		cached = test_bench(counts[i], true, true);
+		printf("%4u models: probe all %6llu ns, keyed %6llu ns, "
+				"cached %6llu ns\n", counts[i],
+				(unsigned long long)linear, (unsigned long long)keyed,
+				(unsigned long long)cached);
+		if (linear == UINT64_MAX || keyed == UINT64_MAX ||
+				cached == UINT64_MAX)
+		{
+			printf("Wrong model manufactured [FAILED]\n");
+			return -1;
+		}
+	}
+	/* With many models probing them all must be far behind */
+	if (keyed >= linear || cached >= linear)
+	{
+		printf("Keyed dispatch slower than probing [FAILED]\n");
+		return -1;
+	}
+	printf("Factory test [OK]\n");
+
+	return 0;
+}
@@ -265,7 +265,7 @@ void* first_tc_consumer(void* arg)
 			return NULL;
 		}
 		count++;
-		osi_time_usleep(rand() % 100000 + 100);
+		osi_time_usleep(rand() % 1000 + 100);
 	}
 	tc_arg->loops = count - 1;
 
@@ -521,6 +521,204 @@ done:
 	UTIL_GLOGI("************************* DONE *************************");
 }
 
+#define THIRD_TC_CHUNK      (2048)
+#define THIRD_TC_TOTAL      (16 * 1024 * 1024)
+#define THIRD_TC_RESIZES    (200)
+
+static const uint32_t third_tc_sizes[] = {8 * 1024, 64 * 1024, 16 * 1024, 128 * 1024};
+
+void* third_tc_provider(void* arg)
+{
+	tc_arg_t *tc_arg = (tc_arg_t*) arg;
+	uint32_t written = 0, size, i;
+	uint8_t *data = NULL;
+
+	while(written < THIRD_TC_TOTAL)
+	{
+		size = rand() % THIRD_TC_CHUNK + 1;
+		if(size > THIRD_TC_TOTAL - written)
+		{
+			size = THIRD_TC_TOTAL - written;
+		}
+		if(util_rbuff_reserve(tc_arg->ring_buff, (void**)&data, size,
+				UTIL_RBUFF_FOREVER) != EOS_ERROR_OK)
+		{
+			UTIL_GLOGE("*************** ERROR reserving data ***************");
+			tc_arg->failed++;
+			return NULL;
+		}
+		for(i=0; i<size; i++)
+		{
+			data[i] = (uint8_t)(written + i);
+		}
+		util_rbuff_commit(tc_arg->ring_buff, data, size);
+		written += size;
+	}
+
+	return NULL;
+}
+
+void* third_tc_consumer(void* arg)
+{
+	tc_arg_t *tc_arg = (tc_arg_t*) arg;
+	uint8_t data[THIRD_TC_CHUNK];
+	uint32_t read = 0, size, i;
+
+	while(read < THIRD_TC_TOTAL)
+	{
+		size = rand() % THIRD_TC_CHUNK + 1;
+		if(size > THIRD_TC_TOTAL - read)
+		{
+			size = THIRD_TC_TOTAL - read;
+		}
+		if(util_rbuff_read_all(tc_arg->ring_buff, data, size,
+				UTIL_RBUFF_FOREVER) != EOS_ERROR_OK)
+		{
+			UTIL_GLOGE("**************** ERROR reading data ****************");
+			tc_arg->failed++;
+			return NULL;
+		}
+		for(i=0; i<size; i++)
+		{
+			if(data[i] != (uint8_t)(read + i))
+			{
+				tc_arg->failed++;
+				break;
+			}
+		}
+		read += size;
+	}
+
+	return NULL;
+}
+
+/* Freeing a chunk read up to the writer's wrap leaves nothing outstanding, so resize must pass */
+static uint32_t third_tc_wrapped_read(void)
+{
+	util_rbuff_t *ring_buff = NULL;
+	util_rbuff_attr_t ring_buff_attr = {NULL, 0, 0, NULL, 0, 0, NULL};
+	uint8_t buff[1024], bigger[2048], data[600];
+	void *chunk = NULL, *old = NULL;
+	uint32_t read = 0, failed = 0;
+
+	ring_buff_attr.size = sizeof(buff);
+	ring_buff_attr.buff = buff;
+	if(util_rbuff_create(&ring_buff_attr, &ring_buff) != EOS_ERROR_OK)
+	{
+		return 1;
+	}
+	/* [0, 800) written, [0, 600) consumed, writer wraps with [0, 300) */
+	if(util_rbuff_reserve(ring_buff, &chunk, 800, 0) != EOS_ERROR_OK ||
+			util_rbuff_commit(ring_buff, chunk, 800) != EOS_ERROR_OK ||
+			util_rbuff_read_all(ring_buff, data, 600, 0) != EOS_ERROR_OK ||
+			util_rbuff_reserve(ring_buff, &chunk, 300, 0) != EOS_ERROR_OK ||
+			chunk != buff ||
+			util_rbuff_commit(ring_buff, chunk, 300) != EOS_ERROR_OK)
+	{
+		failed++;
+		goto done;
+	}
+	/* Reader gets the 200 left before the wrap and frees them */
+	if(util_rbuff_read(ring_buff, &chunk, 300, &read, 0) != EOS_ERROR_OK || read != 200 ||
+			util_rbuff_free(ring_buff, chunk, read) != EOS_ERROR_OK)
+	{
+		failed++;
+		goto done;
+	}
+	if(util_rbuff_resize(ring_buff, bigger, sizeof(bigger), &old) != EOS_ERROR_OK || old != buff)
+	{
+		UTIL_GLOGE("*********** ERROR resizing after wrapped read ***********");
+		failed++;
+		goto done;
+	}
+	if(util_rbuff_read_all(ring_buff, data, 300, 0) != EOS_ERROR_OK)
+	{
+		failed++;
+	}
+
+done:
+	util_rbuff_destroy(&ring_buff);
+	return failed;
+}
+
+static void execute_third_tc(void)
+{
+	osi_thread_t *provider = NULL;
+	osi_thread_t *consumer = NULL;
+	util_rbuff_t *ring_buff = NULL;
+	util_rbuff_attr_t ring_buff_attr = {NULL, 0, 0, NULL, 0, 0, NULL};
+	tc_arg_t tc_arg = {NULL, 0, 0};
+	void *buff = NULL, *old = NULL, *current = NULL;
+	uint32_t size;
+	eos_error_t err;
+
+	UTIL_GLOGI("************ Executing resize while streaming **********");
+	ring_buff_attr.size = third_tc_sizes[0];
+	if((buff = malloc(ring_buff_attr.size)) == NULL)
+	{
+		UTIL_GLOGE("****************** ERROR no memory *****************");
+		goto done;
+	}
+	ring_buff_attr.buff = buff;
+	current = buff;
+	if(util_rbuff_create(&ring_buff_attr, &ring_buff) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("************** ERROR creating ring buffer **************");
+		goto done;
+	}
+	tc_arg.failed += third_tc_wrapped_read();
+	tc_arg.ring_buff = ring_buff;
+	if(osi_thread_create(&provider, NULL, third_tc_provider, &tc_arg) != EOS_ERROR_OK ||
+			osi_thread_create(&consumer, NULL, third_tc_consumer, &tc_arg) != EOS_ERROR_OK)
+	{
+		UTIL_GLOGE("************ ERROR creating test threads ***************");
+		goto done;
+	}
+	while(tc_arg.loops < THIRD_TC_RESIZES)
+	{
+		size = third_tc_sizes[(tc_arg.loops + 1) % (sizeof(third_tc_sizes) / sizeof(uint32_t))];
+		if((buff = malloc(size)) == NULL)
+		{
+			break;
+		}
+		err = util_rbuff_resize(ring_buff, buff, size, &old);
+		if(err == EOS_ERROR_OK)
+		{
+			free(old);
+			current = buff;
+			tc_arg.loops++;
+		}
+		else
+		{
+			free(buff);
+			if(err != EOS_ERROR_BUSY && err != EOS_ERROR_NOMEM)
+			{
+				UTIL_GLOGE("**************** ERROR resizing: %d *****************", err);
+				tc_arg.failed++;
+				break;
+			}
+		}
+		osi_time_usleep(rand() % 1000 + 100);
+	}
+	osi_thread_join(provider, NULL);
+	osi_thread_release(&provider);
+	osi_thread_join(consumer, NULL);
+	osi_thread_release(&consumer);
+
+done:
+	if(ring_buff != NULL)
+	{
+		util_rbuff_destroy(&ring_buff);
+	}
+	if(current != NULL)
+	{
+		free(current);
+	}
+	UTIL_GLOGI(" RESIZES: %u", tc_arg.loops);
+	UTIL_GLOGI(" FAILED:  %u", tc_arg.failed);
+	UTIL_GLOGI("************************* DONE *************************");
+}
+
 #if 0
 #define FOURTH_TC_LOOPS     (3000)
 
@@ -630,6 +828,7 @@ int main(int argc, char** argv)
 
 	execute_first_tc();
 	execute_second_tc();
+	execute_third_tc();
 
 	return 0;
 }
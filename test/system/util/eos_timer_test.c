@@ -0,0 +1,267 @@
+/***************************************************************************************
+Copyright (c) 2015, Swisscom (Switzerland) Ltd.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the Swisscom nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Architecture and development:
+Vladimir Maksovic <Vladimir.Maksovic@swisscom.com>
+Milenko Boric Herget <Milenko.BoricHerget@swisscom.com>
+Dario Vieceli <Dario.Vieceli@swisscom.com>
+***************************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "osi_time.h"
+#include "osi_memory.h"
+#include "util_timer.h"
+#include "util_wdt.h"
+#include "eos_macro.h"
+
+#define MODULE_NAME "test:timer"
+#include "util_log.h"
+
+/* Coarse monotonic clock ticks in 4 ms steps */
+#define TIMER_SLACK_MS (20)
+#define TIMER_CNT (5000)
+#define TIMER_SPREAD_MS (1000)
+#define TIMER_LONG_MS (1500)
+#define WDT_PERIOD_MS (100)
+
+typedef struct timer_ctx
+{
+	util_timer_t *timer;
+	uint64_t deadline;
+	volatile uint64_t fired_at;
+	volatile uint32_t fired;
+} timer_ctx_t;
+
+static volatile uint32_t wdt_count = 0;
+
+static void timer_cbk(void* cookie)
+{
+	timer_ctx_t *ctx = (timer_ctx_t*)cookie;
+
+	ctx->fired_at = util_timer_now();
+	ctx->fired++;
+}
+
+static void timer_rearm_cbk(void* cookie)
+{
+	timer_ctx_t *ctx = (timer_ctx_t*)cookie;
+
+	timer_cbk(cookie);
+	if (ctx->fired < 3)
+	{
+		util_timer_arm(ctx->timer, 10);
+	}
+}
+
+static void timer_self_destroy_cbk(void* cookie)
+{
+	timer_ctx_t *ctx = (timer_ctx_t*)cookie;
+
+	timer_cbk(cookie);
+	util_timer_destroy(&ctx->timer);
+}
+
+static void wdt_cbk(void* cookie)
+{
+	EOS_UNUSED(cookie);
+	wdt_count++;
+}
+
+static bool test_many(void)
+{
+	timer_ctx_t *ctx = osi_calloc(TIMER_CNT * sizeof(timer_ctx_t));
+	uint32_t i = 0, late = 0, early = 0, missed = 0;
+	uint64_t now = 0;
+	bool result = true;
+
+	printf("Many timers: %d spread over %d ms\n", TIMER_CNT, TIMER_SPREAD_MS);
+	for (i = 0; i < TIMER_CNT; i++)
+	{
+		if (util_timer_create(&ctx[i].timer, timer_cbk, &ctx[i]) != EOS_ERROR_OK)
+		{
+			return false;
+		}
+	}
+	now = util_timer_now();
+	for (i = 0; i < TIMER_CNT; i++)
+	{
+		ctx[i].deadline = now + (i * 7919) % TIMER_SPREAD_MS;
+		util_timer_arm(ctx[i].timer, (uint32_t)(ctx[i].deadline - now));
+	}
+	/* Every odd timer is re-armed (later), every 10th cancelled */
+	for (i = 1; i < TIMER_CNT; i += 2)
+	{
+		ctx[i].deadline += 100;
+		util_timer_arm(ctx[i].timer, (uint32_t)(ctx[i].deadline - now));
+	}
+	for (i = 0; i < TIMER_CNT; i += 10)
+	{
+		util_timer_cancel(ctx[i].timer);
+	}
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(TIMER_SPREAD_MS + 100 + 2 * TIMER_SLACK_MS));
+	for (i = 0; i < TIMER_CNT; i++)
+	{
+		if (i % 10 == 0)
+		{
+			missed += (ctx[i].fired != 0);
+			continue;
+		}
+		if (ctx[i].fired != 1)
+		{
+			missed++;
+		}
+		else if (ctx[i].fired_at + 4 < ctx[i].deadline)
+		{
+			early++;
+		}
+		else if (ctx[i].fired_at > ctx[i].deadline + TIMER_SLACK_MS)
+		{
+			late++;
+		}
+	}
+	printf("Many timers: missed/extra %u, early %u, late %u\n", missed, early, late);
+	result = (missed == 0) && (early == 0) && (late == 0);
+	for (i = 0; i < TIMER_CNT; i++)
+	{
+		util_timer_destroy(&ctx[i].timer);
+	}
+	osi_free((void**)&ctx);
+
+	return result;
+}
+
+static bool test_long_and_rearm(void)
+{
+	timer_ctx_t lng, rearm, self;
+	uint64_t start = 0;
+
+	printf("Long timer (%d ms, cascades), re-arm from callback, destroy from callback\n",
+			TIMER_LONG_MS);
+	osi_memset(&lng, 0, sizeof(timer_ctx_t));
+	osi_memset(&rearm, 0, sizeof(timer_ctx_t));
+	osi_memset(&self, 0, sizeof(timer_ctx_t));
+	util_timer_create(&lng.timer, timer_cbk, &lng);
+	util_timer_create(&rearm.timer, timer_rearm_cbk, &rearm);
+	util_timer_create(&self.timer, timer_self_destroy_cbk, &self);
+	start = util_timer_now();
+	util_timer_arm(lng.timer, TIMER_LONG_MS);
+	util_timer_arm(rearm.timer, 10);
+	util_timer_arm(self.timer, 50);
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(TIMER_LONG_MS + TIMER_SLACK_MS));
+	util_timer_destroy(&lng.timer);
+	util_timer_destroy(&rearm.timer);
+	if (lng.fired != 1 || lng.fired_at < start + TIMER_LONG_MS - 4 ||
+			lng.fired_at > start + TIMER_LONG_MS + TIMER_SLACK_MS)
+	{
+		printf("Long timer fired %u times after %llu ms\n", lng.fired,
+				(unsigned long long)(lng.fired_at - start));
+		return false;
+	}
+
+	return (rearm.fired == 3) && (self.fired == 1) && (self.timer == NULL);
+}
+
+static bool test_wdt(void)
+{
+	util_wdt_t *wdt = NULL;
+	uint32_t i = 0;
+
+	printf("Watchdog: keep alive, timeout, suspend, stop\n");
+	if (util_wdt_create(&wdt) != EOS_ERROR_OK ||
+			util_wdt_keep_alive(wdt) != EOS_ERROR_INVAL ||
+			util_wdt_start(wdt, WDT_PERIOD_MS, wdt_cbk, NULL) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	for (i = 0; i < 10; i++)
+	{
+		osi_time_usleep(OSI_TIME_MSEC_TO_USEC(WDT_PERIOD_MS / 4));
+		util_wdt_keep_alive(wdt);
+	}
+	if (wdt_count != 0)
+	{
+		printf("Watchdog fired although kept alive\n");
+		return false;
+	}
+	/* Repeats every period without keep alive */
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(WDT_PERIOD_MS * 2 + WDT_PERIOD_MS / 2));
+	if (wdt_count != 2)
+	{
+		printf("Watchdog fired %u times instead of 2\n", wdt_count);
+		return false;
+	}
+	util_wdt_suspend(wdt, true);
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(WDT_PERIOD_MS * 2));
+	if (wdt_count != 2 || util_wdt_keep_alive(wdt) != EOS_ERROR_INVAL)
+	{
+		return false;
+	}
+	util_wdt_suspend(wdt, false);
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(WDT_PERIOD_MS + WDT_PERIOD_MS / 2));
+	if (wdt_count != 3)
+	{
+		printf("Watchdog fired %u times instead of 3\n", wdt_count);
+		return false;
+	}
+	if (util_wdt_stop(wdt) != EOS_ERROR_OK)
+	{
+		return false;
+	}
+	osi_time_usleep(OSI_TIME_MSEC_TO_USEC(WDT_PERIOD_MS * 2));
+
+	return (wdt_count == 3) && (util_wdt_destroy(&wdt) == EOS_ERROR_OK);
+}
+
+int main(int argc, char** argv)
+{
+	EOS_UNUSED(argc);
+	EOS_UNUSED(argv);
+
+	if (!test_many())
+	{
+		printf("Many timers [FAILED]\n");
+		return -1;
+	}
+	if (!test_long_and_rearm())
+	{
+		printf("Long timer/re-arm [FAILED]\n");
+		return -1;
+	}
+	if (!test_wdt())
+	{
+		printf("Watchdog [FAILED]\n");
+		return -1;
+	}
+	printf("Timer test [OK]\n");
+
+	return 0;
+}
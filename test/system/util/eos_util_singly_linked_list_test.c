@@ -31,6 +31,8 @@ Dario Vieceli <Dario.Vieceli@swisscom.com>
 ***************************************************************************************/
 
 
+#define MODULE_NAME "test:slist"
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
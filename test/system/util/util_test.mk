@@ -108,3 +108,80 @@ CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
 $(call GENERATE_COMPILE_RULES,$(OBJDIR))
 $(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_islist_test)
 
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_bcast_buff_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_bcast_buff_test)
+
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_timer_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_timer_test)
+
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_factory_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_factory_test)
+
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_esparser_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_esparser_test)
+
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_clk_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_clk_test)
+
+$(call CLEAR_VARS)
+CFLAGS:=$(DEF_CFLAGS)
+CXXFLAGS:=$(DEF_CXXFLAGS)
+LDFLAGS:=$(TEST_LDFLAGS)
+
+SRCS += $(UTIL_TESTDIR)/eos_audio_dsp_test.c
+
+CFLAGS += -D_GNU_SOURCE
+CFLAGS += -I$(UTILSDIR)/ -I$(OSIDIR)/
+
+$(call GENERATE_COMPILE_RULES,$(OBJDIR))
+$(call GENERATE_EXECUTABLE_RULE,$(BINDIR),eos_audio_dsp_test)